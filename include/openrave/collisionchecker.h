@@ -46,6 +46,14 @@ enum CollisionOptions
     CO_AllGeometryContacts = 0x80, ///< if set, then will return the contact points of all the colliding geometries. Do not need to explore all pairs of links once the first pair is found. This option can be slow.    
 };
 
+/// \brief options for \ref CollisionCheckerBase::CheckCollisionBatch. The first bits are also used to describe the result of every configuration of the batch.
+enum CollisionBatchOptions
+{
+    CBO_Environment = 1, ///< check the body against the environment. In the results, set if the configuration collides with the environment.
+    CBO_SelfCollision = 2, ///< check the self-collision of the body. In the results, set if the configuration is in self-collision.
+    CBO_StopAtFirstCollision = 4, ///< stop checking once the first configuration in collision is found. The results of the configurations after it are left at 0.
+};
+
 /// \brief action to perform whenever a collision is detected between objects
 enum CollisionAction
 {
@@ -288,6 +296,51 @@ public:
     /// \param[out] report [optional] collision report to be filled with data about the collision.
     virtual bool CheckStandaloneSelfCollision(KinBody::LinkConstPtr plink, CollisionReportPtr report = CollisionReportPtr()) = 0;
 
+    /** \brief Checks collision of a body for a batch of its DOF values.
+
+        Equivalent to calling KinBody::SetDOFValues followed by \ref CheckCollision and/or \ref CheckStandaloneSelfCollision for every configuration, except that checkers can share the synchronization of the environment and the setup of the queries across the whole batch. CO_ActiveDOFs is respected. The state of the body is restored before returning.
+        \param pbody the body to check
+        \param vconfigurations the configurations stored one after the other. Each configuration has dofindices.size() values, or pbody->GetDOF() values if dofindices is empty.
+        \param dofindices the dof indices the values of each configuration are ordered by. If empty, uses all the dofs of the body.
+        \param[out] vresults resized to the number of configurations. Every entry is a mask of CBO_Environment and CBO_SelfCollision describing the collisions of the configuration.
+        \param batchoptions mask of \ref CollisionBatchOptions
+        \param[out] report [optional] collision report filled with the collision of the first configuration in collision.
+        \return the number of configurations in collision
+     */
+    virtual int CheckCollisionBatch(KinBodyPtr pbody, const std::vector<dReal>& vconfigurations, const std::vector<int>& dofindices, std::vector<uint8_t>& vresults, int batchoptions=CBO_Environment|CBO_SelfCollision, CollisionReportPtr report = CollisionReportPtr());
+
+    /** \brief Checks collision of a body for a batch of its transforms.
+
+        Equivalent to calling KinBody::SetTransform followed by \ref CheckCollision and/or \ref CheckStandaloneSelfCollision for every transform. The state of the body is restored before returning.
+        \param pbody the body to check
+        \param vtransforms the transforms of the body to check
+        \param[out] vresults resized to vtransforms.size(). Every entry is a mask of CBO_Environment and CBO_SelfCollision describing the collisions of the transform.
+        \param batchoptions mask of \ref CollisionBatchOptions
+        \param[out] report [optional] collision report filled with the collision of the first transform in collision.
+        \return the number of transforms in collision
+     */
+    virtual int CheckCollisionBatch(KinBodyPtr pbody, const std::vector<Transform>& vtransforms, std::vector<uint8_t>& vresults, int batchoptions=CBO_Environment, CollisionReportPtr report = CollisionReportPtr());
+
+    /** \brief Checks collision of a body moving continuously along a linear or parabolic segment in joint space.
+
+        The segment is q(t) = q0 + t*(dq0 + 0.5*t*(dq1-dq0)/timeelapsed) for t in [0, timeelapsed] if the velocities are given and timeelapsed > 0, otherwise it is q(t) = q0 + t*(q1-q0) for t in [0, 1].
+        Uses conservative advancement: at every step the distance of the body to the obstacles is computed and the segment is advanced by the longest time for which the links are guaranteed to move less than that distance. Therefore the whole segment is covered without any discretization, and thin obstacles cannot be missed.
+        The checker has to support CO_Distance. Passive mimic joints depending on the moving dofs are not supported. In all unsupported cases ORE_NotImplemented is thrown so that callers can fall back to discrete checking. The state of the body is restored before returning.
+        \param pbody the body to check
+        \param q0 the values of dofindices at the start of the segment
+        \param q1 the values of dofindices at the end of the segment
+        \param dq0 the velocities at the start of the segment, can be empty for a linear segment
+        \param dq1 the velocities at the end of the segment, can be empty for a linear segment
+        \param timeelapsed duration of the parabolic segment, 0 for a linear segment
+        \param dofindices the dof indices the values are ordered by. If empty, uses all the dofs of the body.
+        \param[out] fTimeOfContact if in collision, the earliest checked time of the segment where the body is in collision or within fTolerance of an obstacle
+        \param batchoptions mask of CBO_Environment and CBO_SelfCollision, see \ref CollisionBatchOptions
+        \param fTolerance distances smaller than this are treated as collisions, guarantees that the advancement terminates.
+        \param[out] report [optional] collision report filled with the collision at fTimeOfContact
+        \return a mask of CBO_Environment and CBO_SelfCollision describing the collision at fTimeOfContact, 0 if the segment is collision free
+     */
+    virtual int CheckContinuousCollision(KinBodyPtr pbody, const std::vector<dReal>& q0, const std::vector<dReal>& q1, const std::vector<dReal>& dq0, const std::vector<dReal>& dq1, dReal timeelapsed, const std::vector<int>& dofindices, dReal& fTimeOfContact, int batchoptions=CBO_Environment|CBO_SelfCollision, dReal fTolerance=0.001, CollisionReportPtr report = CollisionReportPtr());
+
     /// \deprecated (13/04/09)
     virtual bool CheckSelfCollision(KinBodyConstPtr pbody, CollisionReportPtr report = CollisionReportPtr()) RAVE_DEPRECATED
     {
@@ -315,6 +368,24 @@ protected:
         return boost::static_pointer_cast<CollisionCheckerBase const>(shared_from_this());
     }
 
+    /// \brief default implementation of the batch checks, calls setstatefn(index) and checks every configuration one by one.
+    virtual int _CheckCollisionBatch(KinBodyPtr pbody, size_t numconfigurations, const boost::function<void(size_t)>& setstatefn, std::vector<uint8_t>& vresults, int batchoptions, CollisionReportPtr report);
+
+    /** \brief one step of the conservative advancement of \ref CheckContinuousCollision, the body is already set at the current time of the segment.
+
+        Default implementation uses the minimum distances of the whole body with CO_Distance, checkers can override it to use per link distances.
+        \param vlinkmotionbounds for every link of pbody, (linear, angular) coefficients bounding its motion (the motion of the grabbed bodies included). During a step of duration dt, every point of the link moves by at most dt*linear/(1-2*dt*angular), see \ref _GetConservativeAdvancementTime.
+        \param[out] fTimeStep if not in collision, the duration the body can move along the segment while staying collision free. Can be std::numeric_limits<dReal>::max() if nothing moves.
+        \return a mask of CBO_Environment and CBO_SelfCollision describing the collision at the current state, or the obstacles closer than fTolerance
+     */
+    virtual int _ComputeContinuousCollisionStep(KinBodyConstPtr pbody, const std::vector< std::pair<dReal, dReal> >& vlinkmotionbounds, int batchoptions, dReal fTolerance, dReal& fTimeStep, CollisionReportPtr report);
+
+    /// \brief returns the longest duration for which points bounded by (flinear, fangular) coefficients move less than fdistance, see \ref _ComputeContinuousCollisionStep.
+    static inline dReal _GetConservativeAdvancementTime(dReal fdistance, dReal flinear, dReal fangular) {
+        const dReal fdenom = flinear + 2*fdistance*fangular;
+        return fdenom > 0 ? fdistance/fdenom : std::numeric_limits<dReal>::max();
+    }
+
 private:
     virtual const char* GetHash() const {
         return OPENRAVE_COLLISIONCHECKER_HASH;
@@ -129,6 +129,14 @@ public:
     /// \param[in] cloningoptions The parts of the environment to clone. Parts not specified are left as is.
     virtual void Clone(EnvironmentBaseConstPtr preference, const std::string& clonedEnvName, int cloningoptions) = 0;
 
+    /// \brief Brings the current environment up to date with the reference environment it was cloned from.
+    ///
+    /// If the bodies were cloned from preference by \ref Clone or \ref CloneSelf and the set of bodies of both environments did not change since, only the state (transforms, dof values, velocities, enable states, grabbed bodies, active dofs) of the bodies whose update stamp changed in either environment is copied. Since setting velocities does not change the update stamp, the link velocities of the other bodies are compared and copied when they differ.
+    /// Otherwise, or if the kinematics or geometry of one of these bodies changed, falls back to \ref Clone.
+    /// The reference environment has to be locked by the caller.
+    /// \param[in] cloningoptions The parts of the environment to clone when falling back to \ref Clone. Only the bodies are updated incrementally, so Clone_Bodies has to be set for the update to be incremental.
+    virtual void UpdateFromClone(EnvironmentBaseConstPtr preference, int cloningoptions) = 0;
+
     /// \brief Each function takes an optional pointer to a CollisionReport structure and returns true if collision occurs. <b>[multi-thread safe]</b>
     ///
     /// \name Collision specific functions.
@@ -282,6 +282,16 @@ public:
      */
     virtual bool SolveAll(const IkParameterization& param, const std::vector<dReal>& vFreeParameters, int filteroptions, std::vector<IkReturnPtr>& ikreturns);
 
+    /** \brief Return all joint configurations for each of many end effector transforms.
+
+        Equivalent to calling \ref SolveAll on every pose, except that solvers can share the setup across the whole batch and solve all the poses analytically before validating any of the solutions, so that the filters and collision checks can be run together.
+        \param[in] vparams the poses the end effector has to achieve in the manipulator base's coordinate system. Note that the end effector pose takes into account the grasp coordinate frame for the RobotBase::Manipulator
+        \param[in] filteroptions A bitmask of \ref IkFilterOptions values controlling what is checked for each ik solution.
+        \param[out] vikreturns resized to vparams.size(). vikreturns[i] holds the ik output data of all the solutions of vparams[i].
+        \return the number of poses with at least one solution
+     */
+    virtual int SolveAllBatch(const std::vector<IkParameterization>& vparams, int filteroptions, std::vector< std::vector<IkReturnPtr> >& vikreturns);
+
     /// \brief returns true if the solver supports a particular ik parameterization as input.
     virtual bool Supports(IkParameterizationType iktype) const OPENRAVE_DUMMY_IMPLEMENTATION;
 
@@ -2269,6 +2269,105 @@ public:
     typedef boost::shared_ptr<KinBody::BodyState> BodyStatePtr;
     typedef boost::shared_ptr<KinBody::BodyState const> BodyStateConstPtr;
 
+    /// \brief The kinematic chain of a link precomputed for a set of dofs so that the jacobians of the link can be computed many times without searching the chain or allocating memory. Initialized with \ref KinBody::InitJacobianWorkspace.
+    class OPENRAVE_API JacobianWorkspace
+    {
+public:
+        /// \brief the contribution of one joint axis to the jacobian
+        struct JacobianColumn
+        {
+            int parentlinkindex; ///< the link the joint is attached to
+            Vector vlocalaxis; ///< axis of the joint in the frame of the parent link
+            Vector vlocalanchor; ///< anchor of the joint in the frame of the parent link
+            int icolumn; ///< column of the jacobian, -1 if the axis is a mimic axis spread over the columns of the dofs it depends on
+            int imimic; ///< index of the partials of the mimic axis in the mimic partials, -1 if the axis is not mimic
+            int mimicjointindex; ///< generalized index (into GetJoints() followed by GetPassiveJoints()) of the mimic joint, -1 if the axis is not mimic
+            int mimicaxis; ///< axis of the mimic joint
+            bool bPrismatic;
+        };
+
+        /// \brief computes the jacobians of the link for the link transformations computed by \ref KinBody::ComputeLinkTransformations
+        ///
+        /// \param pLinkTransforms the transforms of all the links of the body
+        /// \param[out] ptranslationjacobian if not NULL, 3xGetNumColumns() row-major translation jacobian of the point vlocalposition of the link
+        /// \param[out] pangularjacobian if not NULL, 3xGetNumColumns() row-major angular velocity jacobian of the link
+        /// \param pMimicPartials GetNumMimicColumns()xGetNumColumns() partial derivatives of the mimic axes computed by \ref KinBody::ComputeJacobianMimicPartials for the same configuration. Can be NULL if GetNumMimicColumns() is 0.
+        void ComputeJacobians(const Transform* pLinkTransforms, dReal* ptranslationjacobian, dReal* pangularjacobian, const dReal* pMimicPartials=NULL) const;
+
+        /// \brief computes the hessians of the link for the link transformations computed by \ref KinBody::ComputeLinkTransformations
+        ///
+        /// Same conventions as \ref KinBody::ComputeHessianTranslation and \ref KinBody::ComputeHessianAxisAngle. As there, the second derivatives of the mimic equations are ignored.
+        /// \param pLinkTransforms the transforms of all the links of the body
+        /// \param[out] ptranslationhessian if not NULL, GetNumColumns()x3xGetNumColumns() hessian of the translation of the point vlocalposition of the link
+        /// \param[out] pangularhessian if not NULL, GetNumColumns()x3xGetNumColumns() hessian of the axis-angle rotation of the link
+        /// \param pMimicPartials same as in \ref ComputeJacobians
+        void ComputeHessians(const Transform* pLinkTransforms, dReal* ptranslationhessian, dReal* pangularhessian, const dReal* pMimicPartials=NULL) const;
+
+        /// \brief the number of columns of the jacobians, the number of dofs the workspace was initialized with
+        inline int GetNumColumns() const {
+            return numcolumns;
+        }
+
+        /// \brief the number of mimic joint axes moving the link
+        inline int GetNumMimicColumns() const {
+            return nummimiccolumns;
+        }
+
+        int linkindex = -1;
+        Vector vlocalposition; ///< point in the frame of the link whose translation jacobian is computed
+        int numcolumns = 0;
+        int nummimiccolumns = 0;
+        std::vector<JacobianColumn> vcolumns; ///< the joint axes moving the link ordered from the root link
+        std::vector<int> vdofcolumns; ///< the column of every dof of the body, -1 if the dof is not in the jacobian. Only set if there are mimic axes.
+    };
+
+    /// \brief The mass properties and joint chain of a body precomputed for evaluating its inverse dynamics at many samples without reading the body state or allocating per sample. Initialized with \ref KinBody::InitInverseDynamicsWorkspace.
+    class OPENRAVE_API InverseDynamicsWorkspace
+    {
+public:
+        /// \brief the inertial properties of a link
+        struct LinkInertia
+        {
+            dReal mass;
+            Vector vlocalcom; ///< center of mass in the link frame
+            TransformMatrix localinertia; ///< rotation part is the inertia tensor about the center of mass in the link frame
+            Transform tlink; ///< transform of the link when the workspace was initialized, used for the links that no joint moves
+        };
+
+        /// \brief a joint of the body in topological order
+        struct JointDynamics
+        {
+            int parentlinkindex; ///< -1 if the joint is attached to the environment
+            int childlinkindex;
+            int dofindex; ///< -1 if the joint is passive, in which case it stays at fixedvalue
+            int jointtype; ///< JointRevolute, JointPrismatic, or 0 if the joint is static
+            Transform tleft, tright; ///< the internal hierarchy transforms of the joint
+            Vector vaxis; ///< normalized axis in the joint frame
+            dReal fixedvalue;
+            dReal coulombfriction, viscousfriction;
+            dReal rotorinertia; ///< rotor inertia of the motor on the load side
+        };
+
+        /** \brief Computes the joint torques for many samples of dof values, velocities, and accelerations.
+
+            Matches \ref KinBody::ComputeInverseDynamics for the workspace's root link transforms, gravity, and motor parameters. The root links are static. Can be called from several threads at once.
+            \param pDOFValues numsamples*dof values, the values of sample i start at pDOFValues[i*dof]
+            \param pDOFVelocities numsamples*dof velocities. If NULL, all velocities are 0
+            \param pDOFAccelerations numsamples*dof accelerations. If NULL, all accelerations are 0
+            \param numsamples the number of samples
+            \param[out] pDOFTorques numsamples*dof torques
+            \param[out] pTorqueValueDerivatives if not NULL, numsamples row-major dof x dof matrices of the partial derivatives of the torques with respect to the dof values, d torque_i / d value_j is at [i*dof+j]
+            \param[out] pTorqueVelocityDerivatives if not NULL, numsamples row-major dof x dof matrices of the partial derivatives of the torques with respect to the dof velocities
+         */
+        void ComputeInverseDynamicsBatch(const dReal* pDOFValues, const dReal* pDOFVelocities, const dReal* pDOFAccelerations, int numsamples, dReal* pDOFTorques, dReal* pTorqueValueDerivatives=NULL, dReal* pTorqueVelocityDerivatives=NULL) const;
+
+        int dof = 0;
+        Vector vgravity;
+        std::vector<LinkInertia> vlinks; ///< indexed by link index
+        std::vector<JointDynamics> vjoints; ///< in topological order
+    };
+
+
     /// \brief Access point of the sensor system that manages the body.
     class OPENRAVE_API ManageData : public boost::enable_shared_from_this<ManageData>
     {
@@ -2809,6 +2908,24 @@ private:
     /// Knowing the dof branches allows the robot to recover the full state of the joints with SetLinkTransformations
     void GetLinkTransformations(std::vector<Transform>& transforms, std::vector<dReal>& doflastsetvalues) const;
 
+    /// \brief computes the transformations of all the links for many configurations at once without modifying the state of the body.
+    ///
+    /// The configurations are computed together joint by joint. The transforms are stored component by component so that revolute and prismatic joints are evaluated with vectorizable loops.
+    /// Joint limits are not checked. Passive joints that are not mimic keep their current values, and links that are not moved by any joint keep their current transforms.
+    /// Throws ORE_NotImplemented if the body has joints following a trajectory.
+    /// \param pJointValues numconfigurations*GetDOF() values, the values of configuration i start at pJointValues[i*GetDOF()]
+    /// \param numconfigurations the number of configurations
+    /// \param[out] vLinkTransforms numconfigurations*GetLinks().size() transforms, the transform of link j for configuration i is at i*GetLinks().size()+j
+    void ComputeLinkTransformationsBatch(const dReal* pJointValues, int numconfigurations, std::vector<Transform>& vLinkTransforms) const;
+
+    /// \brief computes the transformations of all the links for a configuration without modifying the state of the body.
+    ///
+    /// Never writes to the body, so it can be called from several threads at once as long as the body is not modified at the same time.
+    /// Same conventions as \ref ComputeLinkTransformationsBatch.
+    /// \param pJointValues GetDOF() values
+    /// \param[out] pLinkTransforms GetLinks().size() transforms
+    void ComputeLinkTransformations(const dReal* pJointValues, Transform* pLinkTransforms) const;
+
     /// \brief gets the enable states of all links
     void GetLinkEnableStates(std::vector<uint8_t>& enablestates) const;
 
@@ -2983,6 +3100,12 @@ private:
     /// \param dofindices the dof indices to compute the jacobian for. If empty, will compute for all the dofs
     virtual void ComputeJacobianTranslation(const int linkindex, const Vector& position, std::vector<dReal>& jacobian, const std::vector<int>& dofindices = {}) const;
 
+    /// \brief Computes the translation jacobian with respect to a world position for the link transformations computed by \ref ComputeLinkTransformations.
+    ///
+    /// Does not read the state of the body, so it can be called from several threads at once. Throws ORE_NotImplemented if a mimic joint affects the link.
+    /// \param pLinkTransforms GetLinks().size() transforms
+    void ComputeJacobianTranslation(const Transform* pLinkTransforms, const int linkindex, const Vector& position, std::vector<dReal>& jacobian, const std::vector<int>& dofindices = {}) const;
+
     /// \brief calls std::vector version of ComputeJacobian internally
     virtual void CalculateJacobian(const int linkindex, const Vector& position, std::vector<dReal>& jacobian) const;
 
@@ -3005,6 +3128,42 @@ private:
     /// \param vjacobian 3xDOF matrix
     virtual void ComputeJacobianAxisAngle(const int linkindex, std::vector<dReal>& jacobian, const std::vector<int>& dofindices = {}) const;
 
+    /// \brief Computes the angular velocity jacobian of a link for the link transformations computed by \ref ComputeLinkTransformations.
+    ///
+    /// Does not read the state of the body, so it can be called from several threads at once. Throws ORE_NotImplemented if a mimic joint affects the link.
+    /// \param pLinkTransforms GetLinks().size() transforms
+    void ComputeJacobianAxisAngle(const Transform* pLinkTransforms, const int linkindex, std::vector<dReal>& jacobian, const std::vector<int>& dofindices = {}) const;
+
+    /// \brief Precomputes the joint axes affecting a link for computing its jacobians repeatedly with JacobianWorkspace::ComputeJacobians and \ref ComputeJacobiansBatch.
+    ///
+    /// The passive mimic joints moving the link are stored as mimic columns, whose partial derivatives depend on the configuration and are computed with \ref ComputeJacobianMimicPartials.
+    /// \param linkindex index of the link
+    /// \param vlocalposition point in the frame of the link whose translation jacobian is computed
+    /// \param dofindices the dof indices to compute the jacobian for, in the order of the columns. If empty, will compute for all the dofs
+    /// \param[out] workspace
+    void InitJacobianWorkspace(int linkindex, const Vector& vlocalposition, const std::vector<int>& dofindices, JacobianWorkspace& workspace) const;
+
+    /// \brief Computes the jacobians of many links for many configurations at once without modifying the state of the body.
+    ///
+    /// \param pJointValues numconfigurations*GetDOF() values, the values of configuration i start at pJointValues[i*GetDOF()]
+    /// \param numconfigurations the number of configurations
+    /// \param vworkspaces workspaces initialized by \ref InitJacobianWorkspace, one per link jacobian to compute
+    /// \param[out] pjacobians caller owned buffer of numconfigurations times the sum of 6*GetNumColumns() of the workspaces. For every configuration and then every workspace, the 3xGetNumColumns() translation jacobian is followed by the 3xGetNumColumns() angular velocity jacobian.
+    void ComputeJacobiansBatch(const dReal* pJointValues, int numconfigurations, const std::vector<JacobianWorkspace>& vworkspaces, dReal* pjacobians) const;
+
+    /// \brief Computes the hessians of many links for many configurations at once without modifying the state of the body.
+    ///
+    /// Same conventions as \ref ComputeJacobiansBatch.
+    /// \param[out] phessians caller owned buffer of numconfigurations times the sum of 6*GetNumColumns()^2 of the workspaces. For every configuration and then every workspace, the GetNumColumns()x3xGetNumColumns() translation hessian is followed by the GetNumColumns()x3xGetNumColumns() axis-angle hessian.
+    void ComputeHessiansBatch(const dReal* pJointValues, int numconfigurations, const std::vector<JacobianWorkspace>& vworkspaces, dReal* phessians) const;
+
+    /// \brief Computes the partial derivatives of the mimic axes of a jacobian workspace with respect to its columns for a configuration without modifying the state of the body.
+    ///
+    /// Passive joints that are not mimic keep their current values, as in \ref ComputeLinkTransformations.
+    /// \param pJointValues GetDOF() values
+    /// \param[out] pMimicPartials workspace.GetNumMimicColumns()*workspace.GetNumColumns() values, the partials of the mimic axis i start at pMimicPartials[i*workspace.GetNumColumns()]
+    void ComputeJacobianMimicPartials(const dReal* pJointValues, const JacobianWorkspace& workspace, dReal* pMimicPartials) const;
+
     /// \brief Computes the angular velocity jacobian of a specified link about the axes of world coordinates.
     virtual void CalculateAngularVelocityJacobian(const int linkindex, std::vector<dReal>& jacobian) const;
 
@@ -3091,6 +3250,14 @@ private:
      */
     virtual void ComputeInverseDynamics(boost::array< std::vector<dReal>, 3>& doftorquecomponents, const std::vector<dReal>& dofaccelerations, const ForceTorqueMap& externalforcetorque=ForceTorqueMap()) const;
 
+    /** \brief Precomputes the link inertias and the joint chain for evaluating the inverse dynamics with InverseDynamicsWorkspace::ComputeInverseDynamicsBatch.
+
+        The gravity is read from GetEnv()->GetPhysicsEngine()->GetGravity() and the links that no joint moves keep their current transforms.
+        Throws ORE_NotImplemented if the body has mimic joints or joints that are not revolute or prismatic.
+        \param[out] workspace
+     */
+    void InitInverseDynamicsWorkspace(InverseDynamicsWorkspace& workspace) const;
+
     /** \brief Computes dynamic limits for acceleration and jerks, which are dynamically changing based on the given positions and velocities of the robot.
 
         Since not all robots supports dynamic limits, so this function should be overriden in the subclass.
@@ -3605,6 +3772,28 @@ protected:
     /// \brief Update transforms and velocities of the grabbed bodies
     void _UpdateGrabbedBodies();
 
+    /// \brief evaluates the value of a mimic axis of a joint from the values it depends on, picking the first value inside the joint limits like SetDOFValues with CLA_Nothing.
+    ///
+    /// Can be called from several threads at once.
+    /// \param veval cache for the candidate values
+    dReal _EvalMimicJointValue(const Joint& joint, int iaxis, const std::vector<dReal>& vdependentvalues, std::vector<dReal>& veval) const;
+
+    /// \brief computes the values of all the passive joints for a configuration, passive joints that are not mimic keep their current values.
+    ///
+    /// Can be called from several threads at once.
+    /// \param pJointValues GetDOF() values
+    /// \param[out] vPassiveJointValues the values of every axis of the passive joints, in the order of _vPassiveJoints
+    void _ComputePassiveJointValues(const dReal* pJointValues, std::vector< boost::array<dReal, 3> >& vPassiveJointValues) const;
+
+    /// \brief computes the partial derivatives of the mimic axes of a jacobian workspace from the values of the passive joints computed by \ref _ComputePassiveJointValues
+    void _ComputeJacobianMimicPartials(const dReal* pJointValues, const std::vector< boost::array<dReal, 3> >& vPassiveJointValues, const JacobianWorkspace& workspace, dReal* pMimicPartials) const;
+
+    /// \brief adds the partial derivatives of a mimic axis with respect to the dofs scaled by fscale to pMimicPartials, following the mimic joints it depends on with the chain rule.
+    ///
+    /// Can be called from several threads at once.
+    /// \param vdofcolumns the column in pMimicPartials of every dof, -1 if the dof is not used
+    void _AccumulateMimicPartials(const Joint& joint, int iaxis, const dReal* pJointValues, const std::vector< boost::array<dReal, 3> >& vPassiveJointValues, dReal fscale, const std::vector<int>& vdofcolumns, dReal* pMimicPartials) const;
+
     /// \brief resets cached information dependent on the collision checker (usually called when the collision checker is switched or some big mode is set.
     virtual void _ResetInternalCollisionCache();
 
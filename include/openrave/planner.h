@@ -40,6 +40,8 @@ enum ConstraintFilterOptions
     CFO_FromPathSampling=0x00080000, ///< if set, will use \ref NSO_FromPathSampling for the _neighstatefn
     CFO_FromPathShortcutting=0x00100000, ///< if set, will use \ref NSO_FromPathShortcutting for the _neighstatefn
     CFO_FromTrajectorySmoother=0x00200000, ///< if set, will use \ref NSO_FromTrajectorySmoother for the _neighstatefn
+    CFO_CheckContinuousCollisions=0x00400000, ///< if set, the environment and self-collisions of linear and parabolic segments are checked with a single continuous collision query (\ref CollisionCheckerBase::CheckContinuousCollision) instead of at every discretized step. Falls back to the discretized checks when not supported.
+    CFO_CheckInBisectionOrder=0x00800000, ///< if set, the environment and self-collisions at the discretized steps of linear and parabolic segments are checked in bisection (van der Corput) order, starting from the middle of the segment. Segments colliding far from their ends are rejected after a few checks. The remaining constraints and \ref CFO_FillCheckedConfiguration still go through the steps in time order.
     CFO_FinalValuesNotReached=0x40000000, ///< if set, then the final values of the interpolation have not been reached, although a close interpolation has been computed. This happens when manipulator constraints are used.
     CFO_StateSettingError=0x80000000, ///< error when the state setting function (or neighbor function) breaks
     CFO_RecommendedOptions = 0x0000ffff, ///< recommended options that all plugins should use by default
@@ -264,6 +266,12 @@ private:
     typedef boost::function<dReal(const std::vector<dReal>&, const std::vector<dReal>&)> DistMetricFn;
     DistMetricFn _distmetricfn;
 
+    /// \brief Gets the squared dof weights if _distmetricfn is the weighted euclidean distance sqrt(sum_i weights2[i]*(q0[i]-q1[i])^2).
+    ///
+    /// SetConfigurationSpecification sets such a metric when the configuration has one group of dofs and none of them is circular. Planners can then compute the distances without calling _distmetricfn.
+    /// \return false if _distmetricfn is another function
+    bool GetDistMetricWeights2(std::vector<dReal>& vweights2) const;
+
     /** \brief Checks that all the constraints are satisfied between two configurations and passes in the velocity at each point.
 
         The simplest and most fundamental constraint is linearly interpolating the positions and velocities and checking constraints at each discrete point.
@@ -553,7 +553,7 @@ typedef boost::shared_ptr<TrajectoryTimingParameters const> TrajectoryTimingPara
 class OPENRAVE_API ConstraintTrajectoryTimingParameters : public TrajectoryTimingParameters
 {
 public:
-    ConstraintTrajectoryTimingParameters() : TrajectoryTimingParameters(), maxlinkspeed(0), maxlinkaccel(0), maxmanipspeed(0), maxmanipaccel(0), vConstraintManipDir(0,0,1), vConstraintGlobalDir(0,0,1), fCosManipAngleThresh(-1), mingripperdistance(0), velocitydistancethresh(0), maxmergeiterations(1000), minswitchtime(0.2),nshortcutcycles(1), fSearchVelAccelMult(0.8), durationImprovementCutoffRatio(0.001), _bCProcessing(false) {
+    ConstraintTrajectoryTimingParameters() : TrajectoryTimingParameters(), maxlinkspeed(0), maxlinkaccel(0), maxmanipspeed(0), maxmanipaccel(0), vConstraintManipDir(0,0,1), vConstraintGlobalDir(0,0,1), fCosManipAngleThresh(-1), mingripperdistance(0), velocitydistancethresh(0), maxmergeiterations(1000), minswitchtime(0.2),nshortcutcycles(1), fSearchVelAccelMult(0.8), durationImprovementCutoffRatio(0.001), nshortcutworkers(1), _bCProcessing(false) {
         _vXMLParameters.push_back("maxlinkspeed");
         _vXMLParameters.push_back("maxlinkaccel");
         _vXMLParameters.push_back("manipname");
@@ -569,6 +569,7 @@ public:
         _vXMLParameters.push_back("nshortcutcycles");
         _vXMLParameters.push_back("searchvelaccelmult");
         _vXMLParameters.push_back("durationimprovementcutoffratio");
+        _vXMLParameters.push_back("nshortcutworkers");
     }
 
     dReal maxlinkspeed; ///< max speed in m/s that any point on any link goes. 0 means no speed limit
@@ -593,6 +594,11 @@ public:
     dReal fSearchVelAccelMult; ///< a number in [0.0001,0.99999] that is the multipler of the velocity/acceleration limits when time-based constraints are invalidated (manip speed and/or dynamics). The closer to 1 it is, the more optimal the trajectory will be, but it will take more time to compute. A value around 0.5-0.8 is best.
     dReal durationImprovementCutoffRatio; ///< Whenever shortcut is accepted, if change is less than diff/iterations, then do not do anymore shortcutting.
 
+    /// \brief number of threads that evaluate shortcut candidates in parallel, each on its own clone of the environment. By default it is 1.
+    ///
+    /// The workers rebuild the state and constraint functions from _configurationspecification in their environments, so functions set by the user on the parameters are not used by them. Every shortcut they find is checked again with the functions of the parameters before it is applied, so such constraints are still satisfied, but shortcuts rejected by them are wasted work.
+    int nshortcutworkers;
+
 protected:
     bool _bCProcessing;
     virtual bool serialize(std::ostream& O, int options=0) const
@@ -615,6 +621,7 @@ protected:
         O << "<nshortcutcycles>" << nshortcutcycles << "</nshortcutcycles>" << std::endl;
         O << "<searchvelaccelmult>" << fSearchVelAccelMult << "</searchvelaccelmult>" << std::endl;
         O << "<durationimprovementcutoffratio>" << durationImprovementCutoffRatio << "</durationimprovementcutoffratio>" << std::endl;
+        O << "<nshortcutworkers>" << nshortcutworkers << "</nshortcutworkers>" << std::endl;
         if( !(options & 1) ) {
             O << _sExtraParameters << std::endl;
         }
@@ -632,7 +639,7 @@ protected:
         case PE_Support: return PE_Support;
         case PE_Ignore: return PE_Ignore;
         }
-        _bCProcessing = name=="maxlinkspeed" || name =="maxlinkaccel" || name=="manipname" || name=="maxmanipspeed" || name =="maxmanipaccel" || name=="mingripperdistance" || name=="velocitydistancethresh" || name=="maxmergeiterations" || name=="minswitchtime"|| name=="nshortcutcycles" || name=="constraintmanipdir" || name=="constraintglobaldir" || name=="cosmanipanglethresh" || name=="searchvelaccelmult" || name=="durationimprovementcutoffratio";
+        _bCProcessing = name=="maxlinkspeed" || name =="maxlinkaccel" || name=="manipname" || name=="maxmanipspeed" || name =="maxmanipaccel" || name=="mingripperdistance" || name=="velocitydistancethresh" || name=="maxmergeiterations" || name=="minswitchtime"|| name=="nshortcutcycles" || name=="constraintmanipdir" || name=="constraintglobaldir" || name=="cosmanipanglethresh" || name=="searchvelaccelmult" || name=="durationimprovementcutoffratio" || name=="nshortcutworkers";
         return _bCProcessing ? PE_Support : PE_Pass;
     }
 
@@ -675,6 +682,9 @@ protected:
             else if( name == "durationimprovementcutoffratio" ) {
                 _ss >> durationImprovementCutoffRatio;
             }
+            else if( name == "nshortcutworkers" ) {
+                _ss >> nshortcutworkers;
+            }
             else if( name == "constraintmanipdir" ) {
                 _ss >> vConstraintManipDir;
             }
@@ -733,12 +743,20 @@ typedef boost::shared_ptr<WorkspaceTrajectoryParameters const> WorkspaceTrajecto
 class OPENRAVE_API RRTParameters : public PlannerBase::PlannerParameters
 {
 public:
-    RRTParameters() : _minimumgoalpaths(1), _bProcessing(false) {
+    RRTParameters() : _minimumgoalpaths(1), _nNumWorkers(1), _bProcessing(false) {
         _vXMLParameters.push_back("minimumgoalpaths");
+        _vXMLParameters.push_back("numworkers");
     }
 
     size_t _minimumgoalpaths; ///< minimum number of goals to connect to before exiting. the goal with the shortest path is returned.
 
+    /// \brief number of planners to run in parallel, each on its own clone of the environment. The path of the first planner to connect is returned. By default it is 1.
+    ///
+    /// The workers rebuild the state and constraint functions from _configurationspecification in their environments, so functions set by the user on the parameters are not used by them.
+    /// The path of the workers is checked again with _checkpathvelocityconstraintsfn of these parameters, and the query is planned with one thread if it fails.
+    /// The cloned environments are kept by the planner between queries.
+    int _nNumWorkers;
+
 protected:
     bool _bProcessing;
     virtual bool serialize(std::ostream& O, int options=0) const
@@ -747,6 +765,7 @@ protected:
             return false;
         }
         O << "<minimumgoalpaths>" << _minimumgoalpaths << "</minimumgoalpaths>" << std::endl;
+        O << "<numworkers>" << _nNumWorkers << "</numworkers>" << std::endl;
         if( !(options & 1) ) {
             O << _sExtraParameters << std::endl;
         }
@@ -764,7 +783,7 @@ protected:
         case PE_Ignore: return PE_Ignore;
         }
 
-        _bProcessing = name=="minimumgoalpaths";
+        _bProcessing = name=="minimumgoalpaths" || name=="numworkers";
         return _bProcessing ? PE_Support : PE_Pass;
     }
 
@@ -774,6 +793,9 @@ protected:
             if( name == "minimumgoalpaths") {
                 _ss >> _minimumgoalpaths;
             }
+            else if( name == "numworkers") {
+                _ss >> _nNumWorkers;
+            }
             else {
                 RAVELOG_WARN(str(boost::format("unknown tag %s\n")%name));
             }
@@ -418,7 +418,7 @@ OPENRAVE_API void GetDHParameters(std::vector<DHParameter>&vparameters, KinBodyC
 
 /** \brief dynamics and collision checking with linear interpolation
 
-    For any joints with maxtorque > 0, uses KinBody::ComputeInverseDynamics to check if the necessary torque exceeds the max torque. Max torque is always called via GetMaxTorque
+    For any joints with maxtorque > 0, uses KinBody::InverseDynamicsWorkspace (or KinBody::ComputeInverseDynamics for moving bases and mimic joints) to check if the necessary torque exceeds the max torque. Max torque is always called via GetMaxTorque
  **/
 class OPENRAVE_API DynamicsCollisionConstraint
 {
@@ -444,6 +444,11 @@ public:
     /// \param perturbation It is multiplied by each DOF's resolution (_vConfigResolution) before added to the state.
     virtual void SetPerturbation(dReal perturbation);
 
+    /// \brief sets the distance under which continuous collision checking considers the bodies in collision, see \ref CFO_CheckContinuousCollisions.
+    ///
+    /// By default it is 0.001.
+    virtual void SetContinuousCollisionTolerance(dReal tolerance);
+
     /// \brief if using dynamics limiting, choose whether to use the nominal torque or max instantaneous torque.
     ///
     /// \param torquelimitmode 1 if should use instantaneous max torque, 0 if should use nominal torque
@@ -479,6 +484,23 @@ protected:
     virtual int _SetAndCheckState(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& vdofvalues, const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn);
     virtual void _PrintOnFailure(const std::string& prefix);
 
+    /// \brief checks the environment and self-collisions of the whole linear or parabolic segment with one continuous collision query of the checked body
+    ///
+    /// \param q1 the end of the segment, q1-q0 has to be the motion of the segment (already taking into account circular joints)
+    /// \param timeelapsed the segment is linear if 0 or if the velocities are empty
+    /// \param options should already be masked with _filtermask
+    /// \param[out] nCheckedOptions the mask of CFO_CheckEnvCollisions and CFO_CheckSelfCollisions that were checked on the segment, so do not need to be checked at every step. 0 if the continuous check is not supported for the current parameters.
+    virtual int _CheckContinuousCollisions(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& q0, const std::vector<dReal>& q1, const std::vector<dReal>& dq0, const std::vector<dReal>& dq1, dReal timeelapsed, int options, int& nCheckedOptions, ConstraintFilterReturnPtr filterreturn);
+
+    /// \brief checks the environment and self-collisions at the interior discretized steps of the linear or parabolic segment in bisection (van der Corput) order, see \ref CFO_CheckInBisectionOrder.
+    ///
+    /// \param vdelta the motion of the segment (already taking into account circular joints)
+    /// \param timeelapsed the segment is linear if 0 or if the velocities are empty
+    /// \param numSteps the number of steps of a linear segment. parabolic segments are divided uniformly in time so that no dof moves more than its resolution between steps.
+    /// \param options should already be masked with _filtermask
+    /// \param[out] nCheckedOptions the mask of CFO_CheckEnvCollisions and CFO_CheckSelfCollisions that were checked on the segment, so do not need to be checked at every step.
+    virtual int _CheckCollisionsInBisectionOrder(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& q0, const std::vector<dReal>& vdelta, const std::vector<dReal>& dq0, const std::vector<dReal>& dq1, dReal timeelapsed, int numSteps, int options, int& nCheckedOptions, ConstraintFilterReturnPtr filterreturn);
+
     PlannerBase::PlannerParametersWeakConstPtr _parameters;
     std::vector<dReal> _vtempconfig, _vtempvelconfig, dQ, _vtempveldelta, _vtempacceldelta, _vtempaccelconfig, _vtempjerkconfig, _vperturbedvalues, _vcoeff2, _vcoeff1, _vprevtempconfig, _vprevtempvelconfig, _vprevtempaccelconfig, _vtempconfig2, _vdiffconfig, _vdiffvelconfig, _vdiffaccelconfig, _vstepconfig; ///< in configuration space
     std::vector<dReal> _vrawroots, _vrawcoeffs;
@@ -488,13 +510,18 @@ protected:
     int _filtermask;
     DynamicsConstraintsType _torquelimitmode; ///< 1 if should use instantaneous max torque, 0 if should use nominal torque
     dReal _perturbation;
+    dReal _fContinuousCollisionTolerance; ///< distance under which the continuous collision checks consider the bodies in collision
     boost::array< boost::function<bool() >, 2> _usercheckfns;
 
     // for dynamics
     ConfigurationSpecification _specvel;
     std::vector< std::pair<int, std::pair<dReal, dReal> > > _vtorquevalues; ///< cache for dof indices and the torque limits that the current torque should be in
     std::vector< int > _vdofindices;
+    std::vector< int > _vcontinuousdofindices, _vcontinuousconfigindices; ///< for continuous collision checks, the body dofs the configuration maps to
+    std::vector<dReal> _vcontinuousq1; ///< for continuous collision checks
+    std::vector< std::pair<int, int> > _vbisectionintervals; ///< queue of the step intervals left to bisect for \ref _CheckCollisionsInBisectionOrder
     std::vector<dReal> _doftorques, _dofaccelerations; ///< in body DOF space
+    KinBody::InverseDynamicsWorkspace _inversedynamicsworkspace; ///< for checking the torque limits without allocating
     boost::shared_ptr<ConfigurationSpecification::SetConfigurationStateFn> _setvelstatefn;
     std::vector<dReal> _vfulldofdynamicaccelerationlimits, _vfulldofdynamicjerklimits, _vfulldofvalues, _vfulldofvelocities; ///< in body full DOF space. the size is GetDOF().
 };
@@ -51,6 +51,9 @@ inline void usleep(unsigned long microseconds) {
 #endif
 
 #include <bitset>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace OpenRAVE {
 namespace utils {
@@ -289,6 +292,44 @@ OPENRAVE_API std::string GetMD5HashString(const std::string& s);
 /// \brief compute the md5 hash of an array
 OPENRAVE_API std::string GetMD5HashString(const std::vector<uint8_t>& v);
 
+/// \brief fixed set of threads that all run the same job, used by the plugins to split their work across cores
+///
+/// The thread calling Run also runs the job, so a pool of numthreads only starts numthreads-1 threads.
+class OPENRAVE_API WorkerPool
+{
+public:
+    /// \brief the job, called with the index of the thread running it. Index 0 is the thread calling Run.
+    typedef boost::function<void (int)> JobFn;
+
+    WorkerPool(int numthreads);
+    ~WorkerPool();
+
+    /// \brief number of threads running each job, including the calling thread
+    inline int GetNumThreads() const {
+        return (int)_vthreads.size() + 1;
+    }
+
+    /// \brief runs jobfn on every thread and returns once all of them have finished.
+    ///
+    /// \throw openrave_exception if the job threw on any of the threads
+    void Run(const JobFn& jobfn);
+
+private:
+    void _WorkerThread(int ithread);
+
+    std::vector<boost::shared_ptr<std::thread> > _vthreads;
+    std::mutex _mutex;
+    std::condition_variable _condHasWork; ///< notified when a new job is set or the pool is stopped
+    std::condition_variable _condFinished; ///< notified when the last worker finished the current job
+    JobFn _jobfn; ///< current job
+    uint64_t _nJobStamp; ///< incremented for every new job
+    int _numRunning; ///< number of workers that have not finished the current job
+    std::string _errormessage; ///< set if the current job threw
+    bool _bStop;
+};
+
+typedef boost::shared_ptr<WorkerPool> WorkerPoolPtr;
+
 template<class T>
 inline T ClampOnRange(T value, T min, T max)
 {
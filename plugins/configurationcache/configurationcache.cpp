@@ -19,6 +19,7 @@ namespace configurationcache
 OpenRAVE::CollisionCheckerBasePtr CreateCacheCollisionChecker(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput);
 OpenRAVE::SpaceSamplerBasePtr CreateConfigurationJitterer(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput);
 OpenRAVE::SpaceSamplerBasePtr CreateWorkspaceConfigurationJitterer(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput);
+OpenRAVE::PlannerBasePtr CreatePersistentRoadmapPlanner(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput);
 }
 
 const std::string ConfigurationCachePlugin::_pluginname = "ConfigurationCachePlugin";
@@ -28,6 +29,7 @@ ConfigurationCachePlugin::ConfigurationCachePlugin()
     _interfaces[OpenRAVE::PT_CollisionChecker].push_back("CacheChecker");
     _interfaces[OpenRAVE::PT_SpaceSampler].push_back("ConfigurationJitterer");
     _interfaces[OpenRAVE::PT_SpaceSampler].push_back("WorkspaceConfigurationJitterer");
+    _interfaces[OpenRAVE::PT_Planner].push_back("PersistentRoadmap");
 }
 
 ConfigurationCachePlugin::~ConfigurationCachePlugin() {}
@@ -48,6 +50,11 @@ OpenRAVE::InterfaceBasePtr ConfigurationCachePlugin::CreateInterface(OpenRAVE::I
             return configurationcache::CreateWorkspaceConfigurationJitterer(penv,sinput);
         }
         break;
+    case OpenRAVE::PT_Planner:
+        if( interfacename == "persistentroadmap" ) {
+            return configurationcache::CreatePersistentRoadmapPlanner(penv,sinput);
+        }
+        break;
     default:
         break;
     }
@@ -17,6 +17,9 @@
 #include <boost/lexical_cast.hpp>
 
 #include <boost/multi_array.hpp>
+#include <boost/crc.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <algorithm>
 
 using boost::multi_array;
@@ -28,6 +31,15 @@ inline dReal Sqr(dReal x) {
     return x*x;
 }
 
+/// \brief buffers for traversing the levels in the nearest node queries. The queries run concurrently under a shared lock, so every thread has its own.
+struct NearestNodeQueryCache
+{
+    std::vector< std::pair<CacheTreeNodePtr, dReal> > vCurrentLevelNodes, vNextLevelNodes;
+    std::vector< std::pair<CacheTreeNodeConstPtr, dReal> > vNearestNodes;
+};
+
+static thread_local NearestNodeQueryCache s_nearestnodequerycache;
+
 CacheTreeNode::CacheTreeNode(const std::vector<dReal>& cs, Vector* plinkspheres)
 {
     std::copy(cs.begin(), cs.end(), _pcstate);
@@ -42,6 +54,7 @@ CacheTreeNode::CacheTreeNode(const std::vector<dReal>& cs, Vector* plinkspheres)
     _hasselfchild = 0;
     _usenn = 1;
     _hitcount = 0;
+    _userindex = -1;
 }
 
 CacheTreeNode::CacheTreeNode(const dReal* pstate, int dof, Vector* plinkspheres)
@@ -54,6 +67,7 @@ CacheTreeNode::CacheTreeNode(const dReal* pstate, int dof, Vector* plinkspheres)
     _hasselfchild = 0;
     _usenn = 1;
     _hitcount = 0;
+    _userindex = -1;
 }
 
 void CacheTreeNode::SetCollisionInfo(CollisionReportPtr report)
@@ -107,11 +121,6 @@ void CacheTreeNode::SetCollisionInfo(int robotlinkindex, int type)
 CacheTree::CacheTree(int statedof)
 {
     _poolNodes.reset(new boost::pool<>(sizeof(CacheTreeNode)+sizeof(dReal)*statedof));
-    _vnodes.resize(0);
-    _dummycs.resize(0);
-    _fulldirname.resize(0);
-    _mapNodeIndices.clear();
-    _collidingbodyname.resize(0);
 
     _statedof=statedof;
     _weights.resize(_statedof, 1.0);
@@ -126,7 +135,8 @@ CacheTree::~CacheTree()
 
 void CacheTree::Init(const std::vector<dReal>& weights, dReal maxdistance)
 {
-    Reset();
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
+    _Reset();
     _weights = weights;
     _statedof = (int)_weights.size();
     _numnodes = 0;
@@ -146,13 +156,12 @@ void CacheTree::Init(const std::vector<dReal>& weights, dReal maxdistance)
 
 void CacheTree::Reset()
 {
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
+    _Reset();
+}
 
-    _vnodes.resize(0);
-    _dummycs.resize(0);
-    _fulldirname.resize(0);
-    _mapNodeIndices.clear();
-    _collidingbodyname.resize(0);
-
+void CacheTree::_Reset()
+{
     // make sure all children are deleted
     for(size_t ilevel = 0; ilevel < _vsetLevelNodes.size(); ++ilevel) {
         FOREACH(itnode, _vsetLevelNodes[ilevel]) {
@@ -162,9 +171,6 @@ void CacheTree::Reset()
     FOREACH(itchildren, _vsetLevelNodes) {
         itchildren->clear();
     }
-    FOREACH(itnode, _vnodes) {
-        (*itnode)->~CacheTreeNode();
-    }
     // purge_memory leaks!
     //_poolNodes.purge_memory();
     _poolNodes.reset(new boost::pool<>(sizeof(CacheTreeNode)+sizeof(dReal)*_statedof));
@@ -179,11 +185,7 @@ static int s_CacheTreeId = 0;
 CacheTreeNodePtr CacheTree::_CreateCacheTreeNode(const std::vector<dReal>& cs, CollisionReportPtr report)
 {
     // allocate memory for the structure and the internal state vectors
-    void* pmemory;
-    {
-        //std::lock_guard<std::mutex> lock(_mutexpool);
-        pmemory = _poolNodes->malloc();
-    }
+    void* pmemory = _poolNodes->malloc();
     //Vector* plinkspheres = (Vector*)((uint8_t*)pmemory + sizeof(CacheTreeNode) + sizeof(dReal)*_statedof);
     CacheTreeNodePtr newnode = new (pmemory) CacheTreeNode(cs, NULL);
 #ifdef _DEBUG
@@ -196,18 +198,15 @@ CacheTreeNodePtr CacheTree::_CreateCacheTreeNode(const std::vector<dReal>& cs, C
 CacheTreeNodePtr CacheTree::_CloneCacheTreeNode(CacheTreeNodeConstPtr refnode)
 {
     // allocate memory for the structure and the internal state vectors
-    void* pmemory;
-    {
-        //std::lock_guard<std::mutex> lock(_mutexpool);
-        pmemory = _poolNodes->malloc();
-    }
+    void* pmemory = _poolNodes->malloc();
     //Vector* plinkspheres = (Vector*)((uint8_t*)pmemory + sizeof(CacheTreeNode) + sizeof(dReal)*_statedof);
     CacheTreeNodePtr clonenode = new (pmemory) CacheTreeNode(refnode->GetConfigurationState(), _statedof, refnode->_plinkspheres);
 #ifdef _DEBUG
     clonenode->id = s_CacheTreeId++;
 #endif
     clonenode->_conftype = refnode->_conftype;
-    clonenode->_hitcount = refnode->_hitcount;
+    clonenode->_hitcount = refnode->_hitcount.load(std::memory_order_relaxed);
+    clonenode->_userindex = refnode->_userindex;
     if( clonenode->IsInCollision() ) {
         clonenode->_collidinglink = refnode->_collidinglink;
         clonenode->_collidinglinktrans = refnode->_collidinglinktrans;
@@ -225,6 +224,7 @@ void CacheTree::_DeleteCacheTreeNode(CacheTreeNodePtr pnode)
 
 dReal CacheTree::ComputeDistance(const std::vector<dReal>& cstatei, const std::vector<dReal>& cstatef) const
 {
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
     return RaveSqrt(_ComputeDistance2(&cstatei[0], &cstatef[0]));
 }
 
@@ -240,13 +240,15 @@ dReal CacheTree::_ComputeDistance2(const dReal* cstatei, const dReal* cstatef) c
 
 void CacheTree::SetWeights(const std::vector<dReal>& weights)
 {
-    Reset();
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
+    _Reset();
     _weights = weights;
 }
 
 void CacheTree::SetMaxDistance(dReal maxdistance)
 {
-    Reset();
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
+    _Reset();
     _maxdistance = maxdistance;
     _maxlevel = ceilf(RaveLog(_maxdistance)/RaveLog(_base));
     _minlevel = _maxlevel - 1;
@@ -259,7 +261,8 @@ void CacheTree::SetMaxDistance(dReal maxdistance)
 
 void CacheTree::SetBase(dReal base)
 {
-    Reset();
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
+    _Reset();
     _statedof = (int)_weights.size();
     _base = base;
     _fBaseInv = 1/_base;
@@ -274,8 +277,42 @@ void CacheTree::SetBase(dReal base)
     }
 }
 
-std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::vector<dReal>& vquerystate, dReal distancebound, ConfigurationNodeType conftype) const
+void CacheTree::_GetNodeInfo(CacheTreeNodeConstPtr pnode, dReal distance, CacheTreeNodeInfo& info) const
+{
+    info.vstate.assign(pnode->GetConfigurationState(), pnode->GetConfigurationState()+_statedof);
+    info.conftype = pnode->GetType();
+    info.collidinglink = pnode->_collidinglink;
+    info.robotlinkindex = pnode->_robotlinkindex;
+    info.userindex = pnode->_userindex;
+    info.distance = distance;
+}
+
+bool CacheTree::FindNearestNode(const std::vector<dReal>& vquerystate, dReal distancebound, ConfigurationNodeType conftype, CacheTreeNodeInfo& info) const
 {
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+    std::pair<CacheTreeNodeConstPtr, dReal> bestnode = _FindNearestNode(vquerystate, distancebound, conftype);
+    if( !bestnode.first ) {
+        return false;
+    }
+    _GetNodeInfo(bestnode.first, bestnode.second, info);
+    return true;
+}
+
+bool CacheTree::FindNearestNode(const std::vector<dReal>& vquerystate, dReal collisionthresh, dReal freespacethresh, CacheTreeNodeInfo& info) const
+{
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+    std::pair<CacheTreeNodeConstPtr, dReal> bestnode = _FindNearestNode(vquerystate, collisionthresh, freespacethresh);
+    if( !bestnode.first ) {
+        return false;
+    }
+    _GetNodeInfo(bestnode.first, bestnode.second, info);
+    return true;
+}
+
+std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::_FindNearestNode(const std::vector<dReal>& vquerystate, dReal distancebound, ConfigurationNodeType conftype) const
+{
+    std::vector< std::pair<CacheTreeNodePtr, dReal> >& vCurrentLevelNodes = s_nearestnodequerycache.vCurrentLevelNodes;
+    std::vector< std::pair<CacheTreeNodePtr, dReal> >& vNextLevelNodes = s_nearestnodequerycache.vNextLevelNodes;
     if( _numnodes == 0 ) {
         return make_pair(CacheTreeNodeConstPtr(), dReal(0));
     }
@@ -289,17 +326,17 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
     int currentlevel = _maxlevel; // where the root node is
     // traverse all levels gathering up the children at each level
     dReal fLevelBound2 = Sqr(_fMaxLevelBound);
-    _vCurrentLevelNodes.resize(1);
-    _vCurrentLevelNodes[0].first = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
-    _vCurrentLevelNodes[0].second = _ComputeDistance2(pquerystate, _vCurrentLevelNodes[0].first->GetConfigurationState());
-    if( (conftype == CNT_Any || _vCurrentLevelNodes[0].first->GetType() == conftype) && _vCurrentLevelNodes[0].first->_usenn ) {
-        pbestnode = _vCurrentLevelNodes[0].first;
-        bestdist2 = _vCurrentLevelNodes[0].second;
-    }
-    while(_vCurrentLevelNodes.size() > 0 ) {
-        _vNextLevelNodes.resize(0);
+    vCurrentLevelNodes.resize(1);
+    vCurrentLevelNodes[0].first = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
+    vCurrentLevelNodes[0].second = _ComputeDistance2(pquerystate, vCurrentLevelNodes[0].first->GetConfigurationState());
+    if( (conftype == CNT_Any || vCurrentLevelNodes[0].first->GetType() == conftype) && vCurrentLevelNodes[0].first->_usenn ) {
+        pbestnode = vCurrentLevelNodes[0].first;
+        bestdist2 = vCurrentLevelNodes[0].second;
+    }
+    while(vCurrentLevelNodes.size() > 0 ) {
+        vNextLevelNodes.resize(0);
         dReal minchilddist2 = std::numeric_limits<dReal>::infinity();
-        FOREACH(itcurrentnode, _vCurrentLevelNodes) {
+        FOREACH(itcurrentnode, vCurrentLevelNodes) {
             // only take the children whose distances are within the bound
             FOREACHC(itchild, itcurrentnode->first->_vchildren) {
                 dReal curdist2 = _ComputeDistance2(pquerystate, (*itchild)->GetConfigurationState());
@@ -313,22 +350,22 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
                         }
                     }
                 }
-                _vNextLevelNodes.emplace_back(*itchild,  curdist2);
+                vNextLevelNodes.emplace_back(*itchild,  curdist2);
                 if( minchilddist2 > curdist2 ) {
                     minchilddist2 = curdist2;
                 }
             }
         }
 
-        _vCurrentLevelNodes.resize(0);
+        vCurrentLevelNodes.resize(0);
         // have to compute dist < RaveSqrt(minchilddist2) + fLevelBound
         // dist2 < m2 + 2mL + L2
 
         dReal ftestbound2 = 4*minchilddist2*fLevelBound2;
-        FOREACH(itnode, _vNextLevelNodes) {
+        FOREACH(itnode, vNextLevelNodes) {
             dReal f = itnode->second - minchilddist2 - fLevelBound2;
             if( f <= 0 || Sqr(f) <= ftestbound2 ) {
-                _vCurrentLevelNodes.push_back(*itnode);
+                vCurrentLevelNodes.push_back(*itnode);
             }
         }
         currentlevel -= 1;
@@ -341,8 +378,10 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
     return make_pair(CacheTreeNodeConstPtr(), dReal(0));
 }
 
-std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::vector<dReal>& vquerystate, dReal collisionthresh, dReal freespacethresh) const
+std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::_FindNearestNode(const std::vector<dReal>& vquerystate, dReal collisionthresh, dReal freespacethresh) const
 {
+    std::vector< std::pair<CacheTreeNodePtr, dReal> >& vCurrentLevelNodes = s_nearestnodequerycache.vCurrentLevelNodes;
+    std::vector< std::pair<CacheTreeNodePtr, dReal> >& vNextLevelNodes = s_nearestnodequerycache.vNextLevelNodes;
     std::pair<CacheTreeNodeConstPtr, dReal> bestnode;
     bestnode.first = NULL;
     bestnode.second = std::numeric_limits<dReal>::infinity();
@@ -372,15 +411,15 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
                 bestnode = make_pair(proot,RaveSqrt(curdist2));
             }
         }
-        _vCurrentLevelNodes.resize(1);
-        _vCurrentLevelNodes[0].first = proot;
-        _vCurrentLevelNodes[0].second = curdist2;
+        vCurrentLevelNodes.resize(1);
+        vCurrentLevelNodes[0].first = proot;
+        vCurrentLevelNodes[0].second = curdist2;
     }
-    dReal pruneradius2 = Sqr(_maxdistance); // the radius to prune all _vCurrentLevelNodes when going through them. Equivalent to min(query,children) + levelbound from the previous iteration
-    while(_vCurrentLevelNodes.size() > 0 ) {
-        _vNextLevelNodes.resize(0);
+    dReal pruneradius2 = Sqr(_maxdistance); // the radius to prune all vCurrentLevelNodes when going through them. Equivalent to min(query,children) + levelbound from the previous iteration
+    while(vCurrentLevelNodes.size() > 0 ) {
+        vNextLevelNodes.resize(0);
         dReal minchilddist=_maxdistance;
-        FOREACH(itcurrentnode, _vCurrentLevelNodes) {
+        FOREACH(itcurrentnode, vCurrentLevelNodes) {
             if( itcurrentnode->second > pruneradius2 ) {
                 continue;
             }
@@ -402,7 +441,7 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
                     }
                 }
                 if( curdist2 < comparedist2 ) {
-                    _vNextLevelNodes.emplace_back(*itchild,  curdist2);
+                    vNextLevelNodes.emplace_back(*itchild,  curdist2);
                     if( Sqr(minchilddist) > curdist2 ) {
                         minchilddist = RaveSqrt(curdist2);
                         comparedist2 = Sqr(minchilddist + fLevelBound);
@@ -411,7 +450,7 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
             }
         }
 
-        _vCurrentLevelNodes.swap(_vNextLevelNodes);
+        vCurrentLevelNodes.swap(vNextLevelNodes);
         pruneradius2 = Sqr(minchilddist + fLevelBound);
         currentlevel -= 1;
         fLevelBound *= _fBaseInv;
@@ -424,11 +463,100 @@ std::pair<CacheTreeNodeConstPtr, dReal> CacheTree::FindNearestNode(const std::ve
     return bestnode;
 }
 
-int CacheTree::InsertNode(const std::vector<dReal>& cs, CollisionReportPtr report, dReal fMinSeparationDist)
+int CacheTree::FindNearestNodes(const std::vector<dReal>& vquerystate, int numnodes, ConfigurationNodeType conftype, std::vector<CacheTreeNodeInfo>& vnearestnodeinfos) const
+{
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+    std::vector< std::pair<CacheTreeNodeConstPtr, dReal> >& vnearestnodes = s_nearestnodequerycache.vNearestNodes;
+    _FindNearestNodes(vquerystate, numnodes, conftype, vnearestnodes);
+    vnearestnodeinfos.resize(vnearestnodes.size());
+    for(size_t inode = 0; inode < vnearestnodes.size(); ++inode) {
+        _GetNodeInfo(vnearestnodes[inode].first, vnearestnodes[inode].second, vnearestnodeinfos[inode]);
+    }
+    return vnearestnodeinfos.size();
+}
+
+void CacheTree::_FindNearestNodes(const std::vector<dReal>& vquerystate, int numnodes, ConfigurationNodeType conftype, std::vector< std::pair<CacheTreeNodeConstPtr, dReal> >& vnearestnodes) const
+{
+    std::vector< std::pair<CacheTreeNodePtr, dReal> >& vCurrentLevelNodes = s_nearestnodequerycache.vCurrentLevelNodes;
+    std::vector< std::pair<CacheTreeNodePtr, dReal> >& vNextLevelNodes = s_nearestnodequerycache.vNextLevelNodes;
+    vnearestnodes.resize(0);
+    if( _numnodes == 0 || numnodes <= 0 ) {
+        return;
+    }
+
+    OPENRAVE_ASSERT_OP(vquerystate.size(),==,_weights.size());
+    const dReal* pquerystate = &vquerystate[0];
+
+    // vnearestnodes is a max-heap on the squared distance, so the front is the farthest of the nodes found so far
+    const auto fcompare = [](const std::pair<CacheTreeNodeConstPtr, dReal>& a, const std::pair<CacheTreeNodeConstPtr, dReal>& b) {
+        return a.second < b.second;
+    };
+    const auto faddnode = [&](CacheTreeNodeConstPtr pnode, dReal curdist2) {
+        if( !pnode->_usenn || (conftype != CNT_Any && pnode->GetType() != conftype) ) {
+            return;
+        }
+        if( (int)vnearestnodes.size() >= numnodes && curdist2 >= vnearestnodes.front().second ) {
+            return;
+        }
+        // clones of a node are at the same configuration
+        FOREACHC(itnode, vnearestnodes) {
+            if( itnode->second == curdist2 && std::equal(pnode->GetConfigurationState(), pnode->GetConfigurationState()+_statedof, itnode->first->GetConfigurationState()) ) {
+                return;
+            }
+        }
+        if( (int)vnearestnodes.size() >= numnodes ) {
+            std::pop_heap(vnearestnodes.begin(), vnearestnodes.end(), fcompare);
+            vnearestnodes.pop_back();
+        }
+        vnearestnodes.emplace_back(pnode, curdist2);
+        std::push_heap(vnearestnodes.begin(), vnearestnodes.end(), fcompare);
+    };
+
+    dReal fLevelBound = _fMaxLevelBound;
+    vCurrentLevelNodes.resize(1);
+    vCurrentLevelNodes[0].first = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
+    vCurrentLevelNodes[0].second = _ComputeDistance2(pquerystate, vCurrentLevelNodes[0].first->GetConfigurationState());
+    faddnode(vCurrentLevelNodes[0].first, vCurrentLevelNodes[0].second);
+    while(vCurrentLevelNodes.size() > 0 ) {
+        vNextLevelNodes.resize(0);
+        FOREACH(itcurrentnode, vCurrentLevelNodes) {
+            FOREACHC(itchild, itcurrentnode->first->_vchildren) {
+                dReal curdist2 = _ComputeDistance2(pquerystate, (*itchild)->GetConfigurationState());
+                faddnode(*itchild, curdist2);
+                vNextLevelNodes.emplace_back(*itchild, curdist2);
+            }
+        }
+
+        // all descendants of the children are within fLevelBound*_fBaseChildMult of them, so only keep the children that can have descendants closer than the farthest node found so far
+        vCurrentLevelNodes.resize(0);
+        if( (int)vnearestnodes.size() < numnodes ) {
+            vCurrentLevelNodes.swap(vNextLevelNodes);
+        }
+        else {
+            dReal ftestbound = RaveSqrt(vnearestnodes.front().second) + fLevelBound*_fBaseChildMult;
+            dReal ftestbound2 = Sqr(ftestbound);
+            FOREACH(itnode, vNextLevelNodes) {
+                if( itnode->second <= ftestbound2 ) {
+                    vCurrentLevelNodes.push_back(*itnode);
+                }
+            }
+        }
+        fLevelBound *= _fBaseInv;
+    }
+
+    std::sort_heap(vnearestnodes.begin(), vnearestnodes.end(), fcompare);
+    FOREACH(itnode, vnearestnodes) {
+        itnode->second = RaveSqrt(itnode->second);
+    }
+}
+
+int CacheTree::InsertNode(const std::vector<dReal>& cs, CollisionReportPtr report, dReal fMinSeparationDist, int userindex)
 {
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
 
     OPENRAVE_ASSERT_OP(cs.size(),==,_weights.size());
     CacheTreeNodePtr nodein = _CreateCacheTreeNode(cs, report);
+    nodein->_userindex = userindex;
     // if there is no root, make this the root, otherwise call the lowlevel  insert
     if( _numnodes == 0 ) {
         // no root
@@ -606,6 +734,7 @@ bool CacheTree::_InsertDirectly(CacheTreeNodePtr nodein, CacheTreeNodePtr parent
 
 bool CacheTree::RemoveNode(CacheTreeNodeConstPtr _removenode)
 {
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
     if( _numnodes == 0 ) {
         return false;
     }
@@ -614,7 +743,7 @@ bool CacheTree::RemoveNode(CacheTreeNodeConstPtr _removenode)
 
     CacheTreeNodePtr proot = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
     if( _numnodes == 1 && removenode == proot ) {
-        Reset();
+        _Reset();
         return true;
     }
 
@@ -751,6 +880,7 @@ bool CacheTree::_Remove(CacheTreeNodePtr removenode, std::vector< std::vector<Ca
 
 void CacheTree::GetNodeValues(std::vector<dReal>& vals) const
 {
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
     vals.resize(0);
     if( (int)vals.capacity() < _numnodes*_statedof) {
         vals.reserve(_numnodes*_statedof);
@@ -764,6 +894,7 @@ void CacheTree::GetNodeValues(std::vector<dReal>& vals) const
 
 void CacheTree::GetNodeValuesList(std::vector<CacheTreeNodePtr>& lvals)
 {
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
     lvals.resize(0);
     if (_numnodes > 0) {
         FOREACH(itlevelnodes, _vsetLevelNodes) {
@@ -773,6 +904,7 @@ void CacheTree::GetNodeValuesList(std::vector<CacheTreeNodePtr>& lvals)
 }
 int CacheTree::RemoveCollisionConfigurations()
 {
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
 
     int nremoved=0;
     if (_numnodes > 0) {
@@ -786,169 +918,368 @@ int CacheTree::RemoveCollisionConfigurations()
     return nremoved;
 }
 
-int CacheTree::SaveCache(std::string filename)
-{
-    //std::lock_guard<std::mutex> lock(_mutexpool);
-    _mapNodeIndices.clear();
-    int index=0;
-    int knownnodes=0;
-    FOREACH(itlevelnodes, _vsetLevelNodes) {
-        FOREACH(itnode, *itlevelnodes) {
-            if( (*itnode)->_conftype != CNT_Unknown) {
-                knownnodes++;
-            }
-            _mapNodeIndices[*itnode] = index++;
-        }
-    }
+namespace {
 
-    _numnodes = knownnodes;
-    _fulldirname = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
+/// \brief version of the cache file format, increase when the layout of the structures below changes
+static const uint32_t s_cacheFileVersion = 2;
+static const char s_cacheFileMagic[8] = {'O','R','C','A','C','H','E','\0'};
+static const uint32_t s_cacheFileEndianMarker = 0x01020304;
 
-    RAVELOG_DEBUG_FORMAT("Writing cache to %s, size=%d", _fulldirname%_numnodes);
-    
-    FILE* pfile;
-    pfile = fopen(_fulldirname.c_str(),"wb");
+/** The cache file is a header followed by flat arrays that can be used directly from a memory mapping. Every array starts at a multiple of 8 bytes:
 
-    fwrite(&_statedof, sizeof(_statedof), 1, pfile);
-    fwrite(&_weights[0], sizeof(_weights[0])*_weights.size(), 1, pfile);
-    fwrite(&_base, sizeof(_base), 1, pfile);
-    fwrite(&_fBaseInv, sizeof(_fBaseInv), 1, pfile);
-    fwrite(&_fBaseInv2, sizeof(_fBaseInv2), 1, pfile);
-    fwrite(&_fBaseChildMult, sizeof(_fBaseChildMult), 1, pfile);
-    fwrite(&_maxdistance, sizeof(_maxdistance), 1, pfile);
-    fwrite(&_maxlevel, sizeof(_maxlevel), 1, pfile);
-    fwrite(&_minlevel, sizeof(_minlevel), 1, pfile);
-    fwrite(&_numnodes, sizeof(_numnodes), 1, pfile);
-    fwrite(&_fMaxLevelBound, sizeof(_fMaxLevelBound), 1, pfile);
+    - weights: statedof dReal
+    - bodies: numbodies CacheFileBody
+    - nodes: numnodes CacheFileNode
+    - states: numnodes*statedof dReal
+    - children: numchildren int32_t, node index of the child relative to the node index of the parent
+    - names: the names of the bodies
+ */
+struct CacheFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t realsize; ///< sizeof(dReal)
+    uint32_t endianmarker; ///< s_cacheFileEndianMarker in the byte order of the machine that saved the file
+    int32_t statedof;
+    int32_t numnodes;
+    int32_t numchildren;
+    int32_t numbodies;
+    int32_t namessize; ///< bytes of the names array
+    int32_t maxlevel;
+    int32_t minlevel;
+    dReal base;
+    dReal maxdistance;
+    char statehash[64]; ///< hash of the robot the states are for, empty if not known
+    uint32_t checksum; ///< crc32 of all the arrays after the header
+    uint32_t reserved;
+};
+
+/// \brief body that nodes are in collision with. Bodies are matched with KinBody::GetKinematicsGeometryHash when loading
+struct CacheFileBody
+{
+    char hash[64];
+    int32_t nameoffset; ///< offset in the names array
+    int32_t namelength;
+};
 
-    FOREACH(itlevelnodes, _vsetLevelNodes) {
-        FOREACH(itnode, *itlevelnodes) {
-            _newnode = *itnode;
-            // TODO save only configuration != CNT_Unknown without losing the validity of the tree
-            if (true) { //_newnode->_conftype != CNT_Unknown) {
-                fwrite(&_newnode->_level, sizeof(_newnode->_level), 1, pfile);
-                fwrite(_newnode->GetConfigurationState(), sizeof(dReal)*_statedof, 1, pfile);
-                fwrite(&_newnode->_conftype, sizeof(_newnode->_conftype), 1, pfile);
-
-                if (_newnode->_conftype == CNT_Collision ) {
-                    // note, this assumes the colliding body name never changes across environments, which is a false assumption
-                    _collidingbodyname = _newnode->GetCollidingLink()->GetParent()->GetName();
-                    int namelength = _collidingbodyname.size();
-                    fwrite(&namelength, sizeof(namelength), 1, pfile);
-                    fwrite(_collidingbodyname.c_str(), _collidingbodyname.size(), 1, pfile);
-                    int linkindex = _newnode->GetCollidingLink()->GetIndex();
-                    fwrite(&linkindex, sizeof(linkindex), 1, pfile);
-                    fwrite(&_newnode->_robotlinkindex, sizeof(_newnode->_robotlinkindex), 1, pfile);
-                }
+struct CacheFileNode
+{
+    int32_t childoffset; ///< index of the first child in the children array
+    int32_t numchildren;
+    int32_t bodyindex; ///< index in the bodies array of the colliding body, -1 if the node is not in collision
+    int32_t linkindex; ///< link index of the colliding link
+    int32_t robotlinkindex;
+    int16_t level;
+    uint8_t conftype;
+    uint8_t flags; ///< bit 0 is _hasselfchild, bit 1 is _usenn
+};
+
+inline size_t _AlignCacheFileSize(size_t size)
+{
+    return (size+7)&~size_t(7);
+}
+
+inline void _CopyCacheFileString(char* pdest, size_t destsize, const std::string& s)
+{
+    std::fill(pdest, pdest+destsize, 0);
+    std::copy(s.begin(), s.begin()+std::min(s.size(), destsize-1), pdest);
+}
 
-                fwrite(&_newnode->_hasselfchild, sizeof(_newnode->_hasselfchild), 1, pfile);
-                fwrite(&_newnode->_usenn, sizeof(_newnode->_usenn), 1, pfile);
-                int numchildren = _newnode->_vchildren.size();
-                fwrite(&numchildren, sizeof(numchildren), 1, pfile);
+/// \brief offsets of the arrays from the start of the file
+struct CacheFileLayout
+{
+    CacheFileLayout(const CacheFileHeader& header)
+    {
+        weights = _AlignCacheFileSize(sizeof(CacheFileHeader));
+        bodies = _AlignCacheFileSize(weights + sizeof(dReal)*header.statedof);
+        nodes = _AlignCacheFileSize(bodies + sizeof(CacheFileBody)*header.numbodies);
+        states = _AlignCacheFileSize(nodes + sizeof(CacheFileNode)*header.numnodes);
+        children = _AlignCacheFileSize(states + sizeof(dReal)*header.statedof*header.numnodes);
+        names = _AlignCacheFileSize(children + sizeof(int32_t)*header.numchildren);
+        total = names + header.namessize;
+    }
+    size_t weights, bodies, nodes, states, children, names, total;
+};
 
-                FOREACHC(itchild, (*itnode)->_vchildren) {
-                    int cindex = _mapNodeIndices[*itchild];
-                    fwrite(&cindex, sizeof(cindex), 1, pfile);
-                }
+} // end namespace
+
+int CacheTree::SaveCache(std::string filename, const std::string& statehash)
+{
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
+    // index every node in the order of the levels
+    std::vector<CacheTreeNodePtr> vnodes;
+    vnodes.reserve(_numnodes);
+    FOREACH(itlevelnodes, _vsetLevelNodes) {
+        vnodes.insert(vnodes.end(), itlevelnodes->begin(), itlevelnodes->end());
+    }
+    std::map<CacheTreeNodeConstPtr, int32_t> mapNodeIndices;
+    for(size_t inode = 0; inode < vnodes.size(); ++inode) {
+        mapNodeIndices[vnodes[inode]] = inode;
+    }
+
+    CacheFileHeader header;
+    std::fill((char*)&header, (char*)&header+sizeof(header), 0);
+    std::copy(s_cacheFileMagic, s_cacheFileMagic+sizeof(s_cacheFileMagic), header.magic);
+    header.version = s_cacheFileVersion;
+    header.realsize = sizeof(dReal);
+    header.endianmarker = s_cacheFileEndianMarker;
+    header.statedof = _statedof;
+    header.numnodes = vnodes.size();
+    header.maxlevel = _maxlevel;
+    header.minlevel = _minlevel;
+    header.base = _base;
+    header.maxdistance = _maxdistance;
+    _CopyCacheFileString(header.statehash, sizeof(header.statehash), statehash);
+
+    std::vector<CacheFileBody> vbodies;
+    std::map<KinBodyConstPtr, int32_t> mapBodyIndices;
+    std::string names;
+    std::vector<CacheFileNode> vfilenodes(vnodes.size());
+    std::vector<int32_t> vchildren;
+    vchildren.reserve(vnodes.size());
+    for(size_t inode = 0; inode < vnodes.size(); ++inode) {
+        CacheTreeNodeConstPtr pnode = vnodes[inode];
+        CacheFileNode& filenode = vfilenodes[inode];
+        filenode.childoffset = vchildren.size();
+        filenode.numchildren = pnode->_vchildren.size();
+        filenode.bodyindex = -1;
+        filenode.linkindex = -1;
+        filenode.robotlinkindex = pnode->_robotlinkindex;
+        filenode.level = pnode->_level;
+        filenode.conftype = pnode->_conftype;
+        filenode.flags = (pnode->_hasselfchild ? 1 : 0)|(pnode->_usenn ? 2 : 0);
+        if( pnode->_conftype == CNT_Collision && !!pnode->_collidinglink ) {
+            KinBodyConstPtr pbody = pnode->_collidinglink->GetParent();
+            std::map<KinBodyConstPtr, int32_t>::iterator itbody = mapBodyIndices.find(pbody);
+            if( itbody == mapBodyIndices.end() ) {
+                CacheFileBody filebody;
+                _CopyCacheFileString(filebody.hash, sizeof(filebody.hash), pbody->GetKinematicsGeometryHash());
+                filebody.nameoffset = names.size();
+                filebody.namelength = pbody->GetName().size();
+                names += pbody->GetName();
+                itbody = mapBodyIndices.insert(std::make_pair(pbody, (int32_t)vbodies.size())).first;
+                vbodies.push_back(filebody);
             }
+            filenode.bodyindex = itbody->second;
+            filenode.linkindex = pnode->_collidinglink->GetIndex();
+        }
+        else if( pnode->_conftype == CNT_Collision ) {
+            // colliding body is not known anymore
+            filenode.conftype = CNT_Unknown;
+            filenode.flags &= ~2;
+        }
+        FOREACHC(itchild, pnode->_vchildren) {
+            vchildren.push_back(mapNodeIndices[*itchild] - (int32_t)inode);
         }
     }
+    header.numchildren = vchildren.size();
+    header.numbodies = vbodies.size();
+    header.namessize = names.size();
 
-    fclose(pfile);
+    CacheFileLayout layout(header);
+    std::vector<char> vdata(layout.total, 0);
+    if( _statedof > 0 ) {
+        std::copy((const char*)&_weights[0], (const char*)(&_weights[0]+_statedof), &vdata[layout.weights]);
+    }
+    if( vbodies.size() > 0 ) {
+        std::copy((const char*)&vbodies[0], (const char*)(&vbodies[0]+vbodies.size()), &vdata[layout.bodies]);
+    }
+    if( vfilenodes.size() > 0 ) {
+        std::copy((const char*)&vfilenodes[0], (const char*)(&vfilenodes[0]+vfilenodes.size()), &vdata[layout.nodes]);
+        dReal* pstates = (dReal*)&vdata[layout.states];
+        FOREACHC(itnode, vnodes) {
+            pstates = std::copy((*itnode)->GetConfigurationState(), (*itnode)->GetConfigurationState()+_statedof, pstates);
+        }
+    }
+    if( vchildren.size() > 0 ) {
+        std::copy((const char*)&vchildren[0], (const char*)(&vchildren[0]+vchildren.size()), &vdata[layout.children]);
+    }
+    std::copy(names.begin(), names.end(), vdata.begin()+layout.names);
+
+    boost::crc_32_type crc;
+    crc.process_bytes(&vdata[layout.weights], layout.total-layout.weights);
+    header.checksum = crc.checksum();
+    std::copy((const char*)&header, (const char*)(&header+1), &vdata[0]);
 
+    std::string fullfilename = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
+    RAVELOG_DEBUG_FORMAT("Writing cache to %s, size=%d", fullfilename%vnodes.size());
+    FILE* pfile = fopen(fullfilename.c_str(),"wb");
+    if( !pfile ) {
+        RAVELOG_WARN_FORMAT("failed to open %s for writing cache", fullfilename);
+        return 0;
+    }
+    size_t numwritten = fwrite(&vdata[0], vdata.size(), 1, pfile);
+    fclose(pfile);
+    if( numwritten != 1 ) {
+        RAVELOG_WARN_FORMAT("failed to write cache to %s", fullfilename);
+        return 0;
+    }
     return 1;
 }
 
-int CacheTree::LoadCache(std::string filename, EnvironmentBasePtr penv)
+int CacheTree::LoadCache(std::string filename, EnvironmentBasePtr penv, const std::string& statehash)
 {
-    //std::lock_guard<std::mutex> lock(_mutexpool);
-    _fulldirname = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
-
-    FILE* pfile = fopen(_fulldirname.c_str(),"rb");
-    size_t outs;
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
+    std::string fullfilename = RaveFindDatabaseFile(std::string("selfcache.")+filename,false);
 
-    if (!pfile) {
+    boost::interprocess::file_mapping filemapping;
+    boost::interprocess::mapped_region region;
+    try {
+        boost::interprocess::file_mapping(fullfilename.c_str(), boost::interprocess::read_only).swap(filemapping);
+        boost::interprocess::mapped_region(filemapping, boost::interprocess::read_only).swap(region);
+    }
+    catch(const boost::interprocess::interprocess_exception& ex) {
+        RAVELOG_DEBUG_FORMAT("cannot map cache file %s: %s", fullfilename%ex.what());
         return 0;
     }
+    const char* pdata = static_cast<const char*>(region.get_address());
+    const size_t datasize = region.get_size();
 
-    Reset();
-    outs = fread(&_statedof, sizeof(_statedof), 1, pfile);
-
-    _weights.resize(_statedof,1.0);
-    _curconf.resize(_statedof,1.0);
-    outs = fread(&_weights[0], sizeof(_weights[0])*_weights.size(), 1, pfile);
-
-    outs = fread(&_base, sizeof(_base), 1, pfile);
-    outs = fread(&_fBaseInv, sizeof(_fBaseInv), 1, pfile);
-    outs = fread(&_fBaseInv2, sizeof(_fBaseInv2), 1, pfile);
-    outs = fread(&_fBaseChildMult, sizeof(_fBaseChildMult), 1, pfile);
-    outs = fread(&_maxdistance, sizeof(_maxdistance), 1, pfile);
-    outs = fread(&_maxlevel, sizeof(_maxlevel), 1, pfile);
-    outs = fread(&_minlevel, sizeof(_minlevel), 1, pfile);
-    outs = fread(&_numnodes, sizeof(_numnodes), 1, pfile);
-    outs = fread(&_fMaxLevelBound, sizeof(_fMaxLevelBound), 1, pfile);
-
-    int maxenclevel = max(_EncodeLevel(_maxlevel), _EncodeLevel(_minlevel));
-    _vsetLevelNodes.resize(maxenclevel+1);
+    if( datasize < sizeof(CacheFileHeader) ) {
+        RAVELOG_WARN_FORMAT("cache file %s is too small", fullfilename);
+        return 0;
+    }
+    CacheFileHeader header;
+    std::copy(pdata, pdata+sizeof(header), (char*)&header);
+    if( !std::equal(s_cacheFileMagic, s_cacheFileMagic+sizeof(s_cacheFileMagic), header.magic) || header.version != s_cacheFileVersion || header.realsize != sizeof(dReal) || header.endianmarker != s_cacheFileEndianMarker ) {
+        RAVELOG_WARN_FORMAT("cache file %s has an unsupported format (version=%d)", fullfilename%header.version);
+        return 0;
+    }
+    if( header.statedof <= 0 || header.numnodes < 0 || header.numchildren < 0 || header.numbodies < 0 || header.namessize < 0 ) {
+        RAVELOG_WARN_FORMAT("cache file %s is corrupted", fullfilename);
+        return 0;
+    }
+    header.statehash[sizeof(header.statehash)-1] = 0;
+    if( statehash.size() > 0 && header.statehash[0] != 0 && statehash != header.statehash ) {
+        RAVELOG_WARN_FORMAT("cache file %s was saved for a different robot (%s != %s)", fullfilename%header.statehash%statehash);
+        return 0;
+    }
+    if( _statedof > 0 && header.statedof != _statedof ) {
+        RAVELOG_WARN_FORMAT("cache file %s has %d dof, but the cache has %d", fullfilename%header.statedof%_statedof);
+        return 0;
+    }
+    CacheFileLayout layout(header);
+    if( layout.total != datasize ) {
+        RAVELOG_WARN_FORMAT("cache file %s has %d bytes, but expected %d", fullfilename%datasize%layout.total);
+        return 0;
+    }
+    boost::crc_32_type crc;
+    crc.process_bytes(pdata+layout.weights, layout.total-layout.weights);
+    if( crc.checksum() != header.checksum ) {
+        RAVELOG_WARN_FORMAT("cache file %s has a wrong checksum", fullfilename);
+        return 0;
+    }
 
-    _vnodes.resize(_numnodes);
-    _dummycs.resize(_statedof, 0);
+    // the arrays are aligned, so can be used directly from the mapping
+    const dReal* pweights = reinterpret_cast<const dReal*>(pdata+layout.weights);
+    const CacheFileBody* pbodies = reinterpret_cast<const CacheFileBody*>(pdata+layout.bodies);
+    const CacheFileNode* pfilenodes = reinterpret_cast<const CacheFileNode*>(pdata+layout.nodes);
+    const dReal* pstates = reinterpret_cast<const dReal*>(pdata+layout.states);
+    const int32_t* pchildren = reinterpret_cast<const int32_t*>(pdata+layout.children);
+    const char* pnames = pdata+layout.names;
+
+    // check the indices before creating any node
+    int nroots = 0;
+    int maxenclevel = max(_EncodeLevel(header.maxlevel), _EncodeLevel(header.minlevel));
+    for(int inode = 0; inode < header.numnodes; ++inode) {
+        const CacheFileNode& filenode = pfilenodes[inode];
+        if( filenode.childoffset < 0 || filenode.numchildren < 0 || filenode.childoffset + filenode.numchildren > header.numchildren || filenode.bodyindex >= header.numbodies || filenode.level > header.maxlevel ) {
+            RAVELOG_WARN_FORMAT("cache file %s has invalid node %d", fullfilename%inode);
+            return 0;
+        }
+        for(int ichild = 0; ichild < filenode.numchildren; ++ichild) {
+            int childindex = inode + pchildren[filenode.childoffset+ichild];
+            if( childindex < 0 || childindex >= header.numnodes ) {
+                RAVELOG_WARN_FORMAT("cache file %s has invalid child for node %d", fullfilename%inode);
+                return 0;
+            }
+        }
+        if( filenode.level == header.maxlevel ) {
+            ++nroots;
+        }
+        maxenclevel = max(maxenclevel, _EncodeLevel(filenode.level));
+    }
+    if( header.numnodes > 0 && nroots != 1 ) {
+        RAVELOG_WARN_FORMAT("cache file %s has %d root nodes", fullfilename%nroots);
+        return 0;
+    }
+    for(int ibody = 0; ibody < header.numbodies; ++ibody) {
+        if( pbodies[ibody].nameoffset < 0 || pbodies[ibody].namelength < 0 || pbodies[ibody].nameoffset + pbodies[ibody].namelength > header.namessize ) {
+            RAVELOG_WARN_FORMAT("cache file %s has invalid body %d", fullfilename%ibody);
+            return 0;
+        }
+    }
 
-    for(int i = 0; i < _numnodes; ++i) {
-        _vnodes[i] = _CreateCacheTreeNode(_dummycs, CollisionReportPtr());
+    // match the colliding bodies with the bodies in the environment, prefer the body with the same name
+    std::vector<KinBodyPtr> vbodies(header.numbodies), venvbodies;
+    if( !!penv ) {
+        penv->GetBodies(venvbodies);
+    }
+    for(int ibody = 0; ibody < header.numbodies; ++ibody) {
+        std::string bodyname(pnames+pbodies[ibody].nameoffset, pnames+pbodies[ibody].nameoffset+pbodies[ibody].namelength);
+        std::string bodyhash(pbodies[ibody].hash, strnlen(pbodies[ibody].hash, sizeof(pbodies[ibody].hash)));
+        FOREACHC(itbody, venvbodies) {
+            if( (*itbody)->GetKinematicsGeometryHash() == bodyhash ) {
+                if( !vbodies[ibody] || (*itbody)->GetName() == bodyname ) {
+                    vbodies[ibody] = *itbody;
+                }
+            }
+        }
+        if( !vbodies[ibody] ) {
+            RAVELOG_WARN_FORMAT("loading cache expected colliding body %s, but none found, its collision configurations are ignored", bodyname);
+        }
     }
 
-    for (int inode = 0; inode < _numnodes; ++inode)
-    {
-        _newnode = _vnodes.at(inode);
-        outs = fread(&_newnode->_level, sizeof(_newnode->_level), 1, pfile);
-        outs = fread(_newnode->_pcstate, sizeof(dReal)*_statedof, 1, pfile);
-        outs = fread(&_newnode->_conftype, sizeof(_newnode->_conftype), 1, pfile);
-
-        if( _newnode->_conftype == CNT_Collision ) {
-            int namelength;
-            outs = fread(&namelength, sizeof(namelength), 1, pfile);
-            _collidingbodyname.resize(namelength);
-            outs = fread(&_collidingbodyname[0], namelength, 1, pfile);
-            int collidinglinkindex;
-            outs = fread(&collidinglinkindex, sizeof(collidinglinkindex), 1, pfile);
-            _pcollidingbody = penv->GetKinBody(_collidingbodyname);
-            if( !_pcollidingbody ) {
-                RAVELOG_WARN_FORMAT("loading cache expected colliding body %s, but none found", _collidingbodyname);
+    _Reset();
+    _statedof = header.statedof;
+    _weights.assign(pweights, pweights+_statedof);
+    _base = header.base;
+    _fBaseInv = 1/_base;
+    _fBaseInv2 = 1/Sqr(_base);
+    _fBaseChildMult = 1/(_base-1);
+    _maxdistance = header.maxdistance;
+    _maxlevel = header.maxlevel;
+    _minlevel = header.minlevel;
+    _fMaxLevelBound = RavePow(_base, _maxlevel);
+    _poolNodes.reset(new boost::pool<>(sizeof(CacheTreeNode)+sizeof(dReal)*_statedof));
+    if( maxenclevel >= (int)_vsetLevelNodes.size() ) {
+        _vsetLevelNodes.resize(maxenclevel+1);
+    }
+
+    std::vector<CacheTreeNodePtr> vnodes(header.numnodes);
+    for(int inode = 0; inode < header.numnodes; ++inode) {
+        vnodes[inode] = new (_poolNodes->malloc()) CacheTreeNode(pstates + inode*_statedof, _statedof, NULL);
+    }
+    for(int inode = 0; inode < header.numnodes; ++inode) {
+        const CacheFileNode& filenode = pfilenodes[inode];
+        CacheTreeNodePtr pnode = vnodes[inode];
+        pnode->_level = filenode.level;
+        pnode->_hasselfchild = (filenode.flags & 1) ? 1 : 0;
+        pnode->_usenn = (filenode.flags & 2) ? 1 : 0;
+        pnode->_conftype = (ConfigurationNodeType)filenode.conftype;
+        pnode->_robotlinkindex = filenode.robotlinkindex;
+        if( pnode->_conftype == CNT_Collision ) {
+            const KinBodyPtr& pbody = filenode.bodyindex >= 0 ? vbodies[filenode.bodyindex] : KinBodyPtr();
+            if( !!pbody && filenode.linkindex >= 0 && filenode.linkindex < (int)pbody->GetLinks().size() ) {
+                pnode->_collidinglink = pbody->GetLinks()[filenode.linkindex];
             }
             else {
-                _newnode->_collidinglink = _pcollidingbody->GetLinks().at(collidinglinkindex);
+                pnode->SetType(CNT_Unknown);
             }
-            outs = fread(&_newnode->_robotlinkindex, sizeof(_newnode->_robotlinkindex), 1, pfile);
         }
-
-        outs = fread(&_newnode->_hasselfchild, sizeof(_newnode->_hasselfchild), 1, pfile);
-        outs = fread(&_newnode->_usenn, sizeof(_newnode->_usenn), 1, pfile);
-        int numchildren;
-        outs = fread(&numchildren, sizeof(numchildren), 1, pfile);
-        _newnode->_vchildren.resize(numchildren);
-
-        // create the copies of the children and insert them
-        for(int i = 0; i < numchildren; ++i) {
-            int childid;
-            outs = fread(&childid, sizeof(childid), 1, pfile);
-            _newnode->_vchildren[i] = _vnodes.at(childid);
+        pnode->_vchildren.resize(filenode.numchildren);
+        for(int ichild = 0; ichild < filenode.numchildren; ++ichild) {
+            pnode->_vchildren[ichild] = vnodes[inode + pchildren[filenode.childoffset+ichild]];
         }
-
-        _vsetLevelNodes.at(_EncodeLevel(_newnode->_level)).insert(_newnode);
+        _vsetLevelNodes.at(_EncodeLevel(pnode->_level)).insert(pnode);
     }
-
-    fclose(pfile);
-
-    _vnodes.resize(0);
-
-    int numloaded = GetNumKnownNodes();
-    OPENRAVE_ASSERT_OP(numloaded,==,_numnodes);
+    _numnodes = header.numnodes;
     return 1;
 }
 
 int CacheTree::UpdateCollisionConfigurations(KinBodyPtr pbody)
 {
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
     int nremoved=0;
     if (_numnodes > 0) {
         FOREACH(itlevelnodes, _vsetLevelNodes) {
@@ -960,7 +1291,7 @@ int CacheTree::UpdateCollisionConfigurations(KinBodyPtr pbody)
                 }
             }
         }
-        int knum = GetNumKnownNodes();
+        int knum = _GetNumKnownNodes();
         RAVELOG_VERBOSE_FORMAT("removed %d nodes, %d known nodes left",nremoved%knum);
     }
     return nremoved;
@@ -968,6 +1299,7 @@ int CacheTree::UpdateCollisionConfigurations(KinBodyPtr pbody)
 
 int CacheTree::UpdateFreeConfigurations(KinBodyPtr pbody) //todo only remove those with overlaping linkspheres
 {
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
     int nremoved=0;
     if (_numnodes > 0) {
 
@@ -980,7 +1312,7 @@ int CacheTree::UpdateFreeConfigurations(KinBodyPtr pbody) //todo only remove tho
             }
         }
 
-        int knum = GetNumKnownNodes();
+        int knum = _GetNumKnownNodes();
         RAVELOG_VERBOSE_FORMAT("removed %d nodes, %d known nodes left",nremoved%knum);
     }
 
@@ -989,6 +1321,7 @@ int CacheTree::UpdateFreeConfigurations(KinBodyPtr pbody) //todo only remove tho
 
 int CacheTree::RemoveFreeConfigurations()
 {
+    std::unique_lock<std::shared_timed_mutex> lock(_mutex);
     int nremoved=0;
     if (_numnodes > 0) {
         FOREACH(itlevelnodes, _vsetLevelNodes) {
@@ -1002,7 +1335,7 @@ int CacheTree::RemoveFreeConfigurations()
             }
         }
 
-        int knum = GetNumKnownNodes();
+        int knum = _GetNumKnownNodes();
         RAVELOG_VERBOSE_FORMAT("removed %d nodes, %d known nodes left",nremoved%knum);
     }
 
@@ -1010,6 +1343,12 @@ int CacheTree::RemoveFreeConfigurations()
 }
 
 int CacheTree::GetNumKnownNodes()
+{
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
+    return _GetNumKnownNodes();
+}
+
+int CacheTree::_GetNumKnownNodes() const
 {
     int nknown=0;
     if (_numnodes > 0) {
@@ -1026,6 +1365,7 @@ int CacheTree::GetNumKnownNodes()
 
 bool CacheTree::Validate()
 {
+    std::shared_lock<std::shared_timed_mutex> lock(_mutex);
     if( _numnodes == 0 ) {
         return _numnodes==0;
     }
@@ -1224,6 +1564,7 @@ ConfigurationCache::ConfigurationCache(RobotBasePtr pstaterobot, bool envupdates
 ConfigurationCache::~ConfigurationCache()
 {
     _cachetree.Reset();
+    std::lock_guard<std::mutex> lock(_mutex);
     // have to destroy all the change callbacks!
     FOREACH(it, _listCachedData) {
         KinBodyCachedDataPtr pdata = it->lock();
@@ -1278,6 +1619,7 @@ int ConfigurationCache::RemoveFreeConfigurations()
 
 void ConfigurationCache::GetDOFValues(std::vector<dReal>& values)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
     // try to get the values without setting state
     if (_envupdates) {
         _pstaterobot->GetDOFValues(values, _vRobotActiveIndices);
@@ -1300,33 +1642,32 @@ void ConfigurationCache::GetDOFValues(std::vector<dReal>& values)
 
 int ConfigurationCache::CheckCollision(const std::vector<dReal>& conf, KinBody::LinkConstPtr& robotlink, KinBody::LinkConstPtr& collidinglink, dReal& closestdist)
 {
-    std::pair<CacheTreeNodeConstPtr, dReal> knn = _cachetree.FindNearestNode(conf, _collisionthresh, _freespacethresh);
-
-    if( !!knn.first ) {
-
-        closestdist = knn.second;
-        if( knn.first->IsInCollision()) {
+    // the node data is copied while the tree is locked, so other threads can modify the tree after the query
+    CacheTreeNodeInfo info;
+    if( !_cachetree.FindNearestNode(conf, _collisionthresh.load(), _freespacethresh.load(), info) ) {
+        return -1;
+    }
 
-            if ((int)_pstaterobot->GetLinks().size() <= knn.first->GetRobotLinkIndex()) {
-                robotlink = KinBody::LinkConstPtr(); //patch
-            }
-            else{
-                robotlink = _pstaterobot->GetLinks().at(knn.first->GetRobotLinkIndex());
-            }
-            collidinglink = knn.first->GetCollidingLink();
-            return 1;
+    closestdist = info.distance;
+    if( info.conftype == CNT_Collision ) {
+        const std::vector<KinBody::LinkPtr>& vlinks = _pstaterobot->GetLinks();
+        if( info.robotlinkindex < 0 || info.robotlinkindex >= (int)vlinks.size() ) {
+            robotlink = KinBody::LinkConstPtr(); //patch
         }
-        return 0;
+        else {
+            robotlink = vlinks[info.robotlinkindex];
+        }
+        collidinglink = info.collidinglink;
+        return 1;
     }
-    return -1;
+    return 0;
 }
 
 std::pair<std::vector<dReal>, dReal> ConfigurationCache::FindNearestNode(const std::vector<dReal>& conf, dReal dist)
 {
-    std::pair<CacheTreeNodeConstPtr, dReal> knn = _cachetree.FindNearestNode(conf, dist, CNT_Any);
-
-    if( !!knn.first ) {
-        return make_pair(std::vector<dReal>(knn.first->GetConfigurationState(), knn.first->GetConfigurationState()+_lowerlimit.size()), knn.second);
+    CacheTreeNodeInfo info;
+    if( _cachetree.FindNearestNode(conf, dist, CNT_Any, info) ) {
+        return make_pair(info.vstate, info.distance);
     }
     return make_pair(std::vector<dReal>(0), dReal(0));
 }
@@ -1370,6 +1711,7 @@ void ConfigurationCache::_UpdateAddRemoveBodies(KinBodyPtr pbody, int action)
             KinBodyCachedDataPtr pinfo(new KinBodyCachedData());
             pinfo->_changehandle = pbody->RegisterChangeCallback(KinBody::Prop_LinkGeometry|KinBody::Prop_LinkEnable|KinBody::Prop_LinkTransforms, boost::bind(&ConfigurationCache::_UpdateUntrackedBody, this, pbody));
             pbody->SetUserData(_userdatakey, pinfo);
+            std::lock_guard<std::mutex> lock(_mutex);
             _listCachedData.push_back(pinfo);
         }
     }
@@ -1390,6 +1732,7 @@ void ConfigurationCache::_UpdateRobotJointLimits()
     if (_envupdates) {
         RAVELOG_VERBOSE("Updating robot joint limits\n");
 
+        std::lock_guard<std::mutex> lock(_mutex);
         _pstaterobot->SetActiveDOFs(_vRobotActiveIndices, _nRobotAffineDOF);
         _pstaterobot->GetActiveDOFLimits(_newlowerlimit, _newupperlimit);
 
@@ -1418,6 +1761,7 @@ void ConfigurationCache::_UpdateRobotGrabbed()
 {
     bool newGrab = false;
 
+    std::lock_guard<std::mutex> lock(_mutex);
     _vnewgrabbedbodies.resize(0);
     _pstaterobot->GetGrabbed(_vnewgrabbedbodies);
     FOREACH(oldbody, _setgrabbedbodies){
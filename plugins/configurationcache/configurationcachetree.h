@@ -16,7 +16,10 @@
 #define OPENRAVE_CACHETREE_H
 
 #include "openraveplugindefs.h"
+#include <atomic>
 #include <deque>
+#include <mutex>
+#include <shared_mutex>
 #include <boost/pool/pool.hpp>
 
 #define _(msgid) OpenRAVE::RaveGetLocalizedTextForDomain("openrave_plugins_configurationcache", msgid)
@@ -99,9 +102,14 @@ public:
         return _usenn;
     }
 
+    /// \brief returns the index set by the user when inserting the node, -1 if not set. Clones of the node have the same index.
+    inline int GetUserIndex() const {
+        return _userindex;
+    }
+
     /// \brief function used to update the hitcount for this node, TODO use this information to prune cache when it gets too big/slow
     inline int IncreaseHitCount(){
-        return _hitcount++;
+        return _hitcount.fetch_add(1, std::memory_order_relaxed);
     }
 
     // returns closest distance to a configuration of the opposite type seen so far
@@ -131,7 +139,8 @@ protected:
     int16_t _level; ///< the level the node belongs to
     uint8_t _hasselfchild; ///< if 1, then _vchildren has contains a clone of this node in the level below it.
     uint8_t _usenn; ///< if 1, then use part of the nearest neighbor search, otherwise ignore
-    int _hitcount; /// number of cache hits
+    std::atomic<int> _hitcount; /// number of cache hits, increased by concurrent queries
+    int _userindex; ///< index set by the user of the tree, copied to the clones of the node
 
     // managed by pool
 #ifdef _DEBUG
@@ -149,6 +158,19 @@ private:
     friend class CacheTree;
 };
 
+/// \brief copy of the data of a node returned by the queries of CacheTree. Unlike the node pointers, it stays valid when other threads modify the tree.
+struct CacheTreeNodeInfo
+{
+    CacheTreeNodeInfo() : conftype(CNT_Unknown), robotlinkindex(-1), userindex(-1), distance(0) {
+    }
+    std::vector<dReal> vstate; ///< the configuration state of the node
+    ConfigurationNodeType conftype;
+    KinBody::LinkConstPtr collidinglink; ///< valid if conftype is CNT_Collision
+    int robotlinkindex; ///< valid if conftype is CNT_Collision
+    int userindex; ///< \see CacheTreeNode::GetUserIndex
+    dReal distance; ///< distance of the node from the query
+};
+
 typedef CacheTreeNode* CacheTreeNodePtr; ///< OPENRAVE_SHARED_PTR might be too slow, and we never expose the pointers outside of CacheTree, so can use raw pointers.
 typedef const CacheTreeNode* CacheTreeNodeConstPtr;
 
@@ -158,6 +180,8 @@ typedef const CacheTreeNode* CacheTreeNodeConstPtr;
 
     Shouldn't know anything about the openrave environment.
 
+    The tree can be shared by several threads. Queries take a shared lock and can run concurrently, functions that modify the tree take an exclusive lock. Queries return copies of the node data in CacheTreeNodeInfo, so the results stay valid when the tree is modified afterwards.
+
     d(p,q) < (1 + e)d(p,S)
     2^(1+i) (1 + 1/e) <= d(p,Qi)
  */
@@ -179,20 +203,32 @@ public:
     ///
     /// \param distancebound If > 0, the distance bound such that any points as close as distancebound will be immediately returned
     /// \param conftype the type of node to find. If CNT_Any, will return any type.
-    std::pair<CacheTreeNodeConstPtr, dReal> FindNearestNode(const std::vector<dReal>& cs, dReal distancebound=-1, ConfigurationNodeType conftype = CNT_Any) const;
+    /// \param[out] info the data of the nearest node
+    /// \return true if a node is found
+    bool FindNearestNode(const std::vector<dReal>& cs, dReal distancebound, ConfigurationNodeType conftype, CacheTreeNodeInfo& info) const;
 
     /// \brief finds the nearest node searching both collision and free nodes. collision nodes takes priority.
     ///
     /// if it is a collision node, it is within collisionthresh. If it is a freespace node, distance is within freespacethresh
     /// \param collisionthresh assumes > 0
     /// \param freespacethresh assumes > 0
-    std::pair<CacheTreeNodeConstPtr, dReal> FindNearestNode(const std::vector<dReal>& cs, dReal collisionthresh, dReal freespacethresh) const;
+    /// \param[out] info the data of the nearest node
+    /// \return true if a node is found
+    bool FindNearestNode(const std::vector<dReal>& cs, dReal collisionthresh, dReal freespacethresh, CacheTreeNodeInfo& info) const;
+
+    /// \brief finds the numnodes nearest nodes of a particular type. Clones of the same node are only returned once.
+    ///
+    /// \param conftype the type of node to find. If CNT_Any, will return any type.
+    /// \param[out] vnearestnodes the data of the nodes sorted from the nearest
+    /// \return the number of nodes found
+    int FindNearestNodes(const std::vector<dReal>& cs, int numnodes, ConfigurationNodeType conftype, std::vector<CacheTreeNodeInfo>& vnearestnodes) const;
 
     /// \brief inserts node in the tree. If node is too close to other nodes in the tree, then does not insert.
     ///
     /// \param[in] fMinSeparationDist the max distance a node should be separated from its closest neighbor. If node is collision, then only applies to collision neighbors, free neighbors are ignored.
+    /// \param[in] userindex index stored in the node that can be retrieved with CacheTreeNode::GetUserIndex
     /// \return 1 if point is inserted and parent found. 0 if no parent found and point is not inserted. -1 if parent found but point not inserted since it is close to fMinSeparationDist
-    int InsertNode(const std::vector<dReal>& cs, CollisionReportPtr report, dReal fMinSeparationDist);
+    int InsertNode(const std::vector<dReal>& cs, CollisionReportPtr report, dReal fMinSeparationDist, int userindex=-1);
 
     /// \brief removes node from the tree
     ///
@@ -210,7 +246,7 @@ public:
     /// \brief return the configuration values for all nodes in the tree
     void GetNodeValues(std::vector<dReal>& vals) const;
 
-    /// \brief retuns the values for all nodes in the tree
+    /// \brief retuns the values for all nodes in the tree. The nodes are only valid until the next modification of the tree.
     void GetNodeValuesList(std::vector<CacheTreeNodePtr>& lvals);
 
     /// \brief sets the weights
@@ -259,12 +295,35 @@ public:
     int GetNumKnownNodes();
 
     /// \brief save cache to disk
-    int SaveCache(std::string filename);
+    ///
+    /// \param statehash hash of the robot the states are for, stored so that loading the cache for a different robot fails
+    /// \return 1 if saved
+    int SaveCache(std::string filename, const std::string& statehash=std::string());
 
-    /// \brief load cache from disk
-    int LoadCache(std::string filename, EnvironmentBasePtr penv);
+    /// \brief load cache from disk. The file is memory mapped and checked before the tree is modified.
+    ///
+    /// Colliding bodies are matched with the bodies of penv by KinBody::GetKinematicsGeometryHash, collision configurations without a matching body become CNT_Unknown.
+    /// \param statehash if not empty, the cache is only loaded if it was saved with the same hash
+    /// \return 1 if loaded
+    int LoadCache(std::string filename, EnvironmentBasePtr penv, const std::string& statehash=std::string());
 
 private:
+    /// \brief Reset without locking _mutex
+    void _Reset();
+
+    /// \brief GetNumKnownNodes without locking _mutex
+    int _GetNumKnownNodes() const;
+
+    /// \brief FindNearestNode without locking _mutex, the returned node is only valid while _mutex is locked
+    std::pair<CacheTreeNodeConstPtr, dReal> _FindNearestNode(const std::vector<dReal>& cs, dReal distancebound, ConfigurationNodeType conftype) const;
+    std::pair<CacheTreeNodeConstPtr, dReal> _FindNearestNode(const std::vector<dReal>& cs, dReal collisionthresh, dReal freespacethresh) const;
+
+    /// \brief FindNearestNodes without locking _mutex, the returned nodes are only valid while _mutex is locked
+    void _FindNearestNodes(const std::vector<dReal>& cs, int numnodes, ConfigurationNodeType conftype, std::vector< std::pair<CacheTreeNodeConstPtr, dReal> >& vnearestnodes) const;
+
+    /// \brief copies the data of the node into info, _mutex has to be locked
+    void _GetNodeInfo(CacheTreeNodeConstPtr pnode, dReal distance, CacheTreeNodeInfo& info) const;
+
     /// \brief creates new node on the pool
     CacheTreeNodePtr _CreateCacheTreeNode(const std::vector<dReal>& cs, CollisionReportPtr report);
     CacheTreeNodePtr _CloneCacheTreeNode(CacheTreeNodeConstPtr refnode);
@@ -315,14 +374,8 @@ private:
     }
 
     std::vector<dReal> _weights; ///< weights used by the distance function
-    std::vector<dReal> _curconf;
 
-    std::string _fulldirname;
-    CacheTreeNodePtr _newnode; ///< for loading
-    std::string _collidingbodyname;
-    KinBodyPtr _pcollidingbody;
-
-    std::map<CacheTreeNodePtr, int> _mapNodeIndices;
+    CacheTreeNodePtr _newnode;
     std::vector< std::set<CacheTreeNodePtr> > _vsetLevelNodes; ///< _vsetLevelNodes[enc(level)][node] holds the indices of the children of "node" of a given the level. enc(level) maps (-inf,inf) into [0,inf) so it can be indexed by the vector. Every node has an entry in a map here. If the node doesn't hold any children, then it is at the leaf of the tree. _vsetLevelNodes.at(_EncodeLevel(_maxlevel)) is the root.
 
     OPENRAVE_SHARED_PTR<boost::pool<> > _poolNodes; ///< the dynamically growing memory pool of nodes. Since each node's size is determined during run-time, the pool constructor has to be called with the correct node size
@@ -336,18 +389,20 @@ private:
     int _numnodes; ///< the number of nodes in the current tree starting at the root at _vsetLevelNodes.at(_EncodeLevel(_maxlevel))
     dReal _fMaxLevelBound; ///< pow(_base, _maxlevel)
 
-    // cache cache
-    mutable std::vector< std::pair<CacheTreeNodePtr, dReal> > _vCurrentLevelNodes, _vNextLevelNodes;
-    mutable std::vector< std::vector<CacheTreeNodePtr> > _vvCacheNodes;
+    mutable std::shared_timed_mutex _mutex; ///< shared for queries, exclusive for modifications of the tree and the node pool
 
-    std::vector<CacheTreeNodePtr> _vnodes; ///< for loading
-    std::vector<dReal> _dummycs; ///< for loading
+    // cache cache, only used when _mutex is exclusively locked. queries use thread local caches
+    std::vector< std::pair<CacheTreeNodePtr, dReal> > _vCurrentLevelNodes, _vNextLevelNodes;
+    std::vector< std::vector<CacheTreeNodePtr> > _vvCacheNodes;
 };
 
 typedef OPENRAVE_SHARED_PTR<CacheTree> CacheTreePtr;
 
 /** Maintains an up-to-date cache tree synchronized to the openrave environment. Tracks bodies being added removed, states changing, etc.
    The state of cache consists of the active DOFs of the robot that is passed in at constructor time.
+
+   CheckCollision with a configuration, FindNearestNode, InsertConfiguration and the thresholds can be used from several threads.
+   The environment callbacks and GetDOFValues are synchronized with an internal mutex, functions reading the robot state need the environment lock as usual.
  */
 class ConfigurationCache
 {
@@ -492,13 +547,13 @@ public:
     /// \brief saves the cache to disk
     inline void SaveCache(std::string filename)
     {
-        _cachetree.SaveCache(filename);
+        _cachetree.SaveCache(filename, _pstaterobot->GetKinematicsGeometryHash());
     }
 
     /// \brief loads cache from disk
     inline void LoadCache(std::string filename, EnvironmentBasePtr penv)
     {
-        _cachetree.LoadCache(filename, penv);
+        _cachetree.LoadCache(filename, penv, _pstaterobot->GetKinematicsGeometryHash());
     }
 
 private:
@@ -541,15 +596,16 @@ public:
 
     EnvironmentBasePtr _penv; ///< environment
 
-    dReal _collisionthresh; ///< configurations in this distance range (from a collsion configuration in the tree) will be assumed to be in collision
-    dReal _freespacethresh; ///< configurations in this distance range (from a free configuration in the tree)  will be assumed to not be in collision
-    dReal _insertiondistancemult; ///< only insert nodes if they are far from the nearest node in the tree. The distance is computed by multiplying this number of _collisionthresh or _freespacethresh. Distance a configuration must have from the nearest configuration in the tree in order for it be inserted
+    std::atomic<dReal> _collisionthresh; ///< configurations in this distance range (from a collsion configuration in the tree) will be assumed to be in collision
+    std::atomic<dReal> _freespacethresh; ///< configurations in this distance range (from a free configuration in the tree)  will be assumed to not be in collision
+    std::atomic<dReal> _insertiondistancemult; ///< only insert nodes if they are far from the nearest node in the tree. The distance is computed by multiplying this number of _collisionthresh or _freespacethresh. Distance a configuration must have from the nearest configuration in the tree in order for it be inserted
     std::string _userdatakey;
     UserDataPtr _handleJointLimitChange, _handleGrabbedChange; ///< handles for changes in the robot's joint limits and grabbed bodies
     UserDataPtr _handleBodyAddRemove; ///< handle for bodies added or removed to the environment
     std::list<KinBodyCachedDataWeakPtr> _listCachedData; ///< necessary to keep a list of all the data created in order to force reset the change callbacks
 
-    bool _envupdates; ///< if set to true, cache will update itself when the environment changes; should be set to false for selfcollision cache
+    std::atomic<bool> _envupdates; ///< if set to true, cache will update itself when the environment changes; should be set to false for selfcollision cache
+    std::mutex _mutex; ///< protects the limits, grabbed bodies and callback data that are updated by the environment callbacks
 
 };
 
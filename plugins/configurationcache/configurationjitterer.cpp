@@ -627,7 +627,7 @@ By default will sample the robot's active DOFs. Parameters part of the interface
             }
 
             if( !!_cache ) {
-                if( !!_cache->FindNearestNode(vnewdof, _neighdistthresh).first ) {
+                if( _cache->FindNearestNode(vnewdof, _neighdistthresh, CNT_Any, _cachenodeinfo) ) {
                     _cachehit++;
                     nCacheHitSamples++;
                     continue;
@@ -1011,6 +1011,7 @@ protected:
     std::vector<dReal> _curdof, _newdof2, _deltadof, _deltadof2, _vonesample;
 
     CacheTreePtr _cache; ///< caches the visisted configurations
+    CacheTreeNodeInfo _cachenodeinfo; ///< result of the _cache queries
     int _cachehit;
     dReal _neighdistthresh; ///< the minimum distance that nodes can be with respect to each other for the cache
 
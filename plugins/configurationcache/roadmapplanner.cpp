@@ -0,0 +1,916 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 agent
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "configurationcachetree.h"
+
+#include <queue>
+#include <fstream>
+#include <boost/crc.hpp>
+#include <boost/algorithm/string.hpp>
+
+namespace configurationcache {
+
+/// \brief multi-query roadmap that is kept between planning calls and is invalidated when the environment changes
+class PersistentRoadmapPlanner : public PlannerBase
+{
+    enum ValidityState
+    {
+        VS_Unknown = 0,
+        VS_Valid = 1,
+        VS_Invalid = 2,
+    };
+
+    /// \brief the result of the last constraints check of a vertex or an edge
+    struct Validity
+    {
+        Validity() : state(VS_Unknown), collidingbodyindex(0), stamp(0) {
+        }
+        int8_t state; ///< ValidityState
+        int collidingbodyindex; ///< if VS_Invalid, the environment body index of the body that failed the check. -1 if it is a self collision, 0 if not known
+        uint32_t stamp; ///< if VS_Valid, _freestamp at the time of the check
+    };
+
+    struct Edge
+    {
+        Edge(int vertex0, int vertex1, dReal length) : vertex0(vertex0), vertex1(vertex1), length(length) {
+        }
+        inline int GetOtherVertex(int vertex) const {
+            return vertex == vertex0 ? vertex1 : vertex0;
+        }
+        int vertex0, vertex1;
+        dReal length;
+        Validity validity;
+    };
+
+    struct Vertex
+    {
+        std::vector<dReal> q;
+        std::vector<int> vedges; ///< indices into _vedges
+        Validity validity;
+    };
+
+    enum QueryType
+    {
+        QT_None = 0,
+        QT_Start = 1,
+        QT_Goal = 2,
+    };
+
+public:
+    PersistentRoadmapPlanner(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv), _nNeighbors(10), _freestamp(1)
+    {
+        __description = "\
+Multi-query roadmap planner. The collision-free configurations and the checked edges between them are kept between planning calls, \
+so queries in an environment that does not change become a graph search. The vertices are indexed with the cover tree of the configuration cache. \
+Edges are only checked when they are on the shortest path of the roadmap, new samples are only added when the roadmap does not connect the query.\n\n\
+When bodies are moved, added or removed, all the free vertices and edges have to be checked again, \
+but only the vertices and edges that failed because of the changed bodies are reconsidered. Checks are done lazily when a path goes through them. \
+Everything is checked again when the constraints, the collision checker options, the grabbed bodies or the state of the robot besides its active dofs change.\n\n\
+The roadmap is reset when the configuration space (specification, limits or distance weights) changes. It can be saved with SaveRoadmap and loaded with LoadRoadmap.";
+        RegisterCommand("SetNumNeighbors", boost::bind(&PersistentRoadmapPlanner::SetNumNeighborsCommand,this,_1,_2),
+                        "sets the number of nearest neighbors every new roadmap vertex is connected to. By default it is 10");
+        RegisterCommand("SaveRoadmap", boost::bind(&PersistentRoadmapPlanner::SaveRoadmapCommand,this,_1,_2),
+                        "saves the roadmap to the openrave database, takes the filename");
+        RegisterCommand("LoadRoadmap", boost::bind(&PersistentRoadmapPlanner::LoadRoadmapCommand,this,_1,_2),
+                        "loads the roadmap from the openrave database, takes the filename. Vertices and edges that were free are only assumed to still be free if the planner is initialized with the same constraints, robot state and environment as when the roadmap was saved, otherwise they are checked again");
+        RegisterCommand("SetConstraintsKey", boost::bind(&PersistentRoadmapPlanner::SetConstraintsKeyCommand,this,_1,_2),
+                        "sets a string identifying the constraints of the planner parameters. The results of the checks are only reused for the same key and the same type of constraints function, so it has to be changed when a different function of the same type is used");
+        RegisterCommand("ResetRoadmap", boost::bind(&PersistentRoadmapPlanner::ResetRoadmapCommand,this,_1,_2),
+                        "removes all vertices and edges of the roadmap");
+        RegisterCommand("GetRoadmapInfo", boost::bind(&PersistentRoadmapPlanner::GetRoadmapInfoCommand,this,_1,_2),
+                        "returns the number of vertices, edges, edges known to be free and edges known to be in collision");
+        _filterreturn.reset(new ConstraintFilterReturn());
+        _handleBodyAddRemove = GetEnv()->RegisterBodyCallback(boost::bind(&PersistentRoadmapPlanner::_UpdateAddRemoveBodies, this, _1, _2));
+    }
+    virtual ~PersistentRoadmapPlanner() {
+        // the callbacks use this pointer
+        _handleBodyAddRemove.reset();
+        _mapBodyChangeHandles.clear();
+    }
+
+    virtual bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr pparams)
+    {
+        EnvironmentLock lock(GetEnv()->GetMutex());
+        _parameters.reset(new PlannerParameters());
+        _parameters->copy(pparams);
+        _parameters->Validate();
+        _robot = pbase;
+        if( _parameters->_nMaxIterations <= 0 ) {
+            _parameters->_nMaxIterations = 10000;
+        }
+
+        const int dof = _parameters->GetDOF();
+        std::vector<dReal> vweights;
+        if( _parameters->GetDistMetricWeights2(vweights) ) {
+            FOREACH(itweight, vweights) {
+                *itweight = RaveSqrt(*itweight);
+            }
+        }
+        else {
+            vweights.assign(dof, 1);
+        }
+        std::stringstream ssspec;
+        ssspec << _parameters->_configurationspecification;
+        if( !_cachetree || ssspec.str() != _sConfigurationSpecification || vweights != _vweights || _parameters->_vConfigLowerLimit != _vlowerlimit || _parameters->_vConfigUpperLimit != _vupperlimit ) {
+            if( _vvertices.size() > 0 ) {
+                RAVELOG_DEBUG_FORMAT("env=%s, configuration space changed, resetting roadmap with %d vertices", GetEnv()->GetNameId()%_vvertices.size());
+            }
+            _sConfigurationSpecification = ssspec.str();
+            _ResetRoadmap(vweights, _parameters->_vConfigLowerLimit, _parameters->_vConfigUpperLimit);
+        }
+
+        _UpdateValidityKey();
+
+        std::vector<KinBodyPtr> vbodies;
+        GetEnv()->GetBodies(vbodies);
+        FOREACHC(itbody, vbodies) {
+            _RegisterBodyChangeCallback(*itbody);
+        }
+        return true;
+    }
+
+    virtual PlannerStatus PlanPath(TrajectoryBasePtr ptraj, int planningoptions) override
+    {
+        if(!_parameters) {
+            return OPENRAVE_PLANNER_STATUS(str(boost::format("env=%s, PersistentRoadmapPlanner::PlanPath - Error, planner not initialized")%GetEnv()->GetNameId()), PS_Failed);
+        }
+
+        EnvironmentLock lock(GetEnv()->GetMutex());
+        uint64_t basetimeus = utils::GetMonotonicTime();
+        int constraintFilterOptions = 0xffff|CFO_FillCollisionReport;
+
+        PlannerStatus planningstatus;
+        PlannerParameters::StateSaver savestate(_parameters);
+        CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
+
+        // the robot is moved only along the active dofs while planning, any other change of the robot is found here
+        _UpdateValidityKey();
+        _ProcessBodyChanges();
+
+        const int dof = _parameters->GetDOF();
+        _vquerytypes.assign(_vvertices.size(), QT_None);
+        int numstarts = 0, numgoals = 0, numchecks = 0;
+        int startgoalvertex = -1; ///< vertex that is both a start and a goal
+        std::vector<dReal> vconfig(dof);
+        for(size_t index = 0; index < _parameters->vinitialconfig.size(); index += dof) {
+            std::copy(_parameters->vinitialconfig.begin()+index, _parameters->vinitialconfig.begin()+index+dof, vconfig.begin());
+            int vertex = _AddVertex(vconfig);
+            if( vertex >= 0 && _CheckVertex(vertex, constraintFilterOptions, numchecks) ) {
+                _vquerytypes.at(vertex) = QT_Start;
+                ++numstarts;
+            }
+        }
+        for(size_t index = 0; index < _parameters->vgoalconfig.size(); index += dof) {
+            std::copy(_parameters->vgoalconfig.begin()+index, _parameters->vgoalconfig.begin()+index+dof, vconfig.begin());
+            int vertex = _AddVertex(vconfig);
+            if( vertex < 0 ) {
+                continue;
+            }
+            if( _vquerytypes.at(vertex) == QT_Start ) {
+                // already checked as a start
+                startgoalvertex = vertex;
+                ++numgoals;
+            }
+            else if( _vquerytypes.at(vertex) == QT_None && _CheckVertex(vertex, constraintFilterOptions, numchecks) ) {
+                _vquerytypes.at(vertex) = QT_Goal;
+                ++numgoals;
+            }
+        }
+        if( numstarts == 0 ) {
+            return OPENRAVE_PLANNER_STATUS(str(boost::format("env=%s, no valid initial configurations")%GetEnv()->GetNameId()), PS_Failed);
+        }
+        if( numgoals == 0 ) {
+            return OPENRAVE_PLANNER_STATUS(str(boost::format("env=%s, no valid goal configurations")%GetEnv()->GetNameId()), PS_Failed);
+        }
+
+        PlannerProgress progress;
+        std::vector<int> vpathvertices, vpathedges;
+        std::vector<dReal> vsample;
+        int iter = 0;
+        bool bFound = false;
+        bool bSearch = true;
+        if( startgoalvertex >= 0 ) {
+            vpathvertices.assign(1, startgoalvertex);
+            bFound = true;
+        }
+        while(!bFound && iter < _parameters->_nMaxIterations) {
+            progress._iteration = iter;
+            PlannerAction callbackaction = _CallCallbacks(progress);
+            if( callbackaction == PA_Interrupt ) {
+                return OPENRAVE_PLANNER_STATUS(str(boost::format("env=%s, Planning was interrupted")%GetEnv()->GetNameId()), PS_Interrupted);
+            }
+            if( _parameters->_nMaxPlanningTime > 0 ) {
+                uint64_t elapsedtime = utils::GetMonotonicTime()-basetimeus;
+                if( elapsedtime >= 1000*_parameters->_nMaxPlanningTime ) {
+                    RAVELOG_DEBUG_FORMAT("env=%s, time exceeded (%d[us] > %d[us]) so breaking. iter=%d < %d", GetEnv()->GetNameId()%elapsedtime%(1000*_parameters->_nMaxPlanningTime)%iter%_parameters->_nMaxIterations);
+                    break;
+                }
+            }
+
+            if( bSearch ) {
+                bSearch = false;
+                if( _SearchPath(vpathvertices, vpathedges) ) {
+                    bool bPathValid = true;
+                    for(size_t ipath = 0; ipath < vpathedges.size(); ++ipath) {
+                        if( !_CheckVertex(vpathvertices[ipath+1], constraintFilterOptions, numchecks) || !_CheckEdge(vpathedges[ipath], vpathvertices[ipath], constraintFilterOptions, numchecks) ) {
+                            if( planningoptions & PO_AddCollisionStatistics ) {
+                                planningstatus.AddCollisionReport(_filterreturn->_report);
+                            }
+                            bPathValid = false;
+                            break;
+                        }
+                    }
+                    if( bPathValid ) {
+                        bFound = true;
+                        break;
+                    }
+                    bSearch = true;
+                    continue;
+                }
+            }
+
+            ++iter;
+            vsample.resize(0);
+            if( !_parameters->_samplefn(vsample) ) {
+                continue;
+            }
+            int vertex = _AddVertex(vsample);
+            if( vertex >= 0 && _CheckVertex(vertex, constraintFilterOptions, numchecks) ) {
+                bSearch = true;
+            }
+        }
+
+        uint64_t elapsedtimeus = utils::GetMonotonicTime()-basetimeus;
+        if( !bFound ) {
+            std::string description = str(boost::format(_("env=%s, plan failed in %u[us], iter=%d, nMaxIterations=%d, vertices=%d, checks=%d"))%GetEnv()->GetNameId()%elapsedtimeus%iter%_parameters->_nMaxIterations%_vvertices.size()%numchecks);
+            RAVELOG_WARN(description);
+            return OPENRAVE_PLANNER_STATUS(description, PS_Failed);
+        }
+
+        std::vector<dReal> vpath;
+        vpath.reserve(vpathvertices.size()*dof);
+        FOREACHC(itvertex, vpathvertices) {
+            vpath.insert(vpath.end(), _vvertices[*itvertex].q.begin(), _vvertices[*itvertex].q.end());
+        }
+        if( ptraj->GetConfigurationSpecification().GetDOF() == 0 ) {
+            ptraj->Init(_parameters->_configurationspecification);
+        }
+        ptraj->Insert(ptraj->GetNumWaypoints(), vpath, _parameters->_configurationspecification);
+        RAVELOG_DEBUG_FORMAT("env=%s, plan success, iters=%d, path=%d points, vertices=%d, edges=%d, checks=%d, computation time=%u[us]", GetEnv()->GetNameId()%iter%vpathvertices.size()%_vvertices.size()%_vedges.size()%numchecks%elapsedtimeus);
+        return _ProcessPostPlanners(_robot,ptraj);
+    }
+
+    virtual PlannerParametersConstPtr GetParameters() const {
+        return _parameters;
+    }
+
+protected:
+    bool SetNumNeighborsCommand(std::ostream& sout, std::istream& sinput)
+    {
+        sinput >> _nNeighbors;
+        return !!sinput;
+    }
+
+    bool ResetRoadmapCommand(std::ostream& sout, std::istream& sinput)
+    {
+        _ResetRoadmap(_vweights, _vlowerlimit, _vupperlimit);
+        return true;
+    }
+
+    bool SetConstraintsKeyCommand(std::ostream& sout, std::istream& sinput)
+    {
+        std::string key;
+        std::getline(sinput, key);
+        boost::trim(key);
+        if( key != _sConstraintsKey ) {
+            _sConstraintsKey = key;
+            if( !!_parameters ) {
+                _UpdateValidityKey();
+            }
+        }
+        return true;
+    }
+
+    bool GetRoadmapInfoCommand(std::ostream& sout, std::istream& sinput)
+    {
+        if( !!_parameters ) {
+            _UpdateValidityKey();
+        }
+        _ProcessBodyChanges();
+        int numvalid = 0, numinvalid = 0;
+        FOREACHC(itedge, _vedges) {
+            if( _IsValid(itedge->validity) ) {
+                ++numvalid;
+            }
+            else if( itedge->validity.state == VS_Invalid ) {
+                ++numinvalid;
+            }
+        }
+        sout << _vvertices.size() << " " << _vedges.size() << " " << numvalid << " " << numinvalid;
+        return true;
+    }
+
+    /** file format: version, crc32 checksum of the rest of the file, configuration specification, state hash, dof, weights, lower and upper limits,
+        vertices (values, free), edges (vertex indices, length, free).
+
+        The state hash is the md5 of the validity key and of the state of the environment bodies, empty if the roadmap was never checked.
+     */
+    bool SaveRoadmapCommand(std::ostream& sout, std::istream& sinput)
+    {
+        std::string filename;
+        sinput >> filename;
+        if( !sinput ) {
+            return false;
+        }
+        if( !_cachetree ) {
+            RAVELOG_WARN_FORMAT("env=%s, roadmap is not initialized", GetEnv()->GetNameId());
+            return false;
+        }
+        if( !!_parameters ) {
+            _UpdateValidityKey();
+        }
+        _ProcessBodyChanges();
+        const std::string statehash = _ComputeStateHash();
+
+        std::string data;
+        int speclength = _sConfigurationSpecification.size();
+        _AppendRoadmapData(data, &speclength, 1);
+        _AppendRoadmapData(data, _sConfigurationSpecification.c_str(), speclength);
+        int hashlength = statehash.size();
+        _AppendRoadmapData(data, &hashlength, 1);
+        _AppendRoadmapData(data, statehash.c_str(), hashlength);
+        int dof = _vweights.size();
+        _AppendRoadmapData(data, &dof, 1);
+        _AppendRoadmapData(data, _vweights.data(), dof);
+        _AppendRoadmapData(data, _vlowerlimit.data(), dof);
+        _AppendRoadmapData(data, _vupperlimit.data(), dof);
+
+        // collisions are not saved since the colliding bodies can be different when loading
+        int numvertices = _vvertices.size();
+        _AppendRoadmapData(data, &numvertices, 1);
+        FOREACHC(itvertex, _vvertices) {
+            _AppendRoadmapData(data, itvertex->q.data(), dof);
+            uint8_t valid = _IsValid(itvertex->validity);
+            _AppendRoadmapData(data, &valid, 1);
+        }
+        int numedges = _vedges.size();
+        _AppendRoadmapData(data, &numedges, 1);
+        FOREACHC(itedge, _vedges) {
+            _AppendRoadmapData(data, &itedge->vertex0, 1);
+            _AppendRoadmapData(data, &itedge->vertex1, 1);
+            _AppendRoadmapData(data, &itedge->length, 1);
+            uint8_t valid = _IsValid(itedge->validity);
+            _AppendRoadmapData(data, &valid, 1);
+        }
+
+        int version = s_roadmapFileVersion;
+        boost::crc_32_type crc;
+        crc.process_bytes(data.data(), data.size());
+        uint32_t checksum = crc.checksum();
+
+        std::string fullfilename = RaveFindDatabaseFile(std::string("roadmap.")+filename,false);
+        FILE* pfile = fopen(fullfilename.c_str(),"wb");
+        if( !pfile ) {
+            RAVELOG_WARN_FORMAT("env=%s, failed to open %s for writing", GetEnv()->GetNameId()%fullfilename);
+            return false;
+        }
+        bool bSuccess = fwrite(&version, sizeof(version), 1, pfile) == 1 && fwrite(&checksum, sizeof(checksum), 1, pfile) == 1 && fwrite(data.data(), data.size(), 1, pfile) == 1;
+        fclose(pfile);
+        if( !bSuccess ) {
+            RAVELOG_WARN_FORMAT("env=%s, failed to write roadmap to %s", GetEnv()->GetNameId()%fullfilename);
+            return false;
+        }
+        RAVELOG_DEBUG_FORMAT("env=%s, wrote roadmap to %s, vertices=%d, edges=%d", GetEnv()->GetNameId()%fullfilename%numvertices%numedges);
+        return true;
+    }
+
+    bool LoadRoadmapCommand(std::ostream& sout, std::istream& sinput)
+    {
+        std::string filename;
+        sinput >> filename;
+        if( !sinput ) {
+            return false;
+        }
+        std::string fullfilename = RaveFindDatabaseFile(std::string("roadmap.")+filename,true);
+        std::ifstream f;
+        if( fullfilename.size() > 0 ) {
+            f.open(fullfilename.c_str(), std::ios::in|std::ios::binary);
+        }
+        if( !f ) {
+            RAVELOG_WARN_FORMAT("env=%s, failed to find roadmap %s", GetEnv()->GetNameId()%filename);
+            return false;
+        }
+        std::string data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+        size_t offset = 0;
+        int version = 0;
+        uint32_t checksum = 0;
+        if( !_ReadRoadmapData(data, offset, &version, 1) || version != s_roadmapFileVersion || !_ReadRoadmapData(data, offset, &checksum, 1) ) {
+            RAVELOG_WARN_FORMAT("env=%s, roadmap file %s has a different version", GetEnv()->GetNameId()%fullfilename);
+            return false;
+        }
+        boost::crc_32_type crc;
+        crc.process_bytes(data.data()+offset, data.size()-offset);
+        if( crc.checksum() != checksum ) {
+            RAVELOG_WARN_FORMAT("env=%s, roadmap file %s has a wrong checksum", GetEnv()->GetNameId()%fullfilename);
+            return false;
+        }
+
+        bool bSuccess = false;
+        int speclength = 0, hashlength = 0, dof = 0, numvertices = 0, numedges = 0;
+        std::string sspec, statehash;
+        std::vector<dReal> vweights, vlowerlimit, vupperlimit;
+        if( _ReadRoadmapData(data, offset, &speclength, 1) && speclength >= 0 && speclength <= (int)(data.size()-offset) ) {
+            sspec.resize(speclength);
+            if( _ReadRoadmapData(data, offset, &sspec[0], speclength) && _ReadRoadmapData(data, offset, &hashlength, 1) && hashlength >= 0 && hashlength <= (int)(data.size()-offset) ) {
+                statehash.resize(hashlength);
+                if( _ReadRoadmapData(data, offset, &statehash[0], hashlength) && _ReadRoadmapData(data, offset, &dof, 1) && dof > 0 && dof <= (int)(data.size()-offset) ) {
+                    vweights.resize(dof);
+                    vlowerlimit.resize(dof);
+                    vupperlimit.resize(dof);
+                    bSuccess = _ReadRoadmapData(data, offset, vweights.data(), dof) && _ReadRoadmapData(data, offset, vlowerlimit.data(), dof) && _ReadRoadmapData(data, offset, vupperlimit.data(), dof);
+                }
+            }
+        }
+        if( bSuccess ) {
+            _sConfigurationSpecification = sspec;
+            _ResetRoadmap(vweights, vlowerlimit, vupperlimit);
+            // the free flags can only be used if they were checked for the same robot, constraints and environment
+            if( !!_parameters ) {
+                _UpdateValidityKey();
+            }
+            const bool bUseFree = statehash.size() > 0 && statehash == _ComputeStateHash();
+            if( !bUseFree ) {
+                RAVELOG_DEBUG_FORMAT("env=%s, roadmap %s was saved for a different state, vertices and edges have to be checked again", GetEnv()->GetNameId()%fullfilename);
+            }
+            std::vector<dReal> q(dof);
+            uint8_t valid = 0;
+            bSuccess = _ReadRoadmapData(data, offset, &numvertices, 1) && numvertices >= 0;
+            for(int ivertex = 0; bSuccess && ivertex < numvertices; ++ivertex) {
+                bSuccess = _ReadRoadmapData(data, offset, q.data(), dof) && _ReadRoadmapData(data, offset, &valid, 1);
+                if( bSuccess ) {
+                    _vvertices.push_back(Vertex());
+                    _vvertices.back().q = q;
+                    if( valid && bUseFree ) {
+                        _SetValid(_vvertices.back().validity);
+                    }
+                    if( _cachetree->InsertNode(q, CollisionReportPtr(), 0, ivertex) != 1 ) {
+                        // the vertex cannot be used for nearest neighbors, but it is still part of the edges
+                        RAVELOG_DEBUG_FORMAT("env=%s, failed to insert roadmap vertex %d into cache tree", GetEnv()->GetNameId()%ivertex);
+                    }
+                }
+            }
+            bSuccess = bSuccess && _ReadRoadmapData(data, offset, &numedges, 1) && numedges >= 0;
+            for(int iedge = 0; bSuccess && iedge < numedges; ++iedge) {
+                Edge edge(0, 0, 0);
+                bSuccess = _ReadRoadmapData(data, offset, &edge.vertex0, 1) && _ReadRoadmapData(data, offset, &edge.vertex1, 1) && _ReadRoadmapData(data, offset, &edge.length, 1) && _ReadRoadmapData(data, offset, &valid, 1);
+                bSuccess = bSuccess && edge.vertex0 >= 0 && edge.vertex0 < numvertices && edge.vertex1 >= 0 && edge.vertex1 < numvertices;
+                if( bSuccess ) {
+                    if( valid && bUseFree ) {
+                        _SetValid(edge.validity);
+                    }
+                    _vedges.push_back(edge);
+                    _vvertices[edge.vertex0].vedges.push_back(iedge);
+                    _vvertices[edge.vertex1].vedges.push_back(iedge);
+                }
+            }
+        }
+        if( !bSuccess ) {
+            RAVELOG_WARN_FORMAT("env=%s, roadmap file %s is corrupted", GetEnv()->GetNameId()%fullfilename);
+            _ResetRoadmap(_vweights, _vlowerlimit, _vupperlimit);
+            return false;
+        }
+        RAVELOG_DEBUG_FORMAT("env=%s, loaded roadmap from %s, vertices=%d, edges=%d", GetEnv()->GetNameId()%fullfilename%numvertices%numedges);
+        return true;
+    }
+
+    template <typename T>
+    static void _AppendRoadmapData(std::string& data, const T* pvalues, size_t num)
+    {
+        data.append(reinterpret_cast<const char*>(pvalues), sizeof(T)*num);
+    }
+
+    /// \brief reads num values at offset and advances offset
+    ///
+    /// \return false if the data is too short
+    template <typename T>
+    static bool _ReadRoadmapData(const std::string& data, size_t& offset, T* pvalues, size_t num)
+    {
+        if( num > (data.size()-offset)/sizeof(T) ) {
+            return false;
+        }
+        std::copy(data.begin()+offset, data.begin()+offset+sizeof(T)*num, reinterpret_cast<char*>(pvalues));
+        offset += sizeof(T)*num;
+        return true;
+    }
+
+    /// \brief removes all vertices and edges and sets up the cache tree for a new configuration space
+    void _ResetRoadmap(const std::vector<dReal>& vweights, const std::vector<dReal>& vlowerlimit, const std::vector<dReal>& vupperlimit)
+    {
+        _vweights = vweights;
+        _vlowerlimit = vlowerlimit;
+        _vupperlimit = vupperlimit;
+        _vvertices.resize(0);
+        _vedges.resize(0);
+        _setChangedBodies.clear();
+        if( _vweights.size() == 0 ) {
+            _cachetree.reset();
+            return;
+        }
+        // distance has to be computed in the same way as the cache tree, otherwise configurations farther than maxdistance cannot be inserted
+        dReal maxdistance = 0;
+        for (size_t i = 0; i < _vweights.size(); ++i) {
+            dReal f = (_vupperlimit.at(i) - _vlowerlimit.at(i)) * _vweights[i];
+            maxdistance += f*f;
+        }
+        _cachetree.reset(new CacheTree(_vweights.size()));
+        _cachetree->Init(_vweights, max(RaveSqrt(maxdistance), g_fEpsilonLinear));
+    }
+
+    /// \brief adds a vertex to the roadmap and connects it to its _nNeighbors nearest vertices without checking the edges. If a vertex already exists at q, returns it.
+    ///
+    /// \return the index of the vertex, -1 if it cannot be added
+    int _AddVertex(const std::vector<dReal>& q)
+    {
+        _cachetree->FindNearestNodes(q, max(_nNeighbors, 1), CNT_Any, _vnearestnodes);
+        if( _vnearestnodes.size() > 0 && _vnearestnodes[0].distance <= g_fEpsilonLinear ) {
+            return _vnearestnodes[0].userindex;
+        }
+        const int newvertex = _vvertices.size();
+        if( _cachetree->InsertNode(q, CollisionReportPtr(), 0, newvertex) != 1 ) {
+            RAVELOG_DEBUG_FORMAT("env=%s, failed to insert configuration into cache tree, might be out of limits", GetEnv()->GetNameId());
+            return -1;
+        }
+
+        _vvertices.push_back(Vertex());
+        _vvertices.back().q = q;
+        _vquerytypes.push_back(QT_None);
+        for(size_t inearest = 0; inearest < _vnearestnodes.size() && (int)inearest < _nNeighbors; ++inearest) {
+            const int neighborvertex = _vnearestnodes[inearest].userindex;
+            _vedges.emplace_back(newvertex, neighborvertex, _parameters->_distmetricfn(q, _vvertices[neighborvertex].q));
+            _vvertices[newvertex].vedges.push_back(_vedges.size()-1);
+            _vvertices[neighborvertex].vedges.push_back(_vedges.size()-1);
+        }
+        return newvertex;
+    }
+
+    /// \brief checks the vertex if its validity is not known
+    ///
+    /// \return true if the vertex satisfies the constraints
+    bool _CheckVertex(int vertex, int constraintFilterOptions, int& numchecks)
+    {
+        Validity& validity = _vvertices.at(vertex).validity;
+        if( _IsValid(validity) ) {
+            return true;
+        }
+        if( validity.state == VS_Invalid ) {
+            return false;
+        }
+        ++numchecks;
+        _filterreturn->Clear();
+        const std::vector<dReal>& q = _vvertices[vertex].q;
+        int ret = _parameters->CheckPathAllConstraints(q, q, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart, constraintFilterOptions, _filterreturn);
+        _SetCheckResult(validity, ret);
+        return ret == 0;
+    }
+
+    /// \brief checks the edge starting from fromvertex if its validity is not known
+    ///
+    /// \return true if the edge satisfies the constraints
+    bool _CheckEdge(int edgeindex, int fromvertex, int constraintFilterOptions, int& numchecks)
+    {
+        Edge& edge = _vedges.at(edgeindex);
+        if( _IsValid(edge.validity) ) {
+            return true;
+        }
+        if( edge.validity.state == VS_Invalid ) {
+            return false;
+        }
+        ++numchecks;
+        _filterreturn->Clear();
+        const std::vector<dReal>& q0 = _vvertices[fromvertex].q;
+        const std::vector<dReal>& q1 = _vvertices[edge.GetOtherVertex(fromvertex)].q;
+        int ret = _parameters->CheckPathAllConstraints(q0, q1, std::vector<dReal>(), std::vector<dReal>(), 0, IT_Open, constraintFilterOptions, _filterreturn);
+        _SetCheckResult(edge.validity, ret);
+        return ret == 0;
+    }
+
+    /// \brief searches the shortest path from any start vertex to any goal vertex over the vertices and edges that are not known to be invalid
+    ///
+    /// \param[out] vpathvertices the vertices of the path from the start vertex to the goal vertex
+    /// \param[out] vpathedges the edges of the path, vpathedges[i] connects vpathvertices[i] and vpathvertices[i+1]
+    bool _SearchPath(std::vector<int>& vpathvertices, std::vector<int>& vpathedges)
+    {
+        const int numvertices = _vvertices.size();
+        _vcosts.assign(numvertices, std::numeric_limits<dReal>::infinity());
+        _vparentedges.assign(numvertices, -1);
+        std::priority_queue< std::pair<dReal, int>, std::vector< std::pair<dReal, int> >, std::greater< std::pair<dReal, int> > > queue;
+        for(int ivertex = 0; ivertex < numvertices; ++ivertex) {
+            if( _vquerytypes[ivertex] == QT_Start ) {
+                _vcosts[ivertex] = 0;
+                queue.push(std::make_pair(dReal(0), ivertex));
+            }
+        }
+
+        int goalvertex = -1;
+        while(!queue.empty()) {
+            const std::pair<dReal, int> top = queue.top();
+            queue.pop();
+            if( top.first > _vcosts[top.second] ) {
+                continue;
+            }
+            if( _vquerytypes[top.second] == QT_Goal ) {
+                goalvertex = top.second;
+                break;
+            }
+            FOREACHC(itedge, _vvertices[top.second].vedges) {
+                const Edge& edge = _vedges[*itedge];
+                if( edge.validity.state == VS_Invalid ) {
+                    continue;
+                }
+                const int othervertex = edge.GetOtherVertex(top.second);
+                if( _vvertices[othervertex].validity.state == VS_Invalid ) {
+                    continue;
+                }
+                const dReal cost = top.first + edge.length;
+                if( cost < _vcosts[othervertex] ) {
+                    _vcosts[othervertex] = cost;
+                    _vparentedges[othervertex] = *itedge;
+                    queue.push(std::make_pair(cost, othervertex));
+                }
+            }
+        }
+        if( goalvertex < 0 ) {
+            return false;
+        }
+
+        vpathvertices.resize(0);
+        vpathedges.resize(0);
+        int ivertex = goalvertex;
+        vpathvertices.push_back(ivertex);
+        while(_vparentedges[ivertex] >= 0) {
+            vpathedges.push_back(_vparentedges[ivertex]);
+            ivertex = _vedges[_vparentedges[ivertex]].GetOtherVertex(ivertex);
+            vpathvertices.push_back(ivertex);
+        }
+        std::reverse(vpathvertices.begin(), vpathvertices.end());
+        std::reverse(vpathedges.begin(), vpathedges.end());
+        return true;
+    }
+
+    inline bool _IsValid(const Validity& validity) const {
+        return validity.state == VS_Valid && validity.stamp == _freestamp;
+    }
+
+    inline void _SetValid(Validity& validity) const {
+        validity.state = VS_Valid;
+        validity.stamp = _freestamp;
+    }
+
+    /// \brief sets the validity from the return value of CheckPathAllConstraints and the collision report in _filterreturn
+    void _SetCheckResult(Validity& validity, int ret) const
+    {
+        if( ret == 0 ) {
+            _SetValid(validity);
+            return;
+        }
+        validity.state = VS_Invalid;
+        validity.collidingbodyindex = 0;
+        const CollisionReport& report = _filterreturn->_report;
+        KinBodyConstPtr pbody1 = !!report.plink1 ? report.plink1->GetParent() : KinBodyConstPtr();
+        KinBodyConstPtr pbody2 = !!report.plink2 ? report.plink2->GetParent() : KinBodyConstPtr();
+        if( !!pbody1 && !!pbody2 ) {
+            bool bRobot1 = pbody1 == _robot || (!!_robot && _robot->IsGrabbing(*pbody1));
+            bool bRobot2 = pbody2 == _robot || (!!_robot && _robot->IsGrabbing(*pbody2));
+            if( bRobot1 && bRobot2 ) {
+                validity.collidingbodyindex = -1;
+            }
+            else if( bRobot1 ) {
+                validity.collidingbodyindex = pbody2->GetEnvironmentBodyIndex();
+            }
+            else if( bRobot2 ) {
+                validity.collidingbodyindex = pbody1->GetEnvironmentBodyIndex();
+            }
+        }
+    }
+
+    /// \brief all free vertices and edges have to be checked again and the ones that failed because of the changed bodies are not known anymore
+    void _ProcessBodyChanges()
+    {
+        if( _setChangedBodies.empty() ) {
+            return;
+        }
+        const bool bAll = _setChangedBodies.count(-1) > 0;
+        FOREACH(itvertex, _vvertices) {
+            Validity& validity = itvertex->validity;
+            if( validity.state == VS_Invalid && (bAll || validity.collidingbodyindex == 0 || _setChangedBodies.count(validity.collidingbodyindex) > 0) ) {
+                validity.state = VS_Unknown;
+            }
+        }
+        FOREACH(itedge, _vedges) {
+            Validity& validity = itedge->validity;
+            if( validity.state == VS_Invalid && (bAll || validity.collidingbodyindex == 0 || _setChangedBodies.count(validity.collidingbodyindex) > 0) ) {
+                validity.state = VS_Unknown;
+            }
+        }
+        _setChangedBodies.clear();
+    }
+
+    /// \brief marks all vertices and edges as not known
+    void _InvalidateAll()
+    {
+        ++_freestamp;
+        _setChangedBodies.insert(-1);
+    }
+
+    void _RegisterBodyChangeCallback(KinBodyPtr pbody)
+    {
+        const int bodyindex = pbody->GetEnvironmentBodyIndex();
+        if( bodyindex <= 0 || _mapBodyChangeHandles.count(bodyindex) > 0 ) {
+            return;
+        }
+        _mapBodyChangeHandles[bodyindex] = pbody->RegisterChangeCallback(KinBody::Prop_LinkGeometry|KinBody::Prop_LinkEnable|KinBody::Prop_LinkTransforms, boost::bind(&PersistentRoadmapPlanner::_UpdateBody, this, KinBodyWeakPtr(pbody), bodyindex));
+    }
+
+    /// \brief called when body has changed state
+    void _UpdateBody(KinBodyWeakPtr pweakbody, int bodyindex)
+    {
+        KinBodyPtr pbody = pweakbody.lock();
+        // the robot and its grabbed bodies move along the active dofs while planning, the rest of their state is part of the validity key
+        if( !!pbody && !!_robot && (pbody == _robot || _robot->IsGrabbing(*pbody)) ) {
+            return;
+        }
+        ++_freestamp;
+        _setChangedBodies.insert(bodyindex);
+    }
+
+    /// \brief serializes everything the constraints checks depend on except for the other bodies of the environment.
+    ///
+    /// This is the constraints (step length, resolutions, type of the constraints function and _sConstraintsKey), the collision checker and its options,
+    /// and the state of the robot that is not changed by planning: its geometry, the transform if it is not active, the values of the dofs that are not active,
+    /// the link enable states, and the geometry and relative pose of each grabbed body.
+    std::string _ComputeValidityKey() const
+    {
+        std::stringstream ss;
+        ss << std::setprecision(std::numeric_limits<dReal>::digits10+1);
+        ss << _sConfigurationSpecification << endl << _parameters->_fStepLength << " ";
+        FOREACHC(itresolution, _parameters->_vConfigResolution) {
+            ss << *itresolution << " ";
+        }
+        ss << endl << (!!_parameters->_checkpathvelocityconstraintsfn ? _parameters->_checkpathvelocityconstraintsfn.target_type().name() : "") << endl << _sConstraintsKey << endl;
+        CollisionCheckerBasePtr pchecker = GetEnv()->GetCollisionChecker();
+        if( !!pchecker ) {
+            ss << pchecker->GetXMLId() << " " << (pchecker->GetCollisionOptions()|CO_ActiveDOFs) << endl;
+        }
+        if( !_robot ) {
+            return ss.str();
+        }
+
+        ss << _robot->GetName() << " " << _robot->GetKinematicsGeometryHash() << endl;
+        if( _robot->GetAffineDOF() == 0 ) {
+            ss << _robot->GetTransform() << endl;
+        }
+        std::vector<dReal> vdofvalues;
+        _robot->GetDOFValues(vdofvalues);
+        const std::vector<int>& vactivedofindices = _robot->GetActiveDOFIndices();
+        for(int idof = 0; idof < (int)vdofvalues.size(); ++idof) {
+            if( std::find(vactivedofindices.begin(), vactivedofindices.end(), idof) == vactivedofindices.end() ) {
+                ss << idof << "=" << vdofvalues[idof] << " ";
+            }
+        }
+        ss << endl;
+        FOREACHC(itmask, _robot->GetLinkEnableStatesMasks()) {
+            ss << *itmask << " ";
+        }
+        ss << endl;
+
+        std::vector<KinBody::GrabbedInfo> vgrabbedinfos;
+        _robot->GetGrabbedInfo(vgrabbedinfos);
+        std::map<std::string, const KinBody::GrabbedInfo*> mapGrabbedInfos;
+        FOREACHC(itinfo, vgrabbedinfos) {
+            mapGrabbedInfos[itinfo->_grabbedname] = &*itinfo;
+        }
+        FOREACHC(itinfo, mapGrabbedInfos) {
+            ss << itinfo->second->GetGrabbedInfoHash();
+            KinBodyPtr pgrabbed = GetEnv()->GetKinBody(itinfo->first);
+            if( !!pgrabbed ) {
+                ss << " " << pgrabbed->GetKinematicsGeometryHash() << " ";
+                FOREACHC(itmask, pgrabbed->GetLinkEnableStatesMasks()) {
+                    ss << *itmask << " ";
+                }
+            }
+            ss << endl;
+        }
+        return ss.str();
+    }
+
+    /// \brief serializes the state of the bodies that are not the robot or grabbed by it
+    std::string _ComputeEnvironmentKey() const
+    {
+        std::vector<KinBodyPtr> vbodies;
+        GetEnv()->GetBodies(vbodies);
+        std::map<std::string, KinBodyPtr> mapBodies;
+        FOREACHC(itbody, vbodies) {
+            if( !_robot || (*itbody != _robot && !_robot->IsGrabbing(**itbody)) ) {
+                mapBodies[(*itbody)->GetName()] = *itbody;
+            }
+        }
+        std::stringstream ss;
+        ss << std::setprecision(std::numeric_limits<dReal>::digits10+1);
+        std::vector<dReal> vdofvalues;
+        FOREACHC(itbody, mapBodies) {
+            KinBodyPtr pbody = itbody->second;
+            ss << itbody->first << " " << pbody->GetKinematicsGeometryHash() << " " << pbody->GetTransform() << " ";
+            pbody->GetDOFValues(vdofvalues);
+            FOREACHC(itvalue, vdofvalues) {
+                ss << *itvalue << " ";
+            }
+            FOREACHC(itmask, pbody->GetLinkEnableStatesMasks()) {
+                ss << *itmask << " ";
+            }
+            ss << endl;
+        }
+        return ss.str();
+    }
+
+    /// \brief hash of the validity key and the environment that the free vertices and edges were checked for, empty if the validity key is not known
+    std::string _ComputeStateHash() const
+    {
+        if( _sValidityKey.size() == 0 ) {
+            return std::string();
+        }
+        return utils::GetMD5HashString(_sValidityKey + _ComputeEnvironmentKey());
+    }
+
+    /// \brief recomputes the validity key and marks all vertices and edges as not known if it has changed
+    void _UpdateValidityKey()
+    {
+        std::string key = _ComputeValidityKey();
+        if( key != _sValidityKey ) {
+            if( _sValidityKey.size() > 0 ) {
+                RAVELOG_DEBUG_FORMAT("env=%s, constraints or robot state changed, all %d vertices have to be checked again", GetEnv()->GetNameId()%_vvertices.size());
+            }
+            _sValidityKey.swap(key);
+            _InvalidateAll();
+        }
+    }
+
+    /// \brief called when a body has been added/removed from the environment. action=1 is add, action=0 is remove
+    void _UpdateAddRemoveBodies(KinBodyPtr pbody, int action)
+    {
+        const int bodyindex = pbody->GetEnvironmentBodyIndex();
+        if( action == 1 ) {
+            ++_freestamp;
+            _RegisterBodyChangeCallback(pbody);
+        }
+        else if( action == 0 ) {
+            _mapBodyChangeHandles.erase(bodyindex);
+            _setChangedBodies.insert(bodyindex);
+        }
+    }
+
+    static const int s_roadmapFileVersion = 2;
+
+    PlannerParametersPtr _parameters;
+    RobotBasePtr _robot;
+    ConstraintFilterReturnPtr _filterreturn;
+    int _nNeighbors; ///< number of nearest vertices a new vertex is connected to
+
+    // configuration space of the roadmap
+    std::string _sConfigurationSpecification; ///< serialized configuration specification
+    std::vector<dReal> _vweights, _vlowerlimit, _vupperlimit;
+    std::string _sValidityKey; ///< _ComputeValidityKey when the roadmap was last checked
+    std::string _sConstraintsKey; ///< set by the user to distinguish constraints functions of the same type
+
+    CacheTreePtr _cachetree; ///< nearest neighbor structure of the vertices, the user index of the nodes is the vertex index
+    std::vector<Vertex> _vvertices;
+    std::vector<Edge> _vedges;
+
+    uint32_t _freestamp; ///< incremented every time the environment changes, vertices and edges are only free if they were checked with the current stamp
+    std::set<int> _setChangedBodies; ///< environment body indices of the bodies changed since the last query, -1 if all have changed
+    std::map<int, UserDataPtr> _mapBodyChangeHandles; ///< handles for the changes of the bodies in the environment indexed by environment body index
+    UserDataPtr _handleBodyAddRemove; ///< handle for bodies added or removed to the environment
+
+    // caches
+    std::vector<uint8_t> _vquerytypes; ///< QueryType of every vertex for the current query
+    std::vector<CacheTreeNodeInfo> _vnearestnodes;
+    std::vector<dReal> _vcosts;
+    std::vector<int> _vparentedges;
+};
+
+PlannerBasePtr CreatePersistentRoadmapPlanner(EnvironmentBasePtr penv, std::istream& sinput)
+{
+    return PlannerBasePtr(new PersistentRoadmapPlanner(penv, sinput));
+}
+
+}
@@ -104,8 +104,9 @@ const std::list<EnvironmentBase::CollisionCallbackFn>& FCLCollisionChecker::Coll
 
 FCLCollisionChecker::FCLCollisionChecker(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput)
     : OpenRAVE::CollisionCheckerBase(penv)
-    , _broadPhaseCollisionManagerAlgorithm("DynamicAABBTree2")
-    , _bIsSelfCollisionChecker(true) // DynamicAABBTree2 should be slightly faster than Naive
+    , _broadPhaseCollisionManagerAlgorithm("DynamicAABBTree2") // DynamicAABBTree2 should be slightly faster than Naive
+    , _nMinParallelPairs(8)
+    , _bIsSelfCollisionChecker(true)
 {
     _bParentlessCollisionObject = false;
     _userdatakey = std::string("fclcollision") + boost::lexical_cast<std::string>(this);
@@ -121,6 +122,7 @@ FCLCollisionChecker::FCLCollisionChecker(OpenRAVE::EnvironmentBasePtr penv, std:
     // TODO : Consider removing these which could be more harmful than anything else
     RegisterCommand("SetBroadphaseAlgorithm", boost::bind(&FCLCollisionChecker::SetBroadphaseAlgorithmCommand, this, _1, _2), "sets the broadphase algorithm (Naive, SaP, SSaP, IntervalTree, DynamicAABBTree, DynamicAABBTree_Array)");
     RegisterCommand("SetBVHRepresentation", boost::bind(&FCLCollisionChecker::_SetBVHRepresentation, this, _1, _2), "sets the Bouding Volume Hierarchy representation for meshes (AABB, OBB, OBBRSS, RSS, kIDS)");
+    RegisterCommand("SetNumThreads", boost::bind(&FCLCollisionChecker::SetNumThreadsCommand, this, _1, _2), "sets the number of threads running the narrow phase of body/environment checks (1 disables them), followed optionally by the minimum number of candidate geometry pairs to use the threads");
 
     RAVELOG_VERBOSE_FORMAT("FCLCollisionChecker %s created in env %d", _userdatakey%penv->GetId());
 
@@ -174,10 +176,16 @@ void FCLCollisionChecker::Clone(InterfaceBaseConstPtr preference, int cloningopt
     _fclspace->SetGeometryGroup(r->GetGeometryGroup());
     _fclspace->SetBVHRepresentation(r->GetBVHRepresentation());
     _SetBroadphaseAlgorithm(r->GetBroadphaseAlgorithm());
+    if( cloningoptions & Clone_Bodies ) {
+        // the bodies of this environment are about to be initialized from clones of the bodies of r
+        _fclspace->ShareGeometriesFrom(*r->_fclspace);
+    }
 
     // We don't want to clone _bIsSelfCollisionChecker since a self collision checker can be created by cloning a environment collision checker
     _options = r->_options;
     _numMaxContacts = r->_numMaxContacts;
+    _nMinParallelPairs = r->_nMinParallelPairs;
+    SetNumThreads(r->GetNumThreads());
     RAVELOG_VERBOSE(str(boost::format("FCL User data cloning env %d into env %d") % r->GetEnv()->GetId() % GetEnv()->GetId()));
 }
 
@@ -212,6 +220,33 @@ void FCLCollisionChecker::_SetBroadphaseAlgorithm(const std::string &algorithm)
     _envmanagers.clear();
 }
 
+bool FCLCollisionChecker::SetNumThreadsCommand(ostream& sout, istream& sinput)
+{
+    int numthreads = 1;
+    sinput >> numthreads;
+    if( !sinput ) {
+        return false;
+    }
+    int minparallelpairs = 0;
+    sinput >> minparallelpairs;
+    if( !!sinput && minparallelpairs > 0 ) {
+        _nMinParallelPairs = minparallelpairs;
+    }
+    SetNumThreads(numthreads);
+    return true;
+}
+
+void FCLCollisionChecker::SetNumThreads(int numthreads)
+{
+    if( numthreads == GetNumThreads() ) {
+        return;
+    }
+    _workerpool.reset();
+    if( numthreads > 1 ) {
+        _workerpool = boost::make_shared<OpenRAVE::utils::WorkerPool>(numthreads);
+    }
+}
+
 bool FCLCollisionChecker::_SetBVHRepresentation(ostream& sout, istream& sinput)
 {
     std::string type;
@@ -502,7 +537,7 @@ bool FCLCollisionChecker::CheckCollision(KinBodyConstPtr pbody, std::vector<KinB
 #ifdef FCLRAVE_CHECKPARENTLESS
     boost::shared_ptr<void> onexit((void*) 0, boost::bind(&FCLCollisionChecker::_PrintCollisionManagerInstanceBE, this, boost::ref(*pbody), boost::ref(bodyManager), boost::ref(envManager)));
 #endif
-    envManager.GetManager()->collide(bodyManager.GetManager().get(), &query, &FCLCollisionChecker::CheckNarrowPhaseCollision);
+    _CollideEnvironment(envManager, bodyManager, query);
 
     return query._bCollision;
 }
@@ -826,19 +861,209 @@ bool FCLCollisionChecker::CheckStandaloneSelfCollision(LinkConstPtr plink, Colli
     return query._bCollision;
 }
 
+int FCLCollisionChecker::_CheckCollisionBatch(KinBodyPtr pbody, size_t numconfigurations, const boost::function<void(size_t)>& setstatefn, std::vector<uint8_t>& vresults, int batchoptions, CollisionReportPtr report)
+{
+    if( (_options & OpenRAVE::CO_Distance) || !(batchoptions & OpenRAVE::CBO_Environment) ) {
+        // nothing to share between configurations
+        return CollisionCheckerBase::_CheckCollisionBatch(pbody, numconfigurations, setstatefn, vresults, batchoptions, report);
+    }
+
+    START_TIMING_OPT(_statistics, "BodyBatch/Env",_options,pbody->IsRobot());
+    vresults.resize(numconfigurations);
+    std::fill(vresults.begin(), vresults.end(), 0);
+    if( numconfigurations == 0 ) {
+        return 0;
+    }
+    if( !!report ) {
+        report->Reset(_options);
+    }
+
+    const bool bCheckEnvironment = pbody->GetLinks().size() > 0 && _IsEnabled(*pbody);
+
+    // the environment manager excludes pbody and its attached bodies, so moving pbody does not invalidate it
+    _fclspace->Synchronize();
+    std::vector<int> attachedBodyIndices;
+    pbody->GetAttachedEnvironmentBodyIndices(attachedBodyIndices);
+    FCLCollisionManagerInstance& envManager = _GetEnvManager(attachedBodyIndices);
+    FCLCollisionManagerInstance& bodyManager = _GetBodyManager(pbody, !!(_options & OpenRAVE::CO_ActiveDOFs));
+
+    const std::vector<KinBodyConstPtr> vbodyexcluded;
+    const std::vector<LinkConstPtr> vlinkexcluded;
+    CollisionCallbackData query(shared_checker(), report, vbodyexcluded, vlinkexcluded);
+    ADD_TIMING(_statistics);
+#ifdef FCLRAVE_CHECKPARENTLESS
+    boost::shared_ptr<void> onexit((void*) 0, boost::bind(&FCLCollisionChecker::_PrintCollisionManagerInstanceBE, this, boost::ref(*pbody), boost::ref(bodyManager), boost::ref(envManager)));
+#endif
+
+    int numcolliding = 0;
+    for(size_t iconfig = 0; iconfig < numconfigurations; ++iconfig) {
+        setstatefn(iconfig);
+        uint8_t result = 0;
+        if( bCheckEnvironment ) {
+            if( !!query._report ) {
+                query._report->Reset(_options);
+            }
+            query._bStopChecking = false;
+            query._bCollision = false;
+            _fclspace->SynchronizeWithAttached(*pbody);
+            bodyManager.Synchronize();
+            _CollideEnvironment(envManager, bodyManager, query);
+            if( query._bCollision ) {
+                result |= OpenRAVE::CBO_Environment;
+            }
+        }
+        if( (batchoptions & OpenRAVE::CBO_SelfCollision) && !(result && (batchoptions & OpenRAVE::CBO_StopAtFirstCollision)) ) {
+            if( CheckStandaloneSelfCollision(KinBodyConstPtr(pbody), (numcolliding == 0 && !result) ? report : CollisionReportPtr()) ) {
+                result |= OpenRAVE::CBO_SelfCollision;
+            }
+        }
+
+        vresults[iconfig] = result;
+        if( result ) {
+            if( numcolliding == 0 ) {
+                // keep the report of the first configuration in collision, callbacks still need a report to be called
+                if( query._bHasCallbacks ) {
+                    query._report = boost::make_shared<CollisionReport>();
+                }
+                else {
+                    query._report.reset();
+                }
+            }
+            ++numcolliding;
+            if( batchoptions & OpenRAVE::CBO_StopAtFirstCollision ) {
+                break;
+            }
+        }
+    }
+    return numcolliding;
+}
+
+int FCLCollisionChecker::_ComputeContinuousCollisionStep(KinBodyConstPtr pbody, const std::vector< std::pair<dReal, dReal> >& vlinkmotionbounds, int batchoptions, dReal fTolerance, dReal& fTimeStep, CollisionReportPtr report)
+{
+    if( (batchoptions & OpenRAVE::CBO_Environment) && CheckCollision(pbody, report) ) {
+        return OpenRAVE::CBO_Environment;
+    }
+    if( (batchoptions & OpenRAVE::CBO_SelfCollision) && CheckStandaloneSelfCollision(pbody, report) ) {
+        return OpenRAVE::CBO_SelfCollision;
+    }
+
+    START_TIMING_OPT(_statistics, "BodyContinuous",_options,pbody->IsRobot());
+    if( !_distanceReportCache ) {
+        _distanceReportCache = boost::make_shared<CollisionReport>();
+    }
+    fTimeStep = std::numeric_limits<dReal>::max();
+    if( (batchoptions & OpenRAVE::CBO_Environment) && pbody->GetLinks().size() > 0 && _IsEnabled(*pbody) ) {
+        _fclspace->Synchronize();
+        pbody->GetAttachedEnvironmentBodyIndices(_attachedBodyIndicesCache);
+        FCLCollisionManagerInstance& envManager = _GetEnvManager(_attachedBodyIndicesCache);
+        FOREACHC(itlink, pbody->GetLinks()) {
+            if( !_ComputeLinkEnvironmentStep(*itlink, vlinkmotionbounds.at((*itlink)->GetIndex()), envManager, fTolerance, fTimeStep, report) ) {
+                return OpenRAVE::CBO_Environment;
+            }
+        }
+        // grabbed bodies move with their grabbing links
+        pbody->GetGrabbed(_vCachedGrabbedBodies);
+        FOREACHC(itgrabbed, _vCachedGrabbedBodies) {
+            KinBody::LinkPtr pgrabbinglink = pbody->IsGrabbing(**itgrabbed);
+            if( !pgrabbinglink ) {
+                continue;
+            }
+            _fclspace->SynchronizeWithAttached(**itgrabbed);
+            FOREACHC(itlink, (*itgrabbed)->GetLinks()) {
+                if( !_ComputeLinkEnvironmentStep(*itlink, vlinkmotionbounds.at(pgrabbinglink->GetIndex()), envManager, fTolerance, fTimeStep, report) ) {
+                    return OpenRAVE::CBO_Environment;
+                }
+            }
+        }
+    }
+
+    if( (batchoptions & OpenRAVE::CBO_SelfCollision) && pbody->GetLinks().size() > 1 ) {
+        int adjacentOptions = KinBody::AO_Enabled;
+        if( (_options & OpenRAVE::CO_ActiveDOFs) && pbody->IsRobot() ) {
+            adjacentOptions |= KinBody::AO_ActiveDOFs;
+        }
+        const std::vector<int> &nonadjacent = pbody->GetNonAdjacentLinks(adjacentOptions);
+        _fclspace->SynchronizeWithAttached(*pbody);
+
+        const std::vector<KinBodyConstPtr> vbodyexcluded;
+        const std::vector<LinkConstPtr> vlinkexcluded;
+        FCLKinBodyInfoPtr pinfo = _fclspace->GetInfo(*pbody);
+        FOREACH(itset, nonadjacent) {
+            size_t index1 = *itset&0xffff, index2 = *itset>>16;
+            const FCLSpace::FCLKinBodyInfo::LinkInfo& pLINK1 = *pinfo->vlinks.at(index1);
+            const FCLSpace::FCLKinBodyInfo::LinkInfo& pLINK2 = *pinfo->vlinks.at(index2);
+            if( pLINK1.GetLink()->IsSelfCollisionIgnored() || pLINK2.GetLink()->IsSelfCollisionIgnored() ) {
+                continue;
+            }
+            if( !pLINK1.linkBV.second || !pLINK2.linkBV.second ) {
+                continue;
+            }
+            // both links can be moving, bound their relative motion by the sum of their motions
+            const dReal flinear = vlinkmotionbounds.at(index1).first + vlinkmotionbounds.at(index2).first;
+            const dReal fangular = vlinkmotionbounds.at(index1).second + vlinkmotionbounds.at(index2).second;
+            if( flinear <= 0 && fangular <= 0 ) {
+                continue;
+            }
+            // the distance of the bounding boxes is a lower bound of the distance of the links, so skip the pairs that cannot shorten the step
+            if( _GetConservativeAdvancementTime(pLINK1.linkBV.second->getAABB().distance(pLINK2.linkBV.second->getAABB()), flinear, fangular) >= fTimeStep ) {
+                continue;
+            }
+            _distanceReportCache->Reset(OpenRAVE::CO_Distance);
+            CollisionCallbackData query(shared_checker(), _distanceReportCache, vbodyexcluded, vlinkexcluded);
+            query.bselfCollision = true;
+            FOREACHC(itgeom1, pLINK1.vgeoms) {
+                FOREACHC(itgeom2, pLINK2.vgeoms) {
+                    fcl::FCL_REAL dist = -1.0;
+                    CheckNarrowPhaseGeomDistance((*itgeom1).second.get(), (*itgeom2).second.get(), &query, dist);
+                }
+            }
+            if( _distanceReportCache->minDistance < fTolerance ) {
+                if( !!report ) {
+                    report->plink1 = pLINK1.GetLink();
+                    report->plink2 = pLINK2.GetLink();
+                    report->minDistance = _distanceReportCache->minDistance;
+                }
+                return OpenRAVE::CBO_SelfCollision;
+            }
+            fTimeStep = min(fTimeStep, _GetConservativeAdvancementTime(_distanceReportCache->minDistance, flinear, fangular));
+        }
+    }
+    return 0;
+}
+
+bool FCLCollisionChecker::_ComputeLinkEnvironmentStep(LinkConstPtr plink, const std::pair<dReal, dReal>& motionbound, FCLCollisionManagerInstance& envManager, dReal fTolerance, dReal& fTimeStep, CollisionReportPtr report)
+{
+    if( !plink->IsEnabled() || (motionbound.first <= 0 && motionbound.second <= 0) ) {
+        return true;
+    }
+    CollisionObjectPtr pcollLink = _fclspace->GetLinkBV(*plink);
+    if( !pcollLink ) {
+        return true;
+    }
+
+    const std::vector<KinBodyConstPtr> vbodyexcluded;
+    const std::vector<LinkConstPtr> vlinkexcluded;
+    _distanceReportCache->Reset(OpenRAVE::CO_Distance);
+    CollisionCallbackData query(shared_checker(), _distanceReportCache, vbodyexcluded, vlinkexcluded);
+    envManager.GetManager()->distance(pcollLink.get(), &query, &FCLCollisionChecker::CheckNarrowPhaseDistance);
+    if( _distanceReportCache->minDistance < fTolerance ) {
+        if( !!report ) {
+            report->plink1 = plink;
+            report->minDistance = _distanceReportCache->minDistance;
+        }
+        return false;
+    }
+    fTimeStep = min(fTimeStep, _GetConservativeAdvancementTime(_distanceReportCache->minDistance, motionbound.first, motionbound.second));
+    return true;
+}
+
 bool FCLCollisionChecker::CheckNarrowPhaseCollision(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data) {
     CollisionCallbackData* pcb = static_cast<CollisionCallbackData *>(data);
     return pcb->_pchecker->CheckNarrowPhaseCollision(o1, o2, pcb);
 }
 
-bool FCLCollisionChecker::CheckNarrowPhaseCollision(fcl::CollisionObject *o1, fcl::CollisionObject *o2, CollisionCallbackData* pcb)
+bool FCLCollisionChecker::_GetCheckedCollisionLinks(fcl::CollisionObject *o1, fcl::CollisionObject *o2, CollisionCallbackData* pcb, LinkConstPtr& plink1, LinkConstPtr& plink2)
 {
-    if( pcb->_bStopChecking ) {
-        return true;     // don't test anymore
-    }
-
-//        _o1 = o1;
-//        _o2 = o2;
     std::pair<FCLSpace::FCLKinBodyInfo::LinkInfo*, LinkConstPtr> o1info = GetCollisionLink(*o1), o2info = GetCollisionLink(*o2);
 
     if( !o1info.second ) {
@@ -864,8 +1089,8 @@ bool FCLCollisionChecker::CheckNarrowPhaseCollision(fcl::CollisionObject *o1, fc
         // o2 is standalone object
     }
 
-    LinkConstPtr& plink1 = o1info.second;
-    LinkConstPtr& plink2 = o2info.second;
+    plink1 = o1info.second;
+    plink2 = o2info.second;
 
     if( !!plink1 ) {
         if( !plink1->IsEnabled() ) {
@@ -889,7 +1114,22 @@ bool FCLCollisionChecker::CheckNarrowPhaseCollision(fcl::CollisionObject *o1, fc
         if( !pcb->bselfCollision && plink1->GetParent()->IsAttached(*plink2->GetParent())) {
             return false;
         }
+    }
+    return true;
+}
+
+bool FCLCollisionChecker::CheckNarrowPhaseCollision(fcl::CollisionObject *o1, fcl::CollisionObject *o2, CollisionCallbackData* pcb)
+{
+    if( pcb->_bStopChecking ) {
+        return true;     // don't test anymore
+    }
+
+    LinkConstPtr plink1, plink2;
+    if( !_GetCheckedCollisionLinks(o1, o2, pcb, plink1, plink2) ) {
+        return false;
+    }
 
+    if( !!plink1 && !!plink2 ) {
         LinkInfoPtr pLINK1 = _fclspace->GetLinkInfo(*plink1), pLINK2 = _fclspace->GetLinkInfo(*plink2);
 
         //RAVELOG_VERBOSE_FORMAT("env=%d, link %s:%s with %s:%s", GetEnv()->GetId()%plink1->GetParent()->GetName()%plink1->GetName()%plink2->GetParent()->GetName()%plink2->GetName());
@@ -935,6 +1175,104 @@ bool FCLCollisionChecker::CheckNarrowPhaseCollision(fcl::CollisionObject *o1, fc
 }
 
 
+bool FCLCollisionChecker::CollectCandidateGeomPairs(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data) {
+    CollisionCallbackData* pcb = static_cast<CollisionCallbackData *>(data);
+    return pcb->_pchecker->CollectCandidateGeomPairs(o1, o2, pcb);
+}
+
+bool FCLCollisionChecker::CollectCandidateGeomPairs(fcl::CollisionObject *o1, fcl::CollisionObject *o2, CollisionCallbackData* pcb)
+{
+    LinkConstPtr plink1, plink2;
+    if( !_GetCheckedCollisionLinks(o1, o2, pcb, plink1, plink2) ) {
+        return false;
+    }
+
+    if( !!plink1 && !!plink2 ) {
+        LinkInfoPtr pLINK1 = _fclspace->GetLinkInfo(*plink1), pLINK2 = _fclspace->GetLinkInfo(*plink2);
+        FOREACH(itgeompair1, pLINK1->vgeoms) {
+            FOREACH(itgeompair2, pLINK2->vgeoms) {
+                if( itgeompair1->second->getAABB().overlap(itgeompair2->second->getAABB()) ) {
+                    _vCandidateGeomPairsCache.push_back(std::make_pair(itgeompair1->second.get(), itgeompair2->second.get()));
+                }
+            }
+        }
+    }
+    else if( !!plink1 ) {
+        LinkInfoPtr pLINK1 = _fclspace->GetLinkInfo(*plink1);
+        FOREACH(itgeompair1, pLINK1->vgeoms) {
+            if( itgeompair1->second->getAABB().overlap(o2->getAABB()) ) {
+                _vCandidateGeomPairsCache.push_back(std::make_pair(itgeompair1->second.get(), o2));
+            }
+        }
+    }
+    else if( !!plink2 ) {
+        LinkInfoPtr pLINK2 = _fclspace->GetLinkInfo(*plink2);
+        FOREACH(itgeompair2, pLINK2->vgeoms) {
+            if( itgeompair2->second->getAABB().overlap(o1->getAABB()) ) {
+                _vCandidateGeomPairsCache.push_back(std::make_pair(o1, itgeompair2->second.get()));
+            }
+        }
+    }
+    return false; // gather all the pairs
+}
+
+void FCLCollisionChecker::_CollideEnvironment(FCLCollisionManagerInstance& envManager, FCLCollisionManagerInstance& bodyManager, CollisionCallbackData& query)
+{
+    if( !_workerpool ) {
+        envManager.GetManager()->collide(bodyManager.GetManager().get(), &query, &FCLCollisionChecker::CheckNarrowPhaseCollision);
+        return;
+    }
+
+    // the broadphase and the link filtering touch the kinbodies and are done on this thread, only the geometry pairs are checked in parallel
+    _vCandidateGeomPairsCache.resize(0);
+    envManager.GetManager()->collide(bodyManager.GetManager().get(), &query, &FCLCollisionChecker::CollectCandidateGeomPairs);
+    const size_t numpairs = _vCandidateGeomPairsCache.size();
+    _vCandidateCollidingCache.resize(numpairs);
+    if( numpairs < (size_t)_nMinParallelPairs ) {
+        std::fill(_vCandidateCollidingCache.begin(), _vCandidateCollidingCache.end(), 1);
+    }
+    else {
+        std::fill(_vCandidateCollidingCache.begin(), _vCandidateCollidingCache.end(), 0);
+        // callbacks can ignore a collision, so cannot stop at the first colliding pair when they are present
+        const bool bStopAtFirstCollision = !(_options & (OpenRAVE::CO_AllLinkCollisions | OpenRAVE::CO_AllGeometryContacts | OpenRAVE::CO_AllGeometryCollisions)) && !query._bHasCallbacks;
+        std::atomic<size_t> nextindex(0);
+        std::atomic<bool> bstop(false);
+        _workerpool->Run(boost::bind(&FCLCollisionChecker::_CheckCandidateGeomPairsJob, this, _1, boost::ref(nextindex), boost::ref(bstop), bStopAtFirstCollision));
+    }
+
+    // fill the report and call the callbacks in order for the colliding pairs
+    for(size_t ipair = 0; ipair < numpairs; ++ipair) {
+        if( _vCandidateCollidingCache[ipair] ) {
+            CheckNarrowPhaseGeomCollision(_vCandidateGeomPairsCache[ipair].first, _vCandidateGeomPairsCache[ipair].second, &query);
+            if( query._bStopChecking ) {
+                break;
+            }
+        }
+    }
+}
+
+void FCLCollisionChecker::_CheckCandidateGeomPairsJob(int ithread, std::atomic<size_t>& nextindex, std::atomic<bool>& bstop, bool bStopAtFirstCollision)
+{
+    fcl::CollisionRequest request;
+    request.enable_contact = false;
+    request.gjk_solver_type = fcl::GST_INDEP;
+    fcl::CollisionResult result;
+    const size_t numpairs = _vCandidateGeomPairsCache.size();
+    while( !bstop.load() ) {
+        const size_t ipair = nextindex.fetch_add(1);
+        if( ipair >= numpairs ) {
+            break;
+        }
+        result.clear();
+        if( fcl::collide(_vCandidateGeomPairsCache[ipair].first, _vCandidateGeomPairsCache[ipair].second, request, result) > 0 ) {
+            _vCandidateCollidingCache[ipair] = 1;
+            if( bStopAtFirstCollision ) {
+                bstop.store(true);
+            }
+        }
+    }
+}
+
 bool FCLCollisionChecker::CheckNarrowPhaseGeomCollision(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data) {
     CollisionCallbackData* pcb = static_cast<CollisionCallbackData *>(data);
     return pcb->_pchecker->CheckNarrowPhaseGeomCollision(o1, o2, pcb);
@@ -1219,8 +1557,17 @@ std::pair<FCLSpace::FCLKinBodyInfo::LinkInfo*, LinkConstPtr> FCLCollisionChecker
 
 std::pair<FCLSpace::FCLKinBodyInfo::FCLGeometryInfo*, GeometryConstPtr> FCLCollisionChecker::GetCollisionGeometry(const fcl::CollisionObject &collObj)
 {
-    const std::shared_ptr<const fcl::CollisionGeometry>& collgeom = collObj.collisionGeometry();
-    FCLSpace::FCLKinBodyInfo::FCLGeometryInfo* geom_raw = static_cast<FCLSpace::FCLKinBodyInfo::FCLGeometryInfo *>(collgeom->getUserData());
+    // collision geometries can be shared between spaces, so the geometry info is found from the link info of the object
+    FCLSpace::FCLKinBodyInfo::FCLGeometryInfo* geom_raw = nullptr;
+    const FCLSpace::FCLKinBodyInfo::LinkInfo* link_raw = static_cast<const FCLSpace::FCLKinBodyInfo::LinkInfo *>(collObj.getUserData());
+    if( !!link_raw ) {
+        for(size_t igeom = 0; igeom < link_raw->vgeominfos.size() && igeom < link_raw->vgeoms.size(); ++igeom) {
+            if( link_raw->vgeoms[igeom].second.get() == &collObj ) {
+                geom_raw = link_raw->vgeominfos[igeom].get();
+                break;
+            }
+        }
+    }
     if( !!geom_raw ) {
         const GeometryConstPtr pgeom = geom_raw->GetGeometry();
         if( !pgeom ) {
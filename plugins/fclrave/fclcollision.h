@@ -5,6 +5,7 @@
 #include <boost/bind/bind.hpp>
 #include <boost/unordered_set.hpp>
 #include <boost/lexical_cast.hpp>
+#include <atomic>
 #include <openrave/utils.h>
 
 #include <openrave/openrave.h>
@@ -155,6 +156,17 @@ public:
         return _fclspace->GetBVHRepresentation();
     }
 
+    /// Sets the number of threads running the narrow phase of body/environment checks, and optionally the minimum number of candidate geometry pairs for the checks to be split across the threads.
+    /// 1 (the default) disables the threads.
+    /// e.g. "SetNumThreads 8 16"
+    bool SetNumThreadsCommand(ostream& sout, istream& sinput);
+
+    void SetNumThreads(int numthreads);
+
+    int GetNumThreads() const {
+        return !!_workerpool ? _workerpool->GetNumThreads() : 1;
+    }
+
 
     bool InitEnvironment() override;
 
@@ -196,6 +208,12 @@ public:
 
     bool CheckStandaloneSelfCollision(LinkConstPtr plink, CollisionReportPtr report = CollisionReportPtr()) override;
 
+protected:
+    /// \brief checks the batch while synchronizing the environment manager and setting up the query only once
+    int _CheckCollisionBatch(KinBodyPtr pbody, size_t numconfigurations, const boost::function<void(size_t)>& setstatefn, std::vector<uint8_t>& vresults, int batchoptions, CollisionReportPtr report) override;
+
+    /// \brief uses the distance of every link to its own closest obstacle instead of the distance of the whole body
+    int _ComputeContinuousCollisionStep(KinBodyConstPtr pbody, const std::vector< std::pair<dReal, dReal> >& vlinkmotionbounds, int batchoptions, dReal fTolerance, dReal& fTimeStep, CollisionReportPtr report) override;
 
 private:
     inline boost::shared_ptr<FCLCollisionChecker> shared_checker() {
@@ -206,6 +224,27 @@ private:
 
     bool CheckNarrowPhaseCollision(fcl::CollisionObject *o1, fcl::CollisionObject *o2, CollisionCallbackData* pcb);
 
+    /// \brief filters out the pairs that should not be checked (disabled, excluded or attached links) and returns the links of the collision objects
+    ///
+    /// \return false if the pair should not be checked
+    bool _GetCheckedCollisionLinks(fcl::CollisionObject *o1, fcl::CollisionObject *o2, CollisionCallbackData* pcb, LinkConstPtr& plink1, LinkConstPtr& plink2);
+
+    /// \brief broadphase callback adding the overlapping geometry pairs of o1 and o2 to _vCandidateGeomPairsCache instead of checking them
+    static bool CollectCandidateGeomPairs(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data);
+
+    bool CollectCandidateGeomPairs(fcl::CollisionObject *o1, fcl::CollisionObject *o2, CollisionCallbackData* pcb);
+
+    /// \brief collides the body manager against the environment manager, splitting the narrow phase across _workerpool if set
+    void _CollideEnvironment(FCLCollisionManagerInstance& envManager, FCLCollisionManagerInstance& bodyManager, CollisionCallbackData& query);
+
+    /// \brief job run by every thread of _workerpool, checks the candidate pairs until all are taken or bstop is set
+    void _CheckCandidateGeomPairsJob(int ithread, std::atomic<size_t>& nextindex, std::atomic<bool>& bstop, bool bStopAtFirstCollision);
+
+    /// \brief computes the distance of plink to the environment and shortens fTimeStep so that the link moving with motionbound cannot reach it
+    ///
+    /// \return false if the link is closer than fTolerance to the environment
+    bool _ComputeLinkEnvironmentStep(LinkConstPtr plink, const std::pair<dReal, dReal>& motionbound, FCLCollisionManagerInstance& envManager, dReal fTolerance, dReal& fTimeStep, CollisionReportPtr report);
+
     static bool CheckNarrowPhaseGeomCollision(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data);
 
     bool CheckNarrowPhaseGeomCollision(fcl::CollisionObject *o1, fcl::CollisionObject *o2, CollisionCallbackData* pcb);
@@ -281,6 +320,9 @@ private:
     int _nGetEnvManagerCacheClearCount; ///< count down until cache can be cleared
     int _maxNumEnvManagers = 0; ///< for debug, record max size of _envmanagers.
 
+    OpenRAVE::utils::WorkerPoolPtr _workerpool; ///< if set, threads running the narrow phase of body/environment checks
+    int _nMinParallelPairs; ///< minimum number of candidate geometry pairs to use _workerpool
+
 #ifdef FCLRAVE_COLLISION_OBJECTS_STATISTICS
     std::map<fcl::CollisionObject*, int> _currentlyused;
     std::map<fcl::CollisionObject*, std::map<int, int> > _usestatistics;
@@ -302,6 +344,9 @@ private:
     std::vector<KinBodyPtr> _vCachedGrabbedBodies;
 
     std::vector<int> _attachedBodyIndicesCache;
+    std::vector< std::pair<fcl::CollisionObject*, fcl::CollisionObject*> > _vCandidateGeomPairsCache; ///< geometry pairs whose AABBs overlap, gathered by the broadphase when using _workerpool
+    std::vector<uint8_t> _vCandidateCollidingCache; ///< 1 if the pair at the same index in _vCandidateGeomPairsCache collides
+    CollisionReportPtr _distanceReportCache; ///< report of the distance queries of the continuous collision steps
 
     bool _bIsSelfCollisionChecker; // Currently not used
     bool _bParentlessCollisionObject; ///< if set to true, the last collision command ran into colliding with an unknown object
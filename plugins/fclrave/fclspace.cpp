@@ -2,10 +2,13 @@
 
 #include "fclspace.h"
 
+#include <mutex>
+#include <boost/functional/hash.hpp>
+
 namespace fclrave {
 
 template <class T>
-CollisionGeometryPtr ConvertMeshToFCL(std::vector<fcl::Vec3f> const &points,std::vector<fcl::Triangle> const &triangles)
+std::shared_ptr< fcl::BVHModel<T> > BuildBVHModel(std::vector<fcl::Vec3f> const &points,std::vector<fcl::Triangle> const &triangles)
 {
     std::shared_ptr< fcl::BVHModel<T> > const model = make_shared<fcl::BVHModel<T> >();
     model->beginModel(triangles.size(), points.size());
@@ -14,6 +17,118 @@ CollisionGeometryPtr ConvertMeshToFCL(std::vector<fcl::Vec3f> const &points,std:
     return model;
 }
 
+template <class T>
+CollisionGeometryPtr ConvertMeshToFCL(std::vector<fcl::Vec3f> const &points,std::vector<fcl::Triangle> const &triangles)
+{
+    return BuildBVHModel<T>(points, triangles);
+}
+
+/// \brief process wide cache of the BVH models built from collision meshes, keyed by the content of the mesh. There is one cache per BVH type.
+///
+/// The models are shared by all the spaces using the same mesh (cloned environments, geometry groups, bodies loaded from the same file), so their user data is never set.
+/// Entries are dropped once no space holds the model anymore.
+///
+/// The cache only lives in the process. It is not persisted to disk nor shared between processes: fcl::BVHModel keeps its
+/// bounding volume nodes private and endModel always rebuilds the hierarchy, so a memory-mapped hierarchy could not be used
+/// without rebuilding it. Each process still builds every distinct mesh once.
+template <class T>
+class FCLMeshCache
+{
+    typedef std::multimap<size_t, std::weak_ptr< fcl::BVHModel<T> > > ModelMap;
+public:
+    FCLMeshCache() : _numInsertions(0) {
+    }
+
+    CollisionGeometryPtr GetMesh(std::vector<fcl::Vec3f> const &points,std::vector<fcl::Triangle> const &triangles)
+    {
+        const size_t meshhash = _ComputeMeshHash(points, triangles);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            std::pair<typename ModelMap::iterator, typename ModelMap::iterator> range = _mapmodels.equal_range(meshhash);
+            typename ModelMap::iterator it = range.first;
+            while(it != range.second) {
+                std::shared_ptr< fcl::BVHModel<T> > pmodel = it->second.lock();
+                if( !pmodel ) {
+                    it = _mapmodels.erase(it);
+                    continue;
+                }
+                if( _IsSameMesh(*pmodel, points, triangles) ) {
+                    return pmodel;
+                }
+                ++it;
+            }
+        }
+
+        // build outside of the lock since it is the expensive part
+        std::shared_ptr< fcl::BVHModel<T> > pmodel = BuildBVHModel<T>(points, triangles);
+        pmodel->setUserData(nullptr);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _mapmodels.insert(std::make_pair(meshhash, std::weak_ptr< fcl::BVHModel<T> >(pmodel)));
+        if( ++_numInsertions % 256 == 0 ) {
+            typename ModelMap::iterator it = _mapmodels.begin();
+            while(it != _mapmodels.end()) {
+                if( it->second.expired() ) {
+                    it = _mapmodels.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+        return pmodel;
+    }
+
+private:
+    static size_t _ComputeMeshHash(std::vector<fcl::Vec3f> const &points,std::vector<fcl::Triangle> const &triangles)
+    {
+        size_t seed = points.size();
+        boost::hash_combine(seed, triangles.size());
+        for(const fcl::Vec3f& point : points) {
+            boost::hash_combine(seed, point[0]);
+            boost::hash_combine(seed, point[1]);
+            boost::hash_combine(seed, point[2]);
+        }
+        for(const fcl::Triangle& triangle : triangles) {
+            boost::hash_combine(seed, triangle[0]);
+            boost::hash_combine(seed, triangle[1]);
+            boost::hash_combine(seed, triangle[2]);
+        }
+        return seed;
+    }
+
+    static bool _IsSameMesh(const fcl::BVHModel<T>& model, std::vector<fcl::Vec3f> const &points,std::vector<fcl::Triangle> const &triangles)
+    {
+        if( model.num_vertices != (int)points.size() || model.num_tris != (int)triangles.size() ) {
+            return false;
+        }
+        for(size_t ipoint = 0; ipoint < points.size(); ++ipoint) {
+            const fcl::Vec3f& v = model.vertices[ipoint];
+            if( v[0] != points[ipoint][0] || v[1] != points[ipoint][1] || v[2] != points[ipoint][2] ) {
+                return false;
+            }
+        }
+        for(size_t itri = 0; itri < triangles.size(); ++itri) {
+            const fcl::Triangle& tri = model.tri_indices[itri];
+            if( tri[0] != triangles[itri][0] || tri[1] != triangles[itri][1] || tri[2] != triangles[itri][2] ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::mutex _mutex;
+    ModelMap _mapmodels; ///< hash of the mesh -> model
+    uint32_t _numInsertions; ///< used to periodically sweep the expired entries
+};
+
+template <class T>
+CollisionGeometryPtr ConvertMeshToFCLCached(std::vector<fcl::Vec3f> const &points,std::vector<fcl::Triangle> const &triangles)
+{
+    static FCLMeshCache<T> s_meshcache;
+    return s_meshcache.GetMesh(points, triangles);
+}
+
 FCLSpace::FCLKinBodyInfo::FCLKinBodyInfo()
     : nLastStamp(0)
     , nLinkUpdateStamp(0)
@@ -77,6 +192,7 @@ void FCLSpace::DestroyEnvironment()
     _currentpinfo.erase(_currentpinfo.begin() + 1, _currentpinfo.end());
     _cachedpinfo.clear();
     _vecInitializedBodies.clear();
+    _vSharedBodyGeometries.clear();
 }
 
 FCLSpace::FCLKinBodyInfoPtr FCLSpace::InitKinBody(KinBodyConstPtr pbody, FCLKinBodyInfoPtr pinfo, bool bSetToCurrentPInfo)
@@ -92,12 +208,23 @@ FCLSpace::FCLKinBodyInfoPtr FCLSpace::InitKinBody(KinBodyConstPtr pbody, FCLKinB
     // make sure that synchronization do occur !
     pinfo->nLastStamp = pbody->GetUpdateStamp() - 1;
 
+    // geometries of the body this one was cloned from, if they are still available
+    SharedBodyGeometriesPtr pshared;
+    const int bodyIndex = pbody->GetEnvironmentBodyIndex();
+    if( bodyIndex > 0 && bodyIndex < (int)_vSharedBodyGeometries.size() && !!_vSharedBodyGeometries[bodyIndex] ) {
+        pshared.swap(_vSharedBodyGeometries[bodyIndex]);
+        if( pshared->name != pbody->GetName() || pshared->vlinks.size() != pbody->GetLinks().size() ) {
+            pshared.reset();
+        }
+    }
+
     pinfo->vlinks.reserve(pbody->GetLinks().size());
     FOREACHC(itlink, pbody->GetLinks()) {
         const KinBody::LinkPtr& plink = *itlink;
         boost::shared_ptr<FCLKinBodyInfo::LinkInfo> linkinfo(new FCLKinBodyInfo::LinkInfo(plink));
 
         fcl::AABB enclosingBV;
+        bool bSharedGeometries = false;
 
         // Glue code for a unified access to geometries
         if(pinfo->_geometrygroup.size() > 0 && plink->GetGroupNumGeometries(pinfo->_geometrygroup) >= 0) {
@@ -114,7 +241,6 @@ FCLSpace::FCLKinBodyInfoPtr FCLSpace::InitKinBody(KinBodyConstPtr pbody, FCLKinB
                 if( !pfclgeom ) {
                     continue;
                 }
-                pfclgeom->setUserData(nullptr);
 
                 // We do not set the transformation here and leave it to _Synchronize
                 CollisionObjectPtr pfclcoll = boost::make_shared<fcl::CollisionObject>(pfclgeom);
@@ -130,6 +256,9 @@ FCLSpace::FCLKinBodyInfoPtr FCLSpace::InitKinBody(KinBodyConstPtr pbody, FCLKinB
                 }
             }
         }
+        else if( !!pshared && _InitLinkFromSharedGeometries(pshared->vlinks[plink->GetIndex()], *pbody, plink, *linkinfo) ) {
+            bSharedGeometries = true;
+        }
         else {
             const std::vector<KinBody::Link::GeometryPtr> & vgeometries = plink->GetGeometries();
             FOREACH(itgeom, vgeometries) {
@@ -142,8 +271,7 @@ FCLSpace::FCLKinBodyInfoPtr FCLSpace::InitKinBody(KinBodyConstPtr pbody, FCLKinB
                 }
                 boost::shared_ptr<FCLKinBodyInfo::FCLGeometryInfo> pfclgeominfo(new FCLKinBodyInfo::FCLGeometryInfo(pgeom));
                 pfclgeominfo->bodylinkgeomname = pbody->GetName() + "/" + plink->GetName() + "/" + pgeom->GetName();
-                pfclgeom->setUserData(pfclgeominfo.get());
-                // save the pointers
+                // save the pointers, vgeominfos has to stay parallel to vgeoms since the collision geometries can be shared and cannot hold pfclgeominfo
                 linkinfo->vgeominfos.push_back(pfclgeominfo);
 
                 // We do not set the transformation here and leave it to _Synchronize
@@ -165,7 +293,7 @@ FCLSpace::FCLKinBodyInfoPtr FCLSpace::InitKinBody(KinBodyConstPtr pbody, FCLKinB
         if( linkinfo->vgeoms.size() == 0 ) {
             RAVELOG_DEBUG_FORMAT("env=%s, Initializing body '%s' (index=%d) link '%s' with 0 geometries (env %d) (userdatakey %s)", _penv->GetNameId()%pbody->GetName()%pbody->GetEnvironmentBodyIndex()%plink->GetName()%_penv->GetId()%_userdatakey);
         }
-        else {
+        else if( !bSharedGeometries ) {
             CollisionGeometryPtr pfclgeomBV = std::make_shared<fcl::Box>(enclosingBV.max_ - enclosingBV.min_);
             pfclgeomBV->setUserData(nullptr);
             CollisionObjectPtr pfclcollBV = boost::make_shared<fcl::CollisionObject>(pfclgeomBV);
@@ -207,6 +335,101 @@ FCLSpace::FCLKinBodyInfoPtr FCLSpace::InitKinBody(KinBodyConstPtr pbody, FCLKinB
     return pinfo;
 }
 
+void FCLSpace::ShareGeometriesFrom(const FCLSpace& rspace)
+{
+    _vSharedBodyGeometries.clear();
+    if( rspace._bvhRepresentation != _bvhRepresentation ) {
+        return;
+    }
+
+    _vSharedBodyGeometries.resize(rspace._currentpinfo.size());
+    for(size_t bodyIndex = 1; bodyIndex < rspace._currentpinfo.size(); ++bodyIndex) {
+        const FCLKinBodyInfoPtr& pinfo = rspace._currentpinfo[bodyIndex];
+        // the cloned bodies start tracking the default geometry group of this space
+        if( !pinfo || pinfo->_geometrygroup != _geometrygroup ) {
+            continue;
+        }
+        KinBodyPtr pbody = pinfo->GetBody();
+        if( !pbody || pbody->GetLinks().size() != pinfo->vlinks.size() ) {
+            continue;
+        }
+
+        SharedBodyGeometriesPtr pshared(new SharedBodyGeometries());
+        pshared->name = pbody->GetName();
+        pshared->vlinks.resize(pinfo->vlinks.size());
+        for(size_t ilink = 0; ilink < pinfo->vlinks.size(); ++ilink) {
+            const FCLKinBodyInfo::LinkInfo& linkinfo = *pinfo->vlinks[ilink];
+            KinBody::LinkPtr plink = linkinfo.GetLink();
+            // links initialized from a geometry group do not keep their geometry infos
+            if( !plink || linkinfo.vgeominfos.size() != linkinfo.vgeoms.size() ) {
+                pshared.reset();
+                break;
+            }
+
+            SharedLinkGeometries& sharedlink = pshared->vlinks[ilink];
+            const std::vector<KinBody::Link::GeometryPtr>& vgeometries = plink->GetGeometries();
+            sharedlink.numgeometries = vgeometries.size();
+            sharedlink.vgeoms.resize(linkinfo.vgeoms.size());
+            for(size_t igeom = 0; igeom < linkinfo.vgeoms.size(); ++igeom) {
+                KinBody::GeometryPtr pgeom = linkinfo.vgeominfos[igeom]->GetGeometry();
+                std::vector<KinBody::Link::GeometryPtr>::const_iterator itgeom = std::find(vgeometries.begin(), vgeometries.end(), pgeom);
+                if( !pgeom || itgeom == vgeometries.end() ) {
+                    pshared.reset();
+                    break;
+                }
+                const KinBody::GeometryInfo& geominfo = pgeom->GetInfo();
+                SharedGeometry& sharedgeom = sharedlink.vgeoms[igeom];
+                sharedgeom.igeometry = itgeom - vgeometries.begin();
+                sharedgeom.type = geominfo._type;
+                sharedgeom.vGeomData = geominfo._vGeomData;
+                sharedgeom.transform = geominfo.GetTransform();
+                sharedgeom.numvertices = geominfo._meshcollision.vertices.size();
+                sharedgeom.numindices = geominfo._meshcollision.indices.size();
+                sharedgeom.pfclgeom = linkinfo.vgeoms[igeom].second->collisionGeometry();
+            }
+            if( !pshared ) {
+                break;
+            }
+            if( !!linkinfo.linkBV.second ) {
+                sharedlink.vBVTranslation = linkinfo.linkBV.first;
+                sharedlink.pfclgeomBV = linkinfo.linkBV.second->collisionGeometry();
+            }
+        }
+        _vSharedBodyGeometries[bodyIndex] = pshared;
+    }
+}
+
+bool FCLSpace::_InitLinkFromSharedGeometries(const SharedLinkGeometries& sharedlink, const KinBody& body, const KinBody::LinkPtr& plink, FCLKinBodyInfo::LinkInfo& linkinfo)
+{
+    const std::vector<KinBody::Link::GeometryPtr>& vgeometries = plink->GetGeometries();
+    if( sharedlink.numgeometries != vgeometries.size() ) {
+        return false;
+    }
+    FOREACHC(itsharedgeom, sharedlink.vgeoms) {
+        const KinBody::GeometryInfo& geominfo = vgeometries[itsharedgeom->igeometry]->GetInfo();
+        if( geominfo._type != itsharedgeom->type || geominfo._vGeomData != itsharedgeom->vGeomData || geominfo.GetTransform() != itsharedgeom->transform || geominfo._meshcollision.vertices.size() != itsharedgeom->numvertices || geominfo._meshcollision.indices.size() != itsharedgeom->numindices ) {
+            return false;
+        }
+    }
+
+    FOREACHC(itsharedgeom, sharedlink.vgeoms) {
+        const KinBody::GeometryPtr& pgeom = vgeometries[itsharedgeom->igeometry];
+        boost::shared_ptr<FCLKinBodyInfo::FCLGeometryInfo> pfclgeominfo(new FCLKinBodyInfo::FCLGeometryInfo(pgeom));
+        pfclgeominfo->bodylinkgeomname = body.GetName() + "/" + plink->GetName() + "/" + pgeom->GetName();
+        linkinfo.vgeominfos.push_back(pfclgeominfo);
+
+        CollisionObjectPtr pfclcoll = boost::make_shared<fcl::CollisionObject>(itsharedgeom->pfclgeom);
+        pfclcoll->setUserData(&linkinfo);
+        linkinfo.vgeoms.push_back(TransformCollisionPair(pgeom->GetInfo().GetTransform(), pfclcoll));
+    }
+    if( !!sharedlink.pfclgeomBV ) {
+        CollisionObjectPtr pfclcollBV = boost::make_shared<fcl::CollisionObject>(sharedlink.pfclgeomBV);
+        pfclcollBV->setUserData(&linkinfo);
+        linkinfo.linkBV = std::make_pair(sharedlink.vBVTranslation, pfclcollBV);
+    }
+    return true;
+}
+
 bool FCLSpace::HasNamedGeometry(const KinBody &body, const std::string& groupname) {
     // The empty string corresponds to current geometries so all kinbodies have it
     if( groupname.size() == 0 ) {
@@ -300,27 +523,35 @@ void FCLSpace::SetBVHRepresentation(std::string const &type)
     if (type == "AABB") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL<fcl::AABB>;
+        _cachedMeshFactory = &ConvertMeshToFCLCached<fcl::AABB>;
     } else if (type == "OBB") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL<fcl::OBB>;
+        _cachedMeshFactory = &ConvertMeshToFCLCached<fcl::OBB>;
     } else if (type == "RSS") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL<fcl::RSS>;
+        _cachedMeshFactory = &ConvertMeshToFCLCached<fcl::RSS>;
     } else if (type == "OBBRSS") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL<fcl::OBBRSS>;
+        _cachedMeshFactory = &ConvertMeshToFCLCached<fcl::OBBRSS>;
     } else if (type == "kDOP16") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL< fcl::KDOP<16> >;
+        _cachedMeshFactory = &ConvertMeshToFCLCached< fcl::KDOP<16> >;
     } else if (type == "kDOP18") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL< fcl::KDOP<18> >;
+        _cachedMeshFactory = &ConvertMeshToFCLCached< fcl::KDOP<18> >;
     } else if (type == "kDOP24") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL< fcl::KDOP<24> >;
+        _cachedMeshFactory = &ConvertMeshToFCLCached< fcl::KDOP<24> >;
     } else if (type == "kIOS") {
         _bvhRepresentation = type;
         _meshFactory = &ConvertMeshToFCL<fcl::kIOS>;
+        _cachedMeshFactory = &ConvertMeshToFCLCached<fcl::kIOS>;
     } else {
         RAVELOG_WARN(str(boost::format("Unknown BVH representation '%s', keeping '%s' representation") % type % _bvhRepresentation));
         return;
@@ -345,6 +576,10 @@ std::string const& FCLSpace::GetBVHRepresentation() const {
 
 void FCLSpace::Synchronize()
 {
+    if( _vSharedBodyGeometries.size() > 0 ) {
+        // bodies initialized from now on are not clones of the shared ones
+        _vSharedBodyGeometries.clear();
+    }
     // We synchronize only the initialized bodies, which differs from oderave
     for (const KinBodyConstPtr& pbody : _vecInitializedBodies) {
         if (!pbody) {
@@ -448,13 +683,25 @@ CollisionGeometryPtr FCLSpace::_CreateFCLGeomFromGeometryInfo(const KinBody::Geo
 
     case OpenRAVE::GT_CalibrationBoard:
     case OpenRAVE::GT_Box:
-        return std::make_shared<fcl::Box>(info._vGeomData.x*2.0f,info._vGeomData.y*2.0f,info._vGeomData.z*2.0f);
+    {
+        CollisionGeometryPtr pfclgeom = std::make_shared<fcl::Box>(info._vGeomData.x*2.0f,info._vGeomData.y*2.0f,info._vGeomData.z*2.0f);
+        pfclgeom->setUserData(nullptr);
+        return pfclgeom;
+    }
 
     case OpenRAVE::GT_Sphere:
-        return std::make_shared<fcl::Sphere>(info._vGeomData.x);
+    {
+        CollisionGeometryPtr pfclgeom = std::make_shared<fcl::Sphere>(info._vGeomData.x);
+        pfclgeom->setUserData(nullptr);
+        return pfclgeom;
+    }
 
     case OpenRAVE::GT_Cylinder:
-        return std::make_shared<fcl::Cylinder>(info._vGeomData.x, info._vGeomData.y);
+    {
+        CollisionGeometryPtr pfclgeom = std::make_shared<fcl::Cylinder>(info._vGeomData.x, info._vGeomData.y);
+        pfclgeom->setUserData(nullptr);
+        return pfclgeom;
+    }
 
     case OpenRAVE::GT_ConicalFrustum:
     case OpenRAVE::GT_Axial:
@@ -483,7 +730,7 @@ CollisionGeometryPtr FCLSpace::_CreateFCLGeomFromGeometryInfo(const KinBody::Geo
             fcl_triangles[itri] = fcl::Triangle(tri_indices[0], tri_indices[1], tri_indices[2]);
         }
 
-        return _meshFactory(fcl_points, fcl_triangles);
+        return _cachedMeshFactory(fcl_points, fcl_triangles);
     }
 
     default:
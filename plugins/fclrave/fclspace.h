@@ -128,7 +128,7 @@ public:
             }
 
             KinBody::LinkWeakPtr _plink;
-            vector< boost::shared_ptr<FCLGeometryInfo> > vgeominfos; ///< info for every geometry of the link
+            vector< boost::shared_ptr<FCLGeometryInfo> > vgeominfos; ///< info for every geometry of the link. If not empty, index corresponds to vgeoms.
 
             //int nLastStamp; ///< Tracks if the collision geometries are up to date wrt the body update stamp. This is for narrow phase collision
             TranslationCollisionPair linkBV; ///< pair of the translation and collision object corresponding to a bounding OBB for the link
@@ -188,6 +188,12 @@ public:
 
     FCLKinBodyInfoPtr InitKinBody(KinBodyConstPtr pbody, FCLKinBodyInfoPtr pinfo = FCLKinBodyInfoPtr(), bool bSetToCurrentPInfo=true);
 
+    /// \brief keeps references to the collision geometries of the bodies initialized in rspace so that the bodies cloned from them reuse them in InitKinBody instead of building their own.
+    ///
+    /// The fcl geometries are never modified after being built (a geometry change re-initializes the body with new ones), so sharing them is copy-on-write.
+    /// The references are only kept until the next call to Synchronize, which happens at the first query after the environment is cloned.
+    void ShareGeometriesFrom(const FCLSpace& rspace);
+
     bool HasNamedGeometry(const KinBody &body, const std::string& groupname);
 
     void SetGeometryGroup(const std::string& groupname);
@@ -263,11 +269,43 @@ public:
 private:
 
     // what about the tests on non-zero size (eg. box extents) ?
+    // mesh geometries can be shared with other spaces, so the user data of the returned geometry must not be modified
     CollisionGeometryPtr _CreateFCLGeomFromGeometryInfo(const KinBody::GeometryInfo &info);
 
     /// \brief pass in info.GetBody() as a reference to avoid dereferencing the weak pointer in FCLKinBodyInfo
     void _Synchronize(FCLKinBodyInfo& info, const KinBody& body);
 
+    /// \brief collision geometry of another space along with the description of the geometry it was built from
+    struct SharedGeometry
+    {
+        size_t igeometry; ///< index of the geometry in the link
+        GeometryType type;
+        Vector vGeomData;
+        Transform transform;
+        size_t numvertices, numindices; ///< size of the collision mesh
+        CollisionGeometryPtr pfclgeom;
+    };
+
+    struct SharedLinkGeometries
+    {
+        size_t numgeometries; ///< number of geometries of the link
+        std::vector<SharedGeometry> vgeoms;
+        Vector vBVTranslation;
+        CollisionGeometryPtr pfclgeomBV; ///< null if the link has no collision geometry
+    };
+
+    struct SharedBodyGeometries
+    {
+        std::string name; ///< name of the body the geometries were built for
+        std::vector<SharedLinkGeometries> vlinks;
+    };
+    typedef boost::shared_ptr<SharedBodyGeometries> SharedBodyGeometriesPtr;
+
+    /// \brief fills linkinfo with the shared geometries of the link if they match its current geometries.
+    ///
+    /// \return true if linkinfo was filled, false if the geometries have to be built
+    bool _InitLinkFromSharedGeometries(const SharedLinkGeometries& sharedlink, const KinBody& body, const KinBody::LinkPtr& plink, FCLKinBodyInfo::LinkInfo& linkinfo);
+
     /// \brief controls whether the kinbody info is removed during the destructor
     class FCLKinBodyInfoRemover
     {
@@ -321,11 +359,14 @@ private:
 
     std::string _bvhRepresentation;
     MeshFactory _meshFactory;
+    MeshFactory _cachedMeshFactory; ///< same as _meshFactory, but shares the models built for the same mesh through a process wide cache. Used for the geometries of the bodies.
 
     std::vector<KinBodyConstPtr> _vecInitializedBodies; ///< vector of the kinbody initialized in this space. index is the environment body index. nullptr means uninitialized.
     std::vector<std::map< std::string, FCLKinBodyInfoPtr> > _cachedpinfo; ///< Associates to each body id and geometry group name the corresponding kinbody info if already initialized and not currently set as user data. Index of vector is the environment id. index 0 holds null pointer because kin bodies in the env should have positive index.
     std::vector<FCLKinBodyInfoPtr> _currentpinfo; ///< maps kinbody environment id to the kinbodyinfo struct constaining fcl objects. Index of the vector is the environment id (id of the body in the env, not __nUniqueId of env) of the kinbody at that index. The index being environment id makes it easier to compare objects without getting a handle to their pointers. Whenever a FCLKinBodyInfoPtr goes into this map, it is removed from _cachedpinfo. Index of vector is the environment id. index 0 holds null pointer because kin bodies in the env should have positive index.
 
+    std::vector<SharedBodyGeometriesPtr> _vSharedBodyGeometries; ///< collision geometries of the bodies of the space this space was cloned from, see ShareGeometriesFrom. Index of vector is the environment id.
+
     std::vector<int> _vecAttachedEnvBodyIndicesCache; ///< cache
     std::vector<KinBodyPtr> _vecAttachedBodiesCache; ///< cache
 
@@ -18,6 +18,7 @@
 
 #include "plugindefs.h"
 
+#include <atomic>
 #include <boost/bind/bind.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/lexical_cast.hpp>
@@ -86,8 +87,13 @@ public:
         RegisterCommand("SetBackTraceSelfCollisionLinks",boost::bind(&IkFastSolver<IkReal>::_SetBackTraceSelfCollisionLinksCommand,this,_1,_2),
                         "format: int int\n\n\
 for numBacktraceLinksForSelfCollisionWithNonMoving numBacktraceLinksForSelfCollisionWithFree, when pruning self collisions, the number of links to look at. If the tip of the manip self collides with the base, then can safely quit the IK.");
+        RegisterCommand("SetNumThreads",boost::bind(&IkFastSolver<IkReal>::_SetNumThreadsCommand,this,_1,_2),
+                        "format: int [int]\n\n\
+numthreads [minfreevalues], the number of threads used to compute the analytic solutions when sweeping the free joints in Solve and SolveAll. The threads are only used if the sweep has at least minfreevalues free joint values (default 8). Validation of the solutions always stays on the calling thread. 1 disables the threads.");
         _numBacktraceLinksForSelfCollisionWithNonMoving = 2;
         _numBacktraceLinksForSelfCollisionWithFree = 0;
+        _nNumThreads = 1;
+        _nMinParallelFreeValues = 8;
     }
     virtual ~IkFastSolver() {
     }
@@ -167,6 +173,34 @@ for numBacktraceLinksForSelfCollisionWithNonMoving numBacktraceLinksForSelfColli
         return !!sinput;
     }
 
+    bool _SetNumThreadsCommand(ostream& sout, istream& sinput)
+    {
+        int numthreads = 1;
+        sinput >> numthreads;
+        if( !sinput ) {
+            return false;
+        }
+        int minfreevalues = _nMinParallelFreeValues;
+        sinput >> minfreevalues;
+        if( !!sinput ) {
+            _nMinParallelFreeValues = minfreevalues;
+        }
+        _SetNumThreads(numthreads);
+        return true;
+    }
+
+    void _SetNumThreads(int numthreads)
+    {
+        numthreads = max(1, numthreads);
+        if( numthreads != _nNumThreads || (numthreads > 1 && !_workerpool) ) {
+            _workerpool.reset();
+            if( numthreads > 1 ) {
+                _workerpool.reset(new utils::WorkerPool(numthreads));
+            }
+            _nNumThreads = numthreads;
+        }
+    }
+
     bool _GetFreeIndicesCommand(ostream& sout, istream& sinput)
     {
         FOREACHC(it, _vfreeparams) {
@@ -691,7 +725,13 @@ protected:
         std::vector<IkReal> vfree(_vfreeparams.size());
         StateCheckEndEffector stateCheck(probot,_vchildlinks,_vindependentlinks,filteroptions);
         CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
-        IkReturnAction retaction = ComposeSolution(_vfreeparams, vfree, 0, q0, boost::bind(&IkFastSolver::_SolveSingle,shared_solver(), boost::ref(param),boost::ref(vfree),boost::ref(q0),filteroptions,ikreturn,boost::ref(stateCheck)), _vFreeInc);
+        IkReturnAction retaction;
+        if( !!_workerpool && _vfreeparams.size() > 0 ) {
+            retaction = _ComposeSolutionParallel(param, q0, boost::bind(&IkFastSolver::_ValidateSolutionsSingle,shared_solver(), boost::ref(param), _1, boost::ref(q0), filteroptions, ikreturn, boost::ref(stateCheck)), IKRA_RejectKinematics);
+        }
+        else {
+            retaction = ComposeSolution(_vfreeparams, vfree, 0, q0, boost::bind(&IkFastSolver::_SolveSingle,shared_solver(), boost::ref(param),boost::ref(vfree),boost::ref(q0),filteroptions,ikreturn,boost::ref(stateCheck)), _vFreeInc);
+        }
         if( !!ikreturn ) {
             ikreturn->_action = retaction;
         }
@@ -710,7 +750,13 @@ protected:
         std::vector<IkReal> vfree(_vfreeparams.size());
         StateCheckEndEffector stateCheck(probot,_vchildlinks,_vindependentlinks,filteroptions);
         CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
-        IkReturnAction retaction = ComposeSolution(_vfreeparams, vfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_SolveAll,shared_solver(), param,boost::ref(vfree),filteroptions,boost::ref(vikreturns), boost::ref(stateCheck)), _vFreeInc);
+        IkReturnAction retaction;
+        if( !!_workerpool && _vfreeparams.size() > 0 ) {
+            retaction = _ComposeSolutionParallel(param, vector<dReal>(), boost::bind(&IkFastSolver::_ValidateSolutionsAll,shared_solver(), boost::ref(param), _1, filteroptions, boost::ref(vikreturns), boost::ref(stateCheck)), IKRA_Reject);
+        }
+        else {
+            retaction = ComposeSolution(_vfreeparams, vfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_SolveAll,shared_solver(), param,boost::ref(vfree),filteroptions,boost::ref(vikreturns), boost::ref(stateCheck)), _vFreeInc);
+        }
         if( retaction & IKRA_Quit ) {
             return false;
         }
@@ -771,6 +817,195 @@ protected:
         return vikreturns.size()>0;
     }
 
+    /// \brief a solution of SolveAllBatch that passed the joint limits and still has to be validated
+    struct BatchSolution
+    {
+        BatchSolution() : iparam(0), samestaterepeatcount(0) {
+        }
+        size_t iparam; ///< index of the pose in the batch
+        std::vector<dReal> vsolution;
+        std::vector<unsigned int> vsolutionindices;
+        int samestaterepeatcount; ///< index of the solution among the ones differing by 2*PI on joints with big ranges
+        IkParameterization paramnew; ///< the pose of the solution after refining
+        IkReturnPtr ikreturn;
+    };
+
+    /// \brief solves all the poses analytically first, then validates the solutions of the whole batch.
+    ///
+    /// The joint limits are checked while solving. The end effector of Transform6D poses is checked against the environment once per pose, before any of its solutions is validated. The environment collisions of all the solutions that pass the filters and the self-collision checks are checked with one CollisionCheckerBase::CheckCollisionBatch call.
+    virtual int SolveAllBatch(const std::vector<IkParameterization>& vrawparams, int filteroptions, std::vector< std::vector<IkReturnPtr> >& vikreturns)
+    {
+        vikreturns.resize(vrawparams.size());
+        FOREACH(itikreturns, vikreturns) {
+            itikreturns->resize(0);
+        }
+        if( vrawparams.size() == 0 ) {
+            return 0;
+        }
+        RobotBase::ManipulatorPtr pmanip(_pmanip);
+        RobotBasePtr probot = pmanip->GetRobot();
+        RobotBase::RobotStateSaver saver(probot);
+        probot->SetActiveDOFs(pmanip->GetArmIndices());
+        CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
+
+        Transform tIkChainEndlinkToEE;
+        if (!!pmanip->GetIkChainEndLink()) {
+            tIkChainEndlinkToEE = pmanip->GetIkChainEndLink()->GetTransform().inverse() * pmanip->GetEndEffector()->GetTransform();
+        }
+        const Transform tLocalTool = tIkChainEndlinkToEE * pmanip->GetLocalToolTransform();
+
+        // solve all the poses
+        std::vector<IkParameterization> vparams(vrawparams.size());
+        std::vector<BatchSolution> vbatchsolutions;
+        std::vector<IkReal> vfree(_vfreeparams.size());
+        for(size_t iparam = 0; iparam < vrawparams.size(); ++iparam) {
+            IkParameterization ikparamdummy;
+            vparams[iparam] = _ConvertIkParameterization(vrawparams[iparam], ikparamdummy);
+            ComposeSolution(_vfreeparams, vfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_SolveBatchParam,shared_solver(), iparam, boost::ref(vparams[iparam]), boost::ref(vfree), boost::ref(tLocalTool), filteroptions, boost::ref(vbatchsolutions)), _vFreeInc);
+        }
+        if( vbatchsolutions.size() == 0 ) {
+            return 0;
+        }
+
+        StateCheckEndEffector stateCheck(probot,_vchildlinks,_vindependentlinks,filteroptions);
+        std::vector<uint8_t> vparamrejected(vparams.size(), 0);
+        const bool bCheckEndEffectorEnvCollision = (filteroptions&IKFO_CheckEnvCollisions) && stateCheck.NeedCheckEndEffectorEnvCollision();
+        if( bCheckEndEffectorEnvCollision ) {
+            // the end effector of a 6D pose does not depend on the solution, so check it once
+            stateCheck.SetEnvironmentCollisionState();
+            const Transform tBase = pmanip->GetBase()->GetTransform();
+            for(size_t iparam = 0; iparam < vparams.size(); ++iparam) {
+                if( vparams[iparam].GetType() == IKP_Transform6D && pmanip->CheckEndEffectorCollision(tBase * vparams[iparam].GetTransform6D()) ) {
+                    vparamrejected[iparam] = 1;
+                }
+            }
+        }
+
+        // filters that have to run before the collision checks, and self-collisions
+        const bool bHasPreFilters = !(filteroptions & IKFO_IgnoreCustomFilters) && _HasFilterInRange(1, IKSP_MaxPriority);
+        std::vector<size_t> vvalidindices;
+        vvalidindices.reserve(vbatchsolutions.size());
+        for(size_t isolution = 0; isolution < vbatchsolutions.size(); ++isolution) {
+            BatchSolution& batchsolution = vbatchsolutions[isolution];
+            if( vparamrejected[batchsolution.iparam] ) {
+                continue;
+            }
+            const IkParameterization& param = vparams[batchsolution.iparam];
+            probot->SetActiveDOFValues(batchsolution.vsolution,false);
+            _CheckRefineSolution(param, *pmanip, batchsolution.vsolution, !!(filteroptions&IKFO_IgnoreJointLimits));
+            // due to floating-point precision, vsolution and param will not necessarily match anymore. The filters require perfectly matching pair, so compute a new param
+            batchsolution.paramnew = pmanip->GetIkParameterization(param,false);
+            dReal ikworkspacedist = param.ComputeDistanceSqr(batchsolution.paramnew);
+            if( ikworkspacedist > _ikthreshold ) {
+                RAVELOG_VERBOSE_FORMAT("env=%d, ignoring bad ik for %s:%s dist=%f in batch pose %d", GetEnv()->GetId()%probot->GetName()%pmanip->GetName()%RaveSqrt(ikworkspacedist)%batchsolution.iparam);
+                continue;
+            }
+            batchsolution.ikreturn.reset(new IkReturn(IKRA_Success));
+            batchsolution.ikreturn->_mapdata["solutionindices"] = std::vector<dReal>(batchsolution.vsolutionindices.begin(),batchsolution.vsolutionindices.end());
+            if( bHasPreFilters ) {
+                IkReturnAction retaction = _CallBatchFilters(batchsolution, pmanip, stateCheck, filteroptions, 1, IKSP_MaxPriority);
+                if( retaction & IKRA_Quit ) {
+                    vparamrejected[batchsolution.iparam] = 1;
+                    continue;
+                }
+                else if( retaction != IKRA_Success ) {
+                    continue;
+                }
+            }
+            if( !(filteroptions&IKFO_IgnoreSelfCollisions) ) {
+                stateCheck.SetSelfCollisionState();
+                if( probot->CheckSelfCollision() ) {
+                    continue;
+                }
+            }
+            vvalidindices.push_back(isolution);
+        }
+
+        if( (filteroptions&IKFO_CheckEnvCollisions) && vvalidindices.size() > 0 ) {
+            // the end effector was already checked for the 6D poses, so their solutions are checked without it
+            const size_t armdof = pmanip->GetArmIndices().size();
+            std::vector<size_t> vgroupindices;
+            std::vector<dReal> vconfigurations;
+            std::vector<uint8_t> vresults, vcolliding(vbatchsolutions.size(), 0);
+            for(int igroup = 0; igroup < 2; ++igroup) {
+                const bool bWithoutEndEffector = igroup == 0;
+                vgroupindices.resize(0);
+                vconfigurations.resize(0);
+                FOREACHC(itindex, vvalidindices) {
+                    const BatchSolution& batchsolution = vbatchsolutions[*itindex];
+                    if( !vparamrejected[batchsolution.iparam] && (bCheckEndEffectorEnvCollision && vparams[batchsolution.iparam].GetType() == IKP_Transform6D) == bWithoutEndEffector ) {
+                        vgroupindices.push_back(*itindex);
+                        vconfigurations.insert(vconfigurations.end(), batchsolution.vsolution.begin(), batchsolution.vsolution.end());
+                    }
+                }
+                if( vgroupindices.size() == 0 ) {
+                    continue;
+                }
+                BOOST_ASSERT(vconfigurations.size() == vgroupindices.size()*armdof);
+                if( bWithoutEndEffector ) {
+                    stateCheck.ResetCheckEndEffectorEnvCollision();
+                }
+                else {
+                    if( !(filteroptions & IKFO_IgnoreEndEffectorEnvCollisions) ) {
+                        stateCheck.RestoreCheckEndEffectorEnvCollision();
+                    }
+                    stateCheck.SetEnvironmentCollisionState();
+                }
+                GetEnv()->GetCollisionChecker()->CheckCollisionBatch(probot, vconfigurations, pmanip->GetArmIndices(), vresults, CBO_Environment);
+                for(size_t i = 0; i < vgroupindices.size(); ++i) {
+                    vcolliding[vgroupindices[i]] = vresults.at(i) & CBO_Environment;
+                }
+            }
+            size_t writeindex = 0;
+            FOREACHC(itindex, vvalidindices) {
+                if( !vcolliding[*itindex] ) {
+                    vvalidindices[writeindex++] = *itindex;
+                }
+            }
+            vvalidindices.resize(writeindex);
+        }
+
+        // filters that have to run after the collision checks
+        const bool bHasPostFilters = !(filteroptions & IKFO_IgnoreCustomFilters) && _HasFilterInRange(IKSP_MinPriority, 0);
+        FOREACHC(itindex, vvalidindices) {
+            BatchSolution& batchsolution = vbatchsolutions[*itindex];
+            if( vparamrejected[batchsolution.iparam] ) {
+                continue;
+            }
+            probot->SetActiveDOFValues(batchsolution.vsolution,false);
+            if( bHasPostFilters ) {
+                IkReturnAction retaction = _CallBatchFilters(batchsolution, pmanip, stateCheck, filteroptions, IKSP_MinPriority, 0);
+                if( retaction & IKRA_Quit ) {
+                    vparamrejected[batchsolution.iparam] = 1;
+                    continue;
+                }
+                else if( retaction != IKRA_Success ) {
+                    continue;
+                }
+            }
+            if( !(filteroptions & IKFO_IgnoreEndEffectorEnvCollisions) ) {
+                stateCheck.RestoreCheckEndEffectorEnvCollision();
+            }
+            _CallFinishCallbacks(batchsolution.ikreturn, pmanip, pmanip->GetBase()->GetTransform() * batchsolution.paramnew);
+            batchsolution.ikreturn->_vsolution = batchsolution.vsolution;
+            vikreturns[batchsolution.iparam].push_back(batchsolution.ikreturn);
+        }
+
+        int numsolved = 0;
+        for(size_t iparam = 0; iparam < vikreturns.size(); ++iparam) {
+            if( vparamrejected[iparam] ) {
+                vikreturns[iparam].resize(0);
+                continue;
+            }
+            if( vikreturns[iparam].size() == 0 ) {
+                continue;
+            }
+            _SortSolutions(probot, vikreturns[iparam]);
+            ++numsolved;
+        }
+        return numsolved;
+    }
+
     virtual int GetNumFreeParameters() const
     {
         return (int)_vfreeparams.size();
@@ -853,6 +1088,8 @@ protected:
         _numBacktraceLinksForSelfCollisionWithNonMoving = r->_numBacktraceLinksForSelfCollisionWithNonMoving;
         _numBacktraceLinksForSelfCollisionWithFree = r->_numBacktraceLinksForSelfCollisionWithFree;
         _ikthreshold = r->_ikthreshold;
+        _nMinParallelFreeValues = r->_nMinParallelFreeValues;
+        _SetNumThreads(r->_nNumThreads);
 #ifdef OPENRAVE_HAS_LAPACK
         _SetJacobianRefine(r->_fRefineWithJacobianInverseAllowedError, r->_jacobinvsolver._nMaxIterations);
 #endif
@@ -949,17 +1186,83 @@ protected:
         return static_cast<IkReturnAction>(allres);
     }
 
+    /// \brief callback for ComposeSolution that only records the free joint values in the order they are visited
+    IkReturnAction _RecordFreeValues(const vector<IkReal>& vfree, std::vector< vector<IkReal> >& vfreevalues)
+    {
+        vfreevalues.push_back(vfree);
+        return IKRA_Reject;
+    }
+
+    /// \brief sweeps the free joints like ComposeSolution, but computes the analytic solutions of several free joint values at once on _workerpool.
+    ///
+    /// Only the analytic ik runs on the worker threads since it does not touch the environment. The manipulator and its transforms are looked up on the calling thread. fnvalidate is called on the calling thread in the same order as ComposeSolution would call it, so the returned solutions do not change. The values are processed in chunks so that Solve can stop at the first valid solution.
+    /// \param fnvalidate validates the analytic solutions of one set of free joint values
+    /// \param kinematicsfailure returned for the free joint values the analytic ik has no solutions for
+    IkReturnAction _ComposeSolutionParallel(const IkParameterization& param, const vector<dReal>& q0, const boost::function<IkReturnAction(const ikfast::IkSolutionList<IkReal>&)>& fnvalidate, IkReturnAction kinematicsfailure)
+    {
+        std::vector< vector<IkReal> > vfreevalues;
+        std::vector<IkReal> vfree(_vfreeparams.size());
+        ComposeSolution(_vfreeparams, vfree, 0, q0, boost::bind(&IkFastSolver::_RecordFreeValues, this, boost::cref(vfree), boost::ref(vfreevalues)), _vFreeInc);
+
+        RobotBase::ManipulatorPtr pmanip(_pmanip);
+        Transform tIkChainEndlinkToEE;
+        if (!!pmanip->GetIkChainEndLink()) {
+            tIkChainEndlinkToEE = pmanip->GetIkChainEndLink()->GetTransform().inverse() * pmanip->GetEndEffector()->GetTransform();
+        }
+        const Transform tLocalTool = tIkChainEndlinkToEE * pmanip->GetLocalToolTransform();
+
+        bool bUseWorkers = (int)vfreevalues.size() >= _nMinParallelFreeValues;
+        size_t chunksize = bUseWorkers ? 4*_workerpool->GetNumThreads() : 1;
+        std::vector< ikfast::IkSolutionList<IkReal> > vsolutions(chunksize);
+        std::vector<uint8_t> vsuccess(chunksize);
+        int allres = IKRA_Reject;
+        for(size_t ichunkstart = 0; ichunkstart < vfreevalues.size(); ichunkstart += chunksize) {
+            size_t numchunk = min(chunksize, vfreevalues.size()-ichunkstart);
+            for(size_t i = 0; i < numchunk; ++i) {
+                vsolutions[i].Clear();
+            }
+            if( bUseWorkers ) {
+                std::atomic<size_t> nextindex(0);
+                _workerpool->Run([&](int ithread) {
+                    for(size_t i = nextindex++; i < numchunk; i = nextindex++) {
+                        vsuccess[i] = _CallIk(param, vfreevalues[ichunkstart+i], tLocalTool, pmanip, vsolutions[i]);
+                    }
+                });
+            }
+            else {
+                vsuccess[0] = _CallIk(param, vfreevalues[ichunkstart], tLocalTool, pmanip, vsolutions[0]);
+            }
+
+            for(size_t i = 0; i < numchunk; ++i) {
+                IkReturnAction res = vsuccess[i] ? fnvalidate(vsolutions[i]) : kinematicsfailure;
+                if( !(res & IKRA_Reject) ) {
+                    return res;
+                }
+                if( res & IKRA_Quit ) {
+                    return res;
+                }
+                allres |= res;
+            }
+        }
+        return static_cast<IkReturnAction>(allres);
+    }
+
     /// \param tLocalTool _pmanip->GetLocalToolTransform()
     inline bool _CallIk(const IkParameterization& param, const vector<IkReal>& vfree, const Transform& tLocalTool, ikfast::IkSolutionList<IkReal>& solutions)
     {
-        bool bsuccess = false;
         if( !!_ikfunctions->_ComputeIk2 ) {
-            bsuccess = _CallIk2(param, vfree, tLocalTool, solutions);
+            return _CallIk2(param, vfree, tLocalTool, _pmanip.lock(), solutions);
         }
-        else {
-            bsuccess = _CallIk1(param, vfree, tLocalTool, solutions);
+        return _CallIk1(param, vfree, tLocalTool, solutions);
+    }
+
+    /// \brief same as _CallIk, but with the manipulator already locked by the caller. used from the threads of _workerpool, which do not touch _pmanip
+    inline bool _CallIk(const IkParameterization& param, const vector<IkReal>& vfree, const Transform& tLocalTool, const RobotBase::ManipulatorPtr& pmanip, ikfast::IkSolutionList<IkReal>& solutions)
+    {
+        if( !!_ikfunctions->_ComputeIk2 ) {
+            return _CallIk2(param, vfree, tLocalTool, pmanip, solutions);
         }
-        return bsuccess;
+        return _CallIk1(param, vfree, tLocalTool, solutions);
     }
 
     bool _CallIk1(const IkParameterization& param, const vector<IkReal>& vfree, const Transform& tLocalTool, ikfast::IkSolutionList<IkReal>& solutions)
@@ -1099,9 +1402,9 @@ protected:
         throw openrave_exception(str(boost::format(_("don't support ik parameterization 0x%x"))%param.GetType()),ORE_InvalidArguments);
     }
 
-    bool _CallIk2(const IkParameterization& param, const vector<IkReal>& vfree, const Transform& tLocalTool, ikfast::IkSolutionList<IkReal>& solutions)
+    /// \param pmanip passed to ComputeIk2 as pOpenRAVEManip. The ik generated by ikfast does not use it, so it can be called from several threads with the same manipulator
+    bool _CallIk2(const IkParameterization& param, const vector<IkReal>& vfree, const Transform& tLocalTool, RobotBase::ManipulatorPtr pmanip, ikfast::IkSolutionList<IkReal>& solutions)
     {
-        RobotBase::ManipulatorPtr pmanip = _pmanip.lock();
         try {
             switch(param.GetType()) {
             case IKP_Transform6D: {
@@ -1321,7 +1624,13 @@ protected:
         if( !_CallIk(param,vfree, tIkChainEndlinkToEE * pmanip->GetLocalToolTransform(), solutions) ) {
             return IKRA_RejectKinematics;
         }
+        return _ValidateSolutionsSingle(param, solutions, q0, filteroptions, ikreturn, stateCheck);
+    }
 
+    /// \brief validates the analytic solutions of one set of free joint values and returns the one closest to q0
+    IkReturnAction _ValidateSolutionsSingle(const IkParameterization& param, const ikfast::IkSolutionList<IkReal>& solutions, const vector<dReal>& q0, int filteroptions, IkReturnPtr ikreturn, StateCheckEndEffector& stateCheck)
+    {
+        RobotBase::ManipulatorPtr pmanip(_pmanip);
         RobotBasePtr probot = pmanip->GetRobot();
         SolutionInfo bestsolution;
         std::vector<dReal> vravesol(pmanip->GetArmIndices().size());
@@ -1874,7 +2183,6 @@ protected:
     IkReturnAction _SolveAll(const IkParameterization& param, const vector<IkReal>& vfree, int filteroptions, std::vector<IkReturnPtr>& vikreturns, StateCheckEndEffector& stateCheck)
     {
         RobotBase::ManipulatorPtr pmanip(_pmanip);
-        RobotBasePtr probot = pmanip->GetRobot();
         ikfast::IkSolutionList<IkReal> solutions;
         Transform tIkChainEndlinkToEE;
         if (!!pmanip->GetIkChainEndLink()) {
@@ -1882,26 +2190,34 @@ protected:
         }
 
         if( _CallIk(param,vfree, tIkChainEndlinkToEE * pmanip->GetLocalToolTransform(), solutions) ) {
-            vector<IkReal> vsolfree;
-            std::vector<IkReal> sol(pmanip->GetArmIndices().size());
-            for(size_t isolution = 0; isolution < solutions.GetNumSolutions(); ++isolution) {
-                const ikfast::IkSolution<IkReal>& iksol = dynamic_cast<const ikfast::IkSolution<IkReal>& >(solutions.GetSolution(isolution));
-                iksol.Validate();
-                //RAVELOG_VERBOSE_FORMAT("ikfast solution %d/%d (free=%d)", isolution%solutions.GetNumSolutions()%iksol.GetFree().size());
-                if( iksol.GetFree().size() > 0 ) {
-                    // have to search over all the free parameters of the solution!
-                    vsolfree.resize(iksol.GetFree().size());
-                    std::vector<dReal> vFreeInc(_GetFreeIncFromIndices(iksol.GetFree()));
-                    IkReturnAction retaction = ComposeSolution(iksol.GetFree(), vsolfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_ValidateSolutionAll,shared_solver(), boost::ref(param), boost::ref(iksol), boost::ref(vsolfree), filteroptions, boost::ref(sol), boost::ref(vikreturns), boost::ref(stateCheck)), vFreeInc);
-                    if( retaction & IKRA_Quit) {
-                        return retaction;
-                    }
+            return _ValidateSolutionsAll(param, solutions, filteroptions, vikreturns, stateCheck);
+        }
+        return IKRA_Reject; // signals to continue
+    }
+
+    /// \brief validates the analytic solutions of one set of free joint values and adds all the valid ones to vikreturns
+    IkReturnAction _ValidateSolutionsAll(const IkParameterization& param, const ikfast::IkSolutionList<IkReal>& solutions, int filteroptions, std::vector<IkReturnPtr>& vikreturns, StateCheckEndEffector& stateCheck)
+    {
+        RobotBase::ManipulatorPtr pmanip(_pmanip);
+        vector<IkReal> vsolfree;
+        std::vector<IkReal> sol(pmanip->GetArmIndices().size());
+        for(size_t isolution = 0; isolution < solutions.GetNumSolutions(); ++isolution) {
+            const ikfast::IkSolution<IkReal>& iksol = dynamic_cast<const ikfast::IkSolution<IkReal>& >(solutions.GetSolution(isolution));
+            iksol.Validate();
+            //RAVELOG_VERBOSE_FORMAT("ikfast solution %d/%d (free=%d)", isolution%solutions.GetNumSolutions()%iksol.GetFree().size());
+            if( iksol.GetFree().size() > 0 ) {
+                // have to search over all the free parameters of the solution!
+                vsolfree.resize(iksol.GetFree().size());
+                std::vector<dReal> vFreeInc(_GetFreeIncFromIndices(iksol.GetFree()));
+                IkReturnAction retaction = ComposeSolution(iksol.GetFree(), vsolfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_ValidateSolutionAll,shared_solver(), boost::ref(param), boost::ref(iksol), boost::ref(vsolfree), filteroptions, boost::ref(sol), boost::ref(vikreturns), boost::ref(stateCheck)), vFreeInc);
+                if( retaction & IKRA_Quit) {
+                    return retaction;
                 }
-                else {
-                    IkReturnAction retaction = _ValidateSolutionAll(param, iksol, vector<IkReal>(), filteroptions, sol, vikreturns, stateCheck);
-                    if( retaction & IKRA_Quit ) {
-                        return retaction;
-                    }
+            }
+            else {
+                IkReturnAction retaction = _ValidateSolutionAll(param, iksol, vector<IkReal>(), filteroptions, sol, vikreturns, stateCheck);
+                if( retaction & IKRA_Quit ) {
+                    return retaction;
                 }
             }
         }
@@ -2230,6 +2546,75 @@ protected:
         return static_cast<IkReturnAction>(retactionall); // signals to continue
     }
 
+    /// \brief callback for ComposeSolution in SolveAllBatch, adds all the analytic solutions of one pose and one set of free values to vbatchsolutions
+    IkReturnAction _SolveBatchParam(size_t iparam, const IkParameterization& param, const vector<IkReal>& vfree, const Transform& tLocalTool, int filteroptions, std::vector<BatchSolution>& vbatchsolutions)
+    {
+        ikfast::IkSolutionList<IkReal> solutions;
+        if( _CallIk(param, vfree, tLocalTool, solutions) ) {
+            vector<IkReal> vsolfree;
+            std::vector<IkReal> sol;
+            for(size_t isolution = 0; isolution < solutions.GetNumSolutions(); ++isolution) {
+                const ikfast::IkSolution<IkReal>& iksol = dynamic_cast<const ikfast::IkSolution<IkReal>& >(solutions.GetSolution(isolution));
+                iksol.Validate();
+                if( iksol.GetFree().size() > 0 ) {
+                    // have to search over all the free parameters of the solution!
+                    vsolfree.resize(iksol.GetFree().size());
+                    std::vector<dReal> vFreeInc(_GetFreeIncFromIndices(iksol.GetFree()));
+                    ComposeSolution(iksol.GetFree(), vsolfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_AddBatchSolution,shared_solver(), iparam, boost::ref(iksol), boost::ref(vsolfree), filteroptions, boost::ref(sol), boost::ref(vbatchsolutions)), vFreeInc);
+                }
+                else {
+                    _AddBatchSolution(iparam, iksol, vector<IkReal>(), filteroptions, sol, vbatchsolutions);
+                }
+            }
+        }
+        return IKRA_Reject; // signals to continue
+    }
+
+    IkReturnAction _AddBatchSolution(size_t iparam, const ikfast::IkSolution<IkReal>& iksol, const vector<IkReal>& vfree, int filteroptions, std::vector<IkReal>& sol, std::vector<BatchSolution>& vbatchsolutions)
+    {
+        iksol.GetSolution(sol,vfree);
+        std::vector<dReal> vravesol(sol.begin(), sol.end());
+        std::vector< pair<std::vector<dReal>,int> > vravesols;
+        if( !(filteroptions&IKFO_IgnoreJointLimits) ) {
+            _ComputeAllSimilarJointAngles(vravesols, vravesol);
+        }
+        else {
+            vravesols.emplace_back(vravesol, 0);
+        }
+
+        std::vector<unsigned int> vsolutionindices;
+        iksol.GetSolutionIndices(vsolutionindices);
+        for(size_t i = 0; i < vravesols.size(); ++i) {
+            vbatchsolutions.push_back(BatchSolution());
+            BatchSolution& batchsolution = vbatchsolutions.back();
+            batchsolution.iparam = iparam;
+            batchsolution.vsolution.swap(vravesols[i].first);
+            batchsolution.vsolutionindices = vsolutionindices;
+            FOREACH(it,batchsolution.vsolutionindices) {
+                *it += vravesols[i].second<<16;
+            }
+            batchsolution.samestaterepeatcount = i;
+        }
+        return IKRA_Reject; // signals to continue
+    }
+
+    /// \brief calls the filters within [minpriority, maxpriority] on a solution of SolveAllBatch. The robot has to be set to the solution.
+    IkReturnAction _CallBatchFilters(BatchSolution& batchsolution, RobotBase::ManipulatorPtr pmanip, StateCheckEndEffector& stateCheck, int filteroptions, int32_t minpriority, int32_t maxpriority)
+    {
+        _vsolutionindices = batchsolution.vsolutionindices;
+        _nSameStateRepeatCount = batchsolution.samestaterepeatcount; // could be overwritten by _CallFilters call!
+        bool bNeedCheckEndEffectorEnvCollision = stateCheck.NeedCheckEndEffectorEnvCollision();
+        if( !(filteroptions & IKFO_IgnoreEndEffectorEnvCollisions) ) {
+            // have to make sure end effector collisions are set, regardless if stateCheck.ResetCheckEndEffectorEnvCollision has been called
+            stateCheck.RestoreCheckEndEffectorEnvCollision();
+        }
+        IkReturnAction retaction = _CallFilters(batchsolution.vsolution, pmanip, batchsolution.paramnew, batchsolution.ikreturn, minpriority, maxpriority);
+        if( !(filteroptions & IKFO_IgnoreEndEffectorEnvCollisions) && !bNeedCheckEndEffectorEnvCollision ) {
+            stateCheck.ResetCheckEndEffectorEnvCollision();
+        }
+        return retaction;
+    }
+
     bool _CheckJointAngles(std::vector<dReal>& vravesol) const
     {
         for(int j = 0; j < (int)_qlower.size(); ++j) {
@@ -2472,6 +2857,10 @@ protected:
 
     bool _bEmptyTransform6D; ///< if true, then the iksolver has been built with identity of the manipulator transform. Only valid for Transform6D IKs.
 
+    int _nNumThreads; ///< number of threads computing the analytic solutions of the free joint sweep, 1 if disabled
+    int _nMinParallelFreeValues; ///< minimum number of free joint values in a sweep before _workerpool is used
+    utils::WorkerPoolPtr _workerpool; ///< set if _nNumThreads > 1
+
 };
 
 #ifdef OPENRAVE_IKFAST_FLOAT32
@@ -0,0 +1,367 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 agent
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "openraveplugindefs.h"
+#include "rplanners.h"
+
+#include <queue>
+
+/// \brief Lazy PRM. The roadmap edges are not checked when they are added. The shortest path of the roadmap is searched and only its edges are checked; edges that fail are removed and the roadmap is searched again.
+class LazyPrmPlanner : public PlannerBase
+{
+    enum EdgeState
+    {
+        ES_Unchecked = 0,
+        ES_Valid = 1,
+        ES_Invalid = 2,
+    };
+
+    struct Edge
+    {
+        Edge(int vertex0, int vertex1, dReal length) : vertex0(vertex0), vertex1(vertex1), length(length), state(ES_Unchecked) {
+        }
+        inline int GetOtherVertex(int vertex) const {
+            return vertex == vertex0 ? vertex1 : vertex0;
+        }
+        int vertex0, vertex1;
+        dReal length;
+        EdgeState state;
+    };
+
+    struct Vertex
+    {
+        std::vector<dReal> q;
+        std::vector<int> vedges; ///< indices into _vedges
+        int startindex; ///< index of the initial configuration, -1 if not an initial configuration
+        int goalindex; ///< index of the goal configuration, -1 if not a goal configuration
+    };
+
+public:
+    LazyPrmPlanner(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv), _nNeighbors(10), _vertextree(0)
+    {
+        __description = "\
+Lazy Probabilistic Roadmap. Samples the configuration space and connects every sample to its nearest neighbors without checking the edges. \
+Then searches the shortest path from the initial to the goal configurations and only checks the edges of that path. \
+Edges that fail the constraints are removed and the search is repeated, more samples are added when no path exists. See\n\n\
+- R. Bohlin and L.E. Kavraki. Path planning using lazy PRM. In Proc. IEEE Int'l Conf. on Robotics and Automation (ICRA'2000), pages 521-528, San Francisco, CA, April 2000.";
+        RegisterCommand("SetNumNeighbors", boost::bind(&LazyPrmPlanner::SetNumNeighborsCommand,this,_1,_2),
+                        "sets the number of nearest neighbors every new roadmap vertex is connected to. By default it is 10");
+        _filterreturn.reset(new ConstraintFilterReturn());
+    }
+    virtual ~LazyPrmPlanner() {
+    }
+
+    virtual bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr pparams)
+    {
+        EnvironmentLock lock(GetEnv()->GetMutex());
+        _parameters.reset(new RRTParameters());
+        _parameters->copy(pparams);
+        _parameters->Validate();
+        _robot = pbase;
+        FOREACH(it, _parameters->_listInternalSamplers) {
+            (*it)->SetSeed(_parameters->_nRandomGeneratorSeed);
+        }
+
+        PlannerParameters::StateSaver savestate(_parameters);
+        CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
+
+        const int dof = _parameters->GetDOF();
+        _vertextree.Init(boost::static_pointer_cast<PlannerBase>(shared_from_this()), dof, _parameters->_distmetricfn, _parameters->_fStepLength, _parameters->_distmetricfn(_parameters->_vConfigLowerLimit, _parameters->_vConfigUpperLimit));
+        std::vector<dReal> vdistmetricweights2;
+        if( _parameters->GetDistMetricWeights2(vdistmetricweights2) ) {
+            _vertextree.SetDistMetricWeights2(vdistmetricweights2);
+        }
+        _vvertices.resize(0);
+        _vedges.resize(0);
+        _numstarts = 0;
+        _numgoals = 0;
+        std::vector<dReal> vconfig(dof);
+        for(size_t index = 0; index < _parameters->vinitialconfig.size(); index += dof) {
+            std::copy(_parameters->vinitialconfig.begin()+index, _parameters->vinitialconfig.begin()+index+dof, vconfig.begin());
+            _filterreturn->Clear();
+            if( _parameters->CheckPathAllConstraints(vconfig, vconfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart, 0xffff|CFO_FillCollisionReport, _filterreturn) != 0 ) {
+                RAVELOG_DEBUG_FORMAT("env=%s, initial configuration for lazy prm does not satisfy constraints: %s", GetEnv()->GetNameId()%_filterreturn->_report.__str__());
+                continue;
+            }
+            _AddVertex(vconfig, index/dof, -1);
+        }
+        for(size_t index = 0; index < _parameters->vgoalconfig.size(); index += dof) {
+            std::copy(_parameters->vgoalconfig.begin()+index, _parameters->vgoalconfig.begin()+index+dof, vconfig.begin());
+            int ret = _parameters->CheckPathAllConstraints(vconfig, vconfig, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart);
+            if( ret != 0 ) {
+                RAVELOG_WARN_FORMAT("env=%s, goal %d fails constraints with 0x%x", GetEnv()->GetNameId()%(index/dof)%ret);
+                continue;
+            }
+            _AddVertex(vconfig, -1, index/dof);
+        }
+
+        if( _numstarts == 0 && !_parameters->_sampleinitialfn ) {
+            RAVELOG_WARN_FORMAT("env=%s, no initial configurations", GetEnv()->GetNameId());
+            _parameters.reset();
+            return false;
+        }
+        if( _numgoals == 0 && !_parameters->_samplegoalfn ) {
+            RAVELOG_WARN_FORMAT("env=%s, no goals specified", GetEnv()->GetNameId());
+            _parameters.reset();
+            return false;
+        }
+        if( _parameters->_nMaxIterations <= 0 ) {
+            _parameters->_nMaxIterations = 10000;
+        }
+        RAVELOG_DEBUG_FORMAT("env=%s, LazyPRM Planner Initialized, initial=%d, goal=%d, step=%f", GetEnv()->GetNameId()%_numstarts%_numgoals%_parameters->_fStepLength);
+        return true;
+    }
+
+    virtual PlannerStatus PlanPath(TrajectoryBasePtr ptraj, int planningoptions) override
+    {
+        if(!_parameters) {
+            return OPENRAVE_PLANNER_STATUS(str(boost::format("env=%s, LazyPrmPlanner::PlanPath - Error, planner not initialized")%GetEnv()->GetNameId()), PS_Failed);
+        }
+
+        EnvironmentLock lock(GetEnv()->GetMutex());
+        uint64_t basetimeus = utils::GetMonotonicTime();
+        int constraintFilterOptions = 0xffff;
+        if (planningoptions & PO_AddCollisionStatistics) {
+            constraintFilterOptions = constraintFilterOptions|CFO_FillCollisionReport;
+        }
+
+        PlannerStatus planningstatus;
+        PlannerParameters::StateSaver savestate(_parameters);
+        CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
+
+        PlannerProgress progress;
+        std::vector<int> vpathvertices, vpathedges;
+        std::vector<dReal> vsample;
+        int iter = 0, numedgechecks = 0;
+        bool bFound = false;
+        // search the roadmap first since the initial and goal configurations might already be connected
+        bool bSearch = true;
+        while(iter < _parameters->_nMaxIterations) {
+            progress._iteration = iter;
+            PlannerAction callbackaction = _CallCallbacks(progress);
+            if( callbackaction == PA_Interrupt ) {
+                return OPENRAVE_PLANNER_STATUS(str(boost::format("env=%s, Planning was interrupted")%GetEnv()->GetNameId()), PS_Interrupted);
+            }
+            if( _parameters->_nMaxPlanningTime > 0 ) {
+                uint64_t elapsedtime = utils::GetMonotonicTime()-basetimeus;
+                if( elapsedtime >= 1000*_parameters->_nMaxPlanningTime ) {
+                    RAVELOG_DEBUG_FORMAT("env=%s, time exceeded (%d[us] > %d[us]) so breaking. iter=%d < %d", GetEnv()->GetNameId()%elapsedtime%(1000*_parameters->_nMaxPlanningTime)%iter%_parameters->_nMaxIterations);
+                    break;
+                }
+            }
+
+            if( bSearch ) {
+                bSearch = false;
+                if( _SearchPath(vpathvertices, vpathedges) ) {
+                    // check the unchecked edges of the path, the path is valid if all of them pass
+                    bool bPathValid = true;
+                    for(size_t ipath = 0; ipath < vpathedges.size(); ++ipath) {
+                        Edge& edge = _vedges[vpathedges[ipath]];
+                        if( edge.state == ES_Unchecked ) {
+                            ++numedgechecks;
+                            _filterreturn->Clear();
+                            const std::vector<dReal>& q0 = _vvertices[vpathvertices[ipath]].q;
+                            const std::vector<dReal>& q1 = _vvertices[vpathvertices[ipath+1]].q;
+                            if( _parameters->CheckPathAllConstraints(q0, q1, std::vector<dReal>(), std::vector<dReal>(), 0, IT_Open, constraintFilterOptions, _filterreturn) != 0 ) {
+                                edge.state = ES_Invalid;
+                                if( constraintFilterOptions&CFO_FillCollisionReport ) {
+                                    planningstatus.AddCollisionReport(_filterreturn->_report);
+                                }
+                            }
+                            else {
+                                edge.state = ES_Valid;
+                            }
+                        }
+                        if( edge.state == ES_Invalid ) {
+                            bPathValid = false;
+                            break;
+                        }
+                    }
+                    if( bPathValid ) {
+                        bFound = true;
+                        break;
+                    }
+                    // an edge was removed, so search again before sampling
+                    bSearch = true;
+                    continue;
+                }
+            }
+
+            ++iter;
+            if( !!_parameters->_samplegoalfn ) {
+                vsample.resize(0);
+                if( _parameters->_samplegoalfn(vsample) ) {
+                    _AddVertex(vsample, -1, _parameters->vgoalconfig.size()/_parameters->GetDOF() + _numgoals);
+                    bSearch = true;
+                }
+            }
+            if( !!_parameters->_sampleinitialfn ) {
+                vsample.resize(0);
+                if( _parameters->_sampleinitialfn(vsample) ) {
+                    _AddVertex(vsample, _parameters->vinitialconfig.size()/_parameters->GetDOF() + _numstarts, -1);
+                    bSearch = true;
+                }
+            }
+            vsample.resize(0);
+            if( !_parameters->_samplefn(vsample) ) {
+                continue;
+            }
+            if( _parameters->CheckPathAllConstraints(vsample, vsample, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart) != 0 ) {
+                continue;
+            }
+            _AddVertex(vsample, -1, -1);
+            bSearch = true;
+        }
+
+        uint64_t elapsedtimeus = utils::GetMonotonicTime()-basetimeus;
+        if( !bFound ) {
+            std::string description = str(boost::format(_("env=%s, plan failed in %u[us], iter=%d, nMaxIterations=%d, vertices=%d, edge checks=%d"))%GetEnv()->GetNameId()%elapsedtimeus%iter%_parameters->_nMaxIterations%_vvertices.size()%numedgechecks);
+            RAVELOG_WARN(description);
+            return OPENRAVE_PLANNER_STATUS(description, PS_Failed);
+        }
+
+        const int dof = _parameters->GetDOF();
+        std::vector<dReal> vpath;
+        vpath.reserve(vpathvertices.size()*dof);
+        FOREACHC(itvertex, vpathvertices) {
+            vpath.insert(vpath.end(), _vvertices[*itvertex].q.begin(), _vvertices[*itvertex].q.end());
+        }
+        if( ptraj->GetConfigurationSpecification().GetDOF() == 0 ) {
+            ptraj->Init(_parameters->_configurationspecification);
+        }
+        ptraj->Insert(ptraj->GetNumWaypoints(), vpath, _parameters->_configurationspecification);
+        RAVELOG_DEBUG_FORMAT("env=%s, plan success, iters=%d, path=%d points, vertices=%d, edges=%d, edge checks=%d, computation time=%u[us]", GetEnv()->GetNameId()%iter%vpathvertices.size()%_vvertices.size()%_vedges.size()%numedgechecks%elapsedtimeus);
+        return _ProcessPostPlanners(_robot,ptraj);
+    }
+
+    virtual PlannerParametersConstPtr GetParameters() const {
+        return _parameters;
+    }
+
+protected:
+    bool SetNumNeighborsCommand(std::ostream& sout, std::istream& sinput)
+    {
+        sinput >> _nNeighbors;
+        return !!sinput;
+    }
+
+    /// \brief adds a vertex to the roadmap and connects it to its _nNeighbors nearest vertices without checking the edges
+    void _AddVertex(const std::vector<dReal>& q, int startindex, int goalindex)
+    {
+        const int newvertex = _vvertices.size();
+        _vertextree.FindNearestNodes(q, _nNeighbors, _vneighbors);
+
+        _vvertices.push_back(Vertex());
+        Vertex& vertex = _vvertices.back();
+        vertex.q = q;
+        vertex.startindex = startindex;
+        vertex.goalindex = goalindex;
+        for(size_t ineighbor = 0; ineighbor < _vneighbors.size(); ++ineighbor) {
+            const int neighborvertex = _vneighbors[ineighbor].first->_userdata;
+            _vedges.emplace_back(newvertex, neighborvertex, _vneighbors[ineighbor].second);
+            vertex.vedges.push_back(_vedges.size()-1);
+            _vvertices[neighborvertex].vedges.push_back(_vedges.size()-1);
+        }
+        // a configuration closer than the minimum distance of the tree to a vertex is not inserted, it is still connected through the vertices near it
+        _vertextree.InsertNode(NULL, q, newvertex);
+        if( startindex >= 0 ) {
+            ++_numstarts;
+        }
+        if( goalindex >= 0 ) {
+            ++_numgoals;
+        }
+    }
+
+    /// \brief searches the shortest path from any initial vertex to any goal vertex over the edges that are not invalid
+    ///
+    /// \param[out] vpathvertices the vertices of the path from the initial vertex to the goal vertex
+    /// \param[out] vpathedges the edges of the path, vpathedges[i] connects vpathvertices[i] and vpathvertices[i+1]
+    bool _SearchPath(std::vector<int>& vpathvertices, std::vector<int>& vpathedges)
+    {
+        const int numvertices = _vvertices.size();
+        _vcosts.assign(numvertices, std::numeric_limits<dReal>::infinity());
+        _vparentedges.assign(numvertices, -1);
+        std::priority_queue< std::pair<dReal, int>, std::vector< std::pair<dReal, int> >, std::greater< std::pair<dReal, int> > > queue;
+        for(int ivertex = 0; ivertex < numvertices; ++ivertex) {
+            if( _vvertices[ivertex].startindex >= 0 ) {
+                _vcosts[ivertex] = 0;
+                queue.push(std::make_pair(dReal(0), ivertex));
+            }
+        }
+
+        int goalvertex = -1;
+        while(!queue.empty()) {
+            const std::pair<dReal, int> top = queue.top();
+            queue.pop();
+            if( top.first > _vcosts[top.second] ) {
+                continue;
+            }
+            const Vertex& vertex = _vvertices[top.second];
+            if( vertex.goalindex >= 0 ) {
+                goalvertex = top.second;
+                break;
+            }
+            FOREACHC(itedge, vertex.vedges) {
+                const Edge& edge = _vedges[*itedge];
+                if( edge.state == ES_Invalid ) {
+                    continue;
+                }
+                const int othervertex = edge.GetOtherVertex(top.second);
+                const dReal cost = top.first + edge.length;
+                if( cost < _vcosts[othervertex] ) {
+                    _vcosts[othervertex] = cost;
+                    _vparentedges[othervertex] = *itedge;
+                    queue.push(std::make_pair(cost, othervertex));
+                }
+            }
+        }
+        if( goalvertex < 0 ) {
+            return false;
+        }
+
+        vpathvertices.resize(0);
+        vpathedges.resize(0);
+        int ivertex = goalvertex;
+        vpathvertices.push_back(ivertex);
+        while(_vparentedges[ivertex] >= 0) {
+            vpathedges.push_back(_vparentedges[ivertex]);
+            ivertex = _vedges[_vparentedges[ivertex]].GetOtherVertex(ivertex);
+            vpathvertices.push_back(ivertex);
+        }
+        std::reverse(vpathvertices.begin(), vpathvertices.end());
+        std::reverse(vpathedges.begin(), vpathedges.end());
+        return true;
+    }
+
+    RRTParametersPtr _parameters;
+    RobotBasePtr _robot;
+    ConstraintFilterReturnPtr _filterreturn;
+    int _nNeighbors; ///< number of nearest vertices a new vertex is connected to
+
+    std::vector<Vertex> _vvertices;
+    std::vector<Edge> _vedges;
+    SpatialTree<SimpleNode> _vertextree; ///< the vertices for the nearest neighbor queries, the userdata of a node is its vertex index
+    int _numstarts, _numgoals;
+
+    // caches
+    std::vector< std::pair<SimpleNode*, dReal> > _vneighbors;
+    std::vector<dReal> _vcosts;
+    std::vector<int> _vparentedges;
+};
+
+PlannerBasePtr CreateLazyPrmPlanner(EnvironmentBasePtr penv, std::istream& sinput)
+{
+    return PlannerBasePtr(new LazyPrmPlanner(penv, sinput));
+}
@@ -41,6 +41,7 @@ struct ManipConstraintInfo
 
     std::vector<int> vuseddofindices; ///< a vector of unique DOF indices targetted for the body
     std::vector<int> vconfigindices; ///< for every index in vuseddofindices, returns the first configuration space index it came from
+    KinBody::JacobianWorkspace jacobianworkspace; ///< chain of the end-effector for computing its jacobians without searching the robot
 };
 
 class ManipConstraintChecker
@@ -169,6 +170,7 @@ public:
                     info.pmanip = pmanip;
                     spec.ExtractUsedIndices(pmanip->GetRobot(), info.vuseddofindices, info.vconfigindices);
                     info.plink = endeffector;
+                    pmanip->GetRobot()->InitJacobianWorkspace(endeffector->GetIndex(), Vector(), std::vector<int>(), info.jacobianworkspace);
                     ConvertAABBtoCheckPoints(enclosingaabb, info.checkpoints);
                     info.fmaxdistfromcenter = 0;
                     FOREACH(itpoint, info.checkpoints) {
@@ -223,12 +225,8 @@ public:
         OPENRAVE_ASSERT_OP(vellimits.size(),<,64);
 
         FOREACHC(itmanipinfo,_listCheckManips) {
-            RobotBasePtr probot = itmanipinfo->pmanip->GetRobot();
-            Transform tlink = itmanipinfo->plink->GetTransform();
-
             // compute jacobians, make sure to transform by the world frame
-            probot->CalculateAngularVelocityJacobian(itmanipinfo->plink->GetIndex(), _vangularjacobian);
-            probot->CalculateJacobian(itmanipinfo->plink->GetIndex(), tlink.trans, _vtransjacobian);
+            _ComputeJacobians(*itmanipinfo);
 
             // checking for each point is too slow, so use fmaxdistfromcenter instead
             //FOREACH(itpoint,itmanipinfo->checkpoints)
@@ -623,6 +621,22 @@ public:
     }
 
 private:
+    /// \brief computes the translation jacobian of the end-effector origin and the angular velocity jacobian of the end-effector for the current state of the robot
+    void _ComputeJacobians(const ManipConstraintInfo& info)
+    {
+        RobotBasePtr probot = info.pmanip->GetRobot();
+        probot->GetLinkTransformations(_vlinktransforms, _vdoflastsetvalues);
+        const KinBody::JacobianWorkspace& workspace = info.jacobianworkspace;
+        _vmimicpartials.resize(workspace.GetNumMimicColumns()*workspace.GetNumColumns());
+        if( workspace.GetNumMimicColumns() > 0 ) {
+            probot->GetDOFValues(_vfulldofvalues);
+            probot->ComputeJacobianMimicPartials(_vfulldofvalues.data(), workspace, _vmimicpartials.data());
+        }
+        _vtransjacobian.resize(3*workspace.GetNumColumns());
+        _vangularjacobian.resize(3*workspace.GetNumColumns());
+        workspace.ComputeJacobians(_vlinktransforms.data(), _vtransjacobian.data(), _vangularjacobian.data(), _vmimicpartials.data());
+    }
+
     EnvironmentBasePtr _penv;
     std::string _manipname;
     std::vector<KinBodyPtr> listUsedBodies;
@@ -636,6 +650,8 @@ private:
     std::vector<std::pair<Vector,Vector> > endeffvels, endeffaccs;
     std::vector<dReal> _vtransjacobian, _vangularjacobian, _vbestvels2, _vbestaccels2;
     std::vector<dReal> _vdofvalues, _vdofvelocities, _vdofaccelerations;
+    std::vector<dReal> _vfulldofvalues, _vmimicpartials, _vdoflastsetvalues; // full robot DOF
+    std::vector<Transform> _vlinktransforms;
 //@}
 };
 
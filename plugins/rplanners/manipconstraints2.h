@@ -36,6 +36,7 @@ struct ManipConstraintInfo2
     dReal fmaxdistfromcenter; ///< maximum distance from any check point to the EE center
     std::vector<int> vuseddofindices; ///< a vector of unique DOF indices targetted for the body
     std::vector<int> vconfigindices;  ///< for every index in vusedofindices, returns the first configuration space index it came from
+    KinBody::JacobianWorkspace jacobianworkspace; ///< chain of the end-effector for computing its jacobian without setting the robot state
 };
 
 class ManipConstraintChecker2
@@ -170,6 +171,7 @@ public:
                     info.pmanip = pmanip;
                     spec.ExtractUsedIndices(pmanip->GetRobot(), info.vuseddofindices, info.vconfigindices);
                     info.plink = endeffector;
+                    pmanip->GetRobot()->InitJacobianWorkspace(endeffector->GetIndex(), Vector(), std::vector<int>(), info.jacobianworkspace);
                     ConvertAABBtoCheckPoints(enclosingaabb, info.checkpoints);
                     info.fmaxdistfromcenter = 0; // maximum distance between any checkpoints to the end-efffector
                     FOREACH(itpoint, info.checkpoints) {
@@ -478,13 +480,8 @@ public:
 
                     std::list< ManipConstraintInfo2 >::iterator itmanipinfo = _listCheckManips.begin();
                     std::advance(itmanipinfo, accelViolationIndex);
-                    RobotBasePtr probot = itmanipinfo->pmanip->GetRobot();
-                    KinBody::KinBodyStateSaver saver(probot, KinBody::Save_LinkTransformation|KinBody::Save_LinkVelocities);
-                    // Set the robot to the new state
-                    probot->SetDOFValues(vDOFValuesAtViolation, KinBody::CLA_CheckLimits, itmanipinfo->vuseddofindices);
-                    Transform tlink = itmanipinfo->plink->GetTransform();
-                    // compute jacobians, make sure to transform by the world frame
-                    probot->CalculateJacobian(itmanipinfo->plink->GetIndex(), tlink.trans, _vtransjacobian);
+                    // compute jacobians at the violating configuration, they are in the world frame
+                    _ComputeTranslationJacobian(*itmanipinfo, vDOFValuesAtViolation);
                     int armdof = itmanipinfo->pmanip->GetArmDOF();
                     for( int idof = 0; idof < armdof; ++idof ) {
                         Vector vtransaxis(_vtransjacobian[idof], _vtransjacobian[armdof+idof], _vtransjacobian[2*armdof+idof]);
@@ -561,13 +558,8 @@ public:
 
                     std::list< ManipConstraintInfo2 >::iterator itmanipinfo = _listCheckManips.begin();
                     std::advance(itmanipinfo, velViolationIndex);
-                    RobotBasePtr probot = itmanipinfo->pmanip->GetRobot();
-                    KinBody::KinBodyStateSaver saver(probot, KinBody::Save_LinkTransformation|KinBody::Save_LinkVelocities);
-                    // Set the robot to the new state
-                    probot->SetDOFValues(vDOFValuesAtViolation, KinBody::CLA_CheckLimits, itmanipinfo->vuseddofindices);
-                    Transform tlink = itmanipinfo->plink->GetTransform();
-                    // compute jacobians, make sure to transform by the world frame
-                    probot->CalculateJacobian(itmanipinfo->plink->GetIndex(), tlink.trans, _vtransjacobian);
+                    // compute jacobians at the violating configuration, they are in the world frame
+                    _ComputeTranslationJacobian(*itmanipinfo, vDOFValuesAtViolation);
                     int armdof = itmanipinfo->pmanip->GetArmDOF();
                     for( int idof = 0; idof < armdof; ++idof ) {
                         Vector vtransaxis(_vtransjacobian[idof], _vtransjacobian[armdof+idof], _vtransjacobian[2*armdof+idof]);
@@ -760,13 +752,8 @@ public:
 
                 std::list< ManipConstraintInfo2 >::iterator itmanipinfo = _listCheckManips.begin();
                 std::advance(itmanipinfo, accelViolationIndex);
-                RobotBasePtr probot = itmanipinfo->pmanip->GetRobot();
-                KinBody::KinBodyStateSaver saver(probot, KinBody::Save_LinkTransformation|KinBody::Save_LinkVelocities);
-                // Set the robot to the new state
-                probot->SetDOFValues(vDOFValuesAtViolation, KinBody::CLA_CheckLimits, itmanipinfo->vuseddofindices);
-                Transform tlink = itmanipinfo->plink->GetTransform();
-                // compute jacobians, make sure to transform by the world frame
-                probot->CalculateJacobian(itmanipinfo->plink->GetIndex(), tlink.trans, _vtransjacobian);
+                // compute jacobians at the violating configuration, they are in the world frame
+                _ComputeTranslationJacobian(*itmanipinfo, vDOFValuesAtViolation);
                 int armdof = itmanipinfo->pmanip->GetArmDOF();
                 for( int idof = 0; idof < armdof; ++idof ) {
                     Vector vtransaxis(_vtransjacobian[idof], _vtransjacobian[armdof+idof], _vtransjacobian[2*armdof+idof]);
@@ -842,13 +829,8 @@ public:
 
                 std::list< ManipConstraintInfo2 >::iterator itmanipinfo = _listCheckManips.begin();
                 std::advance(itmanipinfo, velViolationIndex);
-                RobotBasePtr probot = itmanipinfo->pmanip->GetRobot();
-                KinBody::KinBodyStateSaver saver(probot, KinBody::Save_LinkTransformation|KinBody::Save_LinkVelocities);
-                // Set the robot to the new state
-                probot->SetDOFValues(vDOFValuesAtViolation, KinBody::CLA_CheckLimits, itmanipinfo->vuseddofindices);
-                Transform tlink = itmanipinfo->plink->GetTransform();
-                // compute jacobians, make sure to transform by the world frame
-                probot->CalculateJacobian(itmanipinfo->plink->GetIndex(), tlink.trans, _vtransjacobian);
+                // compute jacobians at the violating configuration, they are in the world frame
+                _ComputeTranslationJacobian(*itmanipinfo, vDOFValuesAtViolation);
                 int armdof = itmanipinfo->pmanip->GetArmDOF();
                 for( int idof = 0; idof < armdof; ++idof ) {
                     Vector vtransaxis(_vtransjacobian[idof], _vtransjacobian[armdof+idof], _vtransjacobian[2*armdof+idof]);
@@ -944,6 +926,23 @@ public:
     }
 
 private:
+    /// \brief computes the translation jacobian of the end-effector for the values vDOFValues of the dofs info.vuseddofindices into _vtransjacobian without changing the robot state
+    void _ComputeTranslationJacobian(const ManipConstraintInfo2& info, const std::vector<dReal>& vDOFValues)
+    {
+        RobotBasePtr probot = info.pmanip->GetRobot();
+        probot->GetDOFValues(_vfulldofvalues);
+        for(size_t index = 0; index < info.vuseddofindices.size(); ++index) {
+            _vfulldofvalues[info.vuseddofindices[index]] = vDOFValues[index];
+        }
+        _vlinktransforms.resize(probot->GetLinks().size());
+        probot->ComputeLinkTransformations(_vfulldofvalues.data(), _vlinktransforms.data());
+        const KinBody::JacobianWorkspace& workspace = info.jacobianworkspace;
+        _vmimicpartials.resize(workspace.GetNumMimicColumns()*workspace.GetNumColumns());
+        probot->ComputeJacobianMimicPartials(_vfulldofvalues.data(), workspace, _vmimicpartials.data());
+        _vtransjacobian.resize(3*workspace.GetNumColumns());
+        workspace.ComputeJacobians(_vlinktransforms.data(), _vtransjacobian.data(), NULL, _vmimicpartials.data());
+    }
+
     EnvironmentBasePtr _penv;
     std::string _manipname;
     std::vector<KinBodyPtr> listUsedBodies;
@@ -958,6 +957,8 @@ private:
     std::vector<dReal> _vtransjacobian, _vangularjacobian, _vbestvels2, _vbestaccels2;
     std::vector<dReal> _vdotproducts, _vscalingfactors, _vdofvalues, _vdofvelocities, _vdofaccelerations;
     std::vector<int> _vindices;
+    std::vector<dReal> _vfulldofvalues, _vmimicpartials; // full robot DOF
+    std::vector<Transform> _vlinktransforms;
 //@}
 
 };
@@ -36,6 +36,7 @@ struct ManipConstraintInfo3
     dReal fmaxdistfromcenter; ///< maximum distance from any check point to the EE center
     std::vector<int> vuseddofindices; ///< a vector of unique DOF indices targetted for the body
     std::vector<int> vconfigindices;  ///< for every index in vusedofindices, returns the first configuration space index it came from
+    KinBody::JacobianWorkspace jacobianworkspace; ///< chain of the end-effector for computing its jacobians without searching the robot
 };
 
 class ManipConstraintChecker3
@@ -165,6 +166,7 @@ public:
                     info.pmanip = pmanip;
                     spec.ExtractUsedIndices(pmanip->GetRobot(), info.vuseddofindices, info.vconfigindices);
                     info.plink = endeffector;
+                    pmanip->GetRobot()->InitJacobianWorkspace(endeffector->GetIndex(), Vector(), pmanip->GetArmIndices(), info.jacobianworkspace);
                     ConvertAABBtoCheckPoints(enclosingaabb, info.checkpoints);
                     info.fmaxdistfromcenter = 0; // maximum distance between any checkpoints to the end-efffector
                     FOREACH(itpoint, info.checkpoints) {
@@ -213,12 +215,8 @@ public:
         OPENRAVE_ASSERT_OP(vellimits.size(),<,64);
 
         FOREACHC(itmanipinfo,_listCheckManips) {
-            RobotBasePtr probot = itmanipinfo->pmanip->GetRobot();
-            Transform tlink = itmanipinfo->plink->GetTransform();
-
             // compute jacobians, make sure to transform by the world frame
-            probot->CalculateAngularVelocityJacobian(itmanipinfo->plink->GetIndex(), _vangularjacobian);
-            probot->CalculateJacobian(itmanipinfo->plink->GetIndex(), tlink.trans, _vtransjacobian);
+            _ComputeJacobians(*itmanipinfo);
 
             int armdof = itmanipinfo->pmanip->GetArmDOF();
 
@@ -486,6 +484,22 @@ public:
     }
 
 private:
+    /// \brief computes the translation jacobian of the end-effector origin and the angular velocity jacobian of the end-effector for the current state of the robot
+    void _ComputeJacobians(const ManipConstraintInfo3& info)
+    {
+        RobotBasePtr probot = info.pmanip->GetRobot();
+        probot->GetLinkTransformations(_vlinktransforms, _vdoflastsetvalues);
+        const KinBody::JacobianWorkspace& workspace = info.jacobianworkspace;
+        _vmimicpartials.resize(workspace.GetNumMimicColumns()*workspace.GetNumColumns());
+        if( workspace.GetNumMimicColumns() > 0 ) {
+            probot->GetDOFValues(_vfulldofvalues);
+            probot->ComputeJacobianMimicPartials(_vfulldofvalues.data(), workspace, _vmimicpartials.data());
+        }
+        _vtransjacobian.resize(3*workspace.GetNumColumns());
+        _vangularjacobian.resize(3*workspace.GetNumColumns());
+        workspace.ComputeJacobians(_vlinktransforms.data(), _vtransjacobian.data(), _vangularjacobian.data(), _vmimicpartials.data());
+    }
+
     EnvironmentBasePtr _penv;
     int _envId;
     std::string _manipname;
@@ -504,6 +518,8 @@ private:
     Transform _cacheManipTransform;
     std::vector<dReal> _vtransjacobian, _vangularjacobian, _vbestvels2, _vbestaccels2;
     std::vector<dReal> _vdofvalues, _vdofvelocities, _vdofaccelerations;
+    std::vector<dReal> _vfulldofvalues, _vmimicpartials, _vdoflastsetvalues; // full robot DOF
+    std::vector<Transform> _vlinktransforms;
     std::vector<PiecewisePolynomialsInternal::Coordinate> _vcoords1, _vcoords2;
     //@}
 
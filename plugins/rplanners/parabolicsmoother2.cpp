@@ -13,7 +13,10 @@
 // If not, see <http://www.gnu.org/licenses/>.
 #include "openraveplugindefs.h"
 #include <cfloat>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
+#include <thread>
 #include <openrave/planningutils.h>
 
 #include "rampoptimizer/interpolator.h"
@@ -363,8 +366,13 @@ public:
         }
         _environmentid = GetEnv()->GetId();
         _vVisitedDiscretizationCache.resize(0x1000*0x1000,0); // pre-allocate in order to keep memory growth predictable
+        _bShortcutWorker = false;
+        _bShortcutWorkerTryWholePath = false;
         _feasibilitychecker.SetEnvID(_environmentid); // set envid for logging purpose
     }
+    virtual ~ParabolicSmoother2() {
+        _DestroyShortcutWorkers(_vShortcutWorkers);
+    }
 
     virtual bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr params)
     {
@@ -731,7 +739,12 @@ public:
                 }
 #endif
                 shortcutStartTime = utils::GetMicroTime();
-                numShortcuts = _Shortcut(parabolicpath, parameters->_nMaxIterations, this, parameters->_fStepLength*0.99);
+                if( parameters->nshortcutworkers > 1 ) {
+                    numShortcuts = _ShortcutParallel(parabolicpath, parameters->_nMaxIterations, parameters->_fStepLength*0.99);
+                }
+                else {
+                    numShortcuts = _Shortcut(parabolicpath, parameters->_nMaxIterations, this, parameters->_fStepLength*0.99);
+                }
 #ifdef SMOOTHER2_TIMING_DEBUG
                 _tShortcutEnd = utils::GetMicroTime();
 #endif
@@ -1371,6 +1384,18 @@ protected:
         dReal rightneighbor; // the first switch time to the right of this zero-velocity point
     };
 
+    /// \brief A successful shortcut found by a worker of _ShortcutParallel. t0 and t1 are times on
+    /// the path that the worker was given.
+    struct ShortcutCandidate
+    {
+        ShortcutCandidate() : t0(0), t1(0), diff(0), numiters(0) {
+        }
+        dReal t0, t1;  // the time interval that is replaced
+        dReal diff;    // the duration saved by the shortcut
+        std::vector<RampOptimizer::RampND> vrampnds; // the checked rampnds replacing [t0, t1]
+        int numiters;  // the number of shortcut iterations that the worker ran
+    };
+
     /// \brief Time-parameterize the ordered set of waypoints to a trajectory that stops at every
     /// waypoint. _SetMilestones also adds some extra waypoints to the original set if any two
     /// consecutive waypoints are too far apart.
@@ -2435,7 +2460,9 @@ protected:
     int _Shortcut(RampOptimizer::ParabolicPath& parabolicpath, int numIters, RampOptimizer::RandomNumberGeneratorBase* rng, dReal minTimeStep)
     {
         int numShortcuts = 0;
-        _DumpParabolicPath(parabolicpath, _dumplevel, 0);
+        if( !_bShortcutWorker ) {
+            _DumpParabolicPath(parabolicpath, _dumplevel, 0);
+        }
 
 #ifdef SMOOTHER2_PROGRESS_DEBUG
         std::vector<int>& vShortcutStats = _vShortcutStats; // vShortcutStats[SS_X] keeps the number of times a shortcut iter finishes with the status SS_X
@@ -2517,11 +2544,13 @@ protected:
             // Sample t0 and t1. We could possibly add some heuristics here to get higher quality
             // shortcuts
             dReal t0, t1;
-            if( iters == 0 ) {
+            // a shortcut worker only runs a few iterations per round, so it does not count on the last iterations to remove the zerovelpoints
+            const bool bFewItersLeft = !_bShortcutWorker && numIters - iters <= (int)_vZeroVelPointInfos.size();
+            if( iters == 0 && (!_bShortcutWorker || _bShortcutWorkerTryWholePath) ) {
                 t0 = 0;
                 t1 = tTotal;
             }
-            else if( (_vZeroVelPointInfos.size() > 0 && rng->Rand() <= specialShortcutWeight) || (numIters - iters <= (int)_vZeroVelPointInfos.size()) ) {
+            else if( (_vZeroVelPointInfos.size() > 0 && rng->Rand() <= specialShortcutWeight) || bFewItersLeft ) {
                 /* We consider shortcutting around a zerovelpoint (the time instant of an original
                    waypoint which has not yet been shortcut) when there are some zerovelpoints left
                    and either
@@ -2533,7 +2562,7 @@ protected:
                 _SampleTimeAroundCenter(t0, t1,
                                         rng->Rand(), rng->Rand(), tTotal, minTimeStep, tCenter, specialShortcutCutoffTime);
 
-                if( numIters - iters <= (int)_vZeroVelPointInfos.size() ) {
+                if( bFewItersLeft ) {
                     // By the time we reach here, it is likely that these multipliers have been
                     // scaled down to be very small. Try resetting it in hopes that it helps produce
                     // some successful shortcuts.
@@ -3221,6 +3250,20 @@ protected:
                     continue;
                 }
 
+                if( _bShortcutWorker ) {
+                    // Leave the path untouched and let _ShortcutParallel decide whether to commit this shortcut
+                    _workershortcut.t0 = t0;
+                    _workershortcut.t1 = t1;
+                    _workershortcut.diff = t1 - t0;
+                    FOREACHC(itrampnd, shortcutRampNDVectOut) {
+                        _workershortcut.diff -= itrampnd->GetDuration();
+                    }
+                    _workershortcut.vrampnds = shortcutRampNDVectOut;
+                    ++numShortcuts;
+                    ++iters;
+                    break;
+                }
+
                 // Now this shortcut is really successful
                 ++numShortcuts;
 #ifdef SMOOTHER2_PROGRESS_DEBUG
@@ -3238,25 +3281,7 @@ protected:
                     segmentTime += itrampnd->GetDuration();
                 }
                 dReal diff = (t1 - t0) - segmentTime;
-
-                size_t writeIndex = 0;
-                for( size_t readIndex = 0; readIndex < _vZeroVelPointInfos.size(); ++readIndex ) {
-                    if( _vZeroVelPointInfos[readIndex].point <= t0 ) {
-                        writeIndex += 1;
-                    }
-                    else if( _vZeroVelPointInfos[readIndex].point <= t1 ) {
-                        // Do nothing.
-                    }
-                    else {
-                        // Update all zero-velocity points after t1
-                        _vZeroVelPointInfos[writeIndex] = _vZeroVelPointInfos[readIndex];
-                        _vZeroVelPointInfos[writeIndex].point -= diff;
-                        _vZeroVelPointInfos[writeIndex].leftneighbor -= diff;
-                        _vZeroVelPointInfos[writeIndex].rightneighbor -= diff;
-                        writeIndex += 1;
-                    }
-                }
-                _vZeroVelPointInfos.resize(writeIndex);
+                _UpdateZeroVelPointInfos(t0, t1, diff);
 
                 // Now replace the original trajectory segment by the shortcut
                 parabolicpath.ReplaceSegment(t0, t1, shortcutRampNDVectOut);
@@ -3303,6 +3328,11 @@ protected:
             }
         }
 
+        if( _bShortcutWorker ) {
+            _workershortcut.numiters = iters;
+            return numShortcuts;
+        }
+
         // Report status
         if( iters == numIters ) {
             RAVELOG_DEBUG_FORMAT("env=%d, finished at shortcut iter=%d (normal exit), successful=%d, slowdowns=%d, endTime: %.15e -> %.15e; diff = %.15e", _environmentid%iters%numShortcuts%numSlowDowns%tOriginal%tTotal%(tOriginal - tTotal));
@@ -3334,6 +3364,352 @@ protected:
         return numShortcuts;
     }
 
+    /// \brief Removes the zero-velocity points inside [t0, t1] and moves the ones after t1 earlier
+    /// by diff, the duration saved by shortcutting [t0, t1].
+    void _UpdateZeroVelPointInfos(dReal t0, dReal t1, dReal diff)
+    {
+        size_t writeIndex = 0;
+        for( size_t readIndex = 0; readIndex < _vZeroVelPointInfos.size(); ++readIndex ) {
+            if( _vZeroVelPointInfos[readIndex].point <= t0 ) {
+                writeIndex += 1;
+            }
+            else if( _vZeroVelPointInfos[readIndex].point <= t1 ) {
+                // Do nothing.
+            }
+            else {
+                // Update all zero-velocity points after t1
+                _vZeroVelPointInfos[writeIndex] = _vZeroVelPointInfos[readIndex];
+                _vZeroVelPointInfos[writeIndex].point -= diff;
+                _vZeroVelPointInfos[writeIndex].leftneighbor -= diff;
+                _vZeroVelPointInfos[writeIndex].rightneighbor -= diff;
+                writeIndex += 1;
+            }
+        }
+        _vZeroVelPointInfos.resize(writeIndex);
+    }
+
+    /// \brief a smoother running shortcut iterations on its own clone of the environment
+    struct ShortcutWorker
+    {
+        ShortcutWorker() : numshortcuts(0), numiters(0) {
+        }
+        EnvironmentBasePtr penv;
+        boost::shared_ptr<ParabolicSmoother2> smoother;
+        RampOptimizer::ParabolicPath parabolicpath; ///< copy of the path at the beginning of the round
+        int numshortcuts; ///< 1 if smoother->_workershortcut holds a successful shortcut, -1 if interrupted
+        int numiters; ///< max number of shortcut iterations of the round
+        boost::shared_ptr<std::thread> thread; ///< runs the rounds of the worker during _ShortcutParallel
+    };
+    typedef boost::shared_ptr<ShortcutWorker> ShortcutWorkerPtr;
+
+    /// \brief synchronizes the worker threads of _ShortcutParallel with its rounds
+    struct ShortcutRoundState
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        int round = 0; ///< incremented by _ShortcutParallel to start a round
+        int numfinished = 0; ///< number of workers that finished the current round
+        bool bStop = false; ///< if true, the worker threads exit
+        dReal minTimeStep = 0;
+    };
+    typedef boost::shared_ptr<ShortcutRoundState> ShortcutRoundStatePtr;
+
+    /// \brief Shortcuts parabolicpath with _parameters->nshortcutworkers smoothers, each on its own clone
+    /// of the environment.
+    ///
+    /// Shortcutting proceeds in rounds. In every round, each worker gets a copy of the current path
+    /// and runs shortcut iterations with its own seed until it finds one successful shortcut. The
+    /// shortcuts are then committed from the one saving the most time, skipping the ones that
+    /// overlap an already committed shortcut. Since they are replaced starting from the latest one,
+    /// the boundary conditions that every worker checked against are still those of the path.
+    ///
+    /// The workers rebuild their parameters from the configuration specification, so every shortcut
+    /// is checked again with the constraints of _parameters before it is committed. The worker
+    /// threads are started once per call and the cloned environments are kept between calls.
+    ///
+    /// \return the number of committed shortcuts, -1 if interrupted
+    int _ShortcutParallel(RampOptimizer::ParabolicPath& parabolicpath, int numIters, dReal minTimeStep)
+    {
+        const int numworkers = _parameters->nshortcutworkers;
+        if( !_InitShortcutWorkers(numworkers) ) {
+            RAVELOG_WARN_FORMAT("env=%d, failed to initialize the shortcut workers, so shortcutting with one thread", _environmentid);
+            return _Shortcut(parabolicpath, numIters, this, minTimeStep);
+        }
+        std::vector<ShortcutWorkerPtr>& vworkers = _vShortcutWorkers;
+        ShortcutRoundStatePtr pstate(new ShortcutRoundState());
+        pstate->minTimeStep = minTimeStep;
+
+        _DumpParabolicPath(parabolicpath, _dumplevel, 0);
+        const dReal tOriginal = parabolicpath.GetDuration();
+        // each round should only take a small part of the iterations so that the workers start from a recent path
+        const int numItersPerRound = max(1, numIters/(4*numworkers));
+        const int nCutoffIters = std::max(_parameters->nshortcutcycles, min(100, numIters/2)); // same as in _Shortcut
+        const dReal cutoffRatio = _parameters->durationImprovementCutoffRatio;
+        int numShortcuts = 0, numRounds = 0, iters = 0, nItersFromPrevSuccessful = 0;
+        dReal currentBestScore = 0;
+        bool bInterrupted = false;
+        std::vector<size_t> vcandidateindices, vcommittedindices;
+        std::vector<RampOptimizer::RampND>& vcheckedrampnds = _cacheRampNDVectOut;
+        try {
+            for(int iworker = 0; iworker < numworkers; ++iworker) {
+                vworkers[iworker]->thread = boost::make_shared<std::thread>(std::bind(&ParabolicSmoother2::_ShortcutWorkerThread, vworkers[iworker], iworker, pstate));
+            }
+
+            while( iters < numIters ) {
+                if( parabolicpath.GetDuration() < minTimeStep || nItersFromPrevSuccessful > nCutoffIters ) {
+                    break;
+                }
+                if( _CallCallbacks(_progress) == PA_Interrupt ) {
+                    bInterrupted = true;
+                    break;
+                }
+                if( _parameters->_nMaxPlanningTime > 0 ) {
+                    uint32_t elapsedtime = utils::GetMilliTime() - _basetime;
+                    if( elapsedtime >= _parameters->_nMaxPlanningTime ) {
+                        RAVELOG_DEBUG_FORMAT("env=%d, shortcut time exceeded (%dms) so breaking. iter=%d < %d", _environmentid%elapsedtime%iters%numIters);
+                        break;
+                    }
+                }
+
+                for(int iworker = 0; iworker < numworkers; ++iworker) {
+                    ShortcutWorker& worker = *vworkers[iworker];
+                    worker.parabolicpath = parabolicpath;
+                    worker.numiters = min(numItersPerRound, numIters - iters);
+                    worker.smoother->_vZeroVelPointInfos = _vZeroVelPointInfos;
+                    // only one worker needs to try shortcutting the whole path
+                    worker.smoother->_bShortcutWorkerTryWholePath = numRounds == 0 && iworker == 0;
+                }
+                {
+                    std::unique_lock<std::mutex> statelock(pstate->mutex);
+                    pstate->numfinished = 0;
+                    ++pstate->round;
+                    pstate->condition.notify_all();
+                    while( pstate->numfinished < numworkers ) {
+                        pstate->condition.wait(statelock);
+                    }
+                }
+                ++numRounds;
+
+                int numRoundIters = 0;
+                vcandidateindices.resize(0);
+                for(int iworker = 0; iworker < numworkers; ++iworker) {
+                    const ShortcutWorker& worker = *vworkers[iworker];
+                    numRoundIters += worker.smoother->_workershortcut.numiters;
+                    if( worker.numshortcuts < 0 ) {
+                        bInterrupted = true;
+                    }
+                    else if( worker.numshortcuts > 0 ) {
+                        vcandidateindices.push_back(iworker);
+                    }
+                }
+                iters += numRoundIters;
+                _progress._iteration += numRoundIters;
+                if( bInterrupted ) {
+                    break;
+                }
+
+                // Commit the best shortcuts that do not overlap
+                std::sort(vcandidateindices.begin(), vcandidateindices.end(), [&vworkers](size_t index0, size_t index1) {
+                    return vworkers[index0]->smoother->_workershortcut.diff > vworkers[index1]->smoother->_workershortcut.diff;
+                });
+                vcommittedindices.resize(0);
+                FOREACHC(itindex, vcandidateindices) {
+                    const ShortcutCandidate& candidate = vworkers[*itindex]->smoother->_workershortcut;
+                    bool bOverlap = false;
+                    FOREACHC(itcommitted, vcommittedindices) {
+                        const ShortcutCandidate& committed = vworkers[*itcommitted]->smoother->_workershortcut;
+                        if( candidate.t1 >= committed.t0 && candidate.t0 <= committed.t1 ) {
+                            bOverlap = true;
+                            break;
+                        }
+                    }
+                    if( !bOverlap ) {
+                        vcommittedindices.push_back(*itindex);
+                    }
+                }
+
+                std::sort(vcommittedindices.begin(), vcommittedindices.end(), [&vworkers](size_t index0, size_t index1) {
+                    return vworkers[index0]->smoother->_workershortcut.t0 > vworkers[index1]->smoother->_workershortcut.t0;
+                });
+                dReal diff = 0;
+                int numRoundShortcuts = 0;
+                FOREACHC(itindex, vcommittedindices) {
+                    const ShortcutCandidate& committed = vworkers[*itindex]->smoother->_workershortcut;
+                    // The worker checked the shortcut with the constraints rebuilt in its environment, so check it with the ones of _parameters
+                    RampOptimizer::CheckReturn retcheck = _feasibilitychecker.Check2(committed.vrampnds, 0xffff|CFO_FromTrajectorySmoother, vcheckedrampnds);
+                    if( retcheck.retcode != 0 || vcheckedrampnds.size() == 0 ) {
+                        RAVELOG_DEBUG_FORMAT("env=%d, shortcut [%.15e, %.15e] of worker %d fails the constraints of the parameters with 0x%x, so skipping it", _environmentid%committed.t0%committed.t1%(*itindex)%retcheck.retcode);
+                        continue;
+                    }
+                    dReal committeddiff = committed.t1 - committed.t0;
+                    FOREACHC(itrampnd, vcheckedrampnds) {
+                        committeddiff -= itrampnd->GetDuration();
+                    }
+                    if( committeddiff <= 0 ) {
+                        continue;
+                    }
+                    _UpdateZeroVelPointInfos(committed.t0, committed.t1, committeddiff);
+                    parabolicpath.ReplaceSegment(committed.t0, committed.t1, vcheckedrampnds);
+                    diff += committeddiff;
+                    ++numRoundShortcuts;
+                }
+                if( numRoundShortcuts == 0 ) {
+                    nItersFromPrevSuccessful += numRoundIters;
+                    continue;
+                }
+                numShortcuts += numRoundShortcuts;
+
+                // Check consistency
+                if( IS_DEBUGLEVEL(Level_Verbose) ) {
+                    std::vector<dReal>& x0Vect = _cacheX0Vect, &x1Vect = _cacheX1Vect, &v0Vect = _cacheV0Vect, &v1Vect = _cacheV1Vect;
+                    const std::vector<RampOptimizer::RampND>& rampndVect = parabolicpath.GetRampNDVect();
+                    rampndVect.front().GetX0Vect(x0Vect);
+                    rampndVect.back().GetX1Vect(x1Vect);
+                    rampndVect.front().GetV0Vect(v0Vect);
+                    rampndVect.back().GetV1Vect(v1Vect);
+                    RampOptimizer::ParabolicCheckReturn parabolicret = RampOptimizer::CheckRampNDs(rampndVect, _parameters->_vConfigLowerLimit, _parameters->_vConfigUpperLimit, _parameters->_vConfigVelocityLimit, _parameters->_vConfigAccelerationLimit, x0Vect, x1Vect, v0Vect, v1Vect);
+                    OPENRAVE_ASSERT_OP(parabolicret, ==, RampOptimizer::PCR_Normal);
+                }
+
+                dReal score = diff/(nItersFromPrevSuccessful + numRoundIters);
+                nItersFromPrevSuccessful = 0;
+                RAVELOG_DEBUG_FORMAT("env=%d, shortcut round=%d, iter=%d/%d committed %d/%d shortcuts, tTotal=%.15e, score=%.15e, bestScore=%.15e", _environmentid%numRounds%iters%numIters%numRoundShortcuts%vcandidateindices.size()%parabolicpath.GetDuration()%score%currentBestScore);
+                if( score > currentBestScore ) {
+                    currentBestScore = score;
+                }
+                else if( score < cutoffRatio*currentBestScore && numShortcuts > 5 ) {
+                    break;
+                }
+            }
+        }
+        catch(...) {
+            _StopShortcutWorkerThreads(vworkers, pstate);
+            throw;
+        }
+        _StopShortcutWorkerThreads(vworkers, pstate);
+        if( bInterrupted ) {
+            return -1;
+        }
+
+        const dReal tTotal = parabolicpath.GetDuration();
+        RAVELOG_DEBUG_FORMAT("env=%d, finished shortcutting with %d workers in %d rounds, iters=%d, successful=%d, endTime: %.15e -> %.15e; diff = %.15e", _environmentid%numworkers%numRounds%iters%numShortcuts%tOriginal%tTotal%(tOriginal - tTotal));
+        _DumpParabolicPath(parabolicpath, _dumplevel, 1);
+        return numShortcuts;
+    }
+
+    /// \brief brings numworkers shortcut workers up to date with the environment and initializes their smoothers with _parameters
+    ///
+    /// The cloned environments are kept between calls and updated with EnvironmentBase::UpdateFromClone.
+    bool _InitShortcutWorkers(int numworkers)
+    {
+        EnvironmentLock lock(GetEnv()->GetMutex());
+        while( (int)_vShortcutWorkers.size() > numworkers ) {
+            std::vector<ShortcutWorkerPtr> vremoved(1, _vShortcutWorkers.back());
+            _vShortcutWorkers.pop_back();
+            _DestroyShortcutWorkers(vremoved);
+        }
+        for(int iworker = 0; iworker < numworkers; ++iworker) {
+            if( iworker >= (int)_vShortcutWorkers.size() ) {
+                ShortcutWorkerPtr pworker(new ShortcutWorker());
+                pworker->penv = GetEnv()->CloneSelf(Clone_Bodies);
+                _vShortcutWorkers.push_back(pworker);
+            }
+            else {
+                _vShortcutWorkers[iworker]->penv->UpdateFromClone(GetEnv(), Clone_Bodies);
+            }
+            ShortcutWorkerPtr pworker = _vShortcutWorkers[iworker];
+
+            EnvironmentLock workerlock(pworker->penv->GetMutex());
+            ConstraintTrajectoryTimingParametersPtr parameters(new ConstraintTrajectoryTimingParameters());
+            parameters->copy(_parameters);
+            parameters->SetConfigurationSpecification(pworker->penv, _parameters->_configurationspecification);
+            // SetConfigurationSpecification resets the limits from the bodies, so restore the ones the path is timed with
+            parameters->_vConfigLowerLimit = _parameters->_vConfigLowerLimit;
+            parameters->_vConfigUpperLimit = _parameters->_vConfigUpperLimit;
+            parameters->_vConfigVelocityLimit = _parameters->_vConfigVelocityLimit;
+            parameters->_vConfigAccelerationLimit = _parameters->_vConfigAccelerationLimit;
+            parameters->_vConfigJerkLimit = _parameters->_vConfigJerkLimit;
+            parameters->_vConfigResolution = _parameters->_vConfigResolution;
+            parameters->_nRandomGeneratorSeed = _parameters->_nRandomGeneratorSeed + iworker + 1;
+            parameters->nshortcutworkers = 1;
+            parameters->_sPostProcessingPlanner.clear();
+
+            if( !pworker->smoother ) {
+                pworker->smoother = boost::dynamic_pointer_cast<ParabolicSmoother2>(RaveCreatePlanner(pworker->penv, GetXMLId()));
+                if( !pworker->smoother ) {
+                    return false;
+                }
+            }
+            if( !pworker->smoother->InitPlan(RobotBasePtr(), parameters) ) {
+                RAVELOG_WARN_FORMAT("env=%d, failed to initialize shortcut worker %d", _environmentid%iworker);
+                return false;
+            }
+            ParabolicSmoother2& smoother = *pworker->smoother;
+            smoother._bShortcutWorker = true;
+            smoother._bUsePerturbation = _bUsePerturbation;
+            smoother._feasibilitychecker.tol = _feasibilitychecker.tol;
+            smoother._basetime = _basetime;
+        }
+        return true;
+    }
+
+    /// \brief runs one round of shortcut iterations each time pstate->round is incremented until pstate->bStop is set
+    static void _ShortcutWorkerThread(ShortcutWorkerPtr pworker, int iworker, ShortcutRoundStatePtr pstate)
+    {
+        ParabolicSmoother2& smoother = *pworker->smoother;
+        int round = 0;
+        while( true ) {
+            {
+                std::unique_lock<std::mutex> statelock(pstate->mutex);
+                while( !pstate->bStop && pstate->round == round ) {
+                    pstate->condition.wait(statelock);
+                }
+                if( pstate->bStop ) {
+                    return;
+                }
+                round = pstate->round;
+            }
+
+            smoother._workershortcut.numiters = 0;
+            try {
+                EnvironmentLock lock(pworker->penv->GetMutex());
+                pworker->numshortcuts = smoother._Shortcut(pworker->parabolicpath, pworker->numiters, &smoother, pstate->minTimeStep);
+            }
+            catch(const std::exception& ex) {
+                RAVELOG_WARN_FORMAT("env=%d, shortcut worker %d failed: %s", smoother._environmentid%iworker%ex.what());
+                pworker->numshortcuts = 0;
+            }
+
+            std::lock_guard<std::mutex> statelock(pstate->mutex);
+            ++pstate->numfinished;
+            pstate->condition.notify_all();
+        }
+    }
+
+    static void _StopShortcutWorkerThreads(std::vector<ShortcutWorkerPtr>& vworkers, ShortcutRoundStatePtr pstate)
+    {
+        {
+            std::lock_guard<std::mutex> statelock(pstate->mutex);
+            pstate->bStop = true;
+            pstate->condition.notify_all();
+        }
+        FOREACH(itworker, vworkers) {
+            if( !!(*itworker)->thread ) {
+                (*itworker)->thread->join();
+                (*itworker)->thread.reset();
+            }
+        }
+    }
+
+    static void _DestroyShortcutWorkers(std::vector<ShortcutWorkerPtr>& vworkers)
+    {
+        FOREACH(itworker, vworkers) {
+            (*itworker)->smoother.reset();
+            (*itworker)->penv->Destroy();
+        }
+        vworkers.clear();
+    }
+
     /// \brief dump ParabolicPath.
     /// \param[in] parabolicpath : parabolicpath to dump
     /// \param[in] level : debug level
@@ -3593,6 +3969,12 @@ protected:
 
     bool _bUseNewHeuristic;
 
+    // for _ShortcutParallel
+    bool _bShortcutWorker; ///< if true, _Shortcut stops at the first successful shortcut and stores it in _workershortcut instead of modifying the path
+    bool _bShortcutWorkerTryWholePath; ///< if true, the first iteration of a shortcut worker tries to shortcut the whole path
+    ShortcutCandidate _workershortcut;
+    std::vector<ShortcutWorkerPtr> _vShortcutWorkers; ///< workers of _ShortcutParallel, their environments are kept between calls
+
     std::stringstream _sslog; // for logging purpose
 
 }; // end class ParabolicSmoother2
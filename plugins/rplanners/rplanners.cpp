@@ -22,6 +22,7 @@
 OpenRAVE::PlannerBasePtr CreateShortcutLinearPlanner(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput);
 //OpenRAVE::PlannerBasePtr CreateGraspGradientPlanner(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput);
 OpenRAVE::PlannerBasePtr CreateRandomizedAStarPlanner(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput);
+OpenRAVE::PlannerBasePtr CreateLazyPrmPlanner(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput);
 OpenRAVE::PlannerBasePtr CreateWorkspaceTrajectoryTracker(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput);
 OpenRAVE::PlannerBasePtr CreateLinearSmoother(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput);
 OpenRAVE::PlannerBasePtr CreateConstraintParabolicSmoother(OpenRAVE::EnvironmentBasePtr penv, std::istream& sinput);
@@ -47,6 +48,7 @@ RPlannersPlugin::RPlannersPlugin()
     _interfaces[PT_Planner].push_back("BiRRT");
     _interfaces[PT_Planner].push_back("BasicRRT");
     _interfaces[PT_Planner].push_back("ExplorationRRT");
+    _interfaces[PT_Planner].push_back("LazyPRM");
     _interfaces[PT_Planner].push_back("GraspGradient");
     _interfaces[PT_Planner].push_back("shortcut_linear");
     _interfaces[PT_Planner].push_back("LinearTrajectoryRetimer");
@@ -86,6 +88,9 @@ OpenRAVE::InterfaceBasePtr RPlannersPlugin::CreateInterface(OpenRAVE::InterfaceT
         else if( interfacename == "explorationrrt" ) {
             return boost::make_shared<ExplorationPlanner>(penv);
         }
+        else if( interfacename == "lazyprm" ) {
+            return CreateLazyPrmPlanner(penv,sinput);
+        }
         //else if( interfacename == "graspgradient" ) {
         //    return CreateGraspGradientPlanner(penv,sinput);
         //}
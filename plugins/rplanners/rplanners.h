@@ -96,6 +96,7 @@ public:
     }
 
     SimpleNode* rrtparent; ///< pointer to the RRT tree parent
+    std::vector<SimpleNode*> _vrrtchildren; ///< the nodes in the cache tree whose rrtparent is this node, so that the RRT subtree of a node can be visited without searching all the nodes
     std::vector<SimpleNode*> _vchildren; ///< cache tree direct children of this node (for the next cache level down). Has nothing to do with the RRT tree.
     int16_t _level; ///< the level the node belongs to
     uint8_t _hasselfchild; ///< if 1, then _vchildren has contains a clone of this node in the level below it.
@@ -179,6 +180,7 @@ public:
         }
         _planner = planner;
         _distmetricfn = distmetricfn;
+        _vdistmetricweights2.resize(0);
         _fStepLength = fStepLength;
         _dof = dof;
         _vNewConfig.resize(dof);
@@ -214,19 +216,54 @@ public:
         _numnodes = 0;
     }
 
+    /// \brief sets the squared weights of the weighted euclidean distance that the distance metric given to Init computes, so that distances are computed without calling the metric. Has to be called after Init.
+    ///
+    /// \param vweights2 the weights filled by PlannerParameters::GetDistMetricWeights2
+    void SetDistMetricWeights2(const std::vector<dReal>& vweights2)
+    {
+        OPENRAVE_ASSERT_OP((int)vweights2.size(),==,_dof);
+        _vdistmetricweights2 = vweights2;
+    }
+
     inline dReal _ComputeDistance(const dReal* config0, const dReal* config1) const
     {
+        if( _vdistmetricweights2.size() > 0 ) {
+            return _ComputeWeightedDistance(config0, config1);
+        }
         return _distmetricfn(VectorWrapper<dReal>(config0, config0+_dof), VectorWrapper<dReal>(config1, config1+_dof));
     }
 
     inline dReal _ComputeDistance(const dReal* config0, const std::vector<dReal>& config1) const
     {
+        if( _vdistmetricweights2.size() > 0 ) {
+            return _ComputeWeightedDistance(config0, config1.data());
+        }
         return _distmetricfn(VectorWrapper<dReal>(config0,config0+_dof), config1);
     }
 
     inline dReal _ComputeDistance(NodePtr node0, NodePtr node1) const
     {
-        return _distmetricfn(VectorWrapper<dReal>(node0->q, &node0->q[_dof]), VectorWrapper<dReal>(node1->q, &node1->q[_dof]));
+        return _ComputeDistance(node0->q, node1->q);
+    }
+
+    /// \brief weighted euclidean distance with _vdistmetricweights2. Accumulates four independent sums so that the compiler can vectorize the loop.
+    inline dReal _ComputeWeightedDistance(const dReal* config0, const dReal* config1) const
+    {
+        const dReal* pweights2 = _vdistmetricweights2.data();
+        dReal sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+        int i = 0;
+        for(; i+4 <= _dof; i += 4) {
+            const dReal f0 = config0[i]-config1[i], f1 = config0[i+1]-config1[i+1], f2 = config0[i+2]-config1[i+2], f3 = config0[i+3]-config1[i+3];
+            sum0 += pweights2[i]*f0*f0;
+            sum1 += pweights2[i+1]*f1*f1;
+            sum2 += pweights2[i+2]*f2*f2;
+            sum3 += pweights2[i+3]*f3*f3;
+        }
+        for(; i < _dof; ++i) {
+            const dReal f = config0[i]-config1[i];
+            sum0 += pweights2[i]*f*f;
+        }
+        return RaveSqrt((sum0+sum1)+(sum2+sum3));
     }
 
     std::pair<NodeBasePtr, dReal> FindNearestNode(const std::vector<dReal>& vquerystate) const
@@ -234,6 +271,65 @@ public:
         return _FindNearestNode(vquerystate);
     }
 
+    /// \brief finds the k nearest nodes to a configuration, skipping the invalidated nodes
+    ///
+    /// Same traversal as FindNearestNode except that a level only keeps the nodes that can have a descendant closer than the current k-th nearest node.
+    /// \param[out] vnearest at most k nodes sorted by increasing distance
+    void FindNearestNodes(const std::vector<dReal>& vquerystate, int k, std::vector< std::pair<NodePtr, dReal> >& vnearest) const
+    {
+        vnearest.resize(0);
+        if( _numnodes == 0 || k <= 0 ) {
+            return;
+        }
+        OPENRAVE_ASSERT_OP((int)vquerystate.size(),==,_dof);
+
+        // vnearest is a max heap on the distance until the search is done
+        const auto comparedist = [](const std::pair<NodePtr, dReal>& p0, const std::pair<NodePtr, dReal>& p1) {
+                                     return p0.second < p1.second;
+                                 };
+        const auto addnode = [&](NodePtr node, dReal dist) {
+                                 // a node with a self child is found again as its clone in the level below
+                                 if( !node->_usenn || node->_hasselfchild ) {
+                                     return;
+                                 }
+                                 if( (int)vnearest.size() < k ) {
+                                     vnearest.emplace_back(node, dist);
+                                     std::push_heap(vnearest.begin(), vnearest.end(), comparedist);
+                                 }
+                                 else if( dist < vnearest.front().second ) {
+                                     std::pop_heap(vnearest.begin(), vnearest.end(), comparedist);
+                                     vnearest.back() = std::make_pair(node, dist);
+                                     std::push_heap(vnearest.begin(), vnearest.end(), comparedist);
+                                 }
+                             };
+
+        dReal fLevelBound = _fMaxLevelBound;
+        _vCurrentLevelNodes.resize(1);
+        _vCurrentLevelNodes[0].first = *_vsetLevelNodes.at(_EncodeLevel(_maxlevel)).begin();
+        _vCurrentLevelNodes[0].second = _ComputeDistance(_vCurrentLevelNodes[0].first->q, vquerystate);
+        addnode(_vCurrentLevelNodes[0].first, _vCurrentLevelNodes[0].second);
+        while(_vCurrentLevelNodes.size() > 0 ) {
+            _vNextLevelNodes.resize(0);
+            FOREACH(itcurrentnode, _vCurrentLevelNodes) {
+                FOREACHC(itchild, itcurrentnode->first->_vchildren) {
+                    dReal curdist = _ComputeDistance((*itchild)->q, vquerystate);
+                    addnode(*itchild, curdist);
+                    _vNextLevelNodes.emplace_back(*itchild, curdist);
+                }
+            }
+
+            _vCurrentLevelNodes.resize(0);
+            dReal ftestbound = ((int)vnearest.size() < k ? std::numeric_limits<dReal>::infinity() : vnearest.front().second) + fLevelBound;
+            FOREACH(itnode, _vNextLevelNodes) {
+                if( itnode->second < ftestbound ) {
+                    _vCurrentLevelNodes.push_back(*itnode);
+                }
+            }
+            fLevelBound *= _fBaseInv;
+        }
+        std::sort_heap(vnearest.begin(), vnearest.end(), comparedist);
+    }
+
     virtual NodeBasePtr InsertNode(NodeBasePtr parent, const vector<dReal>& config, uint32_t userdata)
     {
         return _InsertNode((NodePtr)parent, config, userdata);
@@ -243,24 +339,9 @@ public:
     {
         //BOOST_ASSERT(Validate());
         uint64_t starttime = utils::GetNanoPerformanceTime();
-        // first gather all the nodes, and then delete them in reverse order they were originally added in
-        NodePtr parent = (NodePtr)parentbase;
-        parent->_usenn = 0;
-        _setchildcache.clear(); _setchildcache.insert(parent);
-        int numruns=0;
-        bool bchanged=true;
-        while(bchanged) {
-            bchanged=false;
-            FOREACHC(itchildren, _vsetLevelNodes) {
-                FOREACHC(itchild, *itchildren) {
-                    if( _setchildcache.find(*itchild) == _setchildcache.end() && _setchildcache.find((*itchild)->rrtparent) != _setchildcache.end() ) {
-                        (*itchild)->_usenn = 0;
-                        _setchildcache.insert(*itchild);
-                        bchanged=true;
-                    }
-                }
-            }
-            ++numruns;
+        _GatherRRTSubtree((NodePtr)parentbase, _vchildcache);
+        FOREACH(itnode, _vchildcache) {
+            (*itnode)->_usenn = 0;
         }
         RAVELOG_VERBOSE("computed in %fs", (1e-9*(utils::GetNanoPerformanceTime()-starttime)));
     }
@@ -271,28 +352,7 @@ public:
         BOOST_ASSERT(Validate());
         uint64_t starttime = utils::GetNanoPerformanceTime();
         // first gather all the nodes, and then delete them in reverse order they were originally added in
-        NodePtr parent = (NodePtr)parentbase;
-        if( _vchildcache.capacity() == 0 ) {
-            _vchildcache.reserve(128);
-        }
-        _vchildcache.resize(0); _vchildcache.push_back(parent);
-        _setchildcache.clear(); _setchildcache.insert(parent);
-        int numruns=0;
-        bool bchanged=true;
-        while(bchanged) {
-            bchanged=false;
-            FOREACHC(itchildren, _vsetLevelNodes) {
-                FOREACHC(itchild, *itchildren) {
-                    if( _setchildcache.find(*itchild) == _setchildcache.end() && _setchildcache.find((*itchild)->rrtparent) != _setchildcache.end() ) {
-                        //if( !std::binary_search(_vchildcache.begin(),_vchildcache.end(),(*itchild)->rrtparent) ) {
-                        _vchildcache.push_back(*itchild);
-                        _setchildcache.insert(*itchild);
-                        bchanged=true;
-                    }
-                }
-            }
-            ++numruns;
-        }
+        _GatherRRTSubtree((NodePtr)parentbase, _vchildcache);
 
         int nremove=0;
         // systematically remove backwards
@@ -305,6 +365,20 @@ public:
         RAVELOG_VERBOSE("computed in %fs", (1e-9*(utils::GetNanoPerformanceTime()-starttime)));
     }
 
+    /// \brief gathers parent and all the nodes descending from it in the RRT, parents before their children
+    void _GatherRRTSubtree(NodePtr parent, std::vector<NodePtr>& vnodes) const
+    {
+        if( vnodes.capacity() == 0 ) {
+            vnodes.reserve(128);
+        }
+        vnodes.resize(0);
+        vnodes.push_back(parent);
+        for(size_t inode = 0; inode < vnodes.size(); ++inode) {
+            const std::vector<NodePtr>& vrrtchildren = vnodes[inode]->_vrrtchildren;
+            vnodes.insert(vnodes.end(), vrrtchildren.begin(), vrrtchildren.end());
+        }
+    }
+
     virtual ExtendType Extend(const vector<dReal>& vTargetConfig, NodeBasePtr& lastnode, bool bOneStep=false, int constraintFilterOptions=0xffff|CFO_FillCheckedConfiguration)
     {
         // get the nearest neighbor
@@ -635,6 +709,9 @@ private:
         void* pmemory = _pNodesPool->malloc();
         NodePtr node = new (pmemory) Node(refnode->rrtparent, refnode->q, _dof);
         node->_userdata = refnode->_userdata;
+        if( !!node->rrtparent ) {
+            node->rrtparent->_vrrtchildren.push_back(node);
+        }
 #ifdef _DEBUG
         node->id = GetNewStaticId();
 #endif
@@ -644,6 +721,14 @@ private:
     void _DeleteNode(Node* p)
     {
         if( !!p ) {
+            if( !!p->rrtparent ) {
+                std::vector<NodePtr>& vrrtchildren = p->rrtparent->_vrrtchildren;
+                typename std::vector<NodePtr>::iterator it = std::find(vrrtchildren.begin(), vrrtchildren.end(), p);
+                if( it != vrrtchildren.end() ) {
+                    *it = vrrtchildren.back();
+                    vrrtchildren.pop_back();
+                }
+            }
             p->~Node();
             _pNodesPool->free(p);
         }
@@ -735,6 +820,9 @@ private:
                 return NodePtr();
             }
         }
+        if( !!parent ) {
+            parent->_vrrtchildren.push_back(newnode);
+        }
         //BOOST_ASSERT(Validate());
         return newnode;
     }
@@ -1050,6 +1138,7 @@ private:
 
 
     boost::function<dReal(const std::vector<dReal>&, const std::vector<dReal>&)> _distmetricfn;
+    std::vector<dReal> _vdistmetricweights2; ///< if not empty, _distmetricfn is the weighted euclidean distance with these squared weights and is not called
     boost::weak_ptr<PlannerBase> _planner;
     dReal _fStepLength;
     int _dof; ///< the number of values of each state
@@ -1070,7 +1159,6 @@ private:
 
     // cache
     vector<NodePtr> _vchildcache;
-    set<NodePtr> _setchildcache;
     vector<dReal> _vNewConfig, _vDeltaConfig, _vCurConfig;
     mutable vector<dReal> _vTempConfig;
     ConstraintFilterReturnPtr _constraintreturn;
@@ -18,6 +18,11 @@
 
 #include "rplanners.h"
 #include <boost/algorithm/string.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 static const dReal g_fEpsilonDotProduct = RavePow(g_fEpsilon,0.8);
 
@@ -69,6 +74,10 @@ Uses the Rapidly-Exploring Random Trees Algorithm.\n\
         _sampleConfig.resize(params->GetDOF());
         // TODO perhaps distmetricfn should take into number of revolutions of circular joints
         _treeForward.Init(shared_planner(), params->GetDOF(), params->_distmetricfn, params->_fStepLength, params->_distmetricfn(params->_vConfigLowerLimit, params->_vConfigUpperLimit));
+        std::vector<dReal> vdistmetricweights2;
+        if( params->GetDistMetricWeights2(vdistmetricweights2) ) {
+            _treeForward.SetDistMetricWeights2(vdistmetricweights2);
+        }
         std::vector<dReal> vinitialconfig(params->GetDOF());
         for(size_t index = 0; index < params->vinitialconfig.size(); index += params->GetDOF()) {
             std::copy(params->vinitialconfig.begin()+index,params->vinitialconfig.begin()+index+params->GetDOF(),vinitialconfig.begin());
@@ -283,6 +292,7 @@ Some python code to display data::\n\
         _nValidGoals = 0;
     }
     virtual ~BirrtPlanner() {
+        _DestroyParallelWorkers(_vParallelWorkers);
     }
 
     struct GOALPATH
@@ -310,6 +320,10 @@ Some python code to display data::\n\
 
         // TODO perhaps distmetricfn should take into number of revolutions of circular joints
         _treeBackward.Init(shared_planner(), _parameters->GetDOF(), _parameters->_distmetricfn, _parameters->_fStepLength, _parameters->_distmetricfn(_parameters->_vConfigLowerLimit, _parameters->_vConfigUpperLimit));
+        std::vector<dReal> vdistmetricweights2;
+        if( _parameters->GetDistMetricWeights2(vdistmetricweights2) ) {
+            _treeBackward.SetDistMetricWeights2(vdistmetricweights2);
+        }
 
         //read in all goals
         if( (_parameters->vgoalconfig.size() % _parameters->GetDOF()) != 0 ) {
@@ -363,6 +377,20 @@ Some python code to display data::\n\
             return OPENRAVE_PLANNER_STATUS(str(boost::format("env=%s, BirrtPlanner::PlanPath - Error, planner not initialized")%GetEnv()->GetNameId()), PS_Failed);
         }
 
+        if( _parameters->_nNumWorkers > 1 ) {
+            if( !_parameters->_samplegoalfn && !_parameters->_sampleinitialfn ) {
+                bool bFallback = false;
+                PlannerStatus parallelstatus = _PlanPathParallel(ptraj, planningoptions, bFallback);
+                if( !bFallback ) {
+                    return parallelstatus;
+                }
+                RAVELOG_DEBUG_FORMAT("env=%s, %s, so planning again with one thread", GetEnv()->GetNameId()%parallelstatus.description);
+            }
+            else {
+                RAVELOG_DEBUG_FORMAT("env=%s, sampling functions of goals and initial configurations cannot be used by the workers, so planning with one thread", GetEnv()->GetNameId());
+            }
+        }
+
         EnvironmentLock lock(GetEnv()->GetMutex());
         uint64_t basetimeus = utils::GetMonotonicTime();
         
@@ -656,6 +684,239 @@ Some python code to display data::\n\
         return _parameters;
     }
 
+    /// \brief state shared by the workers of _PlanPathParallel
+    struct ParallelPlanningState
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::atomic<bool> bCancel{false}; ///< if true, the workers interrupt their planning
+        int winnerindex = -1; ///< index of the first worker that found a path
+        int numfinished = 0;
+    };
+    typedef boost::shared_ptr<ParallelPlanningState> ParallelPlanningStatePtr;
+
+    /// \brief a planner running on its own clone of the environment
+    struct ParallelWorker
+    {
+        EnvironmentBasePtr penv;
+        boost::shared_ptr<BirrtPlanner> planner;
+        TrajectoryBasePtr ptraj;
+        UserDataPtr callbackhandle;
+        PlannerStatus status;
+    };
+    typedef boost::shared_ptr<ParallelWorker> ParallelWorkerPtr;
+
+    /// \brief waits for the threads of _PlanPathParallel that were started
+    static void _JoinParallelWorkerThreads(std::vector< boost::shared_ptr<std::thread> >& vthreads)
+    {
+        FOREACH(itthread, vthreads) {
+            if( !!*itthread && (*itthread)->joinable() ) {
+                (*itthread)->join();
+            }
+        }
+    }
+
+    /// \brief grows _parameters->_nNumWorkers pairs of trees with different seeds, each on its own clone of the environment, and returns the path of the first pair that connects.
+    ///
+    /// The workers rebuild their parameters from the configuration specification, so the path is checked again with the constraints of _parameters before it is returned.
+    /// \param[out] bFallback set to true if the path of the workers does not satisfy the constraints of _parameters and the query has to be planned with one thread
+    PlannerStatus _PlanPathParallel(TrajectoryBasePtr ptraj, int planningoptions, bool& bFallback)
+    {
+        bFallback = false;
+        EnvironmentLock lock(GetEnv()->GetMutex());
+        uint64_t basetimeus = utils::GetMonotonicTime();
+        const int numworkers = _parameters->_nNumWorkers;
+        if( !_InitParallelWorkers(numworkers, ptraj) ) {
+            return OPENRAVE_PLANNER_STATUS(str(boost::format("env=%s, failed to initialize the birrt workers")%GetEnv()->GetNameId()), PS_Failed);
+        }
+        ParallelPlanningStatePtr pstate = _pParallelState;
+
+        std::vector< boost::shared_ptr<std::thread> > vthreads(numworkers);
+        bool bInterrupted = false;
+        try {
+            for(int iworker = 0; iworker < numworkers; ++iworker) {
+                vthreads[iworker] = boost::make_shared<std::thread>(std::bind(&BirrtPlanner::_ParallelWorkerThread, _vParallelWorkers[iworker], iworker, planningoptions, pstate));
+            }
+
+            // the workers do not lock this environment, so the callbacks can still be called with it locked
+            PlannerProgress progress;
+            std::unique_lock<std::mutex> statelock(pstate->mutex);
+            while( pstate->numfinished < numworkers ) {
+                pstate->condition.wait_for(statelock, std::chrono::milliseconds(10));
+                if( !pstate->bCancel ) {
+                    statelock.unlock();
+                    PlannerAction callbackaction = _CallCallbacks(progress);
+                    statelock.lock();
+                    if( callbackaction == PA_Interrupt ) {
+                        bInterrupted = true;
+                        pstate->bCancel = true;
+                    }
+                }
+            }
+        }
+        catch(...) {
+            // joinable threads would terminate the process when destroyed, so stop the workers before propagating
+            pstate->bCancel = true;
+            _JoinParallelWorkerThreads(vthreads);
+            FOREACH(itworker, _vParallelWorkers) {
+                (*itworker)->ptraj.reset();
+            }
+            throw;
+        }
+        _JoinParallelWorkerThreads(vthreads);
+
+        const int winnerindex = pstate->winnerindex;
+        std::vector<dReal> vdata;
+        if( winnerindex >= 0 ) {
+            const ParallelWorker& winner = *_vParallelWorkers.at(winnerindex);
+            _goalindex = winner.planner->_goalindex;
+            _startindex = winner.planner->_startindex;
+            winner.ptraj->GetWaypoints(0, winner.ptraj->GetNumWaypoints(), vdata, _parameters->_configurationspecification);
+        }
+        FOREACH(itworker, _vParallelWorkers) {
+            (*itworker)->ptraj.reset();
+        }
+
+        if( bInterrupted && winnerindex < 0 ) {
+            return OPENRAVE_PLANNER_STATUS(str(boost::format("env=%s, Planning was interrupted")%GetEnv()->GetNameId()), PS_Interrupted);
+        }
+        if( winnerindex < 0 ) {
+            uint64_t elapsedtimeus = utils::GetMonotonicTime()-basetimeus;
+            std::string description = str(boost::format(_("env=%s, plan failed in %u[us] with %d workers, nMaxIterations=%d"))%GetEnv()->GetNameId()%(elapsedtimeus)%numworkers%_parameters->_nMaxIterations);
+            RAVELOG_WARN(description);
+            return OPENRAVE_PLANNER_STATUS(description, PS_Failed);
+        }
+
+        int ret = _CheckParallelPath(vdata);
+        if( ret != 0 ) {
+            bFallback = true;
+            return OPENRAVE_PLANNER_STATUS(str(boost::format("env=%s, path of birrt worker %d fails the constraints of the parameters with 0x%x")%GetEnv()->GetNameId()%winnerindex%ret), PS_Failed);
+        }
+
+        if( ptraj->GetConfigurationSpecification().GetDOF() == 0 ) {
+            ptraj->Init(_parameters->_configurationspecification);
+        }
+        ptraj->Insert(ptraj->GetNumWaypoints(), vdata, _parameters->_configurationspecification);
+        uint64_t elapsedtimeus = utils::GetMonotonicTime()-basetimeus;
+        RAVELOG_DEBUG_FORMAT("env=%s, plan success with worker %d of %d, path=%d points, computation time=%u[us]", GetEnv()->GetNameId()%winnerindex%numworkers%ptraj->GetNumWaypoints()%elapsedtimeus);
+        return _ProcessPostPlanners(_robot,ptraj);
+    }
+
+    /// \brief brings numworkers workers up to date with the environment and initializes their planners for the current query
+    ///
+    /// The cloned environments are kept between queries and updated with EnvironmentBase::UpdateFromClone. GetEnv() has to be locked.
+    bool _InitParallelWorkers(int numworkers, TrajectoryBasePtr ptraj)
+    {
+        if( !_pParallelState ) {
+            _pParallelState.reset(new ParallelPlanningState());
+        }
+        _pParallelState->bCancel = false;
+        _pParallelState->winnerindex = -1;
+        _pParallelState->numfinished = 0;
+
+        while( (int)_vParallelWorkers.size() > numworkers ) {
+            std::vector<ParallelWorkerPtr> vremoved(1, _vParallelWorkers.back());
+            _vParallelWorkers.pop_back();
+            _DestroyParallelWorkers(vremoved);
+        }
+        for(int iworker = 0; iworker < numworkers; ++iworker) {
+            if( iworker >= (int)_vParallelWorkers.size() ) {
+                ParallelWorkerPtr pworker(new ParallelWorker());
+                pworker->penv = GetEnv()->CloneSelf(Clone_Bodies);
+                _vParallelWorkers.push_back(pworker);
+            }
+            else {
+                _vParallelWorkers[iworker]->penv->UpdateFromClone(GetEnv(), Clone_Bodies);
+            }
+            ParallelWorkerPtr pworker = _vParallelWorkers[iworker];
+
+            EnvironmentLock workerlock(pworker->penv->GetMutex());
+            RRTParametersPtr parameters(new RRTParameters());
+            parameters->copy(_parameters);
+            parameters->SetConfigurationSpecification(pworker->penv, _parameters->_configurationspecification);
+            // SetConfigurationSpecification overwrites the initial configurations with the current state
+            parameters->vinitialconfig = _parameters->vinitialconfig;
+            parameters->_nRandomGeneratorSeed = _parameters->_nRandomGeneratorSeed + iworker;
+            parameters->_nNumWorkers = 1;
+            // only the path that is returned is post-processed
+            parameters->_sPostProcessingPlanner.clear();
+
+            if( !pworker->planner ) {
+                pworker->planner = boost::dynamic_pointer_cast<BirrtPlanner>(RaveCreatePlanner(pworker->penv, GetXMLId()));
+                if( !pworker->planner ) {
+                    return false;
+                }
+                pworker->callbackhandle = pworker->planner->RegisterPlanCallback(boost::bind(&BirrtPlanner::_ParallelWorkerCallback, _1, _pParallelState));
+            }
+            RobotBasePtr probot = !!_robot ? pworker->penv->GetRobot(_robot->GetName()) : RobotBasePtr();
+            if( !pworker->planner->InitPlan(probot, parameters) ) {
+                RAVELOG_WARN_FORMAT("env=%s, failed to initialize birrt worker %d", GetEnv()->GetNameId()%iworker);
+                return false;
+            }
+            pworker->ptraj = RaveCreateTrajectory(pworker->penv, ptraj->GetXMLId());
+        }
+        return true;
+    }
+
+    /// \brief checks the path found by a worker with the constraints of _parameters. GetEnv() has to be locked.
+    ///
+    /// \return 0 if every segment satisfies the constraints, otherwise the return code of the failed check
+    int _CheckParallelPath(const std::vector<dReal>& vpath)
+    {
+        const int dof = _parameters->GetDOF();
+        if( !_parameters->_checkpathvelocityconstraintsfn || (int)vpath.size() < 2*dof ) {
+            return 0;
+        }
+        PlannerParameters::StateSaver savestate(_parameters);
+        CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
+        std::vector<dReal> q0(vpath.begin(), vpath.begin()+dof), q1(dof);
+        for(size_t index = dof; index+dof <= vpath.size(); index += dof) {
+            std::copy(vpath.begin()+index, vpath.begin()+index+dof, q1.begin());
+            int ret = _parameters->CheckPathAllConstraints(q0, q1, std::vector<dReal>(), std::vector<dReal>(), 0, IT_OpenStart);
+            if( ret != 0 ) {
+                return ret;
+            }
+            q0.swap(q1);
+        }
+        return 0;
+    }
+
+    static void _ParallelWorkerThread(ParallelWorkerPtr pworker, int iworker, int planningoptions, ParallelPlanningStatePtr pstate)
+    {
+        PlannerStatus status;
+        try {
+            status = pworker->planner->PlanPath(pworker->ptraj, planningoptions);
+        }
+        catch(const std::exception& ex) {
+            RAVELOG_WARN_FORMAT("env=%s, birrt worker %d failed: %s", pworker->penv->GetNameId()%iworker%ex.what());
+            status = PlannerStatus(ex.what(), PS_Failed);
+        }
+        std::lock_guard<std::mutex> statelock(pstate->mutex);
+        pworker->status = status;
+        if( status.HasSolution() && pstate->winnerindex < 0 ) {
+            pstate->winnerindex = iworker;
+            pstate->bCancel = true;
+        }
+        ++pstate->numfinished;
+        pstate->condition.notify_all();
+    }
+
+    static PlannerAction _ParallelWorkerCallback(const PlannerProgress& progress, ParallelPlanningStatePtr pstate)
+    {
+        return pstate->bCancel ? PA_Interrupt : PA_None;
+    }
+
+    static void _DestroyParallelWorkers(std::vector<ParallelWorkerPtr>& vworkers)
+    {
+        FOREACH(itworker, vworkers) {
+            (*itworker)->callbackhandle.reset();
+            (*itworker)->planner.reset();
+            (*itworker)->ptraj.reset();
+            (*itworker)->penv->Destroy();
+        }
+        vworkers.clear();
+    }
+
     virtual bool _DumpTreeCommand(std::ostream& os, std::istream& is) {
         std::string filename = RaveGetHomeDirectory() + string("/birrtdump.txt");
         getline(is, filename);
@@ -675,6 +936,9 @@ protected:
     std::vector< NodeBase* > _vecGoalNodes;
     size_t _nValidGoals; ///< num valid goals
     std::vector<GOALPATH> _vgoalpaths;
+
+    std::vector<ParallelWorkerPtr> _vParallelWorkers; ///< workers of _PlanPathParallel, their environments are kept between queries
+    ParallelPlanningStatePtr _pParallelState; ///< state of the current _PlanPathParallel query, shared with the plan callbacks of the workers
 };
 
 class BasicRrtPlanner : public RrtPlanner<SimpleNode>
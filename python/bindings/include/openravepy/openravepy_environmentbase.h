@@ -85,6 +85,7 @@ public:
 
     void Clone(PyEnvironmentBasePtr pyreference, int options);
     void Clone(PyEnvironmentBasePtr pyreference, const std::string& clonedEnvName, int options);
+    void UpdateFromClone(PyEnvironmentBasePtr pyreference, int options);
 
     bool SetCollisionChecker(PyCollisionCheckerBasePtr pchecker);
     object GetCollisionChecker();
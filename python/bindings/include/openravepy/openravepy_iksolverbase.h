@@ -68,6 +68,8 @@ public:
 
     object SolveAll(object oparam, object oFreeParameters, int filteroptions);
 
+    object SolveAllBatch(object oparams, int filteroptions);
+
     PyIkReturnPtr CallFilters(object oparam);
 
     bool Supports(IkParameterizationType type);
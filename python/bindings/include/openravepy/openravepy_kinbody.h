@@ -246,6 +246,7 @@ public:
     py::object GetTransformPose() const;
     py::object GetLinkTransformations(bool returndoflastvlaues=false) const;
     void SetLinkTransformations(py::object transforms, py::object odoflastvalues=py::none_());
+    py::object ComputeLinkTransformationsBatch(py::object ojointvalues) const;
     void SetLinkVelocities(py::object ovelocities);
     py::object GetLinkEnableStates() const;
     py::object GetLinkEnableStatesMasks() const;
@@ -290,12 +291,14 @@ public:
     void SetDOFTorques(py::object otorques, bool bAdd);
     py::object ComputeJacobianTranslation(int index, py::object oposition, py::object oindices=py::none_());
     py::object ComputeJacobianAxisAngle(int index, py::object oindices=py::none_());
+    py::object ComputeJacobiansBatch(py::object ojointvalues, py::object olinkindices, py::object olocalpositions=py::none_(), py::object oindices=py::none_());
     py::object CalculateJacobian(int index, py::object oposition);
     py::object CalculateRotationJacobian(int index, py::object q) const;
     py::object CalculateAngularVelocityJacobian(int index) const;
     py::object ComputeHessianTranslation(int index, py::object oposition, py::object oindices=py::none_());
     py::object ComputeHessianAxisAngle(int index, py::object oindices=py::none_());
     py::object ComputeInverseDynamics(py::object odofaccelerations, py::object oexternalforcetorque=py::none_(), bool returncomponents=false);
+    py::object ComputeInverseDynamicsBatch(py::object odofvalues, py::object odofvelocities=py::none_(), py::object odofaccelerations=py::none_(), bool returnderivatives=false);
     py::object GetDOFDynamicAccelerationJerkLimits(py::object oDOFPositions, py::object oDOFVelocities) const;
     void SetSelfCollisionChecker(PyCollisionCheckerBasePtr pycollisionchecker);
     PyInterfaceBasePtr GetSelfCollisionChecker();
@@ -1546,6 +1546,8 @@ void init_openravepy_global()
     .value("FromPathSampling", CFO_FromPathSampling)
     .value("FromPathShortcutting", CFO_FromPathShortcutting)
     .value("FromTrajectorySmoother", CFO_FromTrajectorySmoother)
+    .value("CheckContinuousCollisions", CFO_CheckContinuousCollisions)
+    .value("CheckInBisectionOrder", CFO_CheckInBisectionOrder)
     .value("FinalValuesNotReached", CFO_FinalValuesNotReached)
     .value("StateSettingError", CFO_StateSettingError)
     .value("RecommendedOptions", CFO_RecommendedOptions)
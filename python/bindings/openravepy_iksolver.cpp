@@ -214,6 +214,28 @@ object PyIkSolverBase::SolveAll(object oparam, object oFreeParameters, int filte
     return pyreturns;
 }
 
+object PyIkSolverBase::SolveAllBatch(object oparams, int filteroptions)
+{
+    size_t num = len(oparams);
+    std::vector<IkParameterization> vikparams(num);
+    for(size_t i = 0; i < num; ++i) {
+        if( !ExtractIkParameterization(oparams[py::to_object(i)],vikparams[i]) ) {
+            throw openrave_exception(_("first argument to IkSolver.SolveAllBatch needs to be a list of IkParameterization"),ORE_InvalidArguments);
+        }
+    }
+    std::vector< std::vector<IkReturnPtr> > vikreturns;
+    _pIkSolver->SolveAllBatch(vikparams, filteroptions, vikreturns);
+    py::list pyallreturns;
+    FOREACH(itikreturns,vikreturns) {
+        py::list pyreturns;
+        FOREACH(itikreturn,*itikreturns) {
+            pyreturns.append(py::to_object(PyIkReturnPtr(new PyIkReturn(*itikreturn))));
+        }
+        pyallreturns.append(pyreturns);
+    }
+    return pyallreturns;
+}
+
 PyIkReturnPtr PyIkSolverBase::CallFilters(object oparam)
 {
     PyIkReturnPtr pyreturn(new PyIkReturn(IKRA_Reject));
@@ -361,6 +383,7 @@ void init_openravepy_iksolver()
         .def("Solve",SolveFree, PY_ARGS("ikparam","q0","freeparameters", "filteroptions") DOXY_FN(IkSolverBase, Solve "const IkParameterization&; const std::vector; const std::vector; int; IkReturnPtr"))
         .def("SolveAll",SolveAll, PY_ARGS("ikparam","filteroptions") DOXY_FN(IkSolverBase, SolveAll "const IkParameterization&; int; std::vector<IkReturnPtr>"))
         .def("SolveAll",SolveAllFree, PY_ARGS("ikparam","freeparameters","filteroptions") DOXY_FN(IkSolverBase, SolveAll "const IkParameterization&; const std::vector; int; std::vector<IkReturnPtr>"))
+        .def("SolveAllBatch",&PyIkSolverBase::SolveAllBatch, PY_ARGS("ikparams","filteroptions") DOXY_FN(IkSolverBase, SolveAllBatch))
         .def("GetNumFreeParameters",&PyIkSolverBase::GetNumFreeParameters, DOXY_FN(IkSolverBase,GetNumFreeParameters))
         .def("GetFreeParameters",&PyIkSolverBase::GetFreeParameters, DOXY_FN(IkSolverBase,GetFreeParameters))
         .def("Supports",&PyIkSolverBase::Supports, PY_ARGS("iktype") DOXY_FN(IkSolverBase,Supports))
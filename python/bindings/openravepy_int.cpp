@@ -1252,6 +1252,11 @@ void PyEnvironmentBase::Clone(PyEnvironmentBasePtr pyreference, const std::strin
     _penv->Clone(pyreference->GetEnv(),clonedEnvName, options);
 }
 
+void PyEnvironmentBase::UpdateFromClone(PyEnvironmentBasePtr pyreference, int options)
+{
+    _penv->UpdateFromClone(pyreference->GetEnv(),options);
+}
+
 bool PyEnvironmentBase::SetCollisionChecker(PyCollisionCheckerBasePtr pchecker)
 {
     return _penv->SetCollisionChecker(openravepy::GetCollisionChecker(pchecker));
@@ -3466,6 +3471,7 @@ Because race conditions can pop up when trying to lock the openrave environment
                      .def("CloneSelf",pcloneselfname, PY_ARGS("clonedEnvName", "options") DOXY_FN(EnvironmentBase,CloneSelf))
                      .def("Clone",pclone, PY_ARGS("reference","options") DOXY_FN(EnvironmentBase,Clone))
                      .def("Clone",pclonename, PY_ARGS("reference", "clonedEnvName", "options") DOXY_FN(EnvironmentBase,Clone))
+                     .def("UpdateFromClone",&PyEnvironmentBase::UpdateFromClone, PY_ARGS("reference","options") DOXY_FN(EnvironmentBase,UpdateFromClone))
                      .def("SetCollisionChecker",&PyEnvironmentBase::SetCollisionChecker, PY_ARGS("collisionchecker") DOXY_FN(EnvironmentBase,SetCollisionChecker))
                      .def("GetCollisionChecker",&PyEnvironmentBase::GetCollisionChecker, DOXY_FN(EnvironmentBase,GetCollisionChecker))
                      .def("CheckCollision",pcolb, PY_ARGS("body") DOXY_FN(EnvironmentBase,CheckCollision "KinBodyConstPtr; CollisionReportPtr"))
@@ -3336,6 +3336,39 @@ object PyKinBody::GetLinkTransformations(bool returndoflastvlaues) const
     return otransforms;
 }
 
+/// \brief extracts a sequence of configurations of dof values into one contiguous buffer
+static std::vector<dReal> _ExtractConfigurations(object oconfigurations, int dof)
+{
+    std::vector<dReal> vconfigurations;
+    const size_t numconfigurations = len(oconfigurations);
+    vconfigurations.reserve(numconfigurations*dof);
+    for(size_t i = 0; i < numconfigurations; ++i) {
+        std::vector<dReal> vvalues = ExtractArray<dReal>(oconfigurations[py::to_object(i)]);
+        OPENRAVE_ASSERT_OP((int)vvalues.size(),==,dof);
+        vconfigurations.insert(vconfigurations.end(), vvalues.begin(), vvalues.end());
+    }
+    return vconfigurations;
+}
+
+object PyKinBody::ComputeLinkTransformationsBatch(object ojointvalues) const
+{
+    const int dof = _pbody->GetDOF();
+    std::vector<dReal> vjointvalues = _ExtractConfigurations(ojointvalues, dof);
+    const int numconfigurations = len(ojointvalues);
+    std::vector<Transform> vtransforms;
+    _pbody->ComputeLinkTransformationsBatch(vjointvalues.data(), numconfigurations, vtransforms);
+    const size_t numlinks = _pbody->GetLinks().size();
+    py::list oconfigurationtransforms;
+    for(int iconfig = 0; iconfig < numconfigurations; ++iconfig) {
+        py::list otransforms;
+        for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+            otransforms.append(ReturnTransform(vtransforms.at(iconfig*numlinks+ilink)));
+        }
+        oconfigurationtransforms.append(otransforms);
+    }
+    return oconfigurationtransforms;
+}
+
 void PyKinBody::SetLinkTransformations(object transforms, object odoflastvalues)
 {
     size_t numtransforms = len(transforms);
@@ -3827,6 +3860,34 @@ object PyKinBody::ComputeJacobianAxisAngle(int index, object oindices)
     return toPyArray(vjacobian,dims);
 }
 
+object PyKinBody::ComputeJacobiansBatch(object ojointvalues, object olinkindices, object olocalpositions, object oindices)
+{
+    const int dof = _pbody->GetDOF();
+    std::vector<dReal> vjointvalues = _ExtractConfigurations(ojointvalues, dof);
+    const int numconfigurations = len(ojointvalues);
+    std::vector<int> vlinkindices = ExtractArray<int>(olinkindices);
+    std::vector<int> vindices;
+    if( !IS_PYTHONOBJECT_NONE(oindices) ) {
+        vindices = ExtractArray<int>(oindices);
+    }
+    if( !IS_PYTHONOBJECT_NONE(olocalpositions) ) {
+        OPENRAVE_ASSERT_OP(len(olocalpositions),==,vlinkindices.size());
+    }
+    std::vector<KinBody::JacobianWorkspace> vworkspaces(vlinkindices.size());
+    for(size_t i = 0; i < vlinkindices.size(); ++i) {
+        Vector vlocalposition;
+        if( !IS_PYTHONOBJECT_NONE(olocalpositions) ) {
+            vlocalposition = ExtractVector3(olocalpositions[py::to_object(i)]);
+        }
+        _pbody->InitJacobianWorkspace(vlinkindices[i], vlocalposition, vindices, vworkspaces[i]);
+    }
+    const int numcolumns = vworkspaces.size() > 0 ? vworkspaces[0].GetNumColumns() : 0;
+    std::vector<dReal> vjacobians(numconfigurations*vworkspaces.size()*6*numcolumns);
+    _pbody->ComputeJacobiansBatch(vjointvalues.data(), numconfigurations, vworkspaces, vjacobians.data());
+    std::vector<npy_intp> dims(4); dims[0] = numconfigurations; dims[1] = vworkspaces.size(); dims[2] = 6; dims[3] = numcolumns;
+    return toPyArray(vjacobians,dims);
+}
+
 object PyKinBody::CalculateJacobian(int index, object oposition)
 {
     std::vector<dReal> vjacobian;
@@ -3916,6 +3977,35 @@ object PyKinBody::ComputeInverseDynamics(object odofaccelerations, object oexter
     }
 }
 
+object PyKinBody::ComputeInverseDynamicsBatch(object odofvalues, object odofvelocities, object odofaccelerations, bool returnderivatives)
+{
+    const int dof = _pbody->GetDOF();
+    const int numsamples = len(odofvalues);
+    std::vector<dReal> vDOFValues = _ExtractConfigurations(odofvalues, dof), vDOFVelocities, vDOFAccelerations;
+    if( !IS_PYTHONOBJECT_NONE(odofvelocities) ) {
+        OPENRAVE_ASSERT_OP((int)len(odofvelocities),==,numsamples);
+        vDOFVelocities = _ExtractConfigurations(odofvelocities, dof);
+    }
+    if( !IS_PYTHONOBJECT_NONE(odofaccelerations) ) {
+        OPENRAVE_ASSERT_OP((int)len(odofaccelerations),==,numsamples);
+        vDOFAccelerations = _ExtractConfigurations(odofaccelerations, dof);
+    }
+    KinBody::InverseDynamicsWorkspace workspace;
+    _pbody->InitInverseDynamicsWorkspace(workspace);
+    std::vector<dReal> vDOFTorques(numsamples*dof), vTorqueValueDerivatives, vTorqueVelocityDerivatives;
+    if( returnderivatives ) {
+        vTorqueValueDerivatives.resize(numsamples*dof*dof);
+        vTorqueVelocityDerivatives.resize(numsamples*dof*dof);
+    }
+    workspace.ComputeInverseDynamicsBatch(vDOFValues.data(), vDOFVelocities.size() > 0 ? vDOFVelocities.data() : NULL, vDOFAccelerations.size() > 0 ? vDOFAccelerations.data() : NULL, numsamples, vDOFTorques.data(), returnderivatives ? vTorqueValueDerivatives.data() : NULL, returnderivatives ? vTorqueVelocityDerivatives.data() : NULL);
+    std::vector<npy_intp> dims(2); dims[0] = numsamples; dims[1] = dof;
+    if( returnderivatives ) {
+        std::vector<npy_intp> derivativedims(3); derivativedims[0] = numsamples; derivativedims[1] = dof; derivativedims[2] = dof;
+        return py::make_tuple(toPyArray(vDOFTorques,dims), toPyArray(vTorqueValueDerivatives,derivativedims), toPyArray(vTorqueVelocityDerivatives,derivativedims));
+    }
+    return toPyArray(vDOFTorques,dims);
+}
+
 object PyKinBody::GetDOFDynamicAccelerationJerkLimits(py::object oDOFPositions, py::object oDOFVelocities) const
 {
     if( IS_PYTHONOBJECT_NONE(oDOFPositions) || IS_PYTHONOBJECT_NONE(oDOFVelocities) ) {
@@ -4799,9 +4889,11 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SetDOFLimits_overloads, SetDOFLimits, 2,
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(SubtractDOFValues_overloads, SubtractDOFValues, 2, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeJacobianTranslation_overloads, ComputeJacobianTranslation, 2, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeJacobianAxisAngle_overloads, ComputeJacobianAxisAngle, 1, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeJacobiansBatch_overloads, ComputeJacobiansBatch, 2, 4)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeHessianTranslation_overloads, ComputeHessianTranslation, 2, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeHessianAxisAngle_overloads, ComputeHessianAxisAngle, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeInverseDynamics_overloads, ComputeInverseDynamics, 1, 3)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ComputeInverseDynamicsBatch_overloads, ComputeInverseDynamicsBatch, 1, 4)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Restore_overloads, Restore, 0,1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ExtractInfo_overloads, ExtractInfo, 0,1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CreateKinBodyStateSaver_overloads, CreateKinBodyStateSaver, 0,1)
@@ -5750,6 +5842,7 @@ void init_openravepy_kinbody()
                          .def("GetLinkTransformations",&PyKinBody::GetLinkTransformations, GetLinkTransformations_overloads(PY_ARGS("returndoflastvlaues") DOXY_FN(KinBody,GetLinkTransformations)))
 #endif
                          .def("GetBodyTransformations",&PyKinBody::GetLinkTransformations, DOXY_FN(KinBody,GetLinkTransformations))
+                         .def("ComputeLinkTransformationsBatch",&PyKinBody::ComputeLinkTransformationsBatch, PY_ARGS("jointvalues") DOXY_FN(KinBody,ComputeLinkTransformationsBatch))
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
                          .def("SetLinkTransformations",&PyKinBody::SetLinkTransformations,
                               "transforms"_a,
@@ -5887,6 +5980,17 @@ void init_openravepy_kinbody()
 #else
                          .def("ComputeJacobianTranslation",&PyKinBody::ComputeJacobianTranslation,ComputeJacobianTranslation_overloads(PY_ARGS("linkindex","position","indices") DOXY_FN(KinBody,ComputeJacobianTranslation)))
 #endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+                         .def("ComputeJacobiansBatch", &PyKinBody::ComputeJacobiansBatch,
+                              "jointvalues"_a,
+                              "linkindices"_a,
+                              "localpositions"_a = py::none_(),
+                              "indices"_a = py::none_(),
+                              DOXY_FN(KinBody,ComputeJacobiansBatch)
+                              )
+#else
+                         .def("ComputeJacobiansBatch",&PyKinBody::ComputeJacobiansBatch,ComputeJacobiansBatch_overloads(PY_ARGS("jointvalues","linkindices","localpositions","indices") DOXY_FN(KinBody,ComputeJacobiansBatch)))
+#endif
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
                          .def("ComputeJacobianAxisAngle", &PyKinBody::ComputeJacobianAxisAngle,
                               "linkindex"_a,
@@ -5947,6 +6051,17 @@ void init_openravepy_kinbody()
                               )
 #else
                          .def("ComputeInverseDynamics",&PyKinBody::ComputeInverseDynamics, ComputeInverseDynamics_overloads(PY_ARGS("dofaccelerations","externalforcetorque","returncomponents") sComputeInverseDynamicsDoc.c_str()))
+#endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+                         .def("ComputeInverseDynamicsBatch", &PyKinBody::ComputeInverseDynamicsBatch,
+                              "dofvalues"_a,
+                              "dofvelocities"_a = py::none_(),
+                              "dofaccelerations"_a = py::none_(),
+                              "returnderivatives"_a = false,
+                              DOXY_FN(KinBody::InverseDynamicsWorkspace,ComputeInverseDynamicsBatch)
+                              )
+#else
+                         .def("ComputeInverseDynamicsBatch",&PyKinBody::ComputeInverseDynamicsBatch, ComputeInverseDynamicsBatch_overloads(PY_ARGS("dofvalues","dofvelocities","dofaccelerations","returnderivatives") DOXY_FN(KinBody::InverseDynamicsWorkspace,ComputeInverseDynamicsBatch)))
 #endif
                          .def("GetDOFDynamicAccelerationJerkLimits",&PyKinBody::GetDOFDynamicAccelerationJerkLimits, PY_ARGS("dofPositions","dofVelocities") DOXY_FN(KinBody,ComputeDynamicLimits))
                          .def("SetSelfCollisionChecker",&PyKinBody::SetSelfCollisionChecker,PY_ARGS("collisionchecker") DOXY_FN(KinBody,SetSelfCollisionChecker))
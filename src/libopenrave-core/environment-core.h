@@ -556,6 +556,15 @@ public:
         }
     }
 
+    void UpdateFromClone(EnvironmentBaseConstPtr preference, int cloningoptions) override
+    {
+        EnvironmentLock lockenv(GetMutex());
+        boost::shared_ptr<Environment const> r = boost::static_pointer_cast<Environment const>(preference);
+        if( !(cloningoptions & Clone_Bodies) || !_UpdateBodiesFromClone(r) ) {
+            _Clone(r, cloningoptions, true);
+        }
+    }
+
     virtual int AddModule(ModuleBasePtr module, const std::string& cmdargs)
     {
         CHECK_INTERFACE(module);
@@ -3279,6 +3288,8 @@ protected:
         RAVELOG_DEBUG_FORMAT("env=%s, setting openrave home directory to %s", GetNameId()%_homedirectory);
 
         _nBodiesModifiedStamp = 0;
+        _nCloneSourceBodiesModifiedStamp = 0;
+        _nCloneBodiesModifiedStamp = 0;
 
         _assignedBodySensorNameIdSuffix = 0;
 
@@ -3297,6 +3308,8 @@ protected:
 
         _handlegenericrobot = RaveRegisterInterface(PT_Robot,"GenericRobot", RaveGetInterfaceHash(PT_Robot), GetHash(), CreateGenericRobot);
         _handlegenerictrajectory = RaveRegisterInterface(PT_Trajectory,"GenericTrajectory", RaveGetInterfaceHash(PT_Trajectory), GetHash(), CreateGenericTrajectory);
+        _handlemappedtrajectory = RaveRegisterInterface(PT_Trajectory,"MappedTrajectory", RaveGetInterfaceHash(PT_Trajectory), GetHash(), CreateMappedTrajectory);
+        _handlestreamingtrajectory = RaveRegisterInterface(PT_Trajectory,"StreamingTrajectory", RaveGetInterfaceHash(PT_Trajectory), GetHash(), CreateStreamingTrajectory);
         _handlemulticontroller = RaveRegisterInterface(PT_Controller,"GenericMultiController", RaveGetInterfaceHash(PT_Controller), GetHash(), CreateMultiController);
         _handlegenericphysicsengine = RaveRegisterInterface(PT_PhysicsEngine,"GenericPhysicsEngine", RaveGetInterfaceHash(PT_PhysicsEngine), GetHash(), CreateGenericPhysicsEngine);
         _handlegenericcollisionchecker = RaveRegisterInterface(PT_CollisionChecker,"GenericCollisionChecker", RaveGetInterfaceHash(PT_CollisionChecker), GetHash(), CreateGenericCollisionChecker);
@@ -3778,6 +3791,13 @@ protected:
         }
         listViewers.clear();
 
+        if( options & Clone_Bodies ) {
+            _UpdateCloneStamps(r);
+        }
+        else {
+            _pCloneSourceEnv.reset();
+        }
+
         if( !bCheckSharedResources ) {
             if( !!_threadSimulation && _bEnableSimulation ) {
                 _StartSimulationThread();
@@ -3785,6 +3805,97 @@ protected:
         }
     }
 
+    /// \brief copies the state of the bodies that changed since the last clone from r.
+    ///
+    /// \return false without modifying anything if the bodies have to be cloned again
+    bool _UpdateBodiesFromClone(boost::shared_ptr<Environment const> r)
+    {
+        if( _pCloneSourceEnv.lock() != r || r->_nBodiesModifiedStamp != _nCloneSourceBodiesModifiedStamp || _nBodiesModifiedStamp != _nCloneBodiesModifiedStamp ) {
+            return false;
+        }
+
+        std::vector<KinBodyPtr> vChangedBodies; // bodies of r whose state has to be copied
+        std::vector<KinBodyPtr> vUnchangedBodies; // bodies of r whose velocities can still differ, setting velocities does not change the update stamp
+        {
+            SharedLock lock(r->_mutexInterfaces);
+            SharedLock lock2(_mutexInterfaces);
+            if( r->_vecbodies.size() != _vecbodies.size() || _vCloneBodyUpdateStamps.size() != _vecbodies.size() ) {
+                return false;
+            }
+            for(size_t bodyIndex = 0; bodyIndex < r->_vecbodies.size(); ++bodyIndex) {
+                const KinBodyPtr& pbody = r->_vecbodies[bodyIndex];
+                const KinBodyPtr& pnewbody = _vecbodies[bodyIndex];
+                if( !pbody || !pnewbody ) {
+                    if( !!pbody || !!pnewbody ) {
+                        return false;
+                    }
+                    continue;
+                }
+                if( pbody->GetUpdateStamp() == _vCloneBodyUpdateStamps[bodyIndex].first && pnewbody->GetUpdateStamp() == _vCloneBodyUpdateStamps[bodyIndex].second ) {
+                    vUnchangedBodies.push_back(pbody);
+                    continue;
+                }
+                if( pbody->IsRobot() != pnewbody->IsRobot() || pbody->GetName() != pnewbody->GetName() || pbody->GetKinematicsGeometryHash() != pnewbody->GetKinematicsGeometryHash() ) {
+                    RAVELOG_VERBOSE_FORMAT("env=%s, body %s changed its structure in env=%s, cloning again", GetNameId()%pbody->GetName()%r->GetNameId());
+                    return false;
+                }
+                vChangedBodies.push_back(pbody);
+            }
+        }
+
+        // copy the grabbed bodies after all the other states, the grabbed bodies have to be in place when they are grabbed.
+        // the savers are released so that the state of the bodies of r is not restored (and their stamps not changed) when they are destroyed
+        for (const KinBodyPtr& pbody : vChangedBodies) {
+            KinBodyPtr pnewbody = _vecbodies.at(pbody->GetEnvironmentBodyIndex());
+            if( pbody->IsRobot() ) {
+                RobotBase::RobotStateSaver saver(RaveInterfaceCast<RobotBase>(pbody), 0xffffffff&~KinBody::Save_GrabbedBodies);
+                saver.Restore(RaveInterfaceCast<RobotBase>(pnewbody));
+                saver.Release();
+            }
+            else {
+                KinBody::KinBodyStateSaver saver(pbody, 0xffffffff&~KinBody::Save_GrabbedBodies);
+                saver.Restore(pnewbody);
+                saver.Release();
+            }
+        }
+        for (const KinBodyPtr& pbody : vChangedBodies) {
+            KinBodyPtr pnewbody = _vecbodies.at(pbody->GetEnvironmentBodyIndex());
+            KinBody::KinBodyStateSaver saver(pbody, KinBody::Save_GrabbedBodies);
+            saver.Restore(pnewbody);
+            saver.Release();
+        }
+        std::vector<std::pair<Vector,Vector> > vLinkVelocities, vNewLinkVelocities;
+        for (const KinBodyPtr& pbody : vUnchangedBodies) {
+            KinBodyPtr pnewbody = _vecbodies.at(pbody->GetEnvironmentBodyIndex());
+            pbody->GetLinkVelocities(vLinkVelocities);
+            pnewbody->GetLinkVelocities(vNewLinkVelocities);
+            if( vLinkVelocities != vNewLinkVelocities ) {
+                pnewbody->SetLinkVelocities(vLinkVelocities);
+            }
+        }
+
+        RAVELOG_VERBOSE_FORMAT("env=%s, updated %d bodies from env=%s", GetNameId()%vChangedBodies.size()%r->GetNameId());
+        _UpdateCloneStamps(r);
+        return true;
+    }
+
+    /// \brief records the stamps of the bodies of this environment and r right after they were synchronized, see UpdateFromClone
+    void _UpdateCloneStamps(boost::shared_ptr<Environment const> r)
+    {
+        _pCloneSourceEnv = r;
+        _nCloneSourceBodiesModifiedStamp = r->_nBodiesModifiedStamp;
+        _nCloneBodiesModifiedStamp = _nBodiesModifiedStamp;
+
+        SharedLock lock(r->_mutexInterfaces);
+        SharedLock lock2(_mutexInterfaces);
+        _vCloneBodyUpdateStamps.resize(r->_vecbodies.size());
+        for(size_t bodyIndex = 0; bodyIndex < r->_vecbodies.size(); ++bodyIndex) {
+            const KinBodyPtr& pbody = r->_vecbodies[bodyIndex];
+            _vCloneBodyUpdateStamps[bodyIndex].first = !!pbody ? pbody->GetUpdateStamp() : 0;
+            _vCloneBodyUpdateStamps[bodyIndex].second = bodyIndex < _vecbodies.size() && !!_vecbodies[bodyIndex] ? _vecbodies[bodyIndex]->GetUpdateStamp() : 0;
+        }
+    }
+
     /// \brief adds pbody to _vecbodies and other internal data structures
     /// \param pbody kin body to be added to the environment
     /// \param envBodyIndex environment body index of the pbody
@@ -4314,6 +4425,11 @@ protected:
     uint64_t _nSimStartTime;
     int _nBodiesModifiedStamp;     ///< incremented every tiem bodies vector is modified
 
+    boost::weak_ptr<Environment const> _pCloneSourceEnv; ///< environment the bodies were last cloned from, see UpdateFromClone
+    int _nCloneSourceBodiesModifiedStamp; ///< _nBodiesModifiedStamp of _pCloneSourceEnv at the last clone
+    int _nCloneBodiesModifiedStamp; ///< _nBodiesModifiedStamp at the last clone
+    std::vector< std::pair<int, int> > _vCloneBodyUpdateStamps; ///< for every environment body index, the update stamps of the body of _pCloneSourceEnv and of the body of this environment at the last clone
+
     CollisionCheckerBasePtr _pCurrentChecker;
     PhysicsEngineBasePtr _pPhysicsEngine;
 
@@ -4332,7 +4448,7 @@ protected:
     std::pair<std::string, dReal> _unit; ///< unit name mm, cm, inches, m and the conversion for meters
     UnitInfo _unitInfo; ///< unitInfo that describes length unit, mass unit, time unit and angle unit
 
-    UserDataPtr _handlegenericrobot, _handlegenerictrajectory, _handlemulticontroller, _handlegenericphysicsengine, _handlegenericcollisionchecker;
+    UserDataPtr _handlegenericrobot, _handlegenerictrajectory, _handlemappedtrajectory, _handlestreamingtrajectory, _handlemulticontroller, _handlegenericphysicsengine, _handlegenericcollisionchecker;
 
     list<InterfaceBasePtr> _listOwnedInterfaces; ///< protected by _mutexInterfaces
 
@@ -19,6 +19,9 @@
 #include <boost/lambda/lambda.hpp>
 #include <boost/lexical_cast.hpp>
 #include <openrave/xmlreaders.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstring>
 
 using namespace boost::placeholders;
 
@@ -26,7 +29,28 @@ namespace OpenRAVE {
 
 // To distinguish between binary and XML trajectory files
 static const uint16_t BINARY_TRAJECTORY_MAGIC_NUMBER = 0x62ff;
-static const uint16_t BINARY_TRAJECTORY_VERSION_NUMBER = 0x0003;  // Version number for serialization
+static const uint16_t BINARY_TRAJECTORY_VERSION_NUMBER = 0x0004;  // latest version that can be read
+static const uint16_t BINARY_TRAJECTORY_DEFAULT_VERSION_NUMBER = 0x0003;  // Version number for serialization, readable by older versions of openrave
+static const uint16_t BINARY_TRAJECTORY_ALIGNED_VERSION_NUMBER = 0x0004; // first version with BinaryTrajectoryPrefix and aligned waypoints, written with BINARY_TRAJECTORY_ALIGNED_SERIALIZATION_OPTION
+static const int BINARY_TRAJECTORY_ALIGNED_SERIALIZATION_OPTION = 0x4000; // serialize option to write version BINARY_TRAJECTORY_ALIGNED_VERSION_NUMBER
+static const uint16_t BINARY_TRAJECTORY_DATA_ALIGNMENT = 64; // byte alignment of the waypoints from the start of the trajectory
+static const uint32_t BINARY_TRAJECTORY_ENDIAN_MARKER = 0x01020304;
+static const uint32_t BINARY_TRAJECTORY_PREFIX_SIZE = 32; // magic, version and BinaryTrajectoryPrefix
+
+/** \brief fixed size start of the binary trajectory layout from version 0x0004, after the magic and version numbers.
+
+    The layout is the magic and version numbers, this prefix, the spec, description and readable interfaces encoded as in version 0x0003, zero padding up to dataoffset, and the numvalues waypoint values. All the numbers are in the byte order of the machine that wrote the trajectory. Since dataoffset is a multiple of BINARY_TRAJECTORY_DATA_ALIGNMENT, the waypoints of a trajectory file mapped in memory are aligned and can be sampled in place, see MappedTrajectory.
+ */
+struct BinaryTrajectoryPrefix
+{
+    uint16_t realsize; ///< sizeof(dReal) of the writer
+    uint16_t alignment; ///< BINARY_TRAJECTORY_DATA_ALIGNMENT of the writer
+    uint32_t endianmarker; ///< BINARY_TRAJECTORY_ENDIAN_MARKER
+    uint32_t headersize; ///< bytes from the start of the trajectory to the end of the readable interfaces
+    uint32_t dataoffset; ///< bytes from the start of the trajectory to the waypoints
+    uint32_t reserved;
+    uint64_t numvalues; ///< number of waypoint values
+};
 
 static const dReal g_fEpsilonLinear = RavePow(g_fEpsilon,0.9);
 static const dReal g_fEpsilonQuadratic = RavePow(g_fEpsilon,0.45); // should be 0.6...perhaps this is related to parabolic smoother epsilons?
@@ -42,6 +66,11 @@ inline void WriteBinaryUInt32(std::ostream& f, uint32_t value)
     f.write((const char*) &value, sizeof(value));
 }
 
+inline void WriteBinaryUInt64(std::ostream& f, uint64_t value)
+{
+    f.write((const char*) &value, sizeof(value));
+}
+
 inline void WriteBinaryInt(std::ostream& f, int value)
 {
     f.write((const char*) &value, sizeof(value));
@@ -84,6 +113,12 @@ inline bool ReadBinaryUInt32(std::istream& f, uint32_t& value)
     return !!f;
 }
 
+inline bool ReadBinaryUInt64(std::istream& f, uint64_t& value)
+{
+    f.read((char*) &value, sizeof(value));
+    return !!f;
+}
+
 inline bool ReadBinaryInt(std::istream& f, int& value)
 {
     f.read((char*) &value, sizeof(value));
@@ -120,31 +155,51 @@ inline bool ReadBinaryVector(std::istream& f, std::vector<dReal>& v)
     return !!f;
 }
 
-// raw pointers
-inline void ReadBinaryUInt16(const uint8_t*& f, uint16_t& value)
+// raw pointers, pend is the end of the readable data
+
+/// \brief throws if there are less than size bytes left to read from f
+inline void CheckBinaryDataSize(const uint8_t* f, const uint8_t* pend, uint64_t size)
+{
+    if( f > pend || (uint64_t)(pend - f) < size ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("binary trajectory is truncated, reading %d bytes but %d are left"), size%(f > pend ? 0 : pend - f), ORE_InvalidArguments);
+    }
+}
+
+inline void ReadBinaryUInt16(const uint8_t*& f, const uint8_t* pend, uint16_t& value)
 {
-    value = *(uint16_t*)f;
+    CheckBinaryDataSize(f, pend, sizeof(uint16_t));
+    std::memcpy(&value, f, sizeof(uint16_t));
     f += sizeof(uint16_t);
 }
 
-inline void ReadBinaryUInt32(const uint8_t*& f, uint32_t& value)
+inline void ReadBinaryUInt32(const uint8_t*& f, const uint8_t* pend, uint32_t& value)
 {
-    value = *(uint32_t*)f;
+    CheckBinaryDataSize(f, pend, sizeof(uint32_t));
+    std::memcpy(&value, f, sizeof(uint32_t));
     f += sizeof(uint32_t);
 }
 
-inline void ReadBinaryInt(const uint8_t*& f, int& value)
+inline void ReadBinaryUInt64(const uint8_t*& f, const uint8_t* pend, uint64_t& value)
 {
-    value = *(int*)f;
+    CheckBinaryDataSize(f, pend, sizeof(uint64_t));
+    std::memcpy(&value, f, sizeof(uint64_t));
+    f += sizeof(uint64_t);
+}
+
+inline void ReadBinaryInt(const uint8_t*& f, const uint8_t* pend, int& value)
+{
+    CheckBinaryDataSize(f, pend, sizeof(int));
+    std::memcpy(&value, f, sizeof(int));
     f += sizeof(int);
 }
 
-inline void ReadBinaryString(const uint8_t*& f, std::string& s)
+inline void ReadBinaryString(const uint8_t*& f, const uint8_t* pend, std::string& s)
 {
     uint16_t length = 0;
-    ReadBinaryUInt16(f, length);
+    ReadBinaryUInt16(f, pend, length);
     if (length > 0)
     {
+        CheckBinaryDataSize(f, pend, length);
         s.resize(length);
         std::copy(f, f+length, &s[0]);
         f += length;
@@ -154,24 +209,142 @@ inline void ReadBinaryString(const uint8_t*& f, std::string& s)
     }
 }
 
-inline void ReadBinaryVector(const uint8_t*& f, std::vector<dReal>& v)
+inline void ReadBinaryVector(const uint8_t*& f, const uint8_t* pend, std::vector<dReal>& v)
 {
     // Get number of data points
     uint32_t numDataPoints = 0;
-    ReadBinaryUInt32(f, numDataPoints);
-    v.resize(numDataPoints);
+    ReadBinaryUInt32(f, pend, numDataPoints);
 
     // Load binary directly to vector
-    const uint64_t vectorLengthBytes = numDataPoints*sizeof(dReal);
-    std::copy(f, f+vectorLengthBytes, (char*)&v[0]);
+    const uint64_t vectorLengthBytes = (uint64_t)numDataPoints*sizeof(dReal);
+    CheckBinaryDataSize(f, pend, vectorLengthBytes);
+    v.resize(numDataPoints);
+    if( numDataPoints > 0 ) {
+        std::copy(f, f+vectorLengthBytes, (uint8_t*)&v[0]);
+    }
     f += vectorLengthBytes;
 }
 
+inline bool ReadBinaryTrajectoryPrefix(std::istream& f, BinaryTrajectoryPrefix& prefix)
+{
+    ReadBinaryUInt16(f, prefix.realsize);
+    ReadBinaryUInt16(f, prefix.alignment);
+    ReadBinaryUInt32(f, prefix.endianmarker);
+    ReadBinaryUInt32(f, prefix.headersize);
+    ReadBinaryUInt32(f, prefix.dataoffset);
+    ReadBinaryUInt32(f, prefix.reserved);
+    return ReadBinaryUInt64(f, prefix.numvalues);
+}
+
+inline void ReadBinaryTrajectoryPrefix(const uint8_t*& f, const uint8_t* pend, BinaryTrajectoryPrefix& prefix)
+{
+    ReadBinaryUInt16(f, pend, prefix.realsize);
+    ReadBinaryUInt16(f, pend, prefix.alignment);
+    ReadBinaryUInt32(f, pend, prefix.endianmarker);
+    ReadBinaryUInt32(f, pend, prefix.headersize);
+    ReadBinaryUInt32(f, pend, prefix.dataoffset);
+    ReadBinaryUInt32(f, pend, prefix.reserved);
+    ReadBinaryUInt64(f, pend, prefix.numvalues);
+}
+
+/// \brief throws if the trajectory described by prefix cannot be read by this build
+inline void CheckBinaryTrajectoryPrefix(const BinaryTrajectoryPrefix& prefix)
+{
+    if( prefix.endianmarker != BINARY_TRAJECTORY_ENDIAN_MARKER ) {
+        throw OPENRAVE_EXCEPTION_FORMAT0(_("binary trajectory was written with a different byte order"), ORE_InvalidArguments);
+    }
+    if( prefix.realsize != sizeof(dReal) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("binary trajectory was written with %d byte reals, but dReal is %d bytes"), prefix.realsize%sizeof(dReal), ORE_InvalidArguments);
+    }
+    if( prefix.headersize < BINARY_TRAJECTORY_PREFIX_SIZE || prefix.dataoffset < prefix.headersize || (prefix.dataoffset % sizeof(dReal)) != 0 ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("binary trajectory has invalid header size %d and data offset %d"), prefix.headersize%prefix.dataoffset, ORE_InvalidArguments);
+    }
+    if( prefix.numvalues > (std::numeric_limits<size_t>::max()-prefix.dataoffset)/sizeof(dReal) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("binary trajectory has too many values (%d)"), prefix.numvalues, ORE_InvalidArguments);
+    }
+}
+
+/** \brief waypoint values of a GenericTrajectory.
+
+    Either owns the values, or is a read-only view of values owned by someone else (for example a memory-mapped trajectory file) that is kept alive as long as the view. Reading has the same interface as a const std::vector, modifying has to go through GetVector, which throws if the buffer is a view.
+ */
+class WaypointBuffer
+{
+public:
+    WaypointBuffer() : _pview(NULL), _nviewsize(0) {
+    }
+
+    inline size_t size() const {
+        return !!_pview ? _nviewsize : _vdata.size();
+    }
+    inline const dReal* begin() const {
+        return !!_pview ? _pview : _vdata.data();
+    }
+    inline const dReal* end() const {
+        return begin()+size();
+    }
+    inline const dReal& operator[](size_t index) const {
+        return begin()[index];
+    }
+    inline const dReal& at(size_t index) const {
+        OPENRAVE_ASSERT_OP(index,<,size());
+        return begin()[index];
+    }
+
+    /// \brief true if the values are not owned
+    inline bool IsView() const {
+        return !!_pview;
+    }
+
+    /// \brief returns the owned values for modification
+    ///
+    /// \throw openrave_exception if the buffer is a read-only view
+    std::vector<dReal>& GetVector()
+    {
+        if( !!_pview ) {
+            throw OPENRAVE_EXCEPTION_FORMAT0(_("trajectory waypoints are a read-only view and cannot be modified"), ORE_InvalidState);
+        }
+        return _vdata;
+    }
+
+    /// \brief makes the buffer a view of numvalues values starting at pvalues, powner is held as long as the view
+    void SetView(const dReal* pvalues, size_t numvalues, boost::shared_ptr<void const> powner)
+    {
+        _vdata.clear();
+        _pview = pvalues;
+        _nviewsize = numvalues;
+        _powner = powner;
+    }
+
+    /// \brief removes all the values, afterwards the buffer owns its values again
+    void clear()
+    {
+        _vdata.clear();
+        _pview = NULL;
+        _nviewsize = 0;
+        _powner.reset();
+    }
+
+    void swap(WaypointBuffer& r)
+    {
+        _vdata.swap(r._vdata);
+        std::swap(_pview, r._pview);
+        std::swap(_nviewsize, r._nviewsize);
+        _powner.swap(r._powner);
+    }
+
+private:
+    std::vector<dReal> _vdata; ///< the values when the buffer is not a view
+    const dReal* _pview; ///< if not NULL, the values of the view
+    size_t _nviewsize;
+    boost::shared_ptr<void const> _powner; ///< keeps the memory of the view alive
+};
+
 class GenericTrajectory : public TrajectoryBase
 {
     std::map<string,int> _maporder;
 public:
-    GenericTrajectory(EnvironmentBasePtr penv, std::istream& sinput) : TrajectoryBase(penv), _timeoffset(-1)
+    GenericTrajectory(EnvironmentBasePtr penv, std::istream& sinput) : TrajectoryBase(penv), _timeoffset(-1), _nSegmentCoeffsStride(0), _nUnchangedWaypoints(0)
     {
         _maporder["deltatime"] = 0;
         _maporder["joint_snaps"] = 1;
@@ -227,6 +400,8 @@ public:
             _bInit = false;
             _vgroupinterpolators.resize(0);
             _vgroupvalidators.resize(0);
+            _vgroupcoefficientfns.resize(0);
+            _vgroupdegrees.resize(0);
             _vderivoffsets.resize(0);
             _vddoffsets.resize(0);
             _vdddoffsets.resize(0);
@@ -246,6 +421,8 @@ public:
         _vtrajdata.clear();
         _vaccumtime.clear();
         _vdeltainvtime.clear();
+        _vsegmentcoeffstates.clear();
+        _nUnchangedWaypoints = 0;
         _bChanged = true;
         _bSamplingVerified = false;
         _bInit = true;
@@ -258,6 +435,8 @@ public:
                 _bSamplingVerified = false;
                 _bChanged = true;
                 _vtrajdata.clear();
+                _vsegmentcoeffstates.clear();
+                _nUnchangedWaypoints = 0;
             }
         }
     }
@@ -277,15 +456,20 @@ public:
         BOOST_ASSERT(_spec.GetDOF()>0);
         OPENRAVE_ASSERT_FORMAT((nDataElements%_spec.GetDOF()) == 0, "%d does not divide dof %d", nDataElements%_spec.GetDOF(), ORE_InvalidArguments);
         OPENRAVE_ASSERT_OP(index*_spec.GetDOF(),<=,_vtrajdata.size());
-        if( bOverwrite && index*_spec.GetDOF() < _vtrajdata.size() ) {
-            const size_t copysize = min(nDataElements, _vtrajdata.size()-index*_spec.GetDOF());
-            std::copy(pdata, pdata+copysize, _vtrajdata.begin()+index*_spec.GetDOF());
+        std::vector<dReal>& vtrajdata = _vtrajdata.GetVector();
+        _nUnchangedWaypoints = min(_nUnchangedWaypoints, index);
+        if( bOverwrite && index*_spec.GetDOF() < vtrajdata.size() ) {
+            const size_t copysize = min(nDataElements, vtrajdata.size()-index*_spec.GetDOF());
+            _InvalidateOverwrittenSegments(index, copysize/_spec.GetDOF());
+            std::copy(pdata, pdata+copysize, vtrajdata.begin()+index*_spec.GetDOF());
             if( copysize < nDataElements ) {
-                _vtrajdata.insert(_vtrajdata.end(), pdata+copysize, pdata+nDataElements);
+                _InvalidateInsertedSegments(GetNumWaypoints(), (nDataElements-copysize)/_spec.GetDOF());
+                vtrajdata.insert(vtrajdata.end(), pdata+copysize, pdata+nDataElements);
             }
         }
         else {
-            _vtrajdata.insert(_vtrajdata.begin()+index*_spec.GetDOF(), pdata, pdata+nDataElements);
+            _InvalidateInsertedSegments(index, nDataElements/_spec.GetDOF());
+            vtrajdata.insert(vtrajdata.begin()+index*_spec.GetDOF(), pdata, pdata+nDataElements);
         }
         _bChanged = true;
     }
@@ -308,6 +492,8 @@ public:
             Insert(index, pdata, nDataElements, bOverwrite);
         }
         else {
+            std::vector<dReal>& vtrajdata = _vtrajdata.GetVector();
+            _nUnchangedWaypoints = min(_nUnchangedWaypoints, index);
             std::vector< std::vector<ConfigurationSpecification::Group>::const_iterator > vconvertgroups(_spec._vgroups.size());
             for(size_t i = 0; i < vconvertgroups.size(); ++i) {
                 vconvertgroups[i] = spec.FindCompatibleGroup(_spec._vgroups[i]);
@@ -315,9 +501,10 @@ public:
             size_t numpoints = nDataElements/spec.GetDOF();
             size_t sourceindex = 0;
             std::vector<dReal>::iterator ittargetdata;
-            if( bOverwrite && index*_spec.GetDOF() < _vtrajdata.size() ) {
-                size_t copyelements = min(numpoints,_vtrajdata.size()/_spec.GetDOF()-index);
-                ittargetdata = _vtrajdata.begin()+index*_spec.GetDOF();
+            if( bOverwrite && index*_spec.GetDOF() < vtrajdata.size() ) {
+                size_t copyelements = min(numpoints,vtrajdata.size()/_spec.GetDOF()-index);
+                ittargetdata = vtrajdata.begin()+index*_spec.GetDOF();
+                _InvalidateOverwrittenSegments(index, copyelements);
                 _ConvertData(ittargetdata, pdata, vconvertgroups, spec, copyelements, false);
                 sourceindex = copyelements*spec.GetDOF();
                 index += copyelements;
@@ -327,7 +514,8 @@ public:
                 std::vector<dReal> vtemp(numelements*_spec.GetDOF());
                 ittargetdata = vtemp.begin();
                 _ConvertData(ittargetdata, pdata+sourceindex, vconvertgroups, spec, numelements, true);
-                _vtrajdata.insert(_vtrajdata.begin()+index*_spec.GetDOF(),vtemp.begin(),vtemp.end());
+                _InvalidateInsertedSegments(index, numelements);
+                vtrajdata.insert(vtrajdata.begin()+index*_spec.GetDOF(),vtemp.begin(),vtemp.end());
             }
             _bChanged = true;
         }
@@ -341,7 +529,10 @@ public:
         }
         BOOST_ASSERT(startindex*_spec.GetDOF() <= _vtrajdata.size() && endindex*_spec.GetDOF() <= _vtrajdata.size());
         OPENRAVE_ASSERT_OP(startindex,<,endindex);
-        _vtrajdata.erase(_vtrajdata.begin()+startindex*_spec.GetDOF(),_vtrajdata.begin()+endindex*_spec.GetDOF());
+        std::vector<dReal>& vtrajdata = _vtrajdata.GetVector();
+        _nUnchangedWaypoints = min(_nUnchangedWaypoints, startindex);
+        _InvalidateRemovedSegments(startindex, endindex);
+        vtrajdata.erase(vtrajdata.begin()+startindex*_spec.GetDOF(),vtrajdata.begin()+endindex*_spec.GetDOF());
         _bChanged = true;
     }
 
@@ -378,11 +569,7 @@ public:
                 else if( deltatime > waypointdeltatime ) {
                     deltatime = waypointdeltatime;
                 }
-                for(size_t i = 0; i < _vgroupinterpolators.size(); ++i) {
-                    if( !!_vgroupinterpolators[i] ) {
-                        _vgroupinterpolators[i](index-1,deltatime,data.begin());
-                    }
-                }
+                _InterpolateSegment(index-1,deltatime,data.begin());
                 // should return the sample time relative to the last endpoint so it is easier to re-insert in the trajectory
                 data.at(_timeoffset) = deltatime;
             }
@@ -425,11 +612,7 @@ public:
                 else if( deltatime > waypointdeltatime ) {
                     deltatime = waypointdeltatime;
                 }
-                for(size_t i = 0; i < _vgroupinterpolators.size(); ++i) {
-                    if( !!_vgroupinterpolators[i] ) {
-                        _vgroupinterpolators[i](index-1,deltatime,vinternaldata.begin());
-                    }
-                }
+                _InterpolateSegment(index-1,deltatime,vinternaldata.begin());
                 // should return the sample time relative to the last endpoint so it is easier to re-insert in the trajectory
                 vinternaldata.at(_timeoffset) = deltatime;
 
@@ -438,6 +621,21 @@ public:
         }
     }
 
+    void SamplePoints(std::vector<dReal>& data, const std::vector<dReal>& times) const override
+    {
+        BOOST_ASSERT(_bInit);
+        BOOST_ASSERT(_timeoffset>=0);
+        _ComputeInternal();
+        OPENRAVE_ASSERT_OP_FORMAT0((int)_vtrajdata.size(),>=,_spec.GetDOF(), "trajectory needs at least one point to sample from", ORE_InvalidArguments);
+        if( IS_DEBUGLEVEL(Level_Verbose) || (RaveGetDebugLevel() & Level_VerifyPlans) ) {
+            _VerifySampling();
+        }
+        data.resize(_spec.GetDOF()*times.size());
+        if( times.size() > 0 ) {
+            _SamplePoints(&times[0], times.size(), data.begin());
+        }
+    }
+
     void SamplePointsSameDeltaTime(std::vector<dReal>& data, dReal deltatime, bool ensureLastPoint) const override
     {
         BOOST_ASSERT(_bInit);
@@ -455,53 +653,20 @@ public:
         }
 
         int dof = GetConfigurationSpecification().GetDOF();
-        //std::vector<dReal> dataPerTimestep(dof,0);
         data.resize(dof*numPoints);
 
-        const std::vector<dReal>::const_iterator begin = _vaccumtime.begin();
-        std::vector<dReal>::const_iterator it = begin;
-
-        std::vector<dReal>::iterator itdata = data.begin();
-
-        for(int i = 0; i < (ensureLastPoint ? numPoints-1 : numPoints); ++i, itdata += dof) {
-            dReal sampletime = i * deltatime;
-            if( sampletime >= duration ) {
-                std::copy(_vtrajdata.end() - _spec.GetDOF(), _vtrajdata.end(), itdata);
-            }
-            else {
-                // knowing time always increases, it is safe to search in [it, end] instead of [begin, end]
-                it = std::lower_bound(it, _vaccumtime.cend(), sampletime);
-
-                if( it == begin ) {
-                    std::copy(_vtrajdata.begin(),_vtrajdata.begin()+_spec.GetDOF(),itdata);
-                    *(itdata + _timeoffset) = sampletime;
-                }
-                else {
-                    size_t index = it - begin;
-                    dReal timeFromLowerWaypoint = sampletime - _vaccumtime.at(index-1);
-                    dReal waypointdeltatime = _vtrajdata.at(_spec.GetDOF()*index + _timeoffset);
-                    // unfortunately due to floating-point error timeFromLowerWaypoint might not be in the range [0, waypointdeltatime], so double check!
-                    if( timeFromLowerWaypoint < 0 ) {
-                        // most likely small epsilon
-                        timeFromLowerWaypoint = 0;
-                    }
-                    else if( timeFromLowerWaypoint > waypointdeltatime ) {
-                        timeFromLowerWaypoint = waypointdeltatime;
-                    }
-                    for(size_t j = 0; j < _vgroupinterpolators.size(); ++j) {
-                        if( !!_vgroupinterpolators[j] ) {
-                            _vgroupinterpolators[j](index-1, timeFromLowerWaypoint, itdata);
-                        }
-                    }
-                    // should return the sample time relative to the last endpoint so it is easier to re-insert in the trajectory
-                    *(itdata + _timeoffset) = timeFromLowerWaypoint;
-                }
+        int numSampledPoints = ensureLastPoint ? numPoints-1 : numPoints;
+        if( numSampledPoints > 0 ) {
+            std::vector<dReal> vsampletimes(numSampledPoints);
+            for(int i = 0; i < numSampledPoints; ++i) {
+                vsampletimes[i] = i * deltatime;
             }
+            _SamplePoints(&vsampletimes[0], numSampledPoints, data.begin());
         }
 
-        if (ensureLastPoint) {
-            // copy the last point, itdata should point to that
-            std::copy(_vtrajdata.end() - _spec.GetDOF(), _vtrajdata.end(), itdata);
+        if (ensureLastPoint && numPoints > 0) {
+            // copy the last point
+            std::copy(_vtrajdata.end() - _spec.GetDOF(), _vtrajdata.end(), data.begin() + numSampledPoints*dof);
         }
     }
 
@@ -586,88 +751,52 @@ public:
     // New feature: Store trajectory file in binary
     void serialize(std::ostream& O, int options) const override
     {
-        dReal fUnitScale = 1.0;
         if( options & 0x8000 ) {
             TrajectoryBase::serialize(O, options);
         }
-        else {
-            // NOTE: Ignore 'options' argument for now
-
+        else if( !(options & BINARY_TRAJECTORY_ALIGNED_SERIALIZATION_OPTION) ) {
             // Write binary file header
             WriteBinaryUInt16(O, BINARY_TRAJECTORY_MAGIC_NUMBER);
-            WriteBinaryUInt16(O, BINARY_TRAJECTORY_VERSION_NUMBER);
-
-            /* Store meta-data */
+            WriteBinaryUInt16(O, BINARY_TRAJECTORY_DEFAULT_VERSION_NUMBER);
+            _SerializeBinarySpec(O);
 
-            // Indicate size of meta data
-            const ConfigurationSpecification& spec = this->GetConfigurationSpecification();
-            const uint16_t numGroups = spec._vgroups.size();
-            WriteBinaryUInt16(O, numGroups);
-
-            FOREACHC(itgroup, spec._vgroups)
-            {
-                WriteBinaryString(O, itgroup->name);   // Writes group name
-                WriteBinaryInt(O, itgroup->offset);    // Writes offset
-                WriteBinaryInt(O, itgroup->dof);       // Writes dof
-                WriteBinaryString(O, itgroup->interpolation);  // Writes interpolation
+            /* Store data waypoints */
+            const uint32_t numDataPoints = _vtrajdata.size();
+            WriteBinaryUInt32(O, numDataPoints);
+            if( numDataPoints > 0 ) {
+                O.write((const char*)_vtrajdata.begin(), numDataPoints*sizeof(dReal));
             }
 
-            /* Store data waypoints */
-            WriteBinaryVector(O, this->_vtrajdata);
-
-            WriteBinaryString(O, GetDescription());
-
-            // Readable interfaces, added on BINARY_TRAJECTORY_VERSION_NUMBER=0x0002
-            std::stringstream ss;
-            const uint16_t numReadableInterfaces = GetReadableInterfaces().size();
-            WriteBinaryUInt16(O, numReadableInterfaces);
-
-            rapidjson::Document document;
-            int zerooptions = 0;
-            FOREACHC(itReadableInterface, GetReadableInterfaces()) {
-                WriteBinaryString(O, itReadableInterface->first);  // readable interface id
-
-                // try to serialize to json first
-                if (!!itReadableInterface->second) {
-                    rapidjson::Value rReadable;
-                    if( itReadableInterface->second->SerializeJSON(rReadable, document.GetAllocator(), fUnitScale, zerooptions) ) {
-                        WriteBinaryString(O, rReadable.GetString());
-                        WriteBinaryString(O, "StringReadable");
-                        continue;
-                    }
-                    else {
-                        // perhaps XML?
-                        ss.str(std::string());
-                        xmlreaders::StreamXMLWriterPtr writer;
-
-                        // try to serialize to HierarchicalXML
-                        xmlreaders::HierarchicalXMLReadablePtr pHierarchical = OPENRAVE_DYNAMIC_POINTER_CAST<xmlreaders::HierarchicalXMLReadable>(itReadableInterface->second);
-                        if( !!pHierarchical ) {
-                            writer.reset(new xmlreaders::StreamXMLWriter("root")); // need to parse with xml, so need a root
-                            pHierarchical->SerializeXML(writer, options);
-                            writer->Serialize(ss);
+            _SerializeBinaryDescriptionAndReadableInterfaces(O, options);
+        }
+        else {
+            // the prefix holds the size of the spec and readable interfaces, so write them to a buffer first
+            std::stringstream ssheader;
+            _SerializeBinarySpec(ssheader);
+            _SerializeBinaryDescriptionAndReadableInterfaces(ssheader, options);
+            const std::string header = ssheader.str();
+            const uint32_t headersize = BINARY_TRAJECTORY_PREFIX_SIZE + header.size();
+            const uint32_t dataoffset = ((headersize + BINARY_TRAJECTORY_DATA_ALIGNMENT - 1)/BINARY_TRAJECTORY_DATA_ALIGNMENT)*BINARY_TRAJECTORY_DATA_ALIGNMENT;
 
-                            WriteBinaryString(O, ss.str());
-                            WriteBinaryString(O, "HierarchicalXMLReadable");
-                            continue;
-                        }
-                        else {
-                            writer.reset(new xmlreaders::StreamXMLWriter(std::string()));
-                            if( itReadableInterface->second->SerializeXML(writer, zerooptions) ) {
-                                ss.clear();
-                                ss.str(std::string());
-                                writer->Serialize(ss);
-                                WriteBinaryString(O, ss.str());
-                                WriteBinaryString(O, "StringReadable");
-                                continue;
-                            }
-                        }
-                    }
-                }
+            // Write binary file header
+            WriteBinaryUInt16(O, BINARY_TRAJECTORY_MAGIC_NUMBER);
+            WriteBinaryUInt16(O, BINARY_TRAJECTORY_ALIGNED_VERSION_NUMBER);
+            WriteBinaryUInt16(O, sizeof(dReal));
+            WriteBinaryUInt16(O, BINARY_TRAJECTORY_DATA_ALIGNMENT);
+            WriteBinaryUInt32(O, BINARY_TRAJECTORY_ENDIAN_MARKER);
+            WriteBinaryUInt32(O, headersize);
+            WriteBinaryUInt32(O, dataoffset);
+            WriteBinaryUInt32(O, 0);
+            WriteBinaryUInt64(O, _vtrajdata.size());
+            O.write(header.c_str(), header.size());
+
+            // pad so that the waypoints are aligned when the trajectory is mapped in memory
+            static const char s_padding[BINARY_TRAJECTORY_DATA_ALIGNMENT] = {0};
+            O.write(s_padding, dataoffset - headersize);
 
-                // if neither json or xml serializable, write an empty string
-                WriteBinaryString(O, "");
-                WriteBinaryString(O, "StringReadable");
+            /* Store data waypoints */
+            if( _vtrajdata.size() > 0 ) {
+                O.write((const char*)_vtrajdata.begin(), _vtrajdata.size()*sizeof(dReal));
             }
         }
     }
@@ -693,6 +822,38 @@ public:
                 throw OPENRAVE_EXCEPTION_FORMAT(_("unsupported trajectory format version %d "),versionNumber,ORE_InvalidArguments);
             }
 
+            if( versionNumber >= BINARY_TRAJECTORY_ALIGNED_VERSION_NUMBER ) {
+                BinaryTrajectoryPrefix prefix;
+                if( !ReadBinaryTrajectoryPrefix(I, prefix) ) {
+                    throw OPENRAVE_EXCEPTION_FORMAT0(_("cannot read binary trajectory prefix"),ORE_InvalidArguments);
+                }
+                CheckBinaryTrajectoryPrefix(prefix);
+
+                // read the whole header at once and parse it from memory
+                std::vector<uint8_t> vheader(prefix.headersize - BINARY_TRAJECTORY_PREFIX_SIZE);
+                if( vheader.size() > 0 ) {
+                    I.read((char*)&vheader[0], vheader.size());
+                }
+                I.ignore(prefix.dataoffset - prefix.headersize);
+                if( !I ) {
+                    throw OPENRAVE_EXCEPTION_FORMAT0(_("binary trajectory header is truncated"),ORE_InvalidArguments);
+                }
+                const uint8_t* pheader = vheader.data();
+                _DeserializeAlignedBinaryHeader(pheader, vheader.data() + vheader.size(), versionNumber);
+
+                /* Read trajectory data */
+                std::vector<dReal>& vtrajdata = _vtrajdata.GetVector();
+                vtrajdata.resize(prefix.numvalues);
+                if( prefix.numvalues > 0 ) {
+                    I.read((char*)&vtrajdata[0], prefix.numvalues*sizeof(dReal));
+                    if( !I ) {
+                        throw OPENRAVE_EXCEPTION_FORMAT(_("binary trajectory is truncated, expected %d values"),prefix.numvalues,ORE_InvalidArguments);
+                    }
+                }
+                _bChanged = true;
+                return;
+            }
+
             /* Read metadata */
 
             // Read number of groups
@@ -711,53 +872,10 @@ public:
             this->Init(_spec);
 
             /* Read trajectory data */
-            ReadBinaryVector(I, this->_vtrajdata);
+            ReadBinaryVector(I, this->_vtrajdata.GetVector());
             ReadBinaryString(I, __description);
 
-            // clear out existing readable interfaces
-            ClearReadableInterfaces();
-
-            // versions >= 0x0002 have readable interfaces
-            if (versionNumber >= 0x0002) {
-                // read readable interfaces
-                uint16_t numReadableInterfaces = 0;
-                ReadBinaryUInt16(I, numReadableInterfaces);
-                std::string xmlid, readerType;
-                std::string serializedReadableInterface;
-                for (size_t readableInterfaceIndex = 0; readableInterfaceIndex < numReadableInterfaces; ++readableInterfaceIndex) {
-                    ReadBinaryString(I, xmlid);
-                    ReadBinaryString(I, serializedReadableInterface);
-
-                    ReadablePtr readableInterface;
-                    if( versionNumber >= 3 ) {
-                        ReadBinaryString(I, readerType);
-                        if( readerType == "HierarchicalXMLReadable" ) {
-                            xmlreaders::HierarchicalXMLReader xmlreader(xmlid, AttributesList());
-                            xmlreaders::ParseXMLData(xmlreader, serializedReadableInterface.c_str(), serializedReadableInterface.size());
-                            if( !!xmlreader.GetHierarchicalReadable() ) {
-                                // should be one root only
-                                if( xmlreader.GetHierarchicalReadable()->_listchildren.size() == 1 ) {
-                                    readableInterface = xmlreader.GetHierarchicalReadable()->_listchildren.front();
-                                }
-                                else {
-                                    RAVELOG_WARN_FORMAT("tried to parse readable interface %s, but got more than one root", xmlid);
-                                    readableInterface = xmlreader.GetHierarchicalReadable();
-                                }
-                            }
-                            else {
-                                readableInterface = xmlreader.GetReadable();
-                            }
-                        }
-                        else {
-                            readableInterface.reset(new StringReadable(xmlid, serializedReadableInterface));
-                        }
-                    }
-                    else {
-                        readableInterface.reset(new StringReadable(xmlid, serializedReadableInterface));
-                    }
-                    SetReadableInterface(xmlid, readableInterface);
-                }
-            }
+            _DeserializeBinaryReadableInterfaces(I, versionNumber);
         }
         else {
             // try XML deserialization
@@ -770,14 +888,17 @@ public:
     {
         // Check whether binary or XML file
         const uint8_t* I = pdata;
+        const uint8_t* pend = pdata + nDataSize;
         uint16_t binaryFileHeader = 0;
-        ReadBinaryUInt16(I, binaryFileHeader);
+        if( nDataSize >= sizeof(uint16_t) ) {
+            ReadBinaryUInt16(I, pend, binaryFileHeader);
+        }
 
         // Read binary trajectory files
         if (binaryFileHeader == BINARY_TRAJECTORY_MAGIC_NUMBER)
         {
             uint16_t versionNumber = 0;
-            ReadBinaryUInt16(I, versionNumber);
+            ReadBinaryUInt16(I, pend, versionNumber);
 
             // currently supported versions: 0x0001, 0x0002
             if (versionNumber > BINARY_TRAJECTORY_VERSION_NUMBER || versionNumber < 0x0001)
@@ -785,71 +906,34 @@ public:
                 throw OPENRAVE_EXCEPTION_FORMAT(_("unsupported trajectory format version %d "),versionNumber,ORE_InvalidArguments);
             }
 
+            if( versionNumber >= BINARY_TRAJECTORY_ALIGNED_VERSION_NUMBER ) {
+                // the caller owns pdata, so copy the waypoints
+                _DeserializeAlignedBinary(pdata, nDataSize, versionNumber, boost::shared_ptr<void const>());
+                return;
+            }
+
             /* Read metadata */
 
             // Read number of groups
             uint16_t numGroups = 0;
-            ReadBinaryUInt16(I, numGroups);
+            ReadBinaryUInt16(I, pend, numGroups);
 
             _bInit = false;
             _spec._vgroups.resize(numGroups);
             FOREACH(itgroup, _spec._vgroups)
             {
-                ReadBinaryString(I, itgroup->name);             // Read group name
-                ReadBinaryInt(I, itgroup->offset);              // Read offset
-                ReadBinaryInt(I, itgroup->dof);                 // Read dof
-                ReadBinaryString(I, itgroup->interpolation);    // Read interpolation
+                ReadBinaryString(I, pend, itgroup->name);             // Read group name
+                ReadBinaryInt(I, pend, itgroup->offset);              // Read offset
+                ReadBinaryInt(I, pend, itgroup->dof);                 // Read dof
+                ReadBinaryString(I, pend, itgroup->interpolation);    // Read interpolation
             }
             this->Init(_spec);
 
             /* Read trajectory data */
-            ReadBinaryVector(I, this->_vtrajdata);
-            ReadBinaryString(I, __description);
+            ReadBinaryVector(I, pend, this->_vtrajdata.GetVector());
+            ReadBinaryString(I, pend, __description);
 
-            // clear out existing readable interfaces
-            ClearReadableInterfaces();
-
-            // versions >= 0x0002 have readable interfaces
-            if (versionNumber >= 0x0002) {
-                // read readable interfaces
-                uint16_t numReadableInterfaces = 0;
-                ReadBinaryUInt16(I, numReadableInterfaces);
-                std::string xmlid, readerType;
-                std::string serializedReadableInterface;
-                for (size_t readableInterfaceIndex = 0; readableInterfaceIndex < numReadableInterfaces; ++readableInterfaceIndex) {
-                    ReadBinaryString(I, xmlid);
-                    ReadBinaryString(I, serializedReadableInterface);
-
-                    ReadablePtr readableInterface;
-                    if( versionNumber >= 3 ) {
-                        ReadBinaryString(I, readerType);
-                        if( readerType == "HierarchicalXMLReadable" ) {
-                            xmlreaders::HierarchicalXMLReader xmlreader(xmlid, AttributesList());
-                            xmlreaders::ParseXMLData(xmlreader, serializedReadableInterface.c_str(), serializedReadableInterface.size());
-                            if( !!xmlreader.GetHierarchicalReadable() ) {
-                                // should be one root only
-                                if( xmlreader.GetHierarchicalReadable()->_listchildren.size() == 1 ) {
-                                    readableInterface = xmlreader.GetHierarchicalReadable()->_listchildren.front();
-                                }
-                                else {
-                                    RAVELOG_WARN_FORMAT("tried to parse readable interface %s, but got more than one root", xmlid);
-                                    readableInterface = xmlreader.GetHierarchicalReadable();
-                                }
-                            }
-                            else {
-                                readableInterface = xmlreader.GetReadable();
-                            }
-                        }
-                        else {
-                            readableInterface.reset(new StringReadable(xmlid, serializedReadableInterface));
-                        }
-                    }
-                    else {
-                        readableInterface.reset(new StringReadable(xmlid, serializedReadableInterface));
-                    }
-                    SetReadableInterface(xmlid, readableInterface);
-                }
-            }
+            _DeserializeBinaryReadableInterfaces(I, pend, versionNumber);
         }
         else {
             // try XML deserialization
@@ -862,7 +946,7 @@ public:
         InterfaceBase::Clone(preference,cloningoptions);
         TrajectoryBaseConstPtr r = RaveInterfaceConstCast<TrajectoryBase>(preference);
         Init(r->GetConfigurationSpecification());
-        r->GetWaypoints(0,r->GetNumWaypoints(),_vtrajdata);
+        r->GetWaypoints(0,r->GetNumWaypoints(),_vtrajdata.GetVector());
         _bChanged = true;
     }
 
@@ -878,15 +962,230 @@ public:
         _viioffsets.swap(traj->_viioffsets);
         std::swap(_timeoffset, traj->_timeoffset);
         std::swap(_bInit, traj->_bInit);
-        std::swap(_vtrajdata, traj->_vtrajdata);
+        _vtrajdata.swap(traj->_vtrajdata);
         std::swap(_vaccumtime, traj->_vaccumtime);
         std::swap(_vdeltainvtime, traj->_vdeltainvtime);
         std::swap(_bChanged, traj->_bChanged);
+        std::swap(_nUnchangedWaypoints, traj->_nUnchangedWaypoints);
         std::swap(_bSamplingVerified, traj->_bSamplingVerified);
         _InitializeGroupFunctions();
+        // the coefficient layout only depends on the spec, so the cached coefficients of traj stay valid here. traj gets the cleared caches and has to compute them again
+        _vsegmentcoeffs.swap(traj->_vsegmentcoeffs);
+        _vsegmentcoeffstates.swap(traj->_vsegmentcoeffstates);
+        traj->_InitializeGroupFunctions();
+        traj->_bChanged = true;
     }
 
 protected:
+    /// \brief reads the readable interfaces of the binary trajectory format in memory, replacing the existing ones
+    void _DeserializeBinaryReadableInterfaces(const uint8_t*& I, const uint8_t* pend, uint16_t versionNumber)
+    {
+        _DeserializeBinaryReadableInterfacesWith([&I, pend](uint16_t& value) {
+            ReadBinaryUInt16(I, pend, value);
+        }, [&I, pend](std::string& s) {
+            ReadBinaryString(I, pend, s);
+        }, versionNumber);
+    }
+
+    /// \brief reads the readable interfaces of the binary trajectory format from a stream, replacing the existing ones
+    void _DeserializeBinaryReadableInterfaces(std::istream& I, uint16_t versionNumber)
+    {
+        _DeserializeBinaryReadableInterfacesWith([&I](uint16_t& value) {
+            ReadBinaryUInt16(I, value);
+        }, [&I](std::string& s) {
+            ReadBinaryString(I, s);
+        }, versionNumber);
+    }
+
+    /// \brief reads the readable interfaces of the binary trajectory format with readuint16 and readstring, replacing the existing ones
+    template <typename ReadUInt16Fn, typename ReadStringFn>
+    void _DeserializeBinaryReadableInterfacesWith(const ReadUInt16Fn& readuint16, const ReadStringFn& readstring, uint16_t versionNumber)
+    {
+        // clear out existing readable interfaces
+        ClearReadableInterfaces();
+
+        // versions >= 0x0002 have readable interfaces
+        if (versionNumber >= 0x0002) {
+            // read readable interfaces
+            uint16_t numReadableInterfaces = 0;
+            readuint16(numReadableInterfaces);
+            std::string xmlid, readerType;
+            std::string serializedReadableInterface;
+            for (size_t readableInterfaceIndex = 0; readableInterfaceIndex < numReadableInterfaces; ++readableInterfaceIndex) {
+                readstring(xmlid);
+                readstring(serializedReadableInterface);
+
+                ReadablePtr readableInterface;
+                if( versionNumber >= 3 ) {
+                    readstring(readerType);
+                    if( readerType == "HierarchicalXMLReadable" ) {
+                        xmlreaders::HierarchicalXMLReader xmlreader(xmlid, AttributesList());
+                        xmlreaders::ParseXMLData(xmlreader, serializedReadableInterface.c_str(), serializedReadableInterface.size());
+                        if( !!xmlreader.GetHierarchicalReadable() ) {
+                            // should be one root only
+                            if( xmlreader.GetHierarchicalReadable()->_listchildren.size() == 1 ) {
+                                readableInterface = xmlreader.GetHierarchicalReadable()->_listchildren.front();
+                            }
+                            else {
+                                RAVELOG_WARN_FORMAT("tried to parse readable interface %s, but got more than one root", xmlid);
+                                readableInterface = xmlreader.GetHierarchicalReadable();
+                            }
+                        }
+                        else {
+                            readableInterface = xmlreader.GetReadable();
+                        }
+                    }
+                    else {
+                        readableInterface.reset(new StringReadable(xmlid, serializedReadableInterface));
+                    }
+                }
+                else {
+                    readableInterface.reset(new StringReadable(xmlid, serializedReadableInterface));
+                }
+                SetReadableInterface(xmlid, readableInterface);
+            }
+        }
+    }
+
+    /** \brief initializes the trajectory from the binary trajectory format from version BINARY_TRAJECTORY_ALIGNED_VERSION_NUMBER in memory
+
+        \param pdata the start of the trajectory, including the magic and version numbers
+        \param pkeepalive if not empty, the waypoints are not copied. Instead the trajectory becomes a read-only view of them and holds pkeepalive as long as it uses them.
+     */
+    void _DeserializeAlignedBinary(const uint8_t* pdata, size_t nDataSize, uint16_t versionNumber, boost::shared_ptr<void const> pkeepalive)
+    {
+        if( nDataSize < BINARY_TRAJECTORY_PREFIX_SIZE ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("binary trajectory of %d bytes is too small"), nDataSize, ORE_InvalidArguments);
+        }
+        const uint8_t* I = pdata + 2*sizeof(uint16_t);
+        BinaryTrajectoryPrefix prefix;
+        ReadBinaryTrajectoryPrefix(I, pdata + nDataSize, prefix);
+        CheckBinaryTrajectoryPrefix(prefix);
+        if( nDataSize < prefix.dataoffset + prefix.numvalues*sizeof(dReal) ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("binary trajectory is truncated, has %d bytes but needs %d"), nDataSize%(prefix.dataoffset + prefix.numvalues*sizeof(dReal)), ORE_InvalidArguments);
+        }
+        // the header cannot be read past headersize, which is before the waypoints
+        _DeserializeAlignedBinaryHeader(I, pdata + prefix.headersize, versionNumber);
+
+        const uint8_t* pvalues = pdata + prefix.dataoffset;
+        if( !!pkeepalive ) {
+            if( ((uintptr_t)pvalues % sizeof(dReal)) != 0 ) {
+                throw OPENRAVE_EXCEPTION_FORMAT0(_("binary trajectory waypoints are not aligned in memory, cannot use them in place"), ORE_InvalidArguments);
+            }
+            _vtrajdata.SetView(reinterpret_cast<const dReal*>(pvalues), prefix.numvalues, pkeepalive);
+        }
+        else {
+            std::vector<dReal>& vtrajdata = _vtrajdata.GetVector();
+            vtrajdata.resize(prefix.numvalues);
+            if( prefix.numvalues > 0 ) {
+                std::copy(pvalues, pvalues + prefix.numvalues*sizeof(dReal), (uint8_t*)&vtrajdata[0]);
+            }
+        }
+        _bChanged = true;
+    }
+
+    /// \brief reads the spec, description and readable interfaces of the binary trajectory format from version BINARY_TRAJECTORY_ALIGNED_VERSION_NUMBER and initializes the trajectory with the spec
+    ///
+    /// \throw openrave_exception if the header does not fit before pend
+    void _DeserializeAlignedBinaryHeader(const uint8_t*& I, const uint8_t* pend, uint16_t versionNumber)
+    {
+        uint16_t numGroups = 0;
+        ReadBinaryUInt16(I, pend, numGroups);
+
+        _bInit = false;
+        _spec._vgroups.resize(numGroups);
+        FOREACH(itgroup, _spec._vgroups)
+        {
+            ReadBinaryString(I, pend, itgroup->name);             // Read group name
+            ReadBinaryInt(I, pend, itgroup->offset);              // Read offset
+            ReadBinaryInt(I, pend, itgroup->dof);                 // Read dof
+            ReadBinaryString(I, pend, itgroup->interpolation);    // Read interpolation
+        }
+        this->Init(_spec);
+
+        ReadBinaryString(I, pend, __description);
+        _DeserializeBinaryReadableInterfaces(I, pend, versionNumber);
+    }
+
+    /// \brief writes the spec of the binary trajectory format
+    void _SerializeBinarySpec(std::ostream& O) const
+    {
+        /* Store meta-data */
+
+        // Indicate size of meta data
+        const ConfigurationSpecification& spec = this->GetConfigurationSpecification();
+        const uint16_t numGroups = spec._vgroups.size();
+        WriteBinaryUInt16(O, numGroups);
+
+        FOREACHC(itgroup, spec._vgroups)
+        {
+            WriteBinaryString(O, itgroup->name);   // Writes group name
+            WriteBinaryInt(O, itgroup->offset);    // Writes offset
+            WriteBinaryInt(O, itgroup->dof);       // Writes dof
+            WriteBinaryString(O, itgroup->interpolation);  // Writes interpolation
+        }
+    }
+
+    /// \brief writes the description and readable interfaces of the binary trajectory format
+    void _SerializeBinaryDescriptionAndReadableInterfaces(std::ostream& O, int options) const
+    {
+        dReal fUnitScale = 1.0;
+        WriteBinaryString(O, GetDescription());
+
+        // Readable interfaces, added on BINARY_TRAJECTORY_VERSION_NUMBER=0x0002
+        std::stringstream ss;
+        const uint16_t numReadableInterfaces = GetReadableInterfaces().size();
+        WriteBinaryUInt16(O, numReadableInterfaces);
+
+        rapidjson::Document document;
+        int zerooptions = 0;
+        FOREACHC(itReadableInterface, GetReadableInterfaces()) {
+            WriteBinaryString(O, itReadableInterface->first);  // readable interface id
+
+            // try to serialize to json first
+            if (!!itReadableInterface->second) {
+                rapidjson::Value rReadable;
+                if( itReadableInterface->second->SerializeJSON(rReadable, document.GetAllocator(), fUnitScale, zerooptions) ) {
+                    WriteBinaryString(O, rReadable.GetString());
+                    WriteBinaryString(O, "StringReadable");
+                    continue;
+                }
+                else {
+                    // perhaps XML?
+                    ss.str(std::string());
+                    xmlreaders::StreamXMLWriterPtr writer;
+
+                    // try to serialize to HierarchicalXML
+                    xmlreaders::HierarchicalXMLReadablePtr pHierarchical = OPENRAVE_DYNAMIC_POINTER_CAST<xmlreaders::HierarchicalXMLReadable>(itReadableInterface->second);
+                    if( !!pHierarchical ) {
+                        writer.reset(new xmlreaders::StreamXMLWriter("root")); // need to parse with xml, so need a root
+                        pHierarchical->SerializeXML(writer, options);
+                        writer->Serialize(ss);
+
+                        WriteBinaryString(O, ss.str());
+                        WriteBinaryString(O, "HierarchicalXMLReadable");
+                        continue;
+                    }
+                    else {
+                        writer.reset(new xmlreaders::StreamXMLWriter(std::string()));
+                        if( itReadableInterface->second->SerializeXML(writer, zerooptions) ) {
+                            ss.clear();
+                            ss.str(std::string());
+                            writer->Serialize(ss);
+                            WriteBinaryString(O, ss.str());
+                            WriteBinaryString(O, "StringReadable");
+                            continue;
+                        }
+                    }
+                }
+            }
+
+            // if neither json or xml serializable, write an empty string
+            WriteBinaryString(O, "");
+            WriteBinaryString(O, "StringReadable");
+        }
+    }
+
     void _ConvertData(std::vector<dReal>::iterator ittargetdata, const dReal* psourcedata, const std::vector< std::vector<ConfigurationSpecification::Group>::const_iterator >& vconvertgroups, const ConfigurationSpecification& spec, size_t numelements, bool filluninitialized)
     {
         for(size_t igroup = 0; igroup < vconvertgroups.size(); ++igroup) {
@@ -934,9 +1233,14 @@ protected:
             if( _vaccumtime.size() == 0 ) {
                 return;
             }
-            _vaccumtime.at(0) = _vtrajdata.at(_timeoffset);
-            _vdeltainvtime.at(0) = 1/_vtrajdata.at(_timeoffset);
-            for(size_t i = 1; i < _vaccumtime.size(); ++i) {
+            // the times of the waypoints before _nUnchangedWaypoints are still valid, so appending only computes the new waypoints
+            size_t istart = min(_nUnchangedWaypoints, _vaccumtime.size());
+            if( istart == 0 ) {
+                _vaccumtime.at(0) = _vtrajdata.at(_timeoffset);
+                _vdeltainvtime.at(0) = 1/_vtrajdata.at(_timeoffset);
+                istart = 1;
+            }
+            for(size_t i = istart; i < _vaccumtime.size(); ++i) {
                 dReal deltatime = _vtrajdata[_spec.GetDOF()*i+_timeoffset];
                 if( deltatime < 0 ) {
                     throw OPENRAVE_EXCEPTION_FORMAT("deltatime (%.15e) is < 0 at point %d/%d", deltatime%i%_vaccumtime.size(), ORE_InvalidState);
@@ -945,32 +1249,299 @@ protected:
                 _vaccumtime[i] = _vaccumtime[i-1] + deltatime;
             }
         }
+        _nUnchangedWaypoints = _vaccumtime.size();
+        _ComputeSegmentCoefficients();
         _bChanged = false;
         _bSamplingVerified = false;
     }
 
-    /// \brief assumes _ComputeInternal has finished
-    void _VerifySampling() const
+    /// \brief computes the coefficients of the segments that are not cached yet, so that sampling only reads them. called from _ComputeInternal once _vdeltainvtime is valid
+    ///
+    /// Groups that do not have the derivative data to be evaluated are marked SCS_NotPolynomial, so their interpolators throw when the trajectory is sampled, same as without the cache.
+    void _ComputeSegmentCoefficients() const
     {
-        BOOST_ASSERT(!_bChanged);
-        BOOST_ASSERT(_bInit);
-        if( _bSamplingVerified ) {
+        if( _nSegmentCoeffsStride == 0 || _timeoffset < 0 ) {
             return;
         }
-        for(size_t i = 0; i < _vgroupinterpolators.size(); ++i) {
-            if( _spec._vgroups.at(i).offset != _timeoffset ) {
-                if( !_vgroupinterpolators[i] ) {
-                    RAVELOG_WARN(str(boost::format("unknown interpolation method '%s' for group '%s'")%_spec._vgroups.at(i).interpolation%_spec._vgroups.at(i).name));
+        const size_t numwaypoints = GetNumWaypoints();
+        const size_t numsegments = numwaypoints > 0 ? numwaypoints-1 : 0;
+        const size_t numgroups = _vgroupcoeffoffsets.size();
+        if( _vsegmentcoeffstates.size() != numsegments*numgroups ) {
+            // the waypoints were changed without going through the invalidation functions
+            _vsegmentcoeffstates.resize(0);
+            _vsegmentcoeffstates.resize(numsegments*numgroups, SCS_NotComputed);
+            _vsegmentcoeffs.resize(numsegments*_nSegmentCoeffsStride);
+        }
+        for(size_t igroup = 0; igroup < numgroups; ++igroup) {
+            const int coeffoffset = _vgroupcoeffoffsets[igroup];
+            if( coeffoffset < 0 ) {
+                continue;
+            }
+            for(size_t isegment = 0; isegment < numsegments; ++isegment) {
+                uint8_t& state = _vsegmentcoeffstates[isegment*numgroups+igroup];
+                if( state != SCS_NotComputed ) {
+                    continue;
+                }
+                try {
+                    state = _vgroupcoefficientfns[igroup](isegment, &_vsegmentcoeffs[isegment*_nSegmentCoeffsStride+coeffoffset]) ? SCS_Polynomial : SCS_NotPolynomial;
+                }
+                catch(const std::exception&) {
+                    // the missing data is the same for all the segments of the group
+                    for(size_t jsegment = isegment; jsegment < numsegments; ++jsegment) {
+                        _vsegmentcoeffstates[jsegment*numgroups+igroup] = SCS_NotPolynomial;
+                    }
+                    break;
                 }
             }
         }
+    }
 
-        for(size_t i = 0; i < _spec._vgroups.size(); ++i) {
-            const string& interpolation = _spec._vgroups[i].interpolation;
-            const string& name = _spec._vgroups[i].name;
-            for(int j = 0; j < _spec._vgroups[i].dof; ++j) {
-                if( _vderivoffsets.at(_spec._vgroups[i].offset+j) < -2 && _vintegraloffsets.at(_spec._vgroups[i].offset+j) < -2 ) {
-                    throw OPENRAVE_EXCEPTION_FORMAT(_("%s interpolation group '%s' needs derivatives/integrals for sampling"),interpolation%name,ORE_InvalidArguments);
+    /// \brief samples the trajectory at every time in ptimes. assumes _ComputeInternal has finished
+    ///
+    /// All the consecutive times falling in the same segment are evaluated together: the cached polynomial coefficients of every group (see _GetSegmentCoefficients) are evaluated for all the times with loops over the dofs that the compiler can vectorize. Groups that are not polynomials fall back to _vgroupinterpolators. Times do not have to be sorted, but sorted times are the fastest.
+    /// \param itdata holds _spec.GetDOF()*numtimes values
+    void _SamplePoints(const dReal* ptimes, size_t numtimes, std::vector<dReal>::iterator itdata) const
+    {
+        const int dof = _spec.GetDOF();
+        const dReal duration = GetDuration();
+        const std::vector<dReal>::const_iterator itbegin = _vaccumtime.begin();
+        std::vector<dReal>::const_iterator it = itbegin;
+        std::vector<dReal> vsampledeltatimes; // local so that several threads can sample the same trajectory
+        size_t isample = 0;
+        while( isample < numtimes ) {
+            const dReal sampletime = ptimes[isample];
+            std::vector<dReal>::iterator itsampledata = itdata + isample*dof;
+            if( sampletime >= duration ) {
+                std::copy(_vtrajdata.end() - dof, _vtrajdata.end(), itsampledata);
+                ++isample;
+                continue;
+            }
+
+            // the times are usually increasing, so only search from the start if the time is before the current segment
+            if( it != itbegin && sampletime <= *(it-1) ) {
+                it = itbegin;
+            }
+            it = std::lower_bound(it, _vaccumtime.cend(), sampletime);
+            if( it == itbegin ) {
+                std::copy(_vtrajdata.begin(), _vtrajdata.begin()+dof, itsampledata);
+                *(itsampledata + _timeoffset) = sampletime;
+                ++isample;
+                continue;
+            }
+
+            // gather the following times in the same segment (*(it-1), *it]
+            const size_t index = it - itbegin;
+            const dReal segmentstarttime = *(it-1), segmentendtime = *it;
+            const dReal waypointdeltatime = _vtrajdata.at(dof*index + _timeoffset);
+            size_t isampleend = isample;
+            vsampledeltatimes.resize(0);
+            bool bHasPositiveDeltaTime = false;
+            while( isampleend < numtimes && ptimes[isampleend] > segmentstarttime && ptimes[isampleend] <= segmentendtime && ptimes[isampleend] < duration ) {
+                dReal timeFromLowerWaypoint = ptimes[isampleend] - segmentstarttime;
+                // unfortunately due to floating-point error timeFromLowerWaypoint might not be in the range [0, waypointdeltatime], so double check!
+                if( timeFromLowerWaypoint < 0 ) {
+                    // most likely small epsilon
+                    timeFromLowerWaypoint = 0;
+                }
+                else if( timeFromLowerWaypoint > waypointdeltatime ) {
+                    timeFromLowerWaypoint = waypointdeltatime;
+                }
+                if( timeFromLowerWaypoint > g_fEpsilon ) {
+                    bHasPositiveDeltaTime = true;
+                }
+                vsampledeltatimes.push_back(timeFromLowerWaypoint);
+                ++isampleend;
+            }
+            const size_t numsegmentsamples = isampleend - isample;
+
+            for(size_t igroup = 0; igroup < _vgroupinterpolators.size(); ++igroup) {
+                if( !_vgroupinterpolators[igroup] ) {
+                    continue;
+                }
+                const ConfigurationSpecification::Group& g = _spec._vgroups[igroup];
+                const int degree = _vgroupdegrees[igroup];
+                // segments of zero duration have infinite coefficients, so only use them when sampling inside the segment
+                const dReal* pcoeffs = bHasPositiveDeltaTime ? _GetSegmentCoefficients(igroup, index-1) : NULL;
+                if( !!pcoeffs ) {
+                    for(size_t isegmentsample = 0; isegmentsample < numsegmentsamples; ++isegmentsample) {
+                        const dReal t = vsampledeltatimes[isegmentsample];
+                        dReal* pvalues = &*(itdata + (isample+isegmentsample)*dof + g.offset);
+                        if( degree >= 2 && t <= g_fEpsilon ) {
+                            // same as the interpolators, return the waypoint when too close to it
+                            std::copy(pcoeffs, pcoeffs+g.dof, pvalues);
+                            continue;
+                        }
+                        _EvaluateCoefficients(pcoeffs, g.dof, degree, t, pvalues);
+                    }
+                }
+                else {
+                    for(size_t isegmentsample = 0; isegmentsample < numsegmentsamples; ++isegmentsample) {
+                        _vgroupinterpolators[igroup](index-1, vsampledeltatimes[isegmentsample], itdata + (isample+isegmentsample)*dof);
+                    }
+                }
+            }
+
+            for(size_t isegmentsample = 0; isegmentsample < numsegmentsamples; ++isegmentsample) {
+                // should return the sample time relative to the last endpoint so it is easier to re-insert in the trajectory
+                *(itdata + (isample+isegmentsample)*dof + _timeoffset) = vsampledeltatimes[isegmentsample];
+            }
+            isample = isampleend;
+        }
+    }
+
+    /// \brief evaluates the polynomial of every dof at t with Horner's method
+    ///
+    /// \param pcoeffs (degree+1)*dof coefficients laid out as in _ComputeLinearCoefficients
+    static void _EvaluateCoefficients(const dReal* pcoeffs, int dof, int degree, dReal t, dReal* pvalues)
+    {
+        const dReal* pcoeffsdegree = pcoeffs + degree*dof;
+        for(int i = 0; i < dof; ++i) {
+            pvalues[i] = pcoeffsdegree[i];
+        }
+        for(int k = degree-1; k >= 0; --k) {
+            pcoeffsdegree -= dof;
+            for(int i = 0; i < dof; ++i) {
+                pvalues[i] = pcoeffsdegree[i] + t*pvalues[i];
+            }
+        }
+    }
+
+    /// \brief samples all groups of segment isegment (from waypoint isegment to isegment+1) at deltatime from its start. assumes _ComputeInternal has finished
+    void _InterpolateSegment(size_t isegment, dReal deltatime, std::vector<dReal>::iterator itdata) const
+    {
+        for(size_t igroup = 0; igroup < _vgroupinterpolators.size(); ++igroup) {
+            if( !_vgroupinterpolators[igroup] ) {
+                continue;
+            }
+            // close to the waypoint the interpolators copy it, which also handles segments of zero duration
+            const dReal* pcoeffs = deltatime > g_fEpsilon ? _GetSegmentCoefficients(igroup, isegment) : NULL;
+            if( !!pcoeffs ) {
+                const ConfigurationSpecification::Group& g = _spec._vgroups[igroup];
+                _EvaluateCoefficients(pcoeffs, g.dof, _vgroupdegrees[igroup], deltatime, &*(itdata + g.offset));
+            }
+            else {
+                _vgroupinterpolators[igroup](isegment, deltatime, itdata);
+            }
+        }
+    }
+
+    /// \brief returns the cached polynomial coefficients of group igroup for segment isegment. assumes _ComputeInternal has finished
+    ///
+    /// \return NULL if the group cannot be evaluated as a polynomial on the segment, in which case the interpolator has to be used
+    const dReal* _GetSegmentCoefficients(size_t igroup, size_t isegment) const
+    {
+        const int coeffoffset = _vgroupcoeffoffsets[igroup];
+        if( coeffoffset < 0 || _vsegmentcoeffstates.at(isegment*_vgroupcoeffoffsets.size()+igroup) != SCS_Polynomial ) {
+            return NULL;
+        }
+        return &_vsegmentcoeffs[isegment*_nSegmentCoeffsStride+coeffoffset];
+    }
+
+    /// \brief returns true if the coefficient cache matches the current waypoints, which have not been modified yet
+    bool _IsSegmentCoefficientCacheValid() const
+    {
+        const size_t numwaypoints = GetNumWaypoints();
+        return numwaypoints > 1 && _vsegmentcoeffstates.size() == (numwaypoints-1)*_vgroupcoeffoffsets.size();
+    }
+
+    /// \brief replaces numremoved cached segments starting at startsegment by numinserted uncomputed ones
+    void _ReplaceSegmentCoefficients(size_t startsegment, size_t numremoved, size_t numinserted)
+    {
+        const size_t numgroups = _vgroupcoeffoffsets.size();
+        _vsegmentcoeffstates.erase(_vsegmentcoeffstates.begin()+startsegment*numgroups, _vsegmentcoeffstates.begin()+(startsegment+numremoved)*numgroups);
+        _vsegmentcoeffstates.insert(_vsegmentcoeffstates.begin()+startsegment*numgroups, numinserted*numgroups, SCS_NotComputed);
+        _vsegmentcoeffs.erase(_vsegmentcoeffs.begin()+startsegment*_nSegmentCoeffsStride, _vsegmentcoeffs.begin()+(startsegment+numremoved)*_nSegmentCoeffsStride);
+        _vsegmentcoeffs.insert(_vsegmentcoeffs.begin()+startsegment*_nSegmentCoeffsStride, numinserted*_nSegmentCoeffsStride, dReal(0));
+    }
+
+    /// \brief updates the coefficient cache before numpoints waypoints are inserted at index
+    void _InvalidateInsertedSegments(size_t index, size_t numpoints)
+    {
+        if( numpoints == 0 || _nSegmentCoeffsStride == 0 ) {
+            return;
+        }
+        if( !_IsSegmentCoefficientCacheValid() ) {
+            _vsegmentcoeffstates.clear();
+            return;
+        }
+        const size_t numwaypoints = GetNumWaypoints();
+        if( index == 0 ) {
+            // the new points and the segment joining them to the old first point
+            _ReplaceSegmentCoefficients(0, 0, numpoints);
+        }
+        else if( index >= numwaypoints ) {
+            _ReplaceSegmentCoefficients(numwaypoints-1, 0, numpoints);
+        }
+        else {
+            // the segment index-1 is split
+            _ReplaceSegmentCoefficients(index-1, 1, numpoints+1);
+        }
+    }
+
+    /// \brief updates the coefficient cache before the numpoints existing waypoints starting at index are overwritten
+    void _InvalidateOverwrittenSegments(size_t index, size_t numpoints)
+    {
+        if( numpoints == 0 || _nSegmentCoeffsStride == 0 ) {
+            return;
+        }
+        if( !_IsSegmentCoefficientCacheValid() ) {
+            _vsegmentcoeffstates.clear();
+            return;
+        }
+        // every segment touching one of the overwritten points
+        const size_t numsegments = GetNumWaypoints()-1;
+        const size_t startsegment = index > 0 ? index-1 : 0;
+        const size_t endsegment = min(index+numpoints, numsegments);
+        if( startsegment < endsegment ) {
+            std::fill(_vsegmentcoeffstates.begin()+startsegment*_vgroupcoeffoffsets.size(), _vsegmentcoeffstates.begin()+endsegment*_vgroupcoeffoffsets.size(), (uint8_t)SCS_NotComputed);
+        }
+    }
+
+    /// \brief updates the coefficient cache before the waypoints [startindex, endindex) are removed
+    void _InvalidateRemovedSegments(size_t startindex, size_t endindex)
+    {
+        if( _nSegmentCoeffsStride == 0 ) {
+            return;
+        }
+        const size_t numwaypoints = GetNumWaypoints();
+        if( !_IsSegmentCoefficientCacheValid() || (startindex == 0 && endindex >= numwaypoints) ) {
+            _vsegmentcoeffstates.clear();
+            return;
+        }
+        if( startindex == 0 ) {
+            _ReplaceSegmentCoefficients(0, endindex, 0);
+        }
+        else if( endindex >= numwaypoints ) {
+            _ReplaceSegmentCoefficients(startindex-1, numwaypoints-startindex, 0);
+        }
+        else {
+            // a new segment joins startindex-1 and endindex
+            _ReplaceSegmentCoefficients(startindex-1, endindex-startindex+1, 1);
+        }
+    }
+
+    /// \brief assumes _ComputeInternal has finished
+    void _VerifySampling() const
+    {
+        BOOST_ASSERT(!_bChanged);
+        BOOST_ASSERT(_bInit);
+        if( _bSamplingVerified ) {
+            return;
+        }
+        for(size_t i = 0; i < _vgroupinterpolators.size(); ++i) {
+            if( _spec._vgroups.at(i).offset != _timeoffset ) {
+                if( !_vgroupinterpolators[i] ) {
+                    RAVELOG_WARN(str(boost::format("unknown interpolation method '%s' for group '%s'")%_spec._vgroups.at(i).interpolation%_spec._vgroups.at(i).name));
+                }
+            }
+        }
+
+        for(size_t i = 0; i < _spec._vgroups.size(); ++i) {
+            const string& interpolation = _spec._vgroups[i].interpolation;
+            const string& name = _spec._vgroups[i].name;
+            for(int j = 0; j < _spec._vgroups[i].dof; ++j) {
+                if( _vderivoffsets.at(_spec._vgroups[i].offset+j) < -2 && _vintegraloffsets.at(_spec._vgroups[i].offset+j) < -2 ) {
+                    throw OPENRAVE_EXCEPTION_FORMAT(_("%s interpolation group '%s' needs derivatives/integrals for sampling"),interpolation%name,ORE_InvalidArguments);
                 }
             }
         }
@@ -1002,6 +1573,10 @@ protected:
         _viioffsets.resize(0);
         _vgroupinterpolators.resize(_spec._vgroups.size());
         _vgroupvalidators.resize(_spec._vgroups.size());
+        _vgroupcoefficientfns.resize(0);
+        _vgroupcoefficientfns.resize(_spec._vgroups.size());
+        _vgroupdegrees.resize(0);
+        _vgroupdegrees.resize(_spec._vgroups.size(), 0);
         _vderivoffsets.resize(_spec.GetDOF(),-1);
         _vddoffsets.resize(_spec.GetDOF(),-1);
         _vdddoffsets.resize(_spec.GetDOF(),-1);
@@ -1030,6 +1605,8 @@ protected:
                 else {
                     _vgroupinterpolators[i] = boost::bind(&GenericTrajectory::_InterpolateLinear,this,boost::ref(_spec._vgroups[i]),_1,_2,_3);
                     _vgroupvalidators[i] = boost::bind(&GenericTrajectory::_ValidateLinear,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                    _vgroupcoefficientfns[i] = boost::bind(&GenericTrajectory::_ComputeLinearCoefficients,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                    _vgroupdegrees[i] = 1;
                 }
                 nNeedNeighboringInfo = 2;
             }
@@ -1046,6 +1623,8 @@ protected:
                 else {
                     _vgroupinterpolators[i] = boost::bind(&GenericTrajectory::_InterpolateQuadratic,this,boost::ref(_spec._vgroups[i]),_1,_2,_3);
                     _vgroupvalidators[i] = boost::bind(&GenericTrajectory::_ValidateQuadratic,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                    _vgroupcoefficientfns[i] = boost::bind(&GenericTrajectory::_ComputeQuadraticCoefficients,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                    _vgroupdegrees[i] = 2;
                 }
                 nNeedNeighboringInfo = 3;
             }
@@ -1060,22 +1639,30 @@ protected:
                 else {
                     _vgroupinterpolators[i] = boost::bind(&GenericTrajectory::_InterpolateCubic,this,boost::ref(_spec._vgroups[i]),_1,_2,_3);
                     _vgroupvalidators[i] = boost::bind(&GenericTrajectory::_ValidateCubic,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                    _vgroupcoefficientfns[i] = boost::bind(&GenericTrajectory::_ComputeCubicCoefficients,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                    _vgroupdegrees[i] = 3;
                 }
                 nNeedNeighboringInfo = 3;
             }
             else if( interpolation == "quartic" ) {
                 _vgroupinterpolators[i] = boost::bind(&GenericTrajectory::_InterpolateQuartic,this,boost::ref(_spec._vgroups[i]),_1,_2,_3);
                 _vgroupvalidators[i] = boost::bind(&GenericTrajectory::_ValidateQuartic,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                _vgroupcoefficientfns[i] = boost::bind(&GenericTrajectory::_ComputeQuarticCoefficients,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                _vgroupdegrees[i] = 4;
                 nNeedNeighboringInfo = 3;
             }
             else if( interpolation == "quintic" ) {
                 _vgroupinterpolators[i] = boost::bind(&GenericTrajectory::_InterpolateQuintic,this,boost::ref(_spec._vgroups[i]),_1,_2,_3);
                 _vgroupvalidators[i] = boost::bind(&GenericTrajectory::_ValidateQuintic,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                _vgroupcoefficientfns[i] = boost::bind(&GenericTrajectory::_ComputeQuinticCoefficients,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                _vgroupdegrees[i] = 5;
                 nNeedNeighboringInfo = 3;
             }
             else if( interpolation == "sextic" ) {
                 _vgroupinterpolators[i] = boost::bind(&GenericTrajectory::_InterpolateSextic,this,boost::ref(_spec._vgroups[i]),_1,_2,_3);
                 _vgroupvalidators[i] = boost::bind(&GenericTrajectory::_ValidateSextic,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                _vgroupcoefficientfns[i] = boost::bind(&GenericTrajectory::_ComputeSexticCoefficients,this,boost::ref(_spec._vgroups[i]),_1,_2);
+                _vgroupdegrees[i] = 6;
                 nNeedNeighboringInfo = 3;
             }
             else if( interpolation == "" ) {
@@ -1186,6 +1773,19 @@ protected:
                 }
             }
         }
+
+        // layout of the coefficients of one segment in _vsegmentcoeffs
+        _vgroupcoeffoffsets.resize(0);
+        _vgroupcoeffoffsets.resize(_spec._vgroups.size(), -1);
+        _nSegmentCoeffsStride = 0;
+        for(size_t i = 0; i < _spec._vgroups.size(); ++i) {
+            if( !!_vgroupcoefficientfns[i] ) {
+                _vgroupcoeffoffsets[i] = _nSegmentCoeffsStride;
+                _nSegmentCoeffsStride += (_vgroupdegrees[i]+1)*_spec._vgroups[i].dof;
+            }
+        }
+        _vsegmentcoeffstates.clear();
+        _vsegmentcoeffs.clear();
     }
 
     void _InterpolatePrevious(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime, const std::vector<dReal>::iterator& itdata)
@@ -1689,6 +2289,207 @@ protected:
         }
     }
 
+    /// \brief computes the coefficients of the linear polynomial of every dof of the group on segment ipoint, same as _InterpolateLinear.
+    ///
+    /// \param[out] pcoeffs coefficient of degree k of dof i is stored at pcoeffs[k*g.dof+i]
+    /// \return false if the segment cannot be represented as a polynomial, in which case the interpolator has to be used
+    bool _ComputeLinearCoefficients(const ConfigurationSpecification::Group& g, size_t ipoint, dReal* pcoeffs)
+    {
+        size_t offset = ipoint*_spec.GetDOF();
+        int derivoffset = _vderivoffsets[g.offset];
+        if( derivoffset < 0 ) {
+            dReal ideltatime = _vdeltainvtime.at(ipoint+1);
+            for(int i = 0; i < g.dof; ++i) {
+                pcoeffs[i] = _vtrajdata[offset+g.offset+i];
+                pcoeffs[g.dof+i] = (_vtrajdata[_spec.GetDOF()+offset+g.offset+i] - _vtrajdata[offset+g.offset+i])*ideltatime;
+            }
+        }
+        else {
+            for(int i = 0; i < g.dof; ++i) {
+                pcoeffs[i] = _vtrajdata[offset+g.offset+i];
+                pcoeffs[g.dof+i] = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
+            }
+        }
+        return true;
+    }
+
+    bool _ComputeQuadraticCoefficients(const ConfigurationSpecification::Group& g, size_t ipoint, dReal* pcoeffs)
+    {
+        size_t offset = ipoint*_spec.GetDOF();
+        int derivoffset = _vderivoffsets[g.offset];
+        dReal ideltatime = _vdeltainvtime.at(ipoint+1);
+        if( derivoffset >= 0 ) {
+            for(int i = 0; i < g.dof; ++i) {
+                dReal deriv0 = _vtrajdata[offset+derivoffset+i];
+                dReal deriv1 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                pcoeffs[i] = _vtrajdata[offset+g.offset+i];
+                pcoeffs[g.dof+i] = deriv0;
+                pcoeffs[2*g.dof+i] = 0.5*ideltatime*(deriv1-deriv0);
+            }
+        }
+        else {
+            dReal ideltatime2 = ideltatime*ideltatime;
+            int integraloffset = _vintegraloffsets[g.offset];
+            for(int i = 0; i < g.dof; ++i) {
+                // see _InterpolateQuadratic
+                dReal integral0 = _vtrajdata[offset+integraloffset+i];
+                dReal integral1 = _vtrajdata[_spec.GetDOF()+offset+integraloffset+i];
+                dReal value0 = _vtrajdata[offset+g.offset+i];
+                dReal value1 = _vtrajdata[_spec.GetDOF()+offset+g.offset+i];
+                dReal c1TimesDelta = 6*(integral1-integral0)*ideltatime - 4*value0 - 2*value1;
+                pcoeffs[i] = value0;
+                pcoeffs[g.dof+i] = c1TimesDelta*ideltatime;
+                pcoeffs[2*g.dof+i] = (value1 - value0 - c1TimesDelta)*ideltatime2;
+            }
+        }
+        return true;
+    }
+
+    bool _ComputeCubicCoefficients(const ConfigurationSpecification::Group& g, size_t ipoint, dReal* pcoeffs)
+    {
+        size_t offset = ipoint*_spec.GetDOF();
+        int derivoffset = _vderivoffsets[g.offset];
+        int integoffset = _vintegraloffsets[g.offset];
+        int iioffset = _viioffsets[g.offset];
+        if( derivoffset >= 0 ) {
+            // see _InterpolateCubic
+            dReal ideltatime = _vdeltainvtime.at(ipoint+1);
+            dReal ideltatime2 = ideltatime*ideltatime;
+            dReal ideltatime3 = ideltatime2*ideltatime;
+            for(int i = 0; i < g.dof; ++i) {
+                dReal deriv0 = _vtrajdata[offset+derivoffset+i];
+                dReal deriv1 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                dReal px = _vtrajdata.at(_spec.GetDOF()+offset+g.offset+i) - _vtrajdata[offset+g.offset+i];
+                pcoeffs[i] = _vtrajdata[offset+g.offset+i];
+                pcoeffs[g.dof+i] = deriv0;
+                pcoeffs[2*g.dof+i] = 3*px*ideltatime2 - (2*deriv0+deriv1)*ideltatime;
+                pcoeffs[3*g.dof+i] = (deriv1+deriv0)*ideltatime2 - 2*px*ideltatime3;
+            }
+            return true;
+        }
+        else if( integoffset >= 0 && iioffset >= 0 ) {
+            // the interpolator depends on the sampled time through the integral terms, so it is not a fixed polynomial
+            return false;
+        }
+        throw OPENRAVE_EXCEPTION_FORMAT0(_("cubic interpolation does not have all data"),ORE_InvalidArguments);
+    }
+
+    bool _ComputeQuarticCoefficients(const ConfigurationSpecification::Group& g, size_t ipoint, dReal* pcoeffs)
+    {
+        size_t offset = ipoint*_spec.GetDOF();
+        int derivoffset = _vderivoffsets[g.offset];
+        int ddoffset = _vddoffsets[g.offset];
+        int integoffset = _vintegraloffsets[g.offset];
+        if( derivoffset >= 0 && ddoffset >= 0 ) {
+            // see _InterpolateQuartic
+            dReal ideltatime = _vdeltainvtime.at(ipoint+1);
+            dReal ideltatime2 = ideltatime*ideltatime;
+            dReal ideltatime3 = ideltatime2*ideltatime;
+            for(int i = 0; i < g.dof; ++i) {
+                dReal deriv0 = _vtrajdata[offset+derivoffset+i];
+                dReal deriv1 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                dReal dd0 = _vtrajdata[offset+ddoffset+i];
+                dReal dd1 = _vtrajdata[_spec.GetDOF()+offset+ddoffset+i];
+                pcoeffs[i] = _vtrajdata[offset+g.offset+i];
+                pcoeffs[g.dof+i] = deriv0;
+                pcoeffs[2*g.dof+i] = 0.5*dd0;
+                pcoeffs[3*g.dof+i] = (deriv1-deriv0)*ideltatime2 - (2*dd0+dd1)*ideltatime/3.0;
+                pcoeffs[4*g.dof+i] = -0.5*(deriv1-deriv0)*ideltatime3 + (dd0 + dd1)*ideltatime2*0.25;
+            }
+        }
+        else if( derivoffset >= 0 && integoffset >= 0 ) {
+            dReal ideltatime = _vdeltainvtime.at(ipoint + 1);
+            dReal ideltatime2 = ideltatime*ideltatime;
+            dReal ideltatime3 = ideltatime2*ideltatime;
+            dReal ideltatime4 = ideltatime3*ideltatime;
+            dReal ideltatime5 = ideltatime4*ideltatime;
+            for(int i = 0; i < g.dof; ++i) {
+                dReal deriv0 = _vtrajdata[offset + derivoffset + i];
+                dReal deriv1 = _vtrajdata[_spec.GetDOF() + offset + derivoffset + i];
+                dReal pos0 = _vtrajdata[offset + g.offset + i];
+                dReal pos1 = _vtrajdata[_spec.GetDOF() + offset + g.offset + i];
+                dReal idiff = _vtrajdata[_spec.GetDOF() + offset + integoffset + i] - _vtrajdata[offset + integoffset + i];
+                pcoeffs[i] = pos0;
+                pcoeffs[g.dof+i] = deriv0;
+                pcoeffs[2*g.dof+i] = (-4.5*deriv0 + 1.5*deriv1)*ideltatime - (18*pos0 + 12*pos1)*ideltatime2 + 30*idiff*ideltatime3;
+                pcoeffs[3*g.dof+i] = (6*deriv0 - 4*deriv1)*ideltatime2     + (32*pos0 + 28*pos1)*ideltatime3 - 60*idiff*ideltatime4;
+                pcoeffs[4*g.dof+i] = 2.5*(deriv1 - deriv0)*ideltatime3     - 15*(pos0 + pos1)*ideltatime4    + 30*idiff*ideltatime5;
+            }
+        }
+        else {
+            throw OPENRAVE_EXCEPTION_FORMAT0(_("cubic interpolation does not have all data"),ORE_InvalidArguments);
+        }
+        return true;
+    }
+
+    bool _ComputeQuinticCoefficients(const ConfigurationSpecification::Group& g, size_t ipoint, dReal* pcoeffs)
+    {
+        size_t offset = ipoint*_spec.GetDOF();
+        int derivoffset = _vderivoffsets[g.offset];
+        int ddoffset = _vddoffsets[g.offset];
+        if( derivoffset >= 0 && ddoffset >= 0 ) {
+            // see _InterpolateQuintic
+            dReal ideltatime = _vdeltainvtime.at(ipoint+1);
+            dReal ideltatime2 = ideltatime*ideltatime;
+            dReal ideltatime3 = ideltatime2*ideltatime;
+            dReal ideltatime4 = ideltatime2*ideltatime2;
+            dReal ideltatime5 = ideltatime4*ideltatime;
+            for(int i = 0; i < g.dof; ++i) {
+                dReal p0 = _vtrajdata[offset+g.offset+i];
+                dReal px = _vtrajdata[_spec.GetDOF()+offset+g.offset+i] - p0;
+                dReal deriv0 = _vtrajdata[offset+derivoffset+i];
+                dReal deriv1 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                dReal dd0 = _vtrajdata[offset+ddoffset+i];
+                dReal dd1 = _vtrajdata[_spec.GetDOF()+offset+ddoffset+i];
+                pcoeffs[i] = p0;
+                pcoeffs[g.dof+i] = deriv0;
+                pcoeffs[2*g.dof+i] = 0.5*dd0;
+                pcoeffs[3*g.dof+i] = (-1.5*dd0 + dd1*0.5)*ideltatime + (-6*deriv0 - 4*deriv1)*ideltatime2 + px*10*ideltatime3;
+                pcoeffs[4*g.dof+i] = (1.5*dd0 - dd1)*ideltatime2 + (8*deriv0 + 7*deriv1)*ideltatime3 - px*15*ideltatime4;
+                pcoeffs[5*g.dof+i] = (-0.5*dd0 + dd1*0.5)*ideltatime3 - (3*deriv0 + 3*deriv1)*ideltatime4 + px*6*ideltatime5;
+            }
+        }
+        else {
+            throw OPENRAVE_EXCEPTION_FORMAT0(_("cubic interpolation does not have all data"),ORE_InvalidArguments);
+        }
+        return true;
+    }
+
+    bool _ComputeSexticCoefficients(const ConfigurationSpecification::Group& g, size_t ipoint, dReal* pcoeffs)
+    {
+        size_t offset = ipoint*_spec.GetDOF();
+        int derivoffset = _vderivoffsets[g.offset];
+        int ddoffset = _vddoffsets[g.offset];
+        int dddoffset = _vdddoffsets[g.offset];
+        if( derivoffset >= 0 && ddoffset >= 0 && dddoffset >= 0 ) {
+            // see _InterpolateSextic
+            dReal ideltatime = _vdeltainvtime.at(ipoint+1);
+            dReal ideltatime2 = ideltatime*ideltatime;
+            dReal ideltatime3 = ideltatime2*ideltatime;
+            dReal ideltatime4 = ideltatime2*ideltatime2;
+            dReal ideltatime5 = ideltatime4*ideltatime;
+            for(int i = 0; i < g.dof; ++i) {
+                dReal deriv0 = _vtrajdata[offset+derivoffset+i];
+                dReal deriv1 = _vtrajdata[_spec.GetDOF()+offset+derivoffset+i];
+                dReal dd0 = _vtrajdata[offset+ddoffset+i];
+                dReal dd1 = _vtrajdata[_spec.GetDOF()+offset+ddoffset+i];
+                dReal ddd0 = _vtrajdata[offset+dddoffset+i];
+                dReal ddd1 = _vtrajdata[_spec.GetDOF()+offset+dddoffset+i];
+                pcoeffs[i] = _vtrajdata[offset+g.offset+i];
+                pcoeffs[g.dof+i] = deriv0;
+                pcoeffs[2*g.dof+i] = 0.5*dd0;
+                pcoeffs[3*g.dof+i] = ddd0/6.0;
+                pcoeffs[4*g.dof+i] = (-1.5*dd0 - dd1)*ideltatime2 + (-0.375*ddd0 + ddd1*0.125)*ideltatime + (-2.5*deriv0 + 2.5*deriv1)*ideltatime3;
+                pcoeffs[5*g.dof+i] = (1.6*dd0 + 1.4*dd1)*ideltatime3 + (0.3*ddd0 - ddd1*0.2)*ideltatime2 + (3*deriv0 - 3*deriv1)*ideltatime4;
+                pcoeffs[6*g.dof+i] = (-dd0 - dd1)*0.5*ideltatime4 + (-ddd0 + ddd1)/12.0*ideltatime3 + (-deriv0 + deriv1)*ideltatime5;
+            }
+        }
+        else {
+            throw OPENRAVE_EXCEPTION_FORMAT0(_("cubic interpolation does not have all data"),ORE_InvalidArguments);
+        }
+        return true;
+    }
+
     void _ValidateLinear(const ConfigurationSpecification::Group& g, size_t ipoint, dReal deltatime)
     {
         size_t offset = ipoint*_spec.GetDOF();
@@ -1750,20 +2551,460 @@ protected:
     ConfigurationSpecification _spec;
     std::vector< boost::function<void(size_t,dReal,const std::vector<dReal>::iterator&)> > _vgroupinterpolators;
     std::vector< boost::function<void(size_t,dReal)> > _vgroupvalidators;
+    std::vector< boost::function<bool(size_t,dReal*)> > _vgroupcoefficientfns; ///< for every polynomial group, computes the coefficients of a segment for _SamplePoints, see _ComputeLinearCoefficients
+    std::vector<int> _vgroupdegrees; ///< for every group with a coefficient function, the degree of its polynomial
     std::vector<int> _vderivoffsets, _vddoffsets, _vdddoffsets; ///< for every group that relies on other info to compute its position, this will point to the derivative offset. -1 if invalid and not needed, -2 if invalid and needed
     std::vector<int> _vintegraloffsets, _viioffsets; ///< for every group that relies on other info to compute its position, this will point to the integral offset (ie the position for a velocity group). -1 if invalid and not needed, -2 if invalid and needed
     int _timeoffset;
 
-    std::vector<dReal> _vtrajdata;
+    WaypointBuffer _vtrajdata;
     mutable std::vector<dReal> _vaccumtime, _vdeltainvtime;
+
+    /// \brief state of a segment in _vsegmentcoeffstates
+    enum SegmentCoefficientState
+    {
+        SCS_NotComputed = 0, ///< the waypoints of the segment changed since the last _ComputeInternal
+        SCS_Polynomial = 1, ///< the coefficients in _vsegmentcoeffs are valid
+        SCS_NotPolynomial = 2, ///< the group does not have the data to be a polynomial on this segment, use its interpolator
+    };
+    std::vector<int> _vgroupcoeffoffsets; ///< for every group, offset of its coefficients inside the coefficients of a segment. -1 if the group has no coefficient function
+    int _nSegmentCoeffsStride; ///< number of coefficients of one segment, sum of (degree+1)*dof of all polynomial groups
+    mutable std::vector<dReal> _vsegmentcoeffs; ///< cached coefficients of every segment, _nSegmentCoeffsStride per segment. computed by _ComputeInternal
+    mutable std::vector<uint8_t> _vsegmentcoeffstates; ///< SegmentCoefficientState for every segment and group, segment-major
     bool _bInit;
     mutable bool _bChanged; ///< if true, then _ComputeInternal() has to be called in order to compute _vaccumtime and _vdeltainvtime
+    mutable size_t _nUnchangedWaypoints; ///< number of first waypoints that were not modified since the last _ComputeInternal, their _vaccumtime and _vdeltainvtime are still valid
     mutable bool _bSamplingVerified; ///< if false, then _VerifySampling() has not be called yet to verify that all points can be sampled.
 };
 
+/** \brief read-only trajectory that samples the waypoints of a binary trajectory file in place from a memory mapping.
+
+    The file has to be written by GenericTrajectory::serialize with the BINARY_TRAJECTORY_ALIGNED_SERIALIZATION_OPTION (0x4000) option, which writes version BINARY_TRAJECTORY_ALIGNED_VERSION_NUMBER. Only the spec, description and readable interfaces are parsed when loading, the waypoints are never copied and clones share the same mapping. Modifying the waypoints throws ORE_InvalidState; Init and ClearWaypoints release the mapping, after which the trajectory behaves like a GenericTrajectory.
+ */
+class MappedTrajectory : public GenericTrajectory
+{
+public:
+    MappedTrajectory(EnvironmentBasePtr penv, std::istream& sinput) : GenericTrajectory(penv,sinput)
+    {
+        RegisterCommand("Load",boost::bind(&MappedTrajectory::_LoadCommand,this,_1,_2),
+                        "Maps a binary trajectory file and uses its waypoints in place. Format is:\n\n  filename\n");
+        std::string filename;
+        sinput >> filename;
+        if( filename.size() > 0 ) {
+            Load(filename);
+        }
+    }
+
+    /// \brief maps filename and initializes the trajectory with it
+    ///
+    /// \throw openrave_exception if the file cannot be mapped or is not in the aligned binary format
+    void Load(const std::string& filename)
+    {
+        boost::shared_ptr<boost::interprocess::mapped_region> pregion(new boost::interprocess::mapped_region());
+        try {
+            boost::interprocess::file_mapping filemapping(filename.c_str(), boost::interprocess::read_only);
+            boost::interprocess::mapped_region(filemapping, boost::interprocess::read_only).swap(*pregion);
+        }
+        catch(const boost::interprocess::interprocess_exception& ex) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("cannot map trajectory file %s: %s"), filename%ex.what(), ORE_InvalidArguments);
+        }
+
+        const uint8_t* pdata = static_cast<const uint8_t*>(pregion->get_address());
+        const size_t datasize = pregion->get_size();
+        const uint8_t* I = pdata;
+        uint16_t binaryFileHeader = 0, versionNumber = 0;
+        if( datasize >= 2*sizeof(uint16_t) ) {
+            ReadBinaryUInt16(I, pdata + datasize, binaryFileHeader);
+            ReadBinaryUInt16(I, pdata + datasize, versionNumber);
+        }
+        if( binaryFileHeader != BINARY_TRAJECTORY_MAGIC_NUMBER || versionNumber < BINARY_TRAJECTORY_ALIGNED_VERSION_NUMBER || versionNumber > BINARY_TRAJECTORY_VERSION_NUMBER ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("trajectory file %s is not a binary trajectory of version %d to %d"), filename%BINARY_TRAJECTORY_ALIGNED_VERSION_NUMBER%BINARY_TRAJECTORY_VERSION_NUMBER, ORE_InvalidArguments);
+        }
+        _DeserializeAlignedBinary(pdata, datasize, versionNumber, pregion);
+    }
+
+    void Clone(InterfaceBaseConstPtr preference, int cloningoptions) override
+    {
+        boost::shared_ptr<MappedTrajectory const> r = boost::dynamic_pointer_cast<MappedTrajectory const>(preference);
+        if( !r || !r->_vtrajdata.IsView() ) {
+            GenericTrajectory::Clone(preference, cloningoptions);
+            return;
+        }
+        InterfaceBase::Clone(preference,cloningoptions);
+        Init(r->GetConfigurationSpecification());
+        // the waypoints are read-only, so share the mapping
+        _vtrajdata = r->_vtrajdata;
+        _bChanged = true;
+    }
+
+protected:
+    bool _LoadCommand(std::ostream& sout, std::istream& sinput)
+    {
+        std::string filename;
+        sinput >> filename;
+        if( !sinput ) {
+            return false;
+        }
+        Load(filename);
+        return true;
+    }
+};
+
+/** \brief append-only trajectory for online execution, where one thread appends new waypoints while another samples it and removes the consumed waypoints.
+
+    Waypoints can only be inserted at the end and removed from the start. Times are measured from the start of the stream (the last Init or ClearWaypoints), so removing consumed waypoints does not change the times of the remaining ones, and sampling before the first remaining waypoint returns it. The waypoints are stored in a GenericTrajectory whose times are only computed for the appended waypoints; removed waypoints are kept until they are as many as the remaining ones, so appending and removing are amortized O(1) per waypoint. All the functions are serialized with a mutex, which is only held for the duration of a single append, remove or sample call.
+ */
+class StreamingTrajectory : public TrajectoryBase
+{
+public:
+    StreamingTrajectory(EnvironmentBasePtr penv, std::istream& sinput) : TrajectoryBase(penv), _numtrimmed(0), _ftimeorigin(0), _ftrimmedtime(0), _ffirstlivetime(0), _timeoffset(-1)
+    {
+        _ptraj.reset(new GenericTrajectory(penv,sinput));
+        RegisterCommand("TrimBefore",boost::bind(&StreamingTrajectory::_TrimBeforeCommand,this,_1,_2),
+                        "Removes the waypoints before the segment containing the time, returns the number of removed waypoints. Format is:\n\n  time\n");
+    }
+
+    void Init(const ConfigurationSpecification& spec) override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ptraj->Init(spec);
+        _UpdateTimeOffset();
+        _ResetStream();
+    }
+
+    void ClearWaypoints() override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ptraj->ClearWaypoints();
+        _ResetStream();
+    }
+
+    void Insert(size_t index, const std::vector<dReal>& data, bool bOverwrite) override
+    {
+        Insert(index, data.size() > 0 ? &data[0] : NULL, data.size(), bOverwrite);
+    }
+
+    void Insert(size_t index, const dReal* pdata, size_t nDataElements, bool bOverwrite) override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _CheckAppendIndex(index);
+        _ptraj->Insert(_ptraj->GetNumWaypoints(), pdata, nDataElements, false);
+    }
+
+    void Insert(size_t index, const std::vector<dReal>& data, const ConfigurationSpecification& spec, bool bOverwrite) override
+    {
+        Insert(index, data.size() > 0 ? &data[0] : NULL, data.size(), spec, bOverwrite);
+    }
+
+    void Insert(size_t index, const dReal* pdata, size_t nDataElements, const ConfigurationSpecification& spec, bool bOverwrite) override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _CheckAppendIndex(index);
+        _ptraj->Insert(_ptraj->GetNumWaypoints(), pdata, nDataElements, spec, false);
+    }
+
+    /// \brief only removing the first waypoints is supported, the times of the remaining waypoints do not change
+    void Remove(size_t startindex, size_t endindex) override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if( startindex != 0 ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("StreamingTrajectory can only remove the first waypoints, startindex is %d"), startindex, ORE_InvalidArguments);
+        }
+        OPENRAVE_ASSERT_OP(endindex,<=,_ptraj->GetNumWaypoints()-_numtrimmed);
+        _Trim(endindex);
+    }
+
+    void Sample(std::vector<dReal>& data, dReal time) const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ptraj->Sample(data, _GetInternalTime(time));
+    }
+
+    void Sample(std::vector<dReal>& data, dReal time, const ConfigurationSpecification& spec, bool reintializeData) const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ptraj->Sample(data, _GetInternalTime(time), spec, reintializeData);
+    }
+
+    void SamplePoints(std::vector<dReal>& data, const std::vector<dReal>& times) const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _vsampletimes.resize(times.size());
+        for(size_t i = 0; i < times.size(); ++i) {
+            _vsampletimes[i] = _GetInternalTime(times[i]);
+        }
+        _ptraj->SamplePoints(data, _vsampletimes);
+    }
+
+    void SamplePoints(std::vector<dReal>& data, const std::vector<dReal>& times, const ConfigurationSpecification& spec) const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _vsampletimes.resize(times.size());
+        for(size_t i = 0; i < times.size(); ++i) {
+            _vsampletimes[i] = _GetInternalTime(times[i]);
+        }
+        _ptraj->SamplePoints(data, _vsampletimes, spec);
+    }
+
+    /// \brief samples from the time of the last removed waypoint (or the start of the stream) to the end
+    void SamplePointsSameDeltaTime(std::vector<dReal>& data, dReal deltatime, bool ensureLastPoint) const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ComputeSameDeltaTimes(deltatime, ensureLastPoint);
+        _ptraj->SamplePoints(data, _vsampletimes);
+    }
+
+    void SamplePointsSameDeltaTime(std::vector<dReal>& data, dReal deltatime, bool ensureLastPoint, const ConfigurationSpecification& spec) const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ComputeSameDeltaTimes(deltatime, ensureLastPoint);
+        _ptraj->SamplePoints(data, _vsampletimes, spec);
+    }
+
+    const ConfigurationSpecification& GetConfigurationSpecification() const override
+    {
+        return _ptraj->GetConfigurationSpecification();
+    }
+
+    size_t GetNumWaypoints() const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _ptraj->GetNumWaypoints()-_numtrimmed;
+    }
+
+    void GetWaypoints(size_t startindex, size_t endindex, std::vector<dReal>& data) const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ptraj->GetWaypoints(startindex+_numtrimmed, endindex+_numtrimmed, data);
+    }
+
+    void GetWaypoints(size_t startindex, size_t endindex, std::vector<dReal>& data, const ConfigurationSpecification& spec) const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ptraj->GetWaypoints(startindex+_numtrimmed, endindex+_numtrimmed, data, spec);
+    }
+
+    size_t GetFirstWaypointIndexAfterTime(dReal time) const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        size_t index = _ptraj->GetFirstWaypointIndexAfterTime(max(time-_ftimeorigin, dReal(0)));
+        return max(index, _numtrimmed)-_numtrimmed;
+    }
+
+    dReal GetDuration() const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _ftimeorigin+_ptraj->GetDuration();
+    }
+
+    /// \brief writes the remaining waypoints as a GenericTrajectory
+    void serialize(std::ostream& O, int options) const override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::stringstream sinput;
+        TrajectoryBasePtr ptraj(new GenericTrajectory(GetEnv(), sinput));
+        ptraj->Init(_ptraj->GetConfigurationSpecification());
+        _ptraj->GetWaypoints(_numtrimmed, _ptraj->GetNumWaypoints(), _vwaypoints);
+        ptraj->Insert(0, _vwaypoints);
+        ptraj->SetDescription(GetDescription());
+        FOREACHC(itreadable, GetReadableInterfaces()) {
+            ptraj->SetReadableInterface(itreadable->first, itreadable->second);
+        }
+        ptraj->serialize(O, options);
+    }
+
+    void deserialize(std::istream& I) override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ptraj->deserialize(I);
+        _CopyFromDeserialized();
+    }
+
+    void DeserializeFromRawData(const uint8_t* pdata, size_t nDataSize) override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ptraj->DeserializeFromRawData(pdata, nDataSize);
+        _CopyFromDeserialized();
+    }
+
+    void Clone(InterfaceBaseConstPtr preference, int cloningoptions) override
+    {
+        InterfaceBase::Clone(preference,cloningoptions);
+        boost::shared_ptr<StreamingTrajectory const> r = boost::dynamic_pointer_cast<StreamingTrajectory const>(preference);
+        std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+        if( !!r ) {
+            std::unique_lock<std::mutex> lockref(r->_mutex, std::defer_lock);
+            std::lock(lock, lockref);
+            _ptraj->Clone(r->_ptraj, cloningoptions);
+            _numtrimmed = r->_numtrimmed;
+            _ftimeorigin = r->_ftimeorigin;
+            _ftrimmedtime = r->_ftrimmedtime;
+            _ffirstlivetime = r->_ffirstlivetime;
+            _timeoffset = r->_timeoffset;
+        }
+        else {
+            lock.lock();
+            _ptraj->Clone(preference, cloningoptions);
+            _UpdateTimeOffset();
+            _ResetStream();
+        }
+    }
+
+    void Swap(TrajectoryBasePtr rawtraj) override
+    {
+        OPENRAVE_ASSERT_OP(GetXMLId(),==,rawtraj->GetXMLId());
+        boost::shared_ptr<StreamingTrajectory> traj = boost::dynamic_pointer_cast<StreamingTrajectory>(rawtraj);
+        std::unique_lock<std::mutex> lock(_mutex, std::defer_lock), locktraj(traj->_mutex, std::defer_lock);
+        std::lock(lock, locktraj);
+        _ptraj.swap(traj->_ptraj);
+        std::swap(_numtrimmed, traj->_numtrimmed);
+        std::swap(_ftimeorigin, traj->_ftimeorigin);
+        std::swap(_ftrimmedtime, traj->_ftrimmedtime);
+        std::swap(_ffirstlivetime, traj->_ffirstlivetime);
+        std::swap(_timeoffset, traj->_timeoffset);
+    }
+
+protected:
+    bool _TrimBeforeCommand(std::ostream& sout, std::istream& sinput)
+    {
+        dReal time = 0;
+        sinput >> time;
+        if( !sinput ) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        const size_t numwaypoints = _ptraj->GetNumWaypoints();
+        // keep the waypoint starting the segment that contains time
+        size_t index = _ptraj->GetFirstWaypointIndexAfterTime(max(time-_ftimeorigin, dReal(0)));
+        size_t numtrim = 0;
+        if( index > _numtrimmed+1 ) {
+            numtrim = min(index, numwaypoints)-1-_numtrimmed;
+        }
+        _Trim(numtrim);
+        sout << numtrim;
+        return true;
+    }
+
+    /// \brief throws if index is not the end of the trajectory. assumes _mutex is locked
+    void _CheckAppendIndex(size_t index) const
+    {
+        const size_t numwaypoints = _ptraj->GetNumWaypoints()-_numtrimmed;
+        if( index != numwaypoints ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("StreamingTrajectory can only append waypoints, index %d is not the end %d"), index%numwaypoints, ORE_InvalidArguments);
+        }
+    }
+
+    /// \brief removes the first numtrim remaining waypoints. assumes _mutex is locked
+    void _Trim(size_t numtrim)
+    {
+        if( numtrim == 0 ) {
+            return;
+        }
+        const size_t numwaypoints = _ptraj->GetNumWaypoints();
+        const size_t newnumtrimmed = _numtrimmed+numtrim;
+        if( _timeoffset >= 0 ) {
+            // internal time of the last removed waypoint and of the new first waypoint
+            const int dof = _ptraj->GetConfigurationSpecification().GetDOF();
+            _ptraj->GetWaypoints(_numtrimmed, min(newnumtrimmed+1, numwaypoints), _vwaypoints);
+            dReal ftrimmedtime = _numtrimmed > 0 ? _ftrimmedtime : 0;
+            for(size_t i = 0; i < numtrim; ++i) {
+                ftrimmedtime += _vwaypoints[i*dof+_timeoffset];
+            }
+            _ftrimmedtime = ftrimmedtime;
+            _ffirstlivetime = newnumtrimmed < numwaypoints ? ftrimmedtime + _vwaypoints[numtrim*dof+_timeoffset] : ftrimmedtime;
+        }
+        _numtrimmed = newnumtrimmed;
+        if( 2*_numtrimmed >= numwaypoints ) {
+            // the removed waypoints are at least half of the stored ones, so erasing them is amortized O(1) per waypoint
+            _ptraj->Remove(0, _numtrimmed);
+            _ftimeorigin += _ftrimmedtime;
+            _numtrimmed = 0;
+            _ftrimmedtime = 0;
+            _ffirstlivetime = 0;
+        }
+    }
+
+    /// \brief converts a stream time to the time of _ptraj. assumes _mutex is locked
+    inline dReal _GetInternalTime(dReal time) const
+    {
+        return max(time-_ftimeorigin, _ffirstlivetime);
+    }
+
+    /// \brief fills _vsampletimes for SamplePointsSameDeltaTime. assumes _mutex is locked
+    void _ComputeSameDeltaTimes(dReal deltatime, bool ensureLastPoint) const
+    {
+        const dReal starttime = _numtrimmed > 0 ? _ftrimmedtime : 0;
+        const dReal duration = _ptraj->GetDuration()-starttime;
+        int numPoints = int(ceil(duration / deltatime)); // ceil to make it behave same way as numpy arange(0, duration, deltatime)
+        if (ensureLastPoint && (numPoints - 1) * deltatime + g_fEpsilon < duration) {
+            numPoints++;
+        }
+        numPoints = max(numPoints, 0);
+        _vsampletimes.resize(numPoints);
+        for(int i = 0; i < numPoints; ++i) {
+            _vsampletimes[i] = max(starttime + i * deltatime, _ffirstlivetime);
+        }
+        if( ensureLastPoint && numPoints > 0 ) {
+            // sampling at the duration returns the last waypoint
+            _vsampletimes.back() = _ptraj->GetDuration();
+        }
+    }
+
+    /// \brief takes the description and readable interfaces of _ptraj after deserializing. assumes _mutex is locked
+    void _CopyFromDeserialized()
+    {
+        SetDescription(_ptraj->GetDescription());
+        ClearReadableInterfaces();
+        FOREACHC(itreadable, _ptraj->GetReadableInterfaces()) {
+            SetReadableInterface(itreadable->first, itreadable->second);
+        }
+        _UpdateTimeOffset();
+        _ResetStream();
+    }
+
+    void _UpdateTimeOffset()
+    {
+        _timeoffset = -1;
+        FOREACHC(itgroup, _ptraj->GetConfigurationSpecification()._vgroups) {
+            if( itgroup->name == "deltatime" ) {
+                _timeoffset = itgroup->offset;
+            }
+        }
+    }
+
+    /// \brief the stream starts again at time 0. assumes _mutex is locked
+    void _ResetStream()
+    {
+        _numtrimmed = 0;
+        _ftimeorigin = 0;
+        _ftrimmedtime = 0;
+        _ffirstlivetime = 0;
+    }
+
+    TrajectoryBasePtr _ptraj; ///< GenericTrajectory, holds the removed waypoints that were not erased yet followed by the remaining waypoints
+    size_t _numtrimmed; ///< number of first waypoints of _ptraj that were removed
+    dReal _ftimeorigin; ///< stream time of time 0 of _ptraj
+    dReal _ftrimmedtime; ///< time in _ptraj of the last removed waypoint, valid if _numtrimmed > 0
+    dReal _ffirstlivetime; ///< time in _ptraj of the first remaining waypoint if _numtrimmed > 0, otherwise 0. sampling before it returns the waypoint
+    int _timeoffset; ///< offset of deltatime in the waypoints, -1 if the trajectory has no time
+    mutable std::vector<dReal> _vwaypoints; ///< cache
+    mutable std::vector<dReal> _vsampletimes; ///< cache
+    mutable std::mutex _mutex; ///< serializes the appending and sampling threads
+};
+
 TrajectoryBasePtr CreateGenericTrajectory(EnvironmentBasePtr penv, std::istream& sinput)
 {
     return TrajectoryBasePtr(new GenericTrajectory(penv,sinput));
 }
 
+TrajectoryBasePtr CreateMappedTrajectory(EnvironmentBasePtr penv, std::istream& sinput)
+{
+    return TrajectoryBasePtr(new MappedTrajectory(penv,sinput));
+}
+
+TrajectoryBasePtr CreateStreamingTrajectory(EnvironmentBasePtr penv, std::istream& sinput)
+{
+    return TrajectoryBasePtr(new StreamingTrajectory(penv,sinput));
+}
+
 }
@@ -103,6 +103,8 @@ class ColladaWriter;
 RobotBasePtr CreateGenericRobot(EnvironmentBasePtr penv, std::istream& sinput);
 MultiControllerBasePtr CreateMultiController(EnvironmentBasePtr penv, std::istream& sinput);
 TrajectoryBasePtr CreateGenericTrajectory(EnvironmentBasePtr penv, std::istream& sinput);
+TrajectoryBasePtr CreateMappedTrajectory(EnvironmentBasePtr penv, std::istream& sinput);
+TrajectoryBasePtr CreateStreamingTrajectory(EnvironmentBasePtr penv, std::istream& sinput);
 PhysicsEngineBasePtr CreateGenericPhysicsEngine(EnvironmentBasePtr penv, std::istream& sinput);
 CollisionCheckerBasePtr CreateGenericCollisionChecker(EnvironmentBasePtr penv, std::istream& sinput);
 
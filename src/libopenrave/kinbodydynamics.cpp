@@ -0,0 +1,505 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 agent
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "libopenrave.h"
+
+#define CHECK_INTERNAL_COMPUTATION OPENRAVE_ASSERT_FORMAT(_nHierarchyComputed == 2, "env=%s, body %s internal structures need to be computed, current value is %d. Are you sure Environment::AddRobot/AddKinBody was called?", GetEnv()->GetNameId()%GetName()%_nHierarchyComputed, ORE_NotInitialized);
+
+namespace OpenRAVE {
+
+namespace {
+
+/// \brief a value and its derivative along one direction. Running the inverse dynamics on these numbers gives the exact partial derivatives of the torques.
+class DualNumber
+{
+public:
+    DualNumber(dReal value=0, dReal derivative=0) : value(value), derivative(derivative) {
+    }
+
+    dReal value, derivative;
+};
+
+inline DualNumber operator+(const DualNumber& a, const DualNumber& b) {
+    return DualNumber(a.value+b.value, a.derivative+b.derivative);
+}
+
+inline DualNumber operator-(const DualNumber& a, const DualNumber& b) {
+    return DualNumber(a.value-b.value, a.derivative-b.derivative);
+}
+
+inline DualNumber operator-(const DualNumber& a) {
+    return DualNumber(-a.value, -a.derivative);
+}
+
+inline DualNumber operator*(const DualNumber& a, const DualNumber& b) {
+    return DualNumber(a.value*b.value, a.value*b.derivative + a.derivative*b.value);
+}
+
+inline DualNumber& operator+=(DualNumber& a, const DualNumber& b) {
+    a.value += b.value;
+    a.derivative += b.derivative;
+    return a;
+}
+
+inline DualNumber sin(const DualNumber& a) {
+    return DualNumber(std::sin(a.value), std::cos(a.value)*a.derivative);
+}
+
+inline DualNumber cos(const DualNumber& a) {
+    return DualNumber(std::cos(a.value), -std::sin(a.value)*a.derivative);
+}
+
+inline dReal GetRealValue(dReal a) {
+    return a;
+}
+
+inline dReal GetRealValue(const DualNumber& a) {
+    return a.value;
+}
+
+template <typename T>
+struct Vector3
+{
+    T x, y, z;
+};
+
+/// \brief row-major 3x3 matrix
+template <typename T>
+struct Matrix3
+{
+    T m[9];
+};
+
+template <typename T>
+inline Vector3<T> operator+(const Vector3<T>& a, const Vector3<T>& b) {
+    return Vector3<T>{a.x+b.x, a.y+b.y, a.z+b.z};
+}
+
+template <typename T>
+inline Vector3<T> operator-(const Vector3<T>& a, const Vector3<T>& b) {
+    return Vector3<T>{a.x-b.x, a.y-b.y, a.z-b.z};
+}
+
+template <typename T>
+inline Vector3<T> operator*(const T& s, const Vector3<T>& v) {
+    return Vector3<T>{s*v.x, s*v.y, s*v.z};
+}
+
+template <typename T>
+inline Vector3<T>& operator+=(Vector3<T>& a, const Vector3<T>& b) {
+    a.x += b.x;
+    a.y += b.y;
+    a.z += b.z;
+    return a;
+}
+
+template <typename T>
+inline T Dot(const Vector3<T>& a, const Vector3<T>& b) {
+    return a.x*b.x + a.y*b.y + a.z*b.z;
+}
+
+template <typename T>
+inline Vector3<T> Cross(const Vector3<T>& a, const Vector3<T>& b) {
+    return Vector3<T>{a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x};
+}
+
+template <typename T>
+inline Vector3<T> operator*(const Matrix3<T>& A, const Vector3<T>& v) {
+    return Vector3<T>{A.m[0]*v.x + A.m[1]*v.y + A.m[2]*v.z, A.m[3]*v.x + A.m[4]*v.y + A.m[5]*v.z, A.m[6]*v.x + A.m[7]*v.y + A.m[8]*v.z};
+}
+
+template <typename T>
+inline Matrix3<T> operator*(const Matrix3<T>& A, const Matrix3<T>& B) {
+    Matrix3<T> C;
+    for(int i = 0; i < 3; ++i) {
+        for(int j = 0; j < 3; ++j) {
+            C.m[3*i+j] = A.m[3*i]*B.m[j] + A.m[3*i+1]*B.m[3+j] + A.m[3*i+2]*B.m[6+j];
+        }
+    }
+    return C;
+}
+
+/// \brief computes A*B*A^T
+template <typename T>
+inline Matrix3<T> MultiplySymmetric(const Matrix3<T>& A, const Matrix3<T>& B) {
+    const Matrix3<T> AB = A*B;
+    Matrix3<T> C;
+    for(int i = 0; i < 3; ++i) {
+        for(int j = 0; j < 3; ++j) {
+            C.m[3*i+j] = AB.m[3*i]*A.m[3*j] + AB.m[3*i+1]*A.m[3*j+1] + AB.m[3*i+2]*A.m[3*j+2];
+        }
+    }
+    return C;
+}
+
+template <typename T>
+inline Vector3<T> ToVector3(const Vector& v) {
+    return Vector3<T>{T(v.x), T(v.y), T(v.z)};
+}
+
+template <typename T>
+inline Matrix3<T> ToMatrix3(const TransformMatrix& t) {
+    Matrix3<T> A;
+    for(int i = 0; i < 3; ++i) {
+        for(int j = 0; j < 3; ++j) {
+            A.m[3*i+j] = T(t.m[4*i+j]);
+        }
+    }
+    return A;
+}
+
+/// \brief rotation of angle around the normalized axis
+template <typename T>
+inline Matrix3<T> ComputeAxisAngleRotation(const Vector3<T>& axis, const T& angle) {
+    using std::sin;
+    using std::cos;
+    const T c = cos(angle), s = sin(angle);
+    const T oneminusc = T(1) - c;
+    Matrix3<T> A;
+    A.m[0] = c + oneminusc*axis.x*axis.x;
+    A.m[1] = oneminusc*axis.x*axis.y - s*axis.z;
+    A.m[2] = oneminusc*axis.x*axis.z + s*axis.y;
+    A.m[3] = oneminusc*axis.y*axis.x + s*axis.z;
+    A.m[4] = c + oneminusc*axis.y*axis.y;
+    A.m[5] = oneminusc*axis.y*axis.z - s*axis.x;
+    A.m[6] = oneminusc*axis.z*axis.x - s*axis.y;
+    A.m[7] = oneminusc*axis.z*axis.y + s*axis.x;
+    A.m[8] = c + oneminusc*axis.z*axis.z;
+    return A;
+}
+
+/// \brief Recursive Newton Euler on the world frame for the scalar type T. Holds the workspace constants converted to T and the buffers for one sample so that many samples can be evaluated without allocating.
+template <typename T>
+class RecursiveNewtonEuler
+{
+public:
+    RecursiveNewtonEuler(const KinBody::InverseDynamicsWorkspace& workspace) : _workspace(workspace)
+    {
+        const size_t numlinks = workspace.vlinks.size();
+        const size_t numjoints = workspace.vjoints.size();
+        _vlinkrotations.resize(numlinks);
+        _vlinkpositions.resize(numlinks);
+        _vlocalcoms.resize(numlinks);
+        _vlocalinertias.resize(numlinks);
+        for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+            const KinBody::InverseDynamicsWorkspace::LinkInertia& linkinertia = workspace.vlinks[ilink];
+            _vlinkrotations[ilink] = ToMatrix3<T>(TransformMatrix(linkinertia.tlink));
+            _vlinkpositions[ilink] = ToVector3<T>(linkinertia.tlink.trans);
+            _vlocalcoms[ilink] = ToVector3<T>(linkinertia.vlocalcom);
+            _vlocalinertias[ilink] = ToMatrix3<T>(linkinertia.localinertia);
+        }
+        _vleftrotations.resize(numjoints);
+        _vlefttranslations.resize(numjoints);
+        _vrightrotations.resize(numjoints);
+        _vrighttranslations.resize(numjoints);
+        _vlocalaxes.resize(numjoints);
+        for(size_t ijoint = 0; ijoint < numjoints; ++ijoint) {
+            const KinBody::InverseDynamicsWorkspace::JointDynamics& jointdynamics = workspace.vjoints[ijoint];
+            _vleftrotations[ijoint] = ToMatrix3<T>(TransformMatrix(jointdynamics.tleft));
+            _vlefttranslations[ijoint] = ToVector3<T>(jointdynamics.tleft.trans);
+            _vrightrotations[ijoint] = ToMatrix3<T>(TransformMatrix(jointdynamics.tright));
+            _vrighttranslations[ijoint] = ToVector3<T>(jointdynamics.tright.trans);
+            _vlocalaxes[ijoint] = ToVector3<T>(jointdynamics.vaxis);
+        }
+        _vrotations.resize(numlinks);
+        _vpositions.resize(numlinks);
+        _vangularvelocities.resize(numlinks);
+        _vangularaccelerations.resize(numlinks);
+        _vlinearaccelerations.resize(numlinks);
+        _vcoms.resize(numlinks);
+        _vforces.resize(numlinks);
+        _vtorques.resize(numlinks);
+        _vlinkscomputed.resize(numlinks);
+        _vjointaxes.resize(numjoints);
+        _vjointanchors.resize(numjoints);
+        _vjointscomputed.resize(numjoints);
+    }
+
+    /// \brief computes the torques of all the dofs
+    ///
+    /// \param pvalues, pvelocities, paccelerations dof values, velocities, and accelerations
+    /// \param[out] ptorques dof torques
+    void Compute(const T* pvalues, const T* pvelocities, const dReal* paccelerations, T* ptorques)
+    {
+        const KinBody::InverseDynamicsWorkspace& workspace = _workspace;
+        const size_t numlinks = workspace.vlinks.size();
+        const size_t numjoints = workspace.vjoints.size();
+        const Vector3<T> vzero{T(0), T(0), T(0)};
+        const Vector3<T> vbaseacceleration = ToVector3<T>(-workspace.vgravity);
+
+        // root links are static and accelerate against gravity so that gravity does not need to be added to every link
+        for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+            _vrotations[ilink] = _vlinkrotations[ilink];
+            _vpositions[ilink] = _vlinkpositions[ilink];
+            _vangularvelocities[ilink] = vzero;
+            _vangularaccelerations[ilink] = vzero;
+            _vlinearaccelerations[ilink] = vbaseacceleration;
+            _vlinkscomputed[ilink] = 0;
+        }
+        _vlinkscomputed[0] = 1;
+
+        // forward pass, velocities and accelerations of the link origins
+        for(size_t ijoint = 0; ijoint < numjoints; ++ijoint) {
+            const KinBody::InverseDynamicsWorkspace::JointDynamics& jointdynamics = workspace.vjoints[ijoint];
+            const int parentindex = jointdynamics.parentlinkindex >= 0 ? jointdynamics.parentlinkindex : 0;
+            const int childindex = jointdynamics.childlinkindex;
+            const Matrix3<T>& Rparent = _vrotations[parentindex];
+            const Vector3<T>& pparent = _vpositions[parentindex];
+            const Vector3<T>& wparent = _vangularvelocities[parentindex];
+            const Vector3<T>& dwparent = _vangularaccelerations[parentindex];
+            _vjointscomputed[ijoint] = 0;
+
+            if( jointdynamics.jointtype == 0 ) {
+                _vrotations[childindex] = Rparent*_vleftrotations[ijoint];
+                _vpositions[childindex] = Rparent*_vlefttranslations[ijoint] + pparent;
+                const Vector3<T> r = _vpositions[childindex] - pparent;
+                _vangularvelocities[childindex] = wparent;
+                _vangularaccelerations[childindex] = dwparent;
+                _vlinearaccelerations[childindex] = _vlinearaccelerations[parentindex] + Cross(dwparent, r) + Cross(wparent, Cross(wparent, r));
+                _vlinkscomputed[childindex] = 1;
+                _vjointscomputed[ijoint] = 1;
+                continue;
+            }
+            if( _vlinkscomputed[childindex] ) {
+                // closed chain, the link was already moved by another joint
+                continue;
+            }
+
+            T value, velocity;
+            dReal acceleration = 0;
+            if( jointdynamics.dofindex >= 0 ) {
+                value = pvalues[jointdynamics.dofindex];
+                velocity = pvelocities[jointdynamics.dofindex];
+                acceleration = paccelerations[jointdynamics.dofindex];
+            }
+            else {
+                value = T(jointdynamics.fixedvalue);
+                velocity = T(0);
+            }
+
+            const Matrix3<T> Rjoint = Rparent*_vleftrotations[ijoint];
+            const Vector3<T> vanchor = Rparent*_vlefttranslations[ijoint] + pparent;
+            const Vector3<T> vaxis = Rjoint*_vlocalaxes[ijoint];
+            const Vector3<T> vaxisvelocity = velocity*vaxis;
+            const Vector3<T> vaxisacceleration = T(acceleration)*vaxis;
+            if( jointdynamics.jointtype == KinBody::JointRevolute ) {
+                const Matrix3<T> Rchild = Rjoint*ComputeAxisAngleRotation(_vlocalaxes[ijoint], value);
+                _vrotations[childindex] = Rchild*_vrightrotations[ijoint];
+                _vpositions[childindex] = vanchor + Rchild*_vrighttranslations[ijoint];
+                const Vector3<T>& wchild = _vangularvelocities[childindex] = wparent + vaxisvelocity;
+                const Vector3<T>& dwchild = _vangularaccelerations[childindex] = dwparent + vaxisacceleration + Cross(wparent, vaxisvelocity);
+                const Vector3<T> rparenttoanchor = vanchor - pparent;
+                const Vector3<T> anchoracceleration = _vlinearaccelerations[parentindex] + Cross(dwparent, rparenttoanchor) + Cross(wparent, Cross(wparent, rparenttoanchor));
+                const Vector3<T> ranchortochild = _vpositions[childindex] - vanchor;
+                _vlinearaccelerations[childindex] = anchoracceleration + Cross(dwchild, ranchortochild) + Cross(wchild, Cross(wchild, ranchortochild));
+            }
+            else {
+                _vrotations[childindex] = Rjoint*_vrightrotations[ijoint];
+                _vpositions[childindex] = vanchor + value*vaxis + Rjoint*_vrighttranslations[ijoint];
+                _vangularvelocities[childindex] = wparent;
+                _vangularaccelerations[childindex] = dwparent;
+                const Vector3<T> r = _vpositions[childindex] - pparent;
+                _vlinearaccelerations[childindex] = _vlinearaccelerations[parentindex] + Cross(dwparent, r) + Cross(wparent, Cross(wparent, r)) + T(2)*Cross(wparent, vaxisvelocity) + vaxisacceleration;
+            }
+            _vjointaxes[ijoint] = vaxis;
+            _vjointanchors[ijoint] = vanchor;
+            _vlinkscomputed[childindex] = 1;
+            _vjointscomputed[ijoint] = 1;
+        }
+
+        // forces and torques needed to accelerate each link about its center of mass
+        for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+            const Vector3<T>& w = _vangularvelocities[ilink];
+            const Vector3<T>& dw = _vangularaccelerations[ilink];
+            const Vector3<T> rcom = _vrotations[ilink]*_vlocalcoms[ilink];
+            _vcoms[ilink] = _vpositions[ilink] + rcom;
+            const Vector3<T> comacceleration = _vlinearaccelerations[ilink] + Cross(dw, rcom) + Cross(w, Cross(w, rcom));
+            const Matrix3<T> inertia = MultiplySymmetric(_vrotations[ilink], _vlocalinertias[ilink]);
+            _vforces[ilink] = T(workspace.vlinks[ilink].mass)*comacceleration;
+            _vtorques[ilink] = inertia*dw + Cross(w, inertia*w);
+        }
+
+        for(int idof = 0; idof < workspace.dof; ++idof) {
+            ptorques[idof] = T(0);
+        }
+
+        // backward pass, project the accumulated force and torque of each subtree on its joint
+        for(int ijoint = (int)numjoints-1; ijoint >= 0; --ijoint) {
+            if( !_vjointscomputed[ijoint] ) {
+                continue;
+            }
+            const KinBody::InverseDynamicsWorkspace::JointDynamics& jointdynamics = workspace.vjoints[ijoint];
+            const int childindex = jointdynamics.childlinkindex;
+            if( jointdynamics.dofindex >= 0 ) {
+                const int dofindex = jointdynamics.dofindex;
+                T torque;
+                if( jointdynamics.jointtype == KinBody::JointRevolute ) {
+                    torque = Dot(_vjointaxes[ijoint], _vtorques[childindex] + Cross(_vcoms[childindex] - _vjointanchors[ijoint], _vforces[childindex]));
+                }
+                else {
+                    // same convention as KinBody::ComputeInverseDynamics
+                    torque = T(1/(2*PI))*Dot(_vjointaxes[ijoint], _vforces[childindex]);
+                }
+
+                const T& velocity = pvelocities[dofindex];
+                if( GetRealValue(velocity) > g_fEpsilonLinear ) {
+                    torque += T(jointdynamics.coulombfriction);
+                }
+                else if( GetRealValue(velocity) < -g_fEpsilonLinear ) {
+                    torque += T(-jointdynamics.coulombfriction);
+                }
+                torque += T(jointdynamics.viscousfriction)*velocity;
+                torque += T(jointdynamics.rotorinertia*paccelerations[dofindex]);
+                ptorques[dofindex] = torque;
+            }
+
+            if( jointdynamics.parentlinkindex >= 0 ) {
+                const int parentindex = jointdynamics.parentlinkindex;
+                _vforces[parentindex] += _vforces[childindex];
+                _vtorques[parentindex] += _vtorques[childindex] + Cross(_vcoms[childindex] - _vcoms[parentindex], _vforces[childindex]);
+            }
+        }
+    }
+
+private:
+    const KinBody::InverseDynamicsWorkspace& _workspace;
+
+    // workspace constants
+    std::vector< Matrix3<T> > _vlinkrotations, _vlocalinertias, _vleftrotations, _vrightrotations;
+    std::vector< Vector3<T> > _vlinkpositions, _vlocalcoms, _vlefttranslations, _vrighttranslations, _vlocalaxes;
+
+    // per sample buffers
+    std::vector< Matrix3<T> > _vrotations;
+    std::vector< Vector3<T> > _vpositions, _vangularvelocities, _vangularaccelerations, _vlinearaccelerations, _vcoms, _vforces, _vtorques;
+    std::vector< Vector3<T> > _vjointaxes, _vjointanchors;
+    std::vector<uint8_t> _vlinkscomputed, _vjointscomputed;
+};
+
+} // end namespace
+
+void KinBody::InverseDynamicsWorkspace::ComputeInverseDynamicsBatch(const dReal* pDOFValues, const dReal* pDOFVelocities, const dReal* pDOFAccelerations, int numsamples, dReal* pDOFTorques, dReal* pTorqueValueDerivatives, dReal* pTorqueVelocityDerivatives) const
+{
+    if( numsamples <= 0 || dof == 0 ) {
+        return;
+    }
+
+    const std::vector<dReal> vzeros(dof, 0);
+    RecursiveNewtonEuler<dReal> rnea(*this);
+    const bool bComputeDerivatives = !!pTorqueValueDerivatives || !!pTorqueVelocityDerivatives;
+    boost::shared_ptr< RecursiveNewtonEuler<DualNumber> > pdualrnea;
+    std::vector<DualNumber> vdualvalues, vdualvelocities, vdualtorques;
+    if( bComputeDerivatives ) {
+        pdualrnea.reset(new RecursiveNewtonEuler<DualNumber>(*this));
+        vdualvalues.resize(dof);
+        vdualvelocities.resize(dof);
+        vdualtorques.resize(dof);
+    }
+
+    for(int isample = 0; isample < numsamples; ++isample) {
+        const dReal* pvalues = pDOFValues + isample*dof;
+        const dReal* pvelocities = !!pDOFVelocities ? pDOFVelocities + isample*dof : vzeros.data();
+        const dReal* paccelerations = !!pDOFAccelerations ? pDOFAccelerations + isample*dof : vzeros.data();
+        rnea.Compute(pvalues, pvelocities, paccelerations, pDOFTorques + isample*dof);
+        if( !bComputeDerivatives ) {
+            continue;
+        }
+
+        // one pass per column, seeding the derivative of one dof value or velocity
+        for(int icolumn = 0; icolumn < 2*dof; ++icolumn) {
+            const bool bValueColumn = icolumn < dof;
+            dReal* pderivatives = bValueColumn ? pTorqueValueDerivatives : pTorqueVelocityDerivatives;
+            if( !pderivatives ) {
+                continue;
+            }
+            const int idofseed = bValueColumn ? icolumn : icolumn - dof;
+            for(int idof = 0; idof < dof; ++idof) {
+                vdualvalues[idof] = DualNumber(pvalues[idof], bValueColumn && idof == idofseed ? 1 : 0);
+                vdualvelocities[idof] = DualNumber(pvelocities[idof], !bValueColumn && idof == idofseed ? 1 : 0);
+            }
+            pdualrnea->Compute(vdualvalues.data(), vdualvelocities.data(), paccelerations, vdualtorques.data());
+            pderivatives += isample*dof*dof;
+            for(int idof = 0; idof < dof; ++idof) {
+                pderivatives[idof*dof+idofseed] = vdualtorques[idof].derivative;
+            }
+        }
+    }
+}
+
+void KinBody::InitInverseDynamicsWorkspace(InverseDynamicsWorkspace& workspace) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    workspace.dof = GetDOF();
+    workspace.vgravity = GetEnv()->GetPhysicsEngine()->GetGravity();
+
+    workspace.vlinks.resize(_veclinks.size());
+    for(size_t ilink = 0; ilink < _veclinks.size(); ++ilink) {
+        const Link& link = *_veclinks[ilink];
+        InverseDynamicsWorkspace::LinkInertia& linkinertia = workspace.vlinks[ilink];
+        linkinertia.mass = link.GetMass();
+        linkinertia.vlocalcom = link.GetLocalCOM();
+        linkinertia.localinertia = link.GetLocalInertia();
+        linkinertia.tlink = link.GetTransform();
+    }
+
+    workspace.vjoints.resize(_vTopologicallySortedJointsAll.size());
+    for(size_t ijoint = 0; ijoint < _vTopologicallySortedJointsAll.size(); ++ijoint) {
+        const Joint& joint = *_vTopologicallySortedJointsAll[ijoint];
+        InverseDynamicsWorkspace::JointDynamics& jointdynamics = workspace.vjoints[ijoint];
+        const LinkPtr& parentlink = joint._attachedbodies[0];
+        jointdynamics.parentlinkindex = !!parentlink ? parentlink->GetIndex() : -1;
+        jointdynamics.childlinkindex = joint._attachedbodies[1]->GetIndex();
+        jointdynamics.dofindex = -1;
+        jointdynamics.tleft = joint.GetInternalHierarchyLeftTransform();
+        jointdynamics.tright = joint.GetInternalHierarchyRightTransform();
+        jointdynamics.vaxis = Vector(0,0,1);
+        jointdynamics.fixedvalue = 0;
+        jointdynamics.coulombfriction = 0;
+        jointdynamics.viscousfriction = 0;
+        jointdynamics.rotorinertia = 0;
+        if( joint.IsStatic() ) {
+            jointdynamics.jointtype = 0;
+            continue;
+        }
+        if( joint.IsMimic() ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("env=%s, body %s joint %s is mimic, which is not supported for inverse dynamics workspaces"), GetEnv()->GetNameId()%GetName()%joint.GetName(), ORE_NotImplemented);
+        }
+        if( joint.GetType() != JointRevolute && joint.GetType() != JointPrismatic ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("env=%s, body %s joint %s has type 0x%x, which is not supported for inverse dynamics workspaces"), GetEnv()->GetNameId()%GetName()%joint.GetName()%joint.GetType(), ORE_NotImplemented);
+        }
+        jointdynamics.jointtype = joint.GetType();
+        jointdynamics.dofindex = joint.GetDOFIndex();
+        jointdynamics.vaxis = joint.GetInternalHierarchyAxis(0);
+        jointdynamics.vaxis.normalize3();
+        if( jointdynamics.dofindex < 0 ) {
+            // passive joints keep their current values
+            jointdynamics.fixedvalue = joint.GetValue(0);
+            if( !joint.IsCircular(0) ) {
+                jointdynamics.fixedvalue = std::min(std::max(jointdynamics.fixedvalue, joint._info._vlowerlimit[0]), joint._info._vupperlimit[0]);
+            }
+        }
+        else if( !!joint._info._infoElectricMotor ) {
+            const ElectricMotorActuatorInfo& actuatorinfo = *joint._info._infoElectricMotor;
+            jointdynamics.coulombfriction = actuatorinfo.coloumb_friction;
+            jointdynamics.viscousfriction = actuatorinfo.viscous_friction;
+            if( actuatorinfo.rotor_inertia > 0.0 ) {
+                // converting inertia on motor side to load side requires multiplying by gear ratio squared because inertia unit is mass * distance^2
+                jointdynamics.rotorinertia = actuatorinfo.rotor_inertia * actuatorinfo.gear_ratio * actuatorinfo.gear_ratio;
+            }
+        }
+    }
+}
+
+} // end namespace OpenRAVE
@@ -0,0 +1,941 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 agent
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "libopenrave.h"
+
+#include <mutex>
+
+#define CHECK_INTERNAL_COMPUTATION OPENRAVE_ASSERT_FORMAT(_nHierarchyComputed == 2, "env=%s, body %s internal structures need to be computed, current value is %d. Are you sure Environment::AddRobot/AddKinBody was called?", GetEnv()->GetNameId()%GetName()%_nHierarchyComputed, ORE_NotInitialized);
+
+namespace OpenRAVE {
+
+namespace {
+
+/// \brief n transforms stored component by component: the rot.x values of all the transforms, then the rot.y values, ..., then the trans.z values.
+class TransformArray
+{
+public:
+    TransformArray(dReal* p, size_t n) : _p(p), _n(n) {
+    }
+
+    inline dReal& operator()(int icomponent, size_t index) const {
+        return _p[icomponent*_n+index];
+    }
+
+private:
+    dReal* _p;
+    size_t _n;
+};
+
+/// \brief the same transform at every index, can be used in place of a TransformArray
+class ConstantTransformArray
+{
+public:
+    ConstantTransformArray(const Transform& t) {
+        _v[0] = t.rot.x; _v[1] = t.rot.y; _v[2] = t.rot.z; _v[3] = t.rot.w;
+        _v[4] = t.trans.x; _v[5] = t.trans.y; _v[6] = t.trans.z;
+    }
+
+    inline dReal operator()(int icomponent, size_t index) const {
+        return _v[icomponent];
+    }
+
+private:
+    dReal _v[7];
+};
+
+inline void _FillTransformArray(const TransformArray& out, const Transform& t, size_t n)
+{
+    const ConstantTransformArray constant(t);
+    for(int icomponent = 0; icomponent < 7; ++icomponent) {
+        for(size_t index = 0; index < n; ++index) {
+            out(icomponent, index) = constant(icomponent, index);
+        }
+    }
+}
+
+/// \brief out[i] = a[i] * b[i] for all the n transforms. Same math as Transform::operator* without branches so that the loop can be vectorized.
+///
+/// out can be the same array as a or b
+template <typename A, typename B>
+void _MultiplyTransformArrays(const A& a, const B& b, const TransformArray& out, size_t n)
+{
+    for(size_t index = 0; index < n; ++index) {
+        const dReal ax = a(0,index), ay = a(1,index), az = a(2,index), aw = a(3,index);
+        const dReal bx = b(0,index), by = b(1,index), bz = b(2,index), bw = b(3,index);
+        const dReal btx = b(4,index), bty = b(5,index), btz = b(6,index);
+
+        const dReal xx = 2 * ay * ay;
+        const dReal xy = 2 * ay * az;
+        const dReal xz = 2 * ay * aw;
+        const dReal xw = 2 * ay * ax;
+        const dReal yy = 2 * az * az;
+        const dReal yz = 2 * az * aw;
+        const dReal yw = 2 * az * ax;
+        const dReal zz = 2 * aw * aw;
+        const dReal zw = 2 * aw * ax;
+        const dReal tx = (1-yy-zz) * btx + (xy-zw) * bty + (xz+yw) * btz + a(4,index);
+        const dReal ty = (xy+zw) * btx + (1-xx-zz) * bty + (yz-xw) * btz + a(5,index);
+        const dReal tz = (xz-yw) * btx + (yz+xw) * bty + (1-xx-yy) * btz + a(6,index);
+
+        const dReal rx = ax*bx - ay*by - az*bz - aw*bw;
+        const dReal ry = ax*by + ay*bx + az*bw - aw*bz;
+        const dReal rz = ax*bz + az*bx + aw*by - ay*bw;
+        const dReal rw = ax*bw + aw*bx + ay*bz - az*by;
+        // always normalize, the quaternions are already close to unit length
+        const dReal flen = std::sqrt(rx*rx + ry*ry + rz*rz + rw*rw);
+
+        out(0,index) = rx/flen;
+        out(1,index) = ry/flen;
+        out(2,index) = rz/flen;
+        out(3,index) = rw/flen;
+        out(4,index) = tx;
+        out(5,index) = ty;
+        out(6,index) = tz;
+    }
+}
+
+/// \brief computes the transform of a joint for its values, same as KinBody::SetDOFValues
+Transform _ComputeJointTransform(const KinBody::Joint& joint, const dReal* pvalues)
+{
+    Transform tjoint;
+    switch(joint.GetType()) {
+    case KinBody::JointRevolute:
+        tjoint.rot = quatFromAxisAngle(joint.GetInternalHierarchyAxis(0), pvalues[0]);
+        break;
+    case KinBody::JointPrismatic:
+        tjoint.trans = joint.GetInternalHierarchyAxis(0) * pvalues[0];
+        break;
+    case KinBody::JointHinge2: {
+        Transform tfirst;
+        tfirst.rot = quatFromAxisAngle(joint.GetInternalHierarchyAxis(0), pvalues[0]);
+        Transform tsecond;
+        tsecond.rot = quatFromAxisAngle(tfirst.rotate(joint.GetInternalHierarchyAxis(1)), pvalues[1]);
+        tjoint = tsecond * tfirst;
+        break;
+    }
+    case KinBody::JointSpherical: {
+        dReal fang = pvalues[0]*pvalues[0]+pvalues[1]*pvalues[1]+pvalues[2]*pvalues[2];
+        if( fang > 0 ) {
+            fang = RaveSqrt(fang);
+            dReal fiang = 1/fang;
+            tjoint.rot = quatFromAxisAngle(Vector(pvalues[0]*fiang,pvalues[1]*fiang,pvalues[2]*fiang),fang);
+        }
+        break;
+    }
+    default:
+        if( joint.GetType() & KinBody::JointSpecialBit ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("forward kinematic type 0x%x of joint %s not supported"), joint.GetType()%joint.GetName(), ORE_NotImplemented);
+        }
+        for(int iaxis = 0; iaxis < joint.GetDOF(); ++iaxis) {
+            Transform tdelta;
+            if( joint.IsRevolute(iaxis) ) {
+                tdelta.rot = quatFromAxisAngle(joint.GetInternalHierarchyAxis(iaxis), pvalues[iaxis]);
+            }
+            else {
+                tdelta.trans = joint.GetInternalHierarchyAxis(iaxis) * pvalues[iaxis];
+            }
+            tjoint = tjoint * tdelta;
+        }
+        break;
+    }
+    return tjoint;
+}
+
+/// \brief protects the evaluation of the mimic equations, the parsers keep their evaluation state
+std::mutex s_mutexMimicEval;
+
+/// \brief adds the contribution v of a jacobian column to a 3xnumcolumns jacobian. A mimic column is spread over the columns of the dofs it depends on.
+inline void _AddJacobianColumn(dReal* pjacobian, int numcolumns, const KinBody::JacobianWorkspace::JacobianColumn& column, const dReal* pMimicPartials, const Vector& v)
+{
+    if( column.imimic < 0 ) {
+        pjacobian[column.icolumn                 ] += v.x;
+        pjacobian[column.icolumn + numcolumns    ] += v.y;
+        pjacobian[column.icolumn + numcolumns * 2] += v.z;
+        return;
+    }
+    const dReal* ppartials = pMimicPartials + column.imimic*numcolumns;
+    for(int icolumn = 0; icolumn < numcolumns; ++icolumn) {
+        const dReal fpartial = ppartials[icolumn];
+        if( fpartial != 0 ) {
+            pjacobian[icolumn                 ] += v.x*fpartial;
+            pjacobian[icolumn + numcolumns    ] += v.y*fpartial;
+            pjacobian[icolumn + numcolumns * 2] += v.z*fpartial;
+        }
+    }
+}
+
+/// \brief adds the second derivative v of the jacobian columns columni and columnj to a numcolumnsx3xnumcolumns hessian, and to its transpose if bSymmetric is true
+inline void _AddHessianTerm(dReal* phessian, int numcolumns, const KinBody::JacobianWorkspace::JacobianColumn& columni, const KinBody::JacobianWorkspace::JacobianColumn& columnj, const dReal* pMimicPartials, const Vector& v, bool bSymmetric)
+{
+    const int stride = 3*numcolumns;
+    const int ibegin = columni.imimic < 0 ? columni.icolumn : 0, iend = columni.imimic < 0 ? columni.icolumn + 1 : numcolumns;
+    const int jbegin = columnj.imimic < 0 ? columnj.icolumn : 0, jend = columnj.imimic < 0 ? columnj.icolumn + 1 : numcolumns;
+    for(int icolumn = ibegin; icolumn < iend; ++icolumn) {
+        const dReal fpartiali = columni.imimic < 0 ? 1 : pMimicPartials[columni.imimic*numcolumns + icolumn];
+        if( fpartiali == 0 ) {
+            continue;
+        }
+        for(int jcolumn = jbegin; jcolumn < jend; ++jcolumn) {
+            const dReal f = fpartiali*(columnj.imimic < 0 ? 1 : pMimicPartials[columnj.imimic*numcolumns + jcolumn]);
+            if( f == 0 ) {
+                continue;
+            }
+            dReal* p = phessian + stride*icolumn + jcolumn;
+            p[0] += v.x*f;
+            p[numcolumns] += v.y*f;
+            p[2*numcolumns] += v.z*f;
+            if( bSymmetric ) {
+                p = phessian + stride*jcolumn + icolumn;
+                p[0] += v.x*f;
+                p[numcolumns] += v.y*f;
+                p[2*numcolumns] += v.z*f;
+            }
+        }
+    }
+}
+
+} // end namespace
+
+void KinBody::ComputeLinkTransformationsBatch(const dReal* pJointValues, int numconfigurations, std::vector<Transform>& vLinkTransforms) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    const size_t numlinks = _veclinks.size();
+    vLinkTransforms.resize(std::max(numconfigurations, 0)*numlinks);
+    if( numconfigurations <= 0 || numlinks == 0 ) {
+        return;
+    }
+    const size_t n = numconfigurations;
+    const int dof = GetDOF();
+
+    // store the values dof by dof so that every joint reads contiguous values
+    std::vector<dReal> vdofvalues(dof*n);
+    for(size_t index = 0; index < n; ++index) {
+        for(int idof = 0; idof < dof; ++idof) {
+            vdofvalues[idof*n+index] = pJointValues[index*dof+idof];
+        }
+    }
+
+    // values of the passive joints stored by (joint, axis). Passive joints that are not mimic keep their current values.
+    const int nActiveJoints = _vecjoints.size();
+    const int nPassiveJoints = _vPassiveJoints.size();
+    std::vector<dReal> vpassivevalues(nPassiveJoints*3*n, 0);
+    for(int ipassive = 0; ipassive < nPassiveJoints; ++ipassive) {
+        const Joint& joint = *_vPassiveJoints[ipassive];
+        if( joint.IsStatic() || joint.IsMimic() ) {
+            continue;
+        }
+        boost::array<dReal, 3> jvals;
+        joint.GetValues(jvals);
+        for(int iaxis = 0; iaxis < 3; ++iaxis) {
+            dReal fvalue = jvals[iaxis];
+            if( !joint.IsCircular(iaxis) ) {
+                fvalue = std::min(std::max(fvalue, joint._info._vlowerlimit[iaxis]), joint._info._vupperlimit[iaxis]);
+            }
+            std::fill(vpassivevalues.begin() + (ipassive*3+iaxis)*n, vpassivevalues.begin() + (ipassive*3+iaxis+1)*n, fvalue);
+        }
+    }
+
+    // link transforms stored link by link. The links that are not moved by any joint keep their current transforms.
+    std::vector<dReal> vlinkposes(numlinks*7*n);
+    for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+        _FillTransformArray(TransformArray(&vlinkposes[ilink*7*n], n), _veclinks[ilink]->GetTransform(), n);
+    }
+    std::vector<uint8_t> vlinkscomputed(numlinks, 0);
+    vlinkscomputed[0] = 1;
+
+    std::vector<dReal> vjointposes(7*n), vtempposes(7*n), vmimicvalues(3*n);
+    const TransformArray jointposes(&vjointposes[0], n), tempposes(&vtempposes[0], n);
+    std::vector<dReal> vtempvalues, veval;
+    for(size_t ijoint = 0; ijoint < _vTopologicallySortedJointsAll.size(); ++ijoint) {
+        const Joint& joint = *_vTopologicallySortedJointsAll[ijoint];
+        const LinkPtr& parentlink = joint._attachedbodies[0];
+        const LinkPtr& childlink = joint._attachedbodies[1];
+        const TransformArray parentposes(&vlinkposes[(!!parentlink ? parentlink->GetIndex() : 0)*7*n], n);
+        const TransformArray childposes(&vlinkposes[childlink->GetIndex()*7*n], n);
+
+        if( joint.IsStatic() ) {
+            _MultiplyTransformArrays(parentposes, ConstantTransformArray(joint.GetInternalHierarchyLeftTransform()), childposes, n);
+            vlinkscomputed[childlink->GetIndex()] = 1;
+            continue;
+        }
+
+        const int jointindex = _vTopologicallySortedJointIndicesAll[ijoint];
+        const int dofindex = joint.GetDOFIndex(); // active joint has dofindex>=0; passive has dofindex=-1 but jointindex>=0
+        const int jointdof = joint.GetDOF();
+        const KinBody::JointType jointtype = joint.GetType();
+        if( jointtype == JointTrajectory ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("env=%s, body %s joint %s follows a trajectory, which is not supported"), GetEnv()->GetNameId()%GetName()%joint.GetName(), ORE_NotImplemented);
+        }
+
+        // values of every axis of the joint for all the configurations
+        boost::array<dReal*, 3> pvalues;
+        for(int iaxis = 0; iaxis < jointdof; ++iaxis) {
+            pvalues[iaxis] = dofindex >= 0 ? &vdofvalues[(dofindex+iaxis)*n] : &vpassivevalues[((jointindex-nActiveJoints)*3+iaxis)*n];
+        }
+
+        if( joint.IsMimic() ) {
+            for(int iaxis = 0; iaxis < jointdof; ++iaxis) {
+                if( !joint.IsMimic(iaxis) ) {
+                    continue;
+                }
+                // passive joint values are updated in place since other mimic joints can depend on them
+                if( dofindex >= 0 ) {
+                    pvalues[iaxis] = &vmimicvalues[iaxis*n];
+                }
+                const std::vector<Mimic::DOFFormat>& vdofformat = joint._vmimic[iaxis]->_vdofformat;
+                for(size_t index = 0; index < n; ++index) {
+                    vtempvalues.clear();
+                    for(const Mimic::DOFFormat& dofformat : vdofformat) {
+                        vtempvalues.push_back(dofformat.dofindex >= 0 ? vdofvalues[dofformat.dofindex*n+index]
+                                              : vpassivevalues[((dofformat.jointindex-nActiveJoints)*3+dofformat.axis)*n+index]);
+                    }
+                    pvalues[iaxis][index] = _EvalMimicJointValue(joint, iaxis, vtempvalues, veval);
+                }
+            }
+        }
+        // do the test after mimic computation!
+        if( vlinkscomputed[childlink->GetIndex()] ) {
+            continue;
+        }
+
+        if( jointtype == JointRevolute ) {
+            const Vector& vaxis = joint.GetInternalHierarchyAxis(0);
+            const dReal faxislen = RaveSqrt(vaxis.lengthsqr3());
+            if( faxislen == 0 ) {
+                _FillTransformArray(jointposes, Transform(), n);
+            }
+            else {
+                const dReal ax = vaxis.x/faxislen, ay = vaxis.y/faxislen, az = vaxis.z/faxislen;
+                const dReal* pvalue = pvalues[0];
+                for(size_t index = 0; index < n; ++index) {
+                    const dReal fhalfangle = (dReal)0.5*pvalue[index];
+                    const dReal fsin = std::sin(fhalfangle);
+                    jointposes(0,index) = std::cos(fhalfangle);
+                    jointposes(1,index) = ax*fsin;
+                    jointposes(2,index) = ay*fsin;
+                    jointposes(3,index) = az*fsin;
+                    jointposes(4,index) = 0;
+                    jointposes(5,index) = 0;
+                    jointposes(6,index) = 0;
+                }
+            }
+        }
+        else if( jointtype == JointPrismatic ) {
+            const Vector& vaxis = joint.GetInternalHierarchyAxis(0);
+            const dReal* pvalue = pvalues[0];
+            for(size_t index = 0; index < n; ++index) {
+                jointposes(0,index) = 1;
+                jointposes(1,index) = 0;
+                jointposes(2,index) = 0;
+                jointposes(3,index) = 0;
+                jointposes(4,index) = vaxis.x*pvalue[index];
+                jointposes(5,index) = vaxis.y*pvalue[index];
+                jointposes(6,index) = vaxis.z*pvalue[index];
+            }
+        }
+        else {
+            boost::array<dReal, 3> values = {{0, 0, 0}};
+            for(size_t index = 0; index < n; ++index) {
+                for(int iaxis = 0; iaxis < jointdof; ++iaxis) {
+                    values[iaxis] = pvalues[iaxis][index];
+                }
+                const Transform tjoint = _ComputeJointTransform(joint, values.data());
+                jointposes(0,index) = tjoint.rot.x;
+                jointposes(1,index) = tjoint.rot.y;
+                jointposes(2,index) = tjoint.rot.z;
+                jointposes(3,index) = tjoint.rot.w;
+                jointposes(4,index) = tjoint.trans.x;
+                jointposes(5,index) = tjoint.trans.y;
+                jointposes(6,index) = tjoint.trans.z;
+            }
+        }
+
+        // child = parent * (left * joint * right)
+        _MultiplyTransformArrays(ConstantTransformArray(joint.GetInternalHierarchyLeftTransform()), jointposes, tempposes, n);
+        _MultiplyTransformArrays(tempposes, ConstantTransformArray(joint.GetInternalHierarchyRightTransform()), jointposes, n);
+        _MultiplyTransformArrays(parentposes, jointposes, childposes, n);
+        vlinkscomputed[childlink->GetIndex()] = 1;
+    }
+
+    for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+        const TransformArray linkposes(&vlinkposes[ilink*7*n], n);
+        for(size_t index = 0; index < n; ++index) {
+            Transform& t = vLinkTransforms[index*numlinks+ilink];
+            t.rot.x = linkposes(0,index);
+            t.rot.y = linkposes(1,index);
+            t.rot.z = linkposes(2,index);
+            t.rot.w = linkposes(3,index);
+            t.trans.x = linkposes(4,index);
+            t.trans.y = linkposes(5,index);
+            t.trans.z = linkposes(6,index);
+        }
+    }
+}
+
+void KinBody::ComputeLinkTransformations(const dReal* pJointValues, Transform* pLinkTransforms) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    const size_t numlinks = _veclinks.size();
+    if( numlinks == 0 ) {
+        return;
+    }
+
+    // values of the passive joints. Passive joints that are not mimic keep their current values.
+    const int nActiveJoints = _vecjoints.size();
+    const int nPassiveJoints = _vPassiveJoints.size();
+    std::vector< boost::array<dReal, 3> > vPassiveJointValues(nPassiveJoints);
+    for(int ipassive = 0; ipassive < nPassiveJoints; ++ipassive) {
+        const Joint& joint = *_vPassiveJoints[ipassive];
+        if( joint.IsStatic() || joint.IsMimic() ) {
+            continue;
+        }
+        boost::array<dReal, 3>& jvals = vPassiveJointValues[ipassive];
+        joint.GetValues(jvals);
+        for(int iaxis = 0; iaxis < 3; ++iaxis) {
+            if( !joint.IsCircular(iaxis) ) {
+                jvals[iaxis] = std::min(std::max(jvals[iaxis], joint._info._vlowerlimit[iaxis]), joint._info._vupperlimit[iaxis]);
+            }
+        }
+    }
+
+    // the links that are not moved by any joint keep their current transforms
+    for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+        pLinkTransforms[ilink] = _veclinks[ilink]->GetTransform();
+    }
+    std::vector<uint8_t> vlinkscomputed(numlinks, 0);
+    vlinkscomputed[0] = 1;
+
+    boost::array<dReal, 3> mimicvalues;
+    std::vector<dReal> vtempvalues, veval;
+    for(size_t ijoint = 0; ijoint < _vTopologicallySortedJointsAll.size(); ++ijoint) {
+        const Joint& joint = *_vTopologicallySortedJointsAll[ijoint];
+        const LinkPtr& parentlink = joint._attachedbodies[0];
+        const LinkPtr& childlink = joint._attachedbodies[1];
+        const Transform& tparent = pLinkTransforms[!!parentlink ? parentlink->GetIndex() : 0];
+
+        if( joint.IsStatic() ) {
+            pLinkTransforms[childlink->GetIndex()] = tparent * joint.GetInternalHierarchyLeftTransform();
+            vlinkscomputed[childlink->GetIndex()] = 1;
+            continue;
+        }
+
+        const int jointindex = _vTopologicallySortedJointIndicesAll[ijoint];
+        const int dofindex = joint.GetDOFIndex(); // active joint has dofindex>=0; passive has dofindex=-1 but jointindex>=0
+        const int jointdof = joint.GetDOF();
+        if( joint.GetType() == JointTrajectory ) {
+            throw OPENRAVE_EXCEPTION_FORMAT(_("env=%s, body %s joint %s follows a trajectory, which is not supported"), GetEnv()->GetNameId()%GetName()%joint.GetName(), ORE_NotImplemented);
+        }
+
+        const dReal* pvalues = dofindex >= 0 ? pJointValues + dofindex : vPassiveJointValues.at(jointindex-nActiveJoints).data();
+        if( joint.IsMimic() ) {
+            for(int iaxis = 0; iaxis < jointdof; ++iaxis) {
+                if( joint.IsMimic(iaxis) ) {
+                    vtempvalues.clear();
+                    for(const Mimic::DOFFormat& dofformat : joint._vmimic[iaxis]->_vdofformat) {
+                        vtempvalues.push_back(dofformat.dofindex >= 0 ? pJointValues[dofformat.dofindex]
+                                              : vPassiveJointValues.at(dofformat.jointindex-nActiveJoints).at(dofformat.axis));
+                    }
+                    mimicvalues[iaxis] = _EvalMimicJointValue(joint, iaxis, vtempvalues, veval);
+                    // passive joint values are updated since other mimic joints can depend on them
+                    if( dofindex < 0 ) {
+                        vPassiveJointValues.at(jointindex-nActiveJoints).at(iaxis) = mimicvalues[iaxis];
+                    }
+                }
+                else {
+                    mimicvalues[iaxis] = pvalues[iaxis];
+                }
+            }
+            pvalues = mimicvalues.data();
+        }
+        // do the test after mimic computation!
+        if( vlinkscomputed[childlink->GetIndex()] ) {
+            continue;
+        }
+
+        const Transform tjoint = _ComputeJointTransform(joint, pvalues);
+        pLinkTransforms[childlink->GetIndex()] = tparent * (joint.GetInternalHierarchyLeftTransform() * tjoint * joint.GetInternalHierarchyRightTransform());
+        vlinkscomputed[childlink->GetIndex()] = 1;
+    }
+}
+
+void KinBody::ComputeJacobianTranslation(const Transform* pLinkTransforms, const int linkindex, const Vector& position, std::vector<dReal>& vjacobian, const std::vector<int>& dofindices) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    const int nlinks = _veclinks.size();
+    const int nActiveJoints = _vecjoints.size();
+    OPENRAVE_ASSERT_FORMAT(linkindex >= 0 && linkindex < nlinks, "body %s bad link index %d (num links %d)", GetName()%linkindex%nlinks, ORE_InvalidArguments);
+    const size_t dofstride = dofindices.empty() ? GetDOF() : dofindices.size();
+    vjacobian.resize(3 * dofstride);
+    if( dofstride == 0 ) {
+        return;
+    }
+    std::fill(vjacobian.begin(), vjacobian.end(), 0.0);
+
+    const int offset = linkindex * nlinks;
+    for(int curlink = 0; _vAllPairsShortestPaths[offset + curlink].first >= 0; curlink = _vAllPairsShortestPaths[offset + curlink].first) {
+        const int jointindex = _vAllPairsShortestPaths[offset + curlink].second;
+        if( jointindex >= nActiveJoints ) {
+            const Joint& joint = *_vPassiveJoints.at(jointindex - nActiveJoints);
+            if( joint.IsMimic() ) {
+                throw OPENRAVE_EXCEPTION_FORMAT(_("body %s mimic joint %s affects link %d, which is not supported"), GetName()%joint.GetName()%linkindex, ORE_NotImplemented);
+            }
+            continue;
+        }
+
+        const Joint& joint = *_vecjoints[jointindex];
+        if( !DoesAffect(joint.GetJointIndex(), linkindex) ) {
+            continue;
+        }
+        const LinkPtr& parentlink = joint._attachedbodies[0];
+        const Transform& tparent = pLinkTransforms[!!parentlink ? parentlink->GetIndex() : 0];
+        const Vector vanchor = tparent * joint._tLeft.trans;
+        const int dofindex = joint.GetDOFIndex();
+        for(int idof = 0; idof < joint.GetDOF(); ++idof) {
+            const bool bPrismatic = joint.IsPrismatic(idof);
+            if( !bPrismatic && !joint.IsRevolute(idof) ) {
+                RAVELOG_WARN("ComputeJacobianTranslation only supports revolute and prismatic joints, but not this joint type %d", joint.GetType());
+                continue;
+            }
+
+            int index = dofindex + idof;
+            if( !dofindices.empty() ) {
+                const std::vector<int>::const_iterator itindex = std::find(dofindices.begin(), dofindices.end(), dofindex + idof);
+                if( itindex == dofindices.end() ) {
+                    continue;
+                }
+                index = itindex - dofindices.begin();
+            }
+
+            const Vector vaxis = tparent.rotate(joint._tLeft.rotate(joint._vaxes[idof]));
+            const Vector vColumn = bPrismatic ? vaxis : vaxis.cross(position - vanchor);
+            vjacobian[index                ] += vColumn.x;
+            vjacobian[index + dofstride    ] += vColumn.y;
+            vjacobian[index + dofstride * 2] += vColumn.z;
+        }
+    }
+}
+
+void KinBody::ComputeJacobianAxisAngle(const Transform* pLinkTransforms, const int linkindex, std::vector<dReal>& vjacobian, const std::vector<int>& dofindices) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    const int nlinks = _veclinks.size();
+    const int nActiveJoints = _vecjoints.size();
+    OPENRAVE_ASSERT_FORMAT(linkindex >= 0 && linkindex < nlinks, "body %s bad link index %d (num links %d)", GetName()%linkindex%nlinks, ORE_InvalidArguments);
+    const size_t dofstride = dofindices.empty() ? GetDOF() : dofindices.size();
+    vjacobian.resize(3 * dofstride);
+    if( dofstride == 0 ) {
+        return;
+    }
+    std::fill(vjacobian.begin(), vjacobian.end(), 0.0);
+
+    const int offset = linkindex * nlinks;
+    for(int curlink = 0; _vAllPairsShortestPaths[offset + curlink].first >= 0; curlink = _vAllPairsShortestPaths[offset + curlink].first) {
+        const int jointindex = _vAllPairsShortestPaths[offset + curlink].second;
+        if( jointindex >= nActiveJoints ) {
+            const Joint& joint = *_vPassiveJoints.at(jointindex - nActiveJoints);
+            if( joint.IsMimic() ) {
+                throw OPENRAVE_EXCEPTION_FORMAT(_("body %s mimic joint %s affects link %d, which is not supported"), GetName()%joint.GetName()%linkindex, ORE_NotImplemented);
+            }
+            continue;
+        }
+
+        const Joint& joint = *_vecjoints[jointindex];
+        if( !DoesAffect(joint.GetJointIndex(), linkindex) ) {
+            continue;
+        }
+        const LinkPtr& parentlink = joint._attachedbodies[0];
+        const Transform& tparent = pLinkTransforms[!!parentlink ? parentlink->GetIndex() : 0];
+        const int dofindex = joint.GetDOFIndex();
+        for(int idof = 0; idof < joint.GetDOF(); ++idof) {
+            if( joint.IsPrismatic(idof) ) {
+                continue;
+            }
+            else if( !joint.IsRevolute(idof) ) {
+                RAVELOG_WARN("ComputeJacobianAxisAngle only supports revolute and prismatic joints, but not this joint type %d", joint.GetType());
+                continue;
+            }
+
+            int index = dofindex + idof;
+            if( !dofindices.empty() ) {
+                const std::vector<int>::const_iterator itindex = std::find(dofindices.begin(), dofindices.end(), dofindex + idof);
+                if( itindex == dofindices.end() ) {
+                    continue;
+                }
+                index = itindex - dofindices.begin();
+            }
+
+            // axis of a revolute joint is its column in the angular velocity jacobian
+            const Vector vColumn = tparent.rotate(joint._tLeft.rotate(joint._vaxes[idof]));
+            vjacobian[index                ] += vColumn.x;
+            vjacobian[index + dofstride    ] += vColumn.y;
+            vjacobian[index + dofstride * 2] += vColumn.z;
+        }
+    }
+}
+
+void KinBody::JacobianWorkspace::ComputeJacobians(const Transform* pLinkTransforms, dReal* ptranslationjacobian, dReal* pangularjacobian, const dReal* pMimicPartials) const
+{
+    if( nummimiccolumns > 0 && !pMimicPartials ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("link %d is moved by %d mimic axes, but no mimic partials were given"), linkindex%nummimiccolumns, ORE_InvalidArguments);
+    }
+    if( !!ptranslationjacobian ) {
+        std::fill(ptranslationjacobian, ptranslationjacobian + 3*numcolumns, 0);
+    }
+    if( !!pangularjacobian ) {
+        std::fill(pangularjacobian, pangularjacobian + 3*numcolumns, 0);
+    }
+    const Vector position = pLinkTransforms[linkindex] * vlocalposition;
+    for(const JacobianColumn& column : vcolumns) {
+        const Transform& tparent = pLinkTransforms[column.parentlinkindex];
+        const Vector vaxis = tparent.rotate(column.vlocalaxis);
+        if( column.bPrismatic ) {
+            if( !!ptranslationjacobian ) {
+                _AddJacobianColumn(ptranslationjacobian, numcolumns, column, pMimicPartials, vaxis);
+            }
+            continue;
+        }
+        if( !!ptranslationjacobian ) {
+            _AddJacobianColumn(ptranslationjacobian, numcolumns, column, pMimicPartials, vaxis.cross(position - tparent * column.vlocalanchor));
+        }
+        if( !!pangularjacobian ) {
+            _AddJacobianColumn(pangularjacobian, numcolumns, column, pMimicPartials, vaxis);
+        }
+    }
+}
+
+void KinBody::JacobianWorkspace::ComputeHessians(const Transform* pLinkTransforms, dReal* ptranslationhessian, dReal* pangularhessian, const dReal* pMimicPartials) const
+{
+    if( nummimiccolumns > 0 && !pMimicPartials ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("link %d is moved by %d mimic axes, but no mimic partials were given"), linkindex%nummimiccolumns, ORE_InvalidArguments);
+    }
+    const int hessiansize = numcolumns*3*numcolumns;
+    if( !!ptranslationhessian ) {
+        std::fill(ptranslationhessian, ptranslationhessian + hessiansize, 0);
+    }
+    if( !!pangularhessian ) {
+        std::fill(pangularhessian, pangularhessian + hessiansize, 0);
+    }
+    // the derivative of column j with respect to column i closer to the root is axis_i x column_j, prismatic axes do not rotate anything
+    const Vector position = pLinkTransforms[linkindex] * vlocalposition;
+    for(size_t i = 0; i < vcolumns.size(); ++i) {
+        const JacobianColumn& columni = vcolumns[i];
+        if( columni.bPrismatic ) {
+            continue;
+        }
+        const Vector vaxisi = pLinkTransforms[columni.parentlinkindex].rotate(columni.vlocalaxis);
+        for(size_t j = i; j < vcolumns.size(); ++j) {
+            const JacobianColumn& columnj = vcolumns[j];
+            const Transform& tparentj = pLinkTransforms[columnj.parentlinkindex];
+            const Vector vaxisj = tparentj.rotate(columnj.vlocalaxis);
+            if( !!ptranslationhessian ) {
+                const Vector vtranslationj = columnj.bPrismatic ? vaxisj : vaxisj.cross(position - tparentj * columnj.vlocalanchor);
+                _AddHessianTerm(ptranslationhessian, numcolumns, columni, columnj, pMimicPartials, vaxisi.cross(vtranslationj), j != i);
+            }
+            if( !!pangularhessian && j != i && !columnj.bPrismatic ) {
+                _AddHessianTerm(pangularhessian, numcolumns, columni, columnj, pMimicPartials, vaxisi.cross(vaxisj), true);
+            }
+        }
+    }
+}
+
+void KinBody::InitJacobianWorkspace(int linkindex, const Vector& vlocalposition, const std::vector<int>& dofindices, JacobianWorkspace& workspace) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    const int nlinks = _veclinks.size();
+    const int nActiveJoints = _vecjoints.size();
+    OPENRAVE_ASSERT_FORMAT(linkindex >= 0 && linkindex < nlinks, "body %s bad link index %d (num links %d)", GetName()%linkindex%nlinks, ORE_InvalidArguments);
+    workspace.linkindex = linkindex;
+    workspace.vlocalposition = vlocalposition;
+    workspace.numcolumns = dofindices.empty() ? GetDOF() : dofindices.size();
+    workspace.nummimiccolumns = 0;
+    workspace.vcolumns.clear();
+    workspace.vdofcolumns.clear();
+
+    const int offset = linkindex * nlinks;
+    for(int curlink = 0; _vAllPairsShortestPaths[offset + curlink].first >= 0; curlink = _vAllPairsShortestPaths[offset + curlink].first) {
+        const int jointindex = _vAllPairsShortestPaths[offset + curlink].second;
+        if( jointindex >= nActiveJoints ) {
+            // passive joints that are not mimic keep their values, so only the mimic axes move the link
+            const Joint& joint = *_vPassiveJoints.at(jointindex - nActiveJoints);
+            const LinkPtr& parentlink = joint._attachedbodies[0];
+            for(int idof = 0; idof < joint.GetDOF(); ++idof) {
+                if( !joint.IsMimic(idof) ) {
+                    continue;
+                }
+                const bool bPrismatic = joint.IsPrismatic(idof);
+                if( !bPrismatic && !joint.IsRevolute(idof) ) {
+                    RAVELOG_WARN("InitJacobianWorkspace only supports revolute and prismatic joints, but not this joint type %d", joint.GetType());
+                    continue;
+                }
+
+                JacobianWorkspace::JacobianColumn column;
+                column.parentlinkindex = !!parentlink ? parentlink->GetIndex() : 0;
+                column.vlocalaxis = joint._tLeft.rotate(joint._vaxes[idof]);
+                column.vlocalanchor = joint._tLeft.trans;
+                column.icolumn = -1;
+                column.imimic = workspace.nummimiccolumns++;
+                column.mimicjointindex = jointindex;
+                column.mimicaxis = idof;
+                column.bPrismatic = bPrismatic;
+                workspace.vcolumns.push_back(column);
+            }
+            continue;
+        }
+
+        const Joint& joint = *_vecjoints[jointindex];
+        if( !DoesAffect(joint.GetJointIndex(), linkindex) ) {
+            continue;
+        }
+        const LinkPtr& parentlink = joint._attachedbodies[0];
+        const int dofindex = joint.GetDOFIndex();
+        for(int idof = 0; idof < joint.GetDOF(); ++idof) {
+            const bool bPrismatic = joint.IsPrismatic(idof);
+            if( !bPrismatic && !joint.IsRevolute(idof) ) {
+                RAVELOG_WARN("InitJacobianWorkspace only supports revolute and prismatic joints, but not this joint type %d", joint.GetType());
+                continue;
+            }
+
+            int icolumn = dofindex + idof;
+            if( !dofindices.empty() ) {
+                const std::vector<int>::const_iterator itindex = std::find(dofindices.begin(), dofindices.end(), dofindex + idof);
+                if( itindex == dofindices.end() ) {
+                    continue;
+                }
+                icolumn = itindex - dofindices.begin();
+            }
+
+            JacobianWorkspace::JacobianColumn column;
+            column.parentlinkindex = !!parentlink ? parentlink->GetIndex() : 0;
+            column.vlocalaxis = joint._tLeft.rotate(joint._vaxes[idof]);
+            column.vlocalanchor = joint._tLeft.trans;
+            column.icolumn = icolumn;
+            column.imimic = -1;
+            column.mimicjointindex = -1;
+            column.mimicaxis = 0;
+            column.bPrismatic = bPrismatic;
+            workspace.vcolumns.push_back(column);
+        }
+    }
+
+    if( workspace.nummimiccolumns > 0 ) {
+        workspace.vdofcolumns.resize(GetDOF(), -1);
+        for(int icolumn = 0; icolumn < workspace.numcolumns; ++icolumn) {
+            workspace.vdofcolumns.at(dofindices.empty() ? icolumn : dofindices[icolumn]) = icolumn;
+        }
+    }
+}
+
+void KinBody::ComputeJacobiansBatch(const dReal* pJointValues, int numconfigurations, const std::vector<JacobianWorkspace>& vworkspaces, dReal* pjacobians) const
+{
+    const size_t numlinks = _veclinks.size();
+    if( numconfigurations <= 0 || numlinks == 0 ) {
+        return;
+    }
+    bool bHasMimic = false;
+    for(const JacobianWorkspace& workspace : vworkspaces) {
+        bHasMimic |= workspace.GetNumMimicColumns() > 0;
+    }
+    const int dof = GetDOF();
+    std::vector<Transform> vLinkTransforms;
+    ComputeLinkTransformationsBatch(pJointValues, numconfigurations, vLinkTransforms);
+    std::vector< boost::array<dReal, 3> > vPassiveJointValues;
+    std::vector<dReal> vMimicPartials;
+    for(int iconfiguration = 0; iconfiguration < numconfigurations; ++iconfiguration) {
+        const Transform* pLinkTransforms = &vLinkTransforms[iconfiguration*numlinks];
+        if( bHasMimic ) {
+            _ComputePassiveJointValues(pJointValues + iconfiguration*dof, vPassiveJointValues);
+        }
+        for(const JacobianWorkspace& workspace : vworkspaces) {
+            const dReal* pMimicPartials = NULL;
+            if( workspace.GetNumMimicColumns() > 0 ) {
+                vMimicPartials.resize(workspace.GetNumMimicColumns()*workspace.GetNumColumns());
+                _ComputeJacobianMimicPartials(pJointValues + iconfiguration*dof, vPassiveJointValues, workspace, vMimicPartials.data());
+                pMimicPartials = vMimicPartials.data();
+            }
+            const int jacobiansize = 3*workspace.GetNumColumns();
+            workspace.ComputeJacobians(pLinkTransforms, pjacobians, pjacobians + jacobiansize, pMimicPartials);
+            pjacobians += 2*jacobiansize;
+        }
+    }
+}
+
+void KinBody::ComputeHessiansBatch(const dReal* pJointValues, int numconfigurations, const std::vector<JacobianWorkspace>& vworkspaces, dReal* phessians) const
+{
+    const size_t numlinks = _veclinks.size();
+    if( numconfigurations <= 0 || numlinks == 0 ) {
+        return;
+    }
+    bool bHasMimic = false;
+    for(const JacobianWorkspace& workspace : vworkspaces) {
+        bHasMimic |= workspace.GetNumMimicColumns() > 0;
+    }
+    const int dof = GetDOF();
+    std::vector<Transform> vLinkTransforms;
+    ComputeLinkTransformationsBatch(pJointValues, numconfigurations, vLinkTransforms);
+    std::vector< boost::array<dReal, 3> > vPassiveJointValues;
+    std::vector<dReal> vMimicPartials;
+    for(int iconfiguration = 0; iconfiguration < numconfigurations; ++iconfiguration) {
+        const Transform* pLinkTransforms = &vLinkTransforms[iconfiguration*numlinks];
+        if( bHasMimic ) {
+            _ComputePassiveJointValues(pJointValues + iconfiguration*dof, vPassiveJointValues);
+        }
+        for(const JacobianWorkspace& workspace : vworkspaces) {
+            const dReal* pMimicPartials = NULL;
+            if( workspace.GetNumMimicColumns() > 0 ) {
+                vMimicPartials.resize(workspace.GetNumMimicColumns()*workspace.GetNumColumns());
+                _ComputeJacobianMimicPartials(pJointValues + iconfiguration*dof, vPassiveJointValues, workspace, vMimicPartials.data());
+                pMimicPartials = vMimicPartials.data();
+            }
+            const int hessiansize = workspace.GetNumColumns()*3*workspace.GetNumColumns();
+            workspace.ComputeHessians(pLinkTransforms, phessians, phessians + hessiansize, pMimicPartials);
+            phessians += 2*hessiansize;
+        }
+    }
+}
+
+void KinBody::ComputeJacobianMimicPartials(const dReal* pJointValues, const JacobianWorkspace& workspace, dReal* pMimicPartials) const
+{
+    CHECK_INTERNAL_COMPUTATION;
+    if( workspace.GetNumMimicColumns() == 0 ) {
+        return;
+    }
+    std::vector< boost::array<dReal, 3> > vPassiveJointValues;
+    _ComputePassiveJointValues(pJointValues, vPassiveJointValues);
+    _ComputeJacobianMimicPartials(pJointValues, vPassiveJointValues, workspace, pMimicPartials);
+}
+
+void KinBody::_ComputeJacobianMimicPartials(const dReal* pJointValues, const std::vector< boost::array<dReal, 3> >& vPassiveJointValues, const JacobianWorkspace& workspace, dReal* pMimicPartials) const
+{
+    const int nActiveJoints = _vecjoints.size();
+    const int numcolumns = workspace.GetNumColumns();
+    std::fill(pMimicPartials, pMimicPartials + workspace.GetNumMimicColumns()*numcolumns, 0);
+    for(const JacobianWorkspace::JacobianColumn& column : workspace.vcolumns) {
+        if( column.imimic >= 0 ) {
+            const Joint& joint = *_vPassiveJoints.at(column.mimicjointindex - nActiveJoints);
+            _AccumulateMimicPartials(joint, column.mimicaxis, pJointValues, vPassiveJointValues, 1, workspace.vdofcolumns, pMimicPartials + column.imimic*numcolumns);
+        }
+    }
+}
+
+void KinBody::_ComputePassiveJointValues(const dReal* pJointValues, std::vector< boost::array<dReal, 3> >& vPassiveJointValues) const
+{
+    const int nActiveJoints = _vecjoints.size();
+    const int nPassiveJoints = _vPassiveJoints.size();
+    const boost::array<dReal, 3> zerovalues = {{0, 0, 0}};
+    vPassiveJointValues.resize(nPassiveJoints);
+    for(int ipassive = 0; ipassive < nPassiveJoints; ++ipassive) {
+        const Joint& joint = *_vPassiveJoints[ipassive];
+        boost::array<dReal, 3>& jvals = vPassiveJointValues[ipassive];
+        jvals = zerovalues;
+        if( joint.IsStatic() || joint.IsMimic() ) {
+            continue;
+        }
+        joint.GetValues(jvals);
+        for(int iaxis = 0; iaxis < 3; ++iaxis) {
+            if( !joint.IsCircular(iaxis) ) {
+                jvals[iaxis] = std::min(std::max(jvals[iaxis], joint._info._vlowerlimit[iaxis]), joint._info._vupperlimit[iaxis]);
+            }
+        }
+    }
+
+    // mimic joints are evaluated in topological order since they can depend on other mimic joints
+    std::vector<dReal> vtempvalues, veval;
+    for(size_t ijoint = 0; ijoint < _vTopologicallySortedJointsAll.size(); ++ijoint) {
+        const Joint& joint = *_vTopologicallySortedJointsAll[ijoint];
+        const int jointindex = _vTopologicallySortedJointIndicesAll[ijoint];
+        if( jointindex < nActiveJoints || !joint.IsMimic() ) {
+            continue;
+        }
+        for(int iaxis = 0; iaxis < joint.GetDOF(); ++iaxis) {
+            if( !joint.IsMimic(iaxis) ) {
+                continue;
+            }
+            vtempvalues.clear();
+            for(const Mimic::DOFFormat& dofformat : joint._vmimic[iaxis]->_vdofformat) {
+                vtempvalues.push_back(dofformat.dofindex >= 0 ? pJointValues[dofformat.dofindex]
+                                      : vPassiveJointValues.at(dofformat.jointindex-nActiveJoints).at(dofformat.axis));
+            }
+            vPassiveJointValues.at(jointindex-nActiveJoints).at(iaxis) = _EvalMimicJointValue(joint, iaxis, vtempvalues, veval);
+        }
+    }
+}
+
+void KinBody::_AccumulateMimicPartials(const Joint& joint, int iaxis, const dReal* pJointValues, const std::vector< boost::array<dReal, 3> >& vPassiveJointValues, dReal fscale, const std::vector<int>& vdofcolumns, dReal* pMimicPartials) const
+{
+    const int nActiveJoints = _vecjoints.size();
+    const std::vector<Mimic::DOFFormat>& vdofformat = joint._vmimic.at(iaxis)->_vdofformat;
+    std::vector<dReal> vdependentvalues, vpartials;
+    vdependentvalues.reserve(vdofformat.size());
+    for(const Mimic::DOFFormat& dofformat : vdofformat) {
+        vdependentvalues.push_back(dofformat.dofindex >= 0 ? pJointValues[dofformat.dofindex]
+                                   : vPassiveJointValues.at(dofformat.jointindex-nActiveJoints).at(dofformat.axis));
+    }
+    int err;
+    {
+        std::lock_guard<std::mutex> lock(s_mutexMimicEval);
+        err = joint._Eval(iaxis, 1, vdependentvalues, vpartials);
+    }
+    if( err ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("env=%s, failed to evaluate the partial velocities of joint %s, fparser error %d"), GetEnv()->GetNameId()%joint.GetName()%err, ORE_InvalidState);
+    }
+
+    // the partials without a velocity equation are 0, as in Joint::_ComputePartialVelocities
+    const size_t nvars = std::min(vdofformat.size(), vpartials.size());
+    for(size_t ivar = 0; ivar < nvars; ++ivar) {
+        const dReal fpartial = fscale*vpartials[ivar];
+        if( fpartial == 0 ) {
+            continue;
+        }
+        const Mimic::DOFFormat& dofformat = vdofformat[ivar];
+        if( dofformat.dofindex >= 0 ) {
+            const int icolumn = vdofcolumns.at(dofformat.dofindex);
+            if( icolumn >= 0 ) {
+                pMimicPartials[icolumn] += fpartial;
+            }
+        }
+        else {
+            const Joint& dependentjoint = *_vPassiveJoints.at(dofformat.jointindex-nActiveJoints);
+            if( dependentjoint.IsMimic(dofformat.axis) ) {
+                _AccumulateMimicPartials(dependentjoint, dofformat.axis, pJointValues, vPassiveJointValues, fpartial, vdofcolumns, pMimicPartials);
+            }
+        }
+    }
+}
+
+dReal KinBody::_EvalMimicJointValue(const Joint& joint, int iaxis, const std::vector<dReal>& vdependentvalues, std::vector<dReal>& veval) const
+{
+    int err;
+    {
+        std::lock_guard<std::mutex> lock(s_mutexMimicEval);
+        err = joint._Eval(iaxis, 0, vdependentvalues, veval);
+    }
+    if( err || veval.empty() ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("env=%s, failed to evaluate joint %s, fparser error %d"), GetEnv()->GetNameId()%joint.GetName()%err, ORE_InvalidState);
+    }
+    if( joint.GetType() == JointSpherical || joint.IsCircular(iaxis) ) {
+        return veval[0];
+    }
+    const dReal flower = joint._info._vlowerlimit[iaxis], fupper = joint._info._vupperlimit[iaxis];
+    for(dReal eval : veval) {
+        if( eval >= flower-g_fEpsilonJointLimit && eval <= fupper+g_fEpsilonJointLimit ) {
+            return std::min(std::max(eval, flower), fupper);
+        }
+    }
+    return veval[0];
+}
+
+} // end namespace OpenRAVE
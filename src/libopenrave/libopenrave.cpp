@@ -2700,6 +2700,231 @@ int SpaceSamplerBase::_CallStatusFunctions(int sampleiteration)
     return ret;
 }
 
+static void _SetBatchDOFValues(KinBody& body, const std::vector<dReal>& vconfigurations, int dof, const std::vector<int>& dofindices, size_t iconfig)
+{
+    body.SetDOFValues(&vconfigurations.at(iconfig*dof), dof, KinBody::CLA_Nothing, dofindices);
+}
+
+static void _SetBatchTransform(KinBody& body, const std::vector<Transform>& vtransforms, size_t iconfig)
+{
+    body.SetTransform(vtransforms.at(iconfig));
+}
+
+int CollisionCheckerBase::CheckCollisionBatch(KinBodyPtr pbody, const std::vector<dReal>& vconfigurations, const std::vector<int>& dofindices, std::vector<uint8_t>& vresults, int batchoptions, CollisionReportPtr report)
+{
+    const int dof = dofindices.size() > 0 ? (int)dofindices.size() : pbody->GetDOF();
+    if( dof == 0 ) {
+        vresults.resize(0);
+        return 0;
+    }
+    OPENRAVE_ASSERT_OP(vconfigurations.size() % dof, ==, 0);
+    KinBody::KinBodyStateSaver saver(pbody, KinBody::Save_LinkTransformation);
+    return _CheckCollisionBatch(pbody, vconfigurations.size()/dof, boost::bind(&_SetBatchDOFValues, boost::ref(*pbody), boost::cref(vconfigurations), dof, boost::cref(dofindices), _1), vresults, batchoptions, report);
+}
+
+int CollisionCheckerBase::CheckCollisionBatch(KinBodyPtr pbody, const std::vector<Transform>& vtransforms, std::vector<uint8_t>& vresults, int batchoptions, CollisionReportPtr report)
+{
+    KinBody::KinBodyStateSaver saver(pbody, KinBody::Save_LinkTransformation);
+    return _CheckCollisionBatch(pbody, vtransforms.size(), boost::bind(&_SetBatchTransform, boost::ref(*pbody), boost::cref(vtransforms), _1), vresults, batchoptions, report);
+}
+
+int CollisionCheckerBase::_CheckCollisionBatch(KinBodyPtr pbody, size_t numconfigurations, const boost::function<void(size_t)>& setstatefn, std::vector<uint8_t>& vresults, int batchoptions, CollisionReportPtr report)
+{
+    vresults.resize(numconfigurations);
+    std::fill(vresults.begin(), vresults.end(), 0);
+    int numcolliding = 0;
+    CollisionReportPtr preport = report; // only the first configuration in collision is reported
+    for(size_t iconfig = 0; iconfig < numconfigurations; ++iconfig) {
+        setstatefn(iconfig);
+        uint8_t result = 0;
+        if( (batchoptions & CBO_Environment) && CheckCollision(KinBodyConstPtr(pbody), preport) ) {
+            result |= CBO_Environment;
+        }
+        if( (batchoptions & CBO_SelfCollision) && !(result && (batchoptions & CBO_StopAtFirstCollision)) ) {
+            if( CheckStandaloneSelfCollision(KinBodyConstPtr(pbody), !result ? preport : CollisionReportPtr()) ) {
+                result |= CBO_SelfCollision;
+            }
+        }
+        vresults[iconfig] = result;
+        if( result ) {
+            ++numcolliding;
+            preport.reset();
+            if( batchoptions & CBO_StopAtFirstCollision ) {
+                break;
+            }
+        }
+    }
+    return numcolliding;
+}
+
+int CollisionCheckerBase::CheckContinuousCollision(KinBodyPtr pbody, const std::vector<dReal>& q0, const std::vector<dReal>& q1, const std::vector<dReal>& dq0, const std::vector<dReal>& dq1, dReal timeelapsed, const std::vector<int>& dofindices, dReal& fTimeOfContact, int batchoptions, dReal fTolerance, CollisionReportPtr report)
+{
+    const int dof = dofindices.size() > 0 ? (int)dofindices.size() : pbody->GetDOF();
+    OPENRAVE_ASSERT_OP((int)q0.size(), ==, dof);
+    OPENRAVE_ASSERT_OP((int)q1.size(), ==, dof);
+    OPENRAVE_ASSERT_OP(fTolerance, >, 0);
+    if( !!report ) {
+        report->Reset(GetCollisionOptions());
+    }
+
+    // q(t) = q0 + t*(vvel0 + 0.5*t*vaccel) for t in [0, fduration]
+    const bool bParabolic = timeelapsed > 0 && (int)dq0.size() == dof && (int)dq1.size() == dof;
+    const dReal fduration = bParabolic ? timeelapsed : dReal(1.0);
+    std::vector<dReal> vvel0(dof), vaccel(dof, 0), vvalues(dof), vmaxvel(dof);
+    std::vector<int> vsegmentindices(pbody->GetDOF(), -1); // for every dof of the body, its index in the segment or -1 if it does not move
+    for(int i = 0; i < dof; ++i) {
+        if( bParabolic ) {
+            vvel0[i] = dq0[i];
+            vaccel[i] = (dq1[i] - dq0[i])/timeelapsed;
+        }
+        else {
+            vvel0[i] = q1[i] - q0[i];
+        }
+        if( RaveFabs(vvel0[i]) > 0 || RaveFabs(vaccel[i]) > 0 ) {
+            vsegmentindices.at(dofindices.size() > 0 ? dofindices[i] : i) = i;
+        }
+    }
+
+    // the motion of passive mimic joints cannot be bounded from the velocities of the dofs
+    std::vector<int> vmimicdofs;
+    FOREACHC(itjoint, pbody->GetPassiveJoints()) {
+        for(int iaxis = 0; iaxis < (*itjoint)->GetDOF(); ++iaxis) {
+            if( (*itjoint)->IsMimic(iaxis) ) {
+                (*itjoint)->GetMimicDOFIndices(vmimicdofs, iaxis);
+                FOREACHC(itdof, vmimicdofs) {
+                    if( vsegmentindices.at(*itdof) >= 0 ) {
+                        throw OPENRAVE_EXCEPTION_FORMAT(_("env=%s, body %s mimic joint %s depends on moving dof %d, continuous collision not supported"), GetEnv()->GetNameId()%pbody->GetName()%(*itjoint)->GetName()%*itdof, ORE_NotImplemented);
+                    }
+                }
+            }
+        }
+    }
+
+    // for every link, the (joint, axis, segment index) that move it
+    const std::vector<KinBody::LinkPtr>& vlinks = pbody->GetLinks();
+    std::vector< std::vector< boost::tuple<KinBody::JointPtr, int, int> > > vlinkaxes(vlinks.size());
+    FOREACHC(itjoint, pbody->GetJoints()) {
+        for(int iaxis = 0; iaxis < (*itjoint)->GetDOF(); ++iaxis) {
+            const int isegment = vsegmentindices.at((*itjoint)->GetDOFIndex()+iaxis);
+            if( isegment < 0 ) {
+                continue;
+            }
+            for(size_t ilink = 0; ilink < vlinks.size(); ++ilink) {
+                if( pbody->DoesAffect((*itjoint)->GetJointIndex(), ilink) ) {
+                    vlinkaxes[ilink].push_back(boost::make_tuple(*itjoint, iaxis, isegment));
+                }
+            }
+        }
+    }
+
+    // grabbed bodies move with their grabbing links, so have to be included in their extents
+    std::vector<KinBodyPtr> vgrabbed;
+    std::vector<int> vgrabbinglinkindices;
+    pbody->GetGrabbed(vgrabbed);
+    FOREACHC(itgrabbed, vgrabbed) {
+        KinBody::LinkPtr pgrabbinglink = pbody->IsGrabbing(**itgrabbed);
+        vgrabbinglinkindices.push_back(!!pgrabbinglink ? pgrabbinglink->GetIndex() : -1);
+    }
+
+    KinBody::KinBodyStateSaver saver(pbody, KinBody::Save_LinkTransformation);
+    std::vector< std::pair<dReal, dReal> > vlinkmotionbounds(vlinks.size());
+    std::vector<AABB> vlinkaabbs(vlinks.size());
+    dReal ftime = 0;
+    for(int iter = 0; iter < 10000; ++iter) {
+        for(int i = 0; i < dof; ++i) {
+            vvalues[i] = q0[i] + ftime*(vvel0[i] + 0.5*ftime*vaccel[i]);
+            // the velocity is linear in time, so its max over the rest of the segment is at one of the ends
+            vmaxvel[i] = max(RaveFabs(vvel0[i] + ftime*vaccel[i]), RaveFabs(vvel0[i] + fduration*vaccel[i]));
+        }
+        pbody->SetDOFValues(vvalues, KinBody::CLA_Nothing, dofindices);
+
+        for(size_t ilink = 0; ilink < vlinks.size(); ++ilink) {
+            vlinkaabbs[ilink] = vlinks[ilink]->ComputeAABB();
+        }
+        for(size_t igrabbed = 0; igrabbed < vgrabbed.size(); ++igrabbed) {
+            if( vgrabbinglinkindices[igrabbed] >= 0 ) {
+                AABB& ab = vlinkaabbs.at(vgrabbinglinkindices[igrabbed]);
+                AABB abgrabbed = vgrabbed[igrabbed]->ComputeAABB();
+                Vector vmin = ab.pos - ab.extents, vmax = ab.pos + ab.extents;
+                Vector vgrabbedmin = abgrabbed.pos - abgrabbed.extents, vgrabbedmax = abgrabbed.pos + abgrabbed.extents;
+                for(int j = 0; j < 3; ++j) {
+                    vmin[j] = min(vmin[j], vgrabbedmin[j]);
+                    vmax[j] = max(vmax[j], vgrabbedmax[j]);
+                }
+                ab.pos = (dReal)0.5*(vmax+vmin);
+                ab.extents = (dReal)0.5*(vmax-vmin);
+            }
+        }
+
+        // A revolute axis moves a point by at most its angle times the distance to the anchor. Because that distance can grow by twice the motion of the link during the step, the motion D over dt is bounded by D <= dt*(linear + 2*angular*D).
+        for(size_t ilink = 0; ilink < vlinks.size(); ++ilink) {
+            dReal flinear = 0, fangular = 0;
+            const AABB& ab = vlinkaabbs[ilink];
+            FOREACHC(itaxis, vlinkaxes[ilink]) {
+                const dReal fvel = vmaxvel[itaxis->get<2>()];
+                if( itaxis->get<0>()->IsPrismatic(itaxis->get<1>()) ) {
+                    flinear += fvel;
+                }
+                else {
+                    // farthest corner of the box from the anchor
+                    Vector vdelta = ab.pos - itaxis->get<0>()->GetAnchor();
+                    Vector vfar(RaveFabs(vdelta.x) + ab.extents.x, RaveFabs(vdelta.y) + ab.extents.y, RaveFabs(vdelta.z) + ab.extents.z);
+                    flinear += fvel*RaveSqrt(vfar.lengthsqr3());
+                    fangular += fvel;
+                }
+            }
+            vlinkmotionbounds[ilink] = std::make_pair(flinear, fangular);
+        }
+
+        dReal fTimeStep = 0;
+        int ret = _ComputeContinuousCollisionStep(pbody, vlinkmotionbounds, batchoptions, fTolerance, fTimeStep, report);
+        if( ret != 0 ) {
+            fTimeOfContact = ftime;
+            return ret;
+        }
+        if( ftime >= fduration ) {
+            return 0;
+        }
+        ftime = fTimeStep >= fduration - ftime ? fduration : ftime + fTimeStep;
+    }
+
+    RAVELOG_WARN_FORMAT("env=%s, body %s continuous collision did not reach the end of the segment, treating as collision at time %f", GetEnv()->GetNameId()%pbody->GetName()%ftime);
+    fTimeOfContact = ftime;
+    return batchoptions & (CBO_Environment|CBO_SelfCollision);
+}
+
+int CollisionCheckerBase::_ComputeContinuousCollisionStep(KinBodyConstPtr pbody, const std::vector< std::pair<dReal, dReal> >& vlinkmotionbounds, int batchoptions, dReal fTolerance, dReal& fTimeStep, CollisionReportPtr report)
+{
+    CollisionOptionsStateSaver optionsaver(shared_collisionchecker(), GetCollisionOptions()|CO_Distance, false);
+    if( !(GetCollisionOptions() & CO_Distance) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT(_("env=%s, collision checker %s does not support distance queries needed by continuous collision"), GetEnv()->GetNameId()%GetXMLId(), ORE_NotImplemented);
+    }
+
+    // the whole body is bounded by its fastest link
+    dReal flinear = 0, fangular = 0;
+    FOREACHC(itbound, vlinkmotionbounds) {
+        flinear = max(flinear, itbound->first);
+        fangular = max(fangular, itbound->second);
+    }
+
+    CollisionReportPtr pdistreport = !!report ? report : CollisionReportPtr(new CollisionReport());
+    fTimeStep = std::numeric_limits<dReal>::max();
+    if( batchoptions & CBO_Environment ) {
+        if( CheckCollision(pbody, pdistreport) || pdistreport->minDistance < fTolerance ) {
+            return CBO_Environment;
+        }
+        fTimeStep = min(fTimeStep, _GetConservativeAdvancementTime(pdistreport->minDistance, flinear, fangular));
+    }
+    if( batchoptions & CBO_SelfCollision ) {
+        // both links of the closest pair can be moving
+        if( CheckStandaloneSelfCollision(pbody, pdistreport) || pdistreport->minDistance < fTolerance ) {
+            return CBO_SelfCollision;
+        }
+        fTimeStep = min(fTimeStep, _GetConservativeAdvancementTime(pdistreport->minDistance, 2*flinear, 2*fangular));
+    }
+    return 0;
+}
+
 CollisionOptionsStateSaver::CollisionOptionsStateSaver(CollisionCheckerBasePtr p, int newoptions, bool required)
 {
     _oldoptions = p->GetCollisionOptions();
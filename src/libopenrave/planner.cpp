@@ -633,6 +633,40 @@ int SetDOFVelocitiesIndicesParameters(KinBodyPtr pbody, const std::vector<dReal>
     return 0;
 }
 
+/// \brief weighted euclidean distance of dofs that are not circular, equal to _EvalJointDOFDistanceMetric for them
+class JointDOFEuclideanDistanceMetric
+{
+public:
+    JointDOFEuclideanDistanceMetric(const std::vector<dReal>& vweights2) : _vweights2(vweights2) {
+    }
+
+    dReal operator()(const std::vector<dReal>& c0, const std::vector<dReal>& c1) const
+    {
+        OPENRAVE_ASSERT_OP(c0.size(),==,_vweights2.size());
+        OPENRAVE_ASSERT_OP(c1.size(),==,_vweights2.size());
+        dReal dist = 0;
+        for(size_t i = 0; i < _vweights2.size(); ++i) {
+            dReal f = c0[i] - c1[i];
+            dist += _vweights2[i]*f*f;
+        }
+        return RaveSqrt(dist);
+    }
+
+    std::vector<dReal> _vweights2; ///< squared weights
+};
+
+/// \brief returns true if any of the dofs is circular
+static bool _HasCircularDOF(const KinBody& body, const std::vector<int>& dofindices)
+{
+    FOREACHC(itindex, dofindices) {
+        const KinBody::JointPtr& pjoint = body.GetJointFromDOFIndex(*itindex);
+        if( pjoint->IsCircular(*itindex-pjoint->GetDOFIndex()) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void PlannerParameters::SetRobotActiveJoints(RobotBasePtr& robot)
 {
     // check if any of the links affected by the dofs beside the base link are static
@@ -646,7 +680,17 @@ void PlannerParameters::SetRobotActiveJoints(RobotBasePtr& robot)
     }
 
     using namespace planningutils;
-    _distmetricfn = boost::bind(&SimpleDistanceMetric::Eval,boost::shared_ptr<SimpleDistanceMetric>(new SimpleDistanceMetric(robot)),_1,_2);
+    if( robot->GetActiveDOF() == (int)robot->GetActiveDOFIndices().size() && !_HasCircularDOF(*robot, robot->GetActiveDOFIndices()) ) {
+        std::vector<dReal> vweights2;
+        robot->GetActiveDOFWeights(vweights2);
+        FOREACH(itf,vweights2) {
+            *itf *= *itf;
+        }
+        _distmetricfn = JointDOFEuclideanDistanceMetric(vweights2);
+    }
+    else {
+        _distmetricfn = boost::bind(&SimpleDistanceMetric::Eval,boost::shared_ptr<SimpleDistanceMetric>(new SimpleDistanceMetric(robot)),_1,_2);
+    }
     if( robot->GetActiveDOF() == (int)robot->GetActiveDOFIndices().size() ) {
         // only roobt joint indices, so use a more resiliant function
         _getstatefn = boost::bind(&RobotBase::GetDOFValues,robot,_1,robot->GetActiveDOFIndices());
@@ -944,6 +988,7 @@ void PlannerParameters::SetConfigurationSpecification(EnvironmentBasePtr penv, c
     }
 
     _listInternalSamplers.clear();
+    boost::shared_ptr<JointDOFEuclideanDistanceMetric> pEuclideanDistanceMetric;
 
     std::sort(vgroupoffsets.begin(),vgroupoffsets.end());
     for(size_t igroup = 0; igroup < spec._vgroups.size(); ++igroup) {
@@ -968,6 +1013,9 @@ void PlannerParameters::SetConfigurationSpecification(EnvironmentBasePtr penv, c
             diffstatefns[isavegroup].second = g.dof;
             distmetricfns[isavegroup].first = boost::bind(_EvalJointDOFDistanceMetric, diffstatefns[isavegroup].first, _1, _2, vweights2);
             distmetricfns[isavegroup].second = g.dof;
+            if( spec._vgroups.size() == 1 && !_HasCircularDOF(*pbody, dofindices) ) {
+                pEuclideanDistanceMetric.reset(new JointDOFEuclideanDistanceMetric(vweights2));
+            }
 
             SpaceSamplerBasePtr pconfigsampler = RaveCreateSpaceSampler(penv,str(boost::format("bodyconfiguration %s")%pbody->GetName()));
             _listInternalSamplers.push_back(pconfigsampler);
@@ -1019,7 +1067,12 @@ void PlannerParameters::SetConfigurationSpecification(EnvironmentBasePtr penv, c
         }
     }
     _diffstatefn = boost::bind(_CallDiffStateFns,diffstatefns, spec.GetDOF(), nMaxDOFForGroup, _1, _2);
-    _distmetricfn = boost::bind(_CallDistMetricFns,distmetricfns, spec.GetDOF(), nMaxDOFForGroup, _1, _2);
+    if( !!pEuclideanDistanceMetric ) {
+        _distmetricfn = *pEuclideanDistanceMetric;
+    }
+    else {
+        _distmetricfn = boost::bind(_CallDistMetricFns,distmetricfns, spec.GetDOF(), nMaxDOFForGroup, _1, _2);
+    }
     _samplefn = boost::bind(_CallSampleFns,samplefns, spec.GetDOF(), nMaxDOFForGroup, _1);
     _sampleneighfn = boost::bind(_CallSampleNeighFns,sampleneighfns, distmetricfns, spec.GetDOF(), nMaxDOFForGroup, _1, _2, _3);
     _setstatevaluesfn = boost::bind(CallSetStateValuesFns,setstatevaluesfns, spec.GetDOF(), nMaxDOFForGroup, _1, _2);
@@ -1041,6 +1094,16 @@ void PlannerParameters::SetConfigurationSpecification(EnvironmentBasePtr penv, c
     _checkpathvelocityaccelerationconstraintsfn = std::bind(CheckWithAccelerations, pcollision, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7, std::placeholders::_8, std::placeholders::_9, std::placeholders::_10);
 }
 
+bool PlannerParameters::GetDistMetricWeights2(std::vector<dReal>& vweights2) const
+{
+    const JointDOFEuclideanDistanceMetric* pmetric = _distmetricfn.target<JointDOFEuclideanDistanceMetric>();
+    if( !pmetric ) {
+        return false;
+    }
+    vweights2 = pmetric->_vweights2;
+    return true;
+}
+
 void PlannerParameters::Validate() const
 {
     OPENRAVE_ASSERT_OP(_configurationspecification.GetDOF(),==,GetDOF());
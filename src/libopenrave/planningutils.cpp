@@ -2238,7 +2238,7 @@ void GetDHParameters(std::vector<DHParameter>& vparameters, KinBodyConstPtr pbod
     }
 }
 
-DynamicsCollisionConstraint::DynamicsCollisionConstraint(PlannerBase::PlannerParametersConstPtr parameters, const std::list<KinBodyPtr>& listCheckBodies, int filtermask) : _listCheckBodies(listCheckBodies), _filtermask(filtermask), _torquelimitmode(DC_NominalTorque), _perturbation(0.1)
+DynamicsCollisionConstraint::DynamicsCollisionConstraint(PlannerBase::PlannerParametersConstPtr parameters, const std::list<KinBodyPtr>& listCheckBodies, int filtermask) : _listCheckBodies(listCheckBodies), _filtermask(filtermask), _torquelimitmode(DC_NominalTorque), _perturbation(0.1), _fContinuousCollisionTolerance(0.001)
 {
     BOOST_ASSERT(listCheckBodies.size()>0);
     _report.reset(new CollisionReport());
@@ -2278,6 +2278,11 @@ void DynamicsCollisionConstraint::SetPerturbation(dReal perturbation)
     _perturbation = perturbation;
 }
 
+void DynamicsCollisionConstraint::SetContinuousCollisionTolerance(dReal tolerance)
+{
+    _fContinuousCollisionTolerance = tolerance;
+}
+
 int DynamicsCollisionConstraint::_SetAndCheckState(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& vdofvalues, const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn)
 {
 //    if( IS_DEBUGLEVEL(Level_Verbose) ) {
@@ -2331,6 +2336,27 @@ int DynamicsCollisionConstraint::_SetAndCheckState(PlannerBase::PlannerParameter
     return 0;
 }
 
+/// \brief true if the inverse dynamics of the body can be computed with KinBody::InverseDynamicsWorkspace, which requires a static base and only revolute or prismatic joints without mimics
+static bool _CanUseInverseDynamicsWorkspace(const KinBody& body)
+{
+    std::pair<Vector, Vector> basevelocity = body.GetLinks().at(0)->GetVelocity();
+    if( basevelocity.first.lengthsqr3() > g_fEpsilon || basevelocity.second.lengthsqr3() > g_fEpsilon ) {
+        return false;
+    }
+    for(int ijointlist = 0; ijointlist < 2; ++ijointlist) {
+        const std::vector<KinBody::JointPtr>& vjoints = ijointlist == 0 ? body.GetJoints() : body.GetPassiveJoints();
+        FOREACHC(itjoint, vjoints) {
+            if( (*itjoint)->IsStatic() ) {
+                continue;
+            }
+            if( (*itjoint)->IsMimic() || ((*itjoint)->GetType() != KinBody::JointRevolute && (*itjoint)->GetType() != KinBody::JointPrismatic) ) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 int DynamicsCollisionConstraint::_CheckState(const std::vector<dReal>& vdofvelocities, const std::vector<dReal>& vdofaccels, int options, ConstraintFilterReturnPtr filterreturn)
 {
     options &= _filtermask;
@@ -2453,7 +2479,14 @@ int DynamicsCollisionConstraint::_CheckState(const std::vector<dReal>& vdofveloc
                 _specvel.ExtractJointValues(_dofaccelerations.begin(), vdofaccels.begin(), pbody, _vdofindices, 1);
 
                 // compute inverse dynamics and check
-                pbody->ComputeInverseDynamics(_doftorques, _dofaccelerations);
+                if( _CanUseInverseDynamicsWorkspace(*pbody) ) {
+                    // the workspace only copies the link inertias and joint chain, so re-initializing it for the current base keeps the check free of allocations
+                    pbody->InitInverseDynamicsWorkspace(_inversedynamicsworkspace);
+                    _inversedynamicsworkspace.ComputeInverseDynamicsBatch(_vfulldofvalues.data(), _vfulldofvelocities.data(), _dofaccelerations.data(), 1, _doftorques.data());
+                }
+                else {
+                    pbody->ComputeInverseDynamics(_doftorques, _dofaccelerations);
+                }
                 FOREACH(it, _vtorquevalues) {
                     int index = it->first;
                     const std::pair<dReal, dReal>& torquelimits = it->second;
@@ -2530,6 +2563,170 @@ void DynamicsCollisionConstraint::_PrintOnFailure(const std::string& prefix)
     }
 }
 
+int DynamicsCollisionConstraint::_CheckContinuousCollisions(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& q0, const std::vector<dReal>& q1, const std::vector<dReal>& dq0, const std::vector<dReal>& dq1, dReal timeelapsed, int options, int& nCheckedOptions, ConstraintFilterReturnPtr filterreturn)
+{
+    nCheckedOptions = 0;
+    if( _listCheckBodies.size() != 1 ) {
+        return 0;
+    }
+    KinBodyPtr pbody = _listCheckBodies.front();
+
+    // the continuous check moves the dofs of the body directly, so the configuration has to be made only of them
+    params->_configurationspecification.ExtractUsedIndices(pbody, _vcontinuousdofindices, _vcontinuousconfigindices);
+    if( (int)_vcontinuousdofindices.size() != params->GetDOF() ) {
+        return 0;
+    }
+    for(size_t i = 0; i < _vcontinuousconfigindices.size(); ++i) {
+        if( _vcontinuousconfigindices[i] != (int)i ) {
+            return 0;
+        }
+    }
+
+    int batchoptions = 0;
+    if( options & CFO_CheckEnvCollisions ) {
+        batchoptions |= CBO_Environment;
+    }
+    // KinBody::CheckSelfCollision also checks the grabbed bodies and can use a different checker
+    if( (options & CFO_CheckSelfCollisions) && pbody->GetNumGrabbed() == 0 && !pbody->GetSelfCollisionChecker() ) {
+        batchoptions |= CBO_SelfCollision;
+    }
+    if( batchoptions == 0 ) {
+        return 0;
+    }
+
+    CollisionCheckerBasePtr pchecker = pbody->GetEnv()->GetCollisionChecker();
+    if( !pchecker ) {
+        return 0;
+    }
+    dReal fTimeOfContact = 0;
+    int ret = 0;
+    try {
+        ret = pchecker->CheckContinuousCollision(pbody, q0, q1, dq0, dq1, timeelapsed, _vcontinuousdofindices, fTimeOfContact, batchoptions, _fContinuousCollisionTolerance, _report);
+    }
+    catch(const openrave_exception& ex) {
+        if( ex.GetCode() != ORE_NotImplemented ) {
+            throw;
+        }
+        RAVELOG_VERBOSE_FORMAT("env=%d, falling back to discretized collision checks: %s", pbody->GetEnv()->GetId()%ex.what());
+        return 0;
+    }
+
+    if( ret != 0 ) {
+        int nstateret = (ret & CBO_Environment) ? CFO_CheckEnvCollisions : CFO_CheckSelfCollisions;
+        if( !!filterreturn ) {
+            const bool bParabolic = timeelapsed > 0 && dq0.size() == q0.size() && dq1.size() == q0.size();
+            filterreturn->_returncode = nstateret;
+            filterreturn->_invalidvalues.resize(q0.size());
+            filterreturn->_invalidvelocities.resize(bParabolic ? q0.size() : 0);
+            for(size_t i = 0; i < q0.size(); ++i) {
+                if( bParabolic ) {
+                    dReal accel = (dq1[i] - dq0[i])/timeelapsed;
+                    filterreturn->_invalidvalues[i] = q0[i] + fTimeOfContact*(dq0[i] + 0.5*fTimeOfContact*accel);
+                    filterreturn->_invalidvelocities[i] = dq0[i] + fTimeOfContact*accel;
+                }
+                else {
+                    filterreturn->_invalidvalues[i] = q0[i] + fTimeOfContact*(q1[i] - q0[i]);
+                }
+            }
+            filterreturn->_fTimeWhenInvalid = fTimeOfContact;
+            if( options & CFO_FillCollisionReport ) {
+                filterreturn->_report = *_report;
+            }
+        }
+        if( IS_DEBUGLEVEL(Level_Verbose) ) {
+            RAVELOG_VERBOSE_FORMAT("env=%d, continuous collision failed at time %f: %s", pbody->GetEnv()->GetId()%fTimeOfContact%_report->__str__());
+        }
+        return nstateret;
+    }
+
+    if( batchoptions & CBO_Environment ) {
+        nCheckedOptions |= CFO_CheckEnvCollisions;
+    }
+    if( batchoptions & CBO_SelfCollision ) {
+        nCheckedOptions |= CFO_CheckSelfCollisions;
+    }
+    return 0;
+}
+
+int DynamicsCollisionConstraint::_CheckCollisionsInBisectionOrder(PlannerBase::PlannerParametersConstPtr params, const std::vector<dReal>& q0, const std::vector<dReal>& vdelta, const std::vector<dReal>& dq0, const std::vector<dReal>& dq1, dReal timeelapsed, int numSteps, int options, int& nCheckedOptions, ConstraintFilterReturnPtr filterreturn)
+{
+    nCheckedOptions = 0;
+    const int collisionoptions = options & (CFO_CheckEnvCollisions|CFO_CheckSelfCollisions|CFO_CheckWithPerturbation|CFO_FillCollisionReport);
+    if( !(collisionoptions & (CFO_CheckEnvCollisions|CFO_CheckSelfCollisions)) ) {
+        return 0;
+    }
+
+    const size_t ndof = q0.size();
+    const bool bParabolic = timeelapsed > 0 && dq0.size() == ndof && dq1.size() == ndof;
+    int numIntervals = numSteps;
+    if( bParabolic ) {
+        // the speed of a dof is largest at one of the ends of a parabola, so sampling uniformly in time with this many intervals keeps every dof within its resolution
+        numIntervals = 0;
+        for(size_t idof = 0; idof < ndof; ++idof) {
+            dReal fdist = max(RaveFabs(dq0[idof]), RaveFabs(dq1[idof]))*timeelapsed;
+            dReal fresolution = params->_vConfigResolution.at(idof);
+            int steps = fresolution != 0 ? (int)(fdist/fresolution + 0.99) : (int)(fdist*100);
+            if( steps > numIntervals ) {
+                numIntervals = steps;
+            }
+        }
+    }
+
+    _vtempconfig.resize(ndof);
+    _vtempvelconfig.resize(dq0.size() == ndof && dq1.size() == ndof ? ndof : 0);
+    _vbisectionintervals.resize(0);
+    if( numIntervals >= 2 ) {
+        _vbisectionintervals.reserve(numIntervals);
+        _vbisectionintervals.emplace_back(0, numIntervals);
+    }
+    const dReal fiNumIntervals = numIntervals > 0 ? 1/(dReal)numIntervals : dReal(0);
+    // visit the middle of every interval before the middles of its halves, this is the van der Corput order on the discretized segment
+    for(size_t iinterval = 0; iinterval < _vbisectionintervals.size(); ++iinterval) {
+        const int lower = _vbisectionintervals[iinterval].first, upper = _vbisectionintervals[iinterval].second;
+        const int middle = (lower + upper)/2;
+        if( middle - lower >= 2 ) {
+            _vbisectionintervals.emplace_back(lower, middle);
+        }
+        if( upper - middle >= 2 ) {
+            _vbisectionintervals.emplace_back(middle, upper);
+        }
+
+        dReal t = middle*fiNumIntervals, fTimeWhenInvalid = t;
+        if( bParabolic ) {
+            dReal itimeelapsed = 1/timeelapsed;
+            t *= timeelapsed;
+            fTimeWhenInvalid = t;
+            for(size_t idof = 0; idof < ndof; ++idof) {
+                dReal accel = (dq1[idof] - dq0[idof])*itimeelapsed;
+                _vtempconfig[idof] = q0[idof] + t*(dq0[idof] + 0.5*t*accel);
+                _vtempvelconfig[idof] = dq0[idof] + t*accel;
+            }
+        }
+        else {
+            for(size_t idof = 0; idof < ndof; ++idof) {
+                _vtempconfig[idof] = q0[idof] + t*vdelta[idof];
+            }
+            for(size_t idof = 0; idof < _vtempvelconfig.size(); ++idof) {
+                _vtempvelconfig[idof] = dq0[idof] + t*(dq1[idof] - dq0[idof]);
+            }
+        }
+
+        int nstateret = _SetAndCheckState(params, _vtempconfig, _vtempvelconfig, _vtempaccelconfig, collisionoptions, filterreturn);
+        if( nstateret != 0 ) {
+            if( !!filterreturn ) {
+                filterreturn->_returncode = nstateret;
+                filterreturn->_invalidvalues = _vtempconfig;
+                filterreturn->_invalidvelocities = _vtempvelconfig;
+                filterreturn->_fTimeWhenInvalid = fTimeWhenInvalid;
+            }
+            return nstateret;
+        }
+    }
+
+    nCheckedOptions = collisionoptions & (CFO_CheckEnvCollisions|CFO_CheckSelfCollisions);
+    return 0;
+}
+
 inline std::ostream& RaveSerializeTransform(std::ostream& O, const Transform& t, char delim=',')
 {
     O << t.rot.x << delim << t.rot.y << delim << t.rot.z << delim << t.rot.w << delim << t.trans.x << delim << t.trans.y << delim << t.trans.z;
@@ -2799,6 +2996,33 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
         return 0;
     }
 
+    // the collisions of the whole segment are checked at once, so only the remaining constraints are checked at every step.
+    int nPrecheckedOptions = 0;
+    if( (maskoptions & CFO_CheckContinuousCollisions) && !(maskoptions & CFO_CheckWithPerturbation) && (maskoptions & (CFO_CheckEnvCollisions|CFO_CheckSelfCollisions)) ) {
+        const bool bParabolic = maskinterpolation == IT_Default && (timeelapsed > 0 && dq0.size() == q0.size() && dq1.size() == q0.size());
+        _vcontinuousq1.resize(q0.size());
+        for (i = 0; i < q0.size(); i++) {
+            _vcontinuousq1[i] = q0[i] + dQ.at(i);
+        }
+        int nstateret = _CheckContinuousCollisions(params, q0, _vcontinuousq1, bParabolic ? dq0 : std::vector<dReal>(), bParabolic ? dq1 : std::vector<dReal>(), bParabolic ? timeelapsed : dReal(0), maskoptions, nPrecheckedOptions, filterreturn);
+        if( nstateret != 0 ) {
+            return nstateret;
+        }
+        maskoptions &= ~nPrecheckedOptions;
+    }
+
+    // the collisions at the interpolated steps are checked starting from the middle of the segment, so the steps below only check the remaining constraints and fill the checked configurations in time order.
+    if( (maskoptions & CFO_CheckInBisectionOrder) && (maskoptions & (CFO_CheckEnvCollisions|CFO_CheckSelfCollisions)) ) {
+        const bool bParabolic = maskinterpolation == IT_Default && (timeelapsed > 0 && dq0.size() == q0.size() && dq1.size() == q0.size());
+        int nBisectionCheckedOptions = 0;
+        int nstateret = _CheckCollisionsInBisectionOrder(params, q0, dQ, bParabolic ? dq0 : std::vector<dReal>(), bParabolic ? dq1 : std::vector<dReal>(), bParabolic ? timeelapsed : dReal(0), numSteps, maskoptions, nBisectionCheckedOptions, filterreturn);
+        if( nstateret != 0 ) {
+            return nstateret;
+        }
+        maskoptions &= ~nBisectionCheckedOptions;
+        nPrecheckedOptions |= nBisectionCheckedOptions;
+    }
+
     for (i = 0; i < params->GetDOF(); i++) {
         _vtempconfig.at(i) = q0.at(i);
     }
@@ -3092,6 +3316,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
             }
             if( neighstatus == NSS_SuccessfulWithDeviation ) {
                 bHasRampDeviatedFromInterpolation = true;
+                maskoptions |= nPrecheckedOptions; // the continuous and bisection checks only covered the interpolated segment
             }
             bHasNewTempConfigToAdd = true;
 
@@ -3302,6 +3527,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
                 // Although being collision-free, the configurations along the segment (q, qnew) may
                 // not satisfy other constraints. Therefore, we do *not* add them to filterreturn.
                 bHasRampDeviatedFromInterpolation = true;
+                maskoptions |= nPrecheckedOptions; // the continuous and bisection checks only covered the interpolated segment
                 int maxnumsteps = 0, steps;
                 itres = vConfigResolution.begin();
                 for( int idof = 0; idof < params->GetDOF(); idof++, itres++ ) {
@@ -3420,6 +3646,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
                 // Although being collision-free, the configurations along the segment (q, qnew) may not
                 // satisfy other constraints. Therefore, we do *not* add them to filterreturn.
                 bHasRampDeviatedFromInterpolation = true;
+                maskoptions |= nPrecheckedOptions; // the continuous and bisection checks only covered the interpolated segment
                 int maxnumsteps = 0, steps;
                 itres = vConfigResolution.begin();
                 for( int idof = 0; idof < params->GetDOF(); idof++, itres++ ) {
@@ -3496,6 +3723,7 @@ int DynamicsCollisionConstraint::Check(const std::vector<dReal>& q0, const std::
 
             if( numPostNeighSteps > 1 ) {
                 bHasRampDeviatedFromInterpolation = true;
+                maskoptions |= nPrecheckedOptions; // the continuous and bisection checks only covered the interpolated segment
                 // should never happen, but just in case _neighstatefn is some non-linear constraint projection
                 if( _listCheckBodies.size() > 0 ) {
                     RAVELOG_WARN_FORMAT("env=%d, have to divide the arc in %d steps even after original interpolation is done, interval=%d", _listCheckBodies.front()->GetEnv()->GetId()%numPostNeighSteps%interval);
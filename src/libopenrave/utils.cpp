@@ -17,6 +17,8 @@
 #include "libopenrave.h"
 #include <openrave/utils.h>
 
+#include <functional>
+
 #include "md5.h"
 
 namespace OpenRAVE {
@@ -121,5 +123,95 @@ std::string GetFilenameUntilSeparator(std::istream& sinput, char separator)
     return filename.substr( startpos, endpos-startpos+1 );
 }
 
+WorkerPool::WorkerPool(int numthreads)
+    : _nJobStamp(0)
+    , _numRunning(0)
+    , _bStop(false)
+{
+    for(int ithread = 1; ithread < numthreads; ++ithread) {
+        _vthreads.push_back(boost::make_shared<std::thread>(std::bind(&WorkerPool::_WorkerThread, this, ithread)));
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _bStop = true;
+    }
+    _condHasWork.notify_all();
+    FOREACH(itthread, _vthreads) {
+        (*itthread)->join();
+    }
+    _vthreads.clear();
+}
+
+void WorkerPool::Run(const JobFn& jobfn)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobfn = jobfn;
+        _numRunning = _vthreads.size();
+        _errormessage.clear();
+        ++_nJobStamp;
+    }
+    _condHasWork.notify_all();
+
+    std::string errormessage;
+    try {
+        jobfn(0);
+    }
+    catch(const std::exception& ex) {
+        errormessage = ex.what();
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condFinished.wait(lock, [this]() {
+        return _numRunning == 0;
+    });
+    _jobfn.clear();
+    if( errormessage.size() == 0 ) {
+        errormessage.swap(_errormessage);
+    }
+    if( errormessage.size() > 0 ) {
+        throw OPENRAVE_EXCEPTION_FORMAT("worker job failed: %s", errormessage, ORE_Failed);
+    }
+}
+
+void WorkerPool::_WorkerThread(int ithread)
+{
+    uint64_t nLastJobStamp = 0;
+    while(true) {
+        JobFn jobfn;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condHasWork.wait(lock, [this, nLastJobStamp]() {
+                return _bStop || _nJobStamp != nLastJobStamp;
+            });
+            if( _bStop ) {
+                return;
+            }
+            nLastJobStamp = _nJobStamp;
+            jobfn = _jobfn;
+        }
+
+        std::string errormessage;
+        try {
+            jobfn(ithread);
+        }
+        catch(const std::exception& ex) {
+            errormessage = ex.what();
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if( errormessage.size() > 0 && _errormessage.size() == 0 ) {
+            _errormessage = errormessage;
+        }
+        if( --_numRunning == 0 ) {
+            _condFinished.notify_all();
+        }
+    }
+}
+
 } // utils
 } // OpenRAVE
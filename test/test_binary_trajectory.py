@@ -12,6 +12,7 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 from common_test_openrave import *
+import tempfile
 
 class TestBinaryTrajectory(EnvironmentSetup):
 	def test_binary_traj(self):
@@ -107,3 +108,50 @@ class TestBinaryTrajectory(EnvironmentSetup):
 		trajBinary1 = trajectory1.serialize()
 		trajectory1Copy.deserialize(trajBinary1)
 		assert(trajectory1Copy.GetDescription()=='test')
+
+	def test_mapped_traj(self):
+		env = self.env
+		trajxml = """
+		<trajectory>
+		<configuration>
+		<group name="joint_values GP7 0 1" offset="0" dof="2" interpolation="linear"/>
+		<group name="deltatime" offset="2" dof="1" interpolation=""/>
+		</configuration>
+		<data count="4">
+		0 0 0 1 2 0.5 2 1 1 -1 0.5 0.25
+		</data>
+		</trajectory>
+		"""
+		trajectory = RaveCreateTrajectory(env, '')
+		trajectory.deserialize(trajxml)
+		trajectory.SetDescription('mapped')
+		fd, filename = tempfile.mkstemp(suffix='.traj')
+		os.close(fd)
+		try:
+			# the default binary format cannot be mapped
+			trajectory.SaveToFile(filename)
+			assert_raises(openrave_exception, RaveCreateTrajectory(env, 'MappedTrajectory').SendCommand, 'Load %s'%filename)
+
+			# 0x4000 writes the aligned binary format
+			trajectory.SaveToFile(filename, 0x4000)
+			trajectoryCopy = RaveCreateTrajectory(env, '')
+			trajectoryCopy.LoadFromFile(filename)
+			assert trajectory.GetConfigurationSpecification() == trajectoryCopy.GetConfigurationSpecification()
+			assert list(trajectory.GetWaypoints(0, trajectory.GetNumWaypoints())) == list(trajectoryCopy.GetWaypoints(0, trajectoryCopy.GetNumWaypoints()))
+
+			mapped = RaveCreateTrajectory(env, 'MappedTrajectory')
+			mapped.SendCommand('Load %s'%filename)
+			assert trajectory.GetConfigurationSpecification() == mapped.GetConfigurationSpecification()
+			assert mapped.GetDescription() == 'mapped'
+			assert list(trajectory.GetWaypoints(0, trajectory.GetNumWaypoints())) == list(mapped.GetWaypoints(0, mapped.GetNumWaypoints()))
+			times = linspace(0, trajectory.GetDuration(), 21)
+			assert transdist(trajectory.SamplePoints2D(times), mapped.SamplePoints2D(times)) <= len(times)*g_epsilon
+			for t in times:
+				assert transdist(trajectory.Sample(t), mapped.Sample(t)) <= g_epsilon
+			# clones share the mapping
+			mappedClone = RaveClone(mapped, 0)
+			assert transdist(trajectory.SamplePoints2D(times), mappedClone.SamplePoints2D(times)) <= len(times)*g_epsilon
+			# the mapped waypoints are read only
+			assert_raises(openrave_exception, mapped.Insert, mapped.GetNumWaypoints(), [0, 0, 1])
+		finally:
+			os.remove(filename)
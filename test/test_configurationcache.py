@@ -13,6 +13,7 @@
 # limitations under the License.
 from common_test_openrave import *
 from openravepy import openravepy_configurationcache
+import threading
 
 class TestConfigurationCache(EnvironmentSetup):
     def setup(self):
@@ -135,6 +136,147 @@ class TestConfigurationCache(EnvironmentSetup):
             self.log.info('writing cache to file...')
             cachechecker.SendCommand('SaveCache')
 
+    def test_saveload(self):
+        env = self.env
+        with env:
+            self.LoadEnv('data/lab1.env.xml')
+            robot = env.GetRobots()[0]
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+
+            cachechecker = RaveCreateCollisionChecker(self.env,'CacheChecker')
+            success=cachechecker.SendCommand('TrackRobotState %s'%robot.GetName())
+            assert(success is not None)
+            env.SetCollisionChecker(cachechecker)
+            robot.SetSelfCollisionChecker(cachechecker)
+            cachechecker.SendCommand('ResetSelfCache')
+
+            sampler = RaveCreateSpaceSampler(env, u'RobotConfiguration %s'%robot.GetName())
+            confs = []
+            selfcollisions = []
+            with robot:
+                for iter in range(0, 200):
+                    robot.SetActiveDOFValues(sampler.SampleSequence(SampleDataType.Real,1))
+                    confs.append(robot.GetActiveDOFValues())
+                    selfcollisions.append(env.GetCollisionChecker().CheckSelfCollision(robot))
+            selfcachedcollisions, selfcachedcollisionhits, selfcachedfreehits, selfcachesize = cachechecker.SendCommand('GetSelfCacheStatistics').split()
+            assert(int(selfcachesize) > 0)
+
+            self.log.info('writing cache to file...')
+            cachechecker.SendCommand('SaveCache')
+            cachechecker.SendCommand('ResetSelfCache')
+            selfcachedcollisions, selfcachedcollisionhits, selfcachedfreehits, resetcachesize = cachechecker.SendCommand('GetSelfCacheStatistics').split()
+            assert(int(resetcachesize) == 0)
+
+            self.log.info('reading cache from file...')
+            cachechecker.SendCommand('LoadCache')
+            selfcachedcollisions, selfcachedcollisionhits, selfcachedfreehits, loadedcachesize = cachechecker.SendCommand('GetSelfCacheStatistics').split()
+            assert(int(loadedcachesize) == int(selfcachesize))
+            assert(int(cachechecker.SendCommand('ValidateSelfCache')) == 1)
+            with robot:
+                for values, selfcollision in izip(confs, selfcollisions):
+                    robot.SetActiveDOFValues(values)
+                    assert(env.GetCollisionChecker().CheckSelfCollision(robot) == selfcollision)
+            self.log.info('save and load test passed')
+
+    def test_concurrentqueries(self):
+        self.LoadEnv('data/lab1.env.xml')
+        env=self.env
+        robot=env.GetRobots()[0]
+        robot.SetActiveDOFs(range(7))
+        cache=openravepy_configurationcache.ConfigurationCache(robot)
+        originalvalues = robot.GetActiveDOFValues()
+        cache.InsertConfiguration(originalvalues, None)
+        errors = []
+        def insertconfigurations(seed):
+            try:
+                randomstate = random.RandomState(seed)
+                for iter in range(0, 500):
+                    cache.InsertConfiguration(originalvalues + 0.5*(randomstate.rand(len(originalvalues))-0.5), None)
+            except Exception as e:
+                errors.append(e)
+
+        def queryconfigurations(seed):
+            try:
+                randomstate = random.RandomState(seed)
+                for iter in range(0, 500):
+                    values = originalvalues + 0.5*(randomstate.rand(len(originalvalues))-0.5)
+                    ret, closestdist, collisioninfo = cache.CheckCollision(values)
+                    # inserted configurations are all free
+                    assert(ret != 1)
+                    cache.FindNearestNode(values, 4)
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target=insertconfigurations, args=(seed,)) for seed in range(2)] + [threading.Thread(target=queryconfigurations, args=(seed,)) for seed in range(2,6)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        assert(len(errors) == 0)
+        assert(cache.GetNumNodes() > 1)
+        assert(cache.Validate())
+
+    def test_persistentroadmap(self):
+        env = self.env
+        with env:
+            self.LoadEnv('data/lab1.env.xml')
+            robot = env.GetRobots()[0]
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            start = robot.GetActiveDOFValues()
+            goal = array([-0.75,1,0,2,-1,-1.5,1])
+
+            def getroadmapinfo(planner):
+                numvertices, numedges, numvalid, numinvalid = [int(x) for x in planner.SendCommand('GetRoadmapInfo').split()]
+                return numvertices, numedges, numvalid, numinvalid
+
+            def plan(planner, initial, goal):
+                params = Planner.PlannerParameters()
+                params.SetRobotActiveJoints(robot)
+                params.SetInitialConfig(initial)
+                params.SetGoalConfig(goal)
+                params.SetMaxIterations(5000)
+                assert(planner.InitPlan(robot, params))
+                traj = RaveCreateTrajectory(env,'')
+                with robot:
+                    status = planner.PlanPath(traj)
+                assert(status.statusCode == PlannerStatusCode.HasSolution)
+                assert(transdist(traj.GetWaypoint(0,robot.GetActiveConfigurationSpecification()),initial) <= g_epsilon)
+                assert(transdist(traj.GetWaypoint(-1,robot.GetActiveConfigurationSpecification()),goal) <= g_epsilon)
+                with robot:
+                    planningutils.RetimeActiveDOFTrajectory(traj,robot,False)
+                    planningutils.VerifyTrajectory(params,traj,samplingstep=0.002)
+                return traj
+
+            planner = RaveCreatePlanner(env,'PersistentRoadmap')
+            plan(planner, start, goal)
+            numvertices, numedges, numvalid, numinvalid = getroadmapinfo(planner)
+            assert(numvertices >= 2 and numvalid > 0)
+
+            # the roadmap is kept between queries
+            plan(planner, goal, start)
+            numvertices2, numedges2, numvalid2, numinvalid2 = getroadmapinfo(planner)
+            assert(numvertices2 >= numvertices and numedges2 >= numedges)
+
+            # a roadmap loaded for the same state keeps its checked edges
+            assert(planner.SendCommand('SaveRoadmap test_persistentroadmap') is not None)
+            planner2 = RaveCreatePlanner(env,'PersistentRoadmap')
+            params = Planner.PlannerParameters()
+            params.SetRobotActiveJoints(robot)
+            params.SetInitialConfig(start)
+            params.SetGoalConfig(goal)
+            assert(planner2.InitPlan(robot, params))
+            assert(planner2.SendCommand('LoadRoadmap test_persistentroadmap') is not None)
+            assert(getroadmapinfo(planner2) == (numvertices2, numedges2, numvalid2, 0))
+
+            # moving an obstacle invalidates the free edges
+            mug = env.GetKinBody('mug1')
+            T = mug.GetTransform()
+            T[2,3] += 0.01
+            mug.SetTransform(T)
+            numvertices3, numedges3, numvalid3, numinvalid3 = getroadmapinfo(planner)
+            assert(numvertices3 == numvertices2 and numvalid3 == 0)
+            plan(planner, start, goal)
+
     def test_find_insert(self):
 
         self.LoadEnv('data/lab1.env.xml')
@@ -191,6 +191,43 @@ class TestEnvironment(EnvironmentSetup):
             assert(endtime <= 0.05)
             misc.CompareEnvironments(env,clonedenv,epsilon=g_epsilon)
             
+    def test_updatefromclone(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        with env:
+            robot=env.GetRobots()[0]
+            clonedenv = env.CloneSelf(CloningOptions.Bodies)
+            try:
+                clonedrobot = clonedenv.GetRobot(robot.GetName())
+
+                # only the state changed
+                values = robot.GetDOFValues()
+                values[0] += 0.2
+                robot.SetDOFValues(values)
+                clonedenv.UpdateFromClone(env, CloningOptions.Bodies)
+                misc.CompareEnvironments(env,clonedenv,epsilon=g_epsilon)
+                assert(transdist(clonedrobot.GetDOFValues(),robot.GetDOFValues()) <= g_epsilon)
+
+                # velocities do not change the update stamp of the body
+                velocities = zeros(robot.GetDOF())
+                velocities[0] = 0.5
+                robot.SetDOFVelocities(velocities)
+                clonedenv.UpdateFromClone(env, CloningOptions.Bodies)
+                assert(transdist(clonedrobot.GetDOFVelocities(),robot.GetDOFVelocities()) <= g_epsilon)
+
+                # changes in the cloned environment are reverted
+                clonedrobot.SetDOFValues(zeros(clonedrobot.GetDOF()))
+                clonedenv.UpdateFromClone(env, CloningOptions.Bodies)
+                assert(transdist(clonedrobot.GetDOFValues(),robot.GetDOFValues()) <= g_epsilon)
+
+                # the set of bodies changed, so everything is cloned again
+                env.Remove(env.GetKinBody('mug1'))
+                clonedenv.UpdateFromClone(env, CloningOptions.Bodies)
+                assert(clonedenv.GetKinBody('mug1') is None)
+                misc.CompareEnvironments(env,clonedenv,epsilon=g_epsilon)
+            finally:
+                clonedenv.Destroy()
+
     def test_multithread(self):
         self.log.info('test multiple threads accessing same resource')
         def mythread(env,threadid):
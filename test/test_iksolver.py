@@ -68,6 +68,32 @@ class TestIkSolver(EnvironmentSetup):
             sols = ikmodel.manip.FindIKSolutions(T,IkFilterOptions.CheckEnvCollisions)
             assert(len(sols)>0 and any([sol[index] > 0.2 for sol in sols]) and any([sol[index] < -0.2 for sol in sols]) and any([sol[index] > -0.2 and sol[index] < 0.2 for sol in sols]))
 
+    def test_solveallbatch(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        ikmodel = databases.inversekinematics.InverseKinematicsModel(robot,IkParameterization.Type.Transform6D)
+        if not ikmodel.load():
+            ikmodel.autogenerate()
+
+        with env:
+            manip = ikmodel.manip
+            iksolver = manip.GetIkSolver()
+            lower,upper = robot.GetDOFLimits(manip.GetArmIndices())
+            ikparams = []
+            with robot:
+                for i in range(20):
+                    robot.SetDOFValues(randlimits(lower,upper),manip.GetArmIndices())
+                    ikparams.append(manip.GetIkParameterization(IkParameterizationType.Transform6D,False))
+            def getsolutions(ikreturns):
+                return sorted([tuple(round(x,6) for x in ikreturn.GetSolution()) for ikreturn in ikreturns])
+
+            for filteroptions in [0,IkFilterOptions.CheckEnvCollisions]:
+                allikreturns = iksolver.SolveAllBatch(ikparams,filteroptions)
+                assert(len(allikreturns) == len(ikparams))
+                for ikparam,ikreturns in izip(ikparams,allikreturns):
+                    assert(getsolutions(ikreturns) == getsolutions(iksolver.SolveAll(ikparam,filteroptions)))
+
     def test_iksolutionjitter(self):
         env=self.env
         self.LoadEnv('data/lab1.env.xml')
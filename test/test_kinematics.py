@@ -589,6 +589,85 @@ class TestKinematics(EnvironmentSetup):
                         coeffs1,residuals, rank, singular_values, rcond=polyfit(mults,errsecond/errsecond[-1],3,full=True)
                         assert(residuals<0.01)
                         
+    def test_batchlinktransformations(self):
+        self.log.info('check the batched link transformations against the link transformations of the body state')
+        env=self.env
+        for envfile in ['robots/barrettwam.robot.xml','robots/pr2-beta-static.zae']:
+            env.Reset()
+            self.LoadEnv(envfile,{'skipgeometry':'1'})
+            body = env.GetBodies()[0]
+            lowerlimit,upperlimit = body.GetDOFLimits()
+            configurations = array([randlimits(lowerlimit,upperlimit) for i in range(10)])
+            with env:
+                alltransforms = body.ComputeLinkTransformationsBatch(configurations)
+                assert(len(alltransforms) == len(configurations))
+                with body:
+                    for dofvalues,transforms in izip(configurations,alltransforms):
+                        body.SetDOFValues(dofvalues)
+                        assert(len(transforms) == len(body.GetLinks()))
+                        for ilink,link in enumerate(body.GetLinks()):
+                            assert(transdist(transforms[ilink],link.GetTransform()) <= g_epsilon)
+
+    def test_batchjacobians(self):
+        self.log.info('check the batched jacobians against the jacobians of the body state')
+        env=self.env
+        for envfile in ['robots/barrettwam.robot.xml','robots/pr2-beta-static.zae']:
+            env.Reset()
+            self.LoadEnv(envfile,{'skipgeometry':'1'})
+            body = env.GetBodies()[0]
+            lowerlimit,upperlimit = body.GetDOFLimits()
+            configurations = array([randlimits(lowerlimit,upperlimit) for i in range(10)])
+            linkindices = range(len(body.GetLinks()))
+            localpositions = random.rand(len(linkindices),3)-0.5
+            with env:
+                jacobians = body.ComputeJacobiansBatch(configurations,linkindices,localpositions)
+                assert(jacobians.shape == (len(configurations),len(linkindices),6,body.GetDOF()))
+                with body:
+                    for dofvalues,linkjacobians in izip(configurations,jacobians):
+                        body.SetDOFValues(dofvalues)
+                        for ilink,link in enumerate(body.GetLinks()):
+                            Tlink = link.GetTransform()
+                            position = dot(Tlink[0:3,0:3],localpositions[ilink])+Tlink[0:3,3]
+                            assert(transdist(linkjacobians[ilink][0:3],body.ComputeJacobianTranslation(ilink,position)) <= g_epsilon)
+                            assert(transdist(linkjacobians[ilink][3:6],body.CalculateAngularVelocityJacobian(ilink)) <= g_epsilon)
+
+    def test_batchinversedynamics(self):
+        self.log.info('check the batched inverse dynamics and its derivatives against ComputeInverseDynamics')
+        env=self.env
+        with env:
+            for envfile in ['robots/wam7.kinbody.xml','robots/barrettwam.robot.xml']:
+                env.Reset()
+                self.LoadEnv(envfile)
+                body = [body for body in env.GetBodies() if body.GetDOF() > 0][0]
+                env.GetPhysicsEngine().SetGravity(random.rand(3)*10-5)
+                lower,upper = body.GetDOFLimits()
+                vellimits = body.GetDOFVelocityLimits()
+                numsamples = 10
+                dofvalues = array([randlimits(lower,upper) for i in range(numsamples)])
+                dofvelocities = array([randlimits(-vellimits,vellimits) for i in range(numsamples)])
+                dofaccelerations = 10*random.rand(numsamples,body.GetDOF())-5
+                torques, dtorquedvalues, dtorquedvelocities = body.ComputeInverseDynamicsBatch(dofvalues,dofvelocities,dofaccelerations,returnderivatives=True)
+                torquethresh = g_epsilon*body.GetDOF()*(1+abs(torques).max())
+                assert(transdist(body.ComputeInverseDynamicsBatch(dofvalues,dofvelocities,dofaccelerations),torques) <= numsamples*torquethresh)
+                with body:
+                    for isample in range(numsamples):
+                        body.SetDOFValues(dofvalues[isample],checklimits=False)
+                        body.SetDOFVelocities(dofvelocities[isample],[0,0,0],[0,0,0],checklimits=False)
+                        assert(transdist(torques[isample],body.ComputeInverseDynamics(dofaccelerations[isample])) <= torquethresh)
+
+                # the derivatives should match the central differences of the torques
+                deltastep = 1e-5
+                derivativethresh = 1e-4*numsamples*body.GetDOF()*(1+abs(torques).max())
+                for idof in range(body.GetDOF()):
+                    delta = zeros(body.GetDOF())
+                    delta[idof] = deltastep
+                    torquesplus = body.ComputeInverseDynamicsBatch(dofvalues+delta,dofvelocities,dofaccelerations)
+                    torquesminus = body.ComputeInverseDynamicsBatch(dofvalues-delta,dofvelocities,dofaccelerations)
+                    assert(transdist((torquesplus-torquesminus)/(2*deltastep),dtorquedvalues[:,:,idof]) <= derivativethresh)
+                    torquesplus = body.ComputeInverseDynamicsBatch(dofvalues,dofvelocities+delta,dofaccelerations)
+                    torquesminus = body.ComputeInverseDynamicsBatch(dofvalues,dofvelocities-delta,dofaccelerations)
+                    assert(transdist((torquesplus-torquesminus)/(2*deltastep),dtorquedvelocities[:,:,idof]) <= derivativethresh)
+
     def test_initkinbody(self):
         self.log.info('tests initializing a kinematics body')
         env=self.env
@@ -621,6 +621,41 @@ class RunPlanning(EnvironmentSetup):
             assert(success)
             assert(not env.CheckCollision(collisionbody))
 
+    def test_checkinbisectionorder(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        with env:
+            robot.SetActiveDOFs(robot.GetActiveManipulator().GetArmIndices())
+            parameters = Planner.PlannerParameters()
+            parameters.SetRobotActiveJoints(robot)
+            constraint = planningutils.DynamicsCollisionConstraint(parameters,[robot])
+            collisionoptions = int(ConstraintFilterOptions.CheckEnvCollisions)|int(ConstraintFilterOptions.CheckSelfCollisions)
+            filloptions = collisionoptions|int(ConstraintFilterOptions.FillCheckedConfiguration)
+            bisectionoption = int(ConstraintFilterOptions.CheckInBisectionOrder)
+            lower,upper = robot.GetActiveDOFLimits()
+            numvalid = 0
+            numinvalid = 0
+            with robot:
+                for iter in range(100):
+                    q0 = randlimits(lower,upper)
+                    q1 = randlimits(lower,upper)
+                    # the segment is invalid in bisection order if and only if it is invalid when checked in time order
+                    ret = constraint.Check(q0,q1,[],[],0,Interval.Closed,collisionoptions)
+                    retbisection = constraint.Check(q0,q1,[],[],0,Interval.Closed,collisionoptions|bisectionoption)
+                    assert((ret == 0) == (retbisection == 0))
+                    if ret == 0:
+                        numvalid += 1
+                        # the checked configurations are still returned in time order
+                        filterreturn = constraint.Check(q0,q1,[],[],0,Interval.Closed,filloptions,True)
+                        filterreturnbisection = constraint.Check(q0,q1,[],[],0,Interval.Closed,filloptions|bisectionoption,True)
+                        assert(transdist(filterreturn['configurations'],filterreturnbisection['configurations']) <= g_epsilon)
+                        assert(transdist(filterreturn['configurationtimes'],filterreturnbisection['configurationtimes']) <= g_epsilon)
+                    else:
+                        numinvalid += 1
+            self.log.info('checked %d valid and %d invalid segments', numvalid, numinvalid)
+            assert(numvalid > 0 and numinvalid > 0)
+
 #generate_classes(RunPlanning, globals(), [('ode','ode'),('bullet','bullet')])
 
 class test_ode(RunPlanning):
@@ -805,6 +805,89 @@ class TestTrajectory(EnvironmentSetup):
                 expectedaccel=array([  0.00000000e+00,   7.50000000e+00,   1.00000000e+01, 1.00000000e+01,   1.00000000e+01,   0.00000000e+00, 3.50596745e-16,   4.67462326e-16,   4.67462326e-16, 4.67462326e-16,   0.00000000e+00,  -7.50000000e+00, -1.00000000e+01,  -1.00000000e+01,  -1.00000000e+01, 0.00000000e+00,   0.00000000e+00,   0.00000000e+00, 0.00000000e+00,   0.00000000e+00])
                 assert(transdist(expectedaccel,acceldata) <= g_epsilon)
 
+    def test_bulksampling(self):
+        self.log.info('check that sampling many points at once matches sampling them one by one')
+        env = self.env
+        self.LoadEnv('data/katanatable.env.xml')
+        robot=env.GetRobots()[0]
+        with env:
+            robot.SetActiveDOFs(range(5))
+            robot.SetDOFVelocityLimits(linspace(1,5,robot.GetDOF()))
+            robot.SetDOFAccelerationLimits(linspace(10,50,robot.GetDOF()))
+            traj = RaveCreateTrajectory(env,'')
+            traj.Init(robot.GetActiveConfigurationSpecification())
+            traj.Insert(0,[-1,-0.5,-1,-1,-1,0,0.5,0.2,0,0.4,1,1,1,1,1])
+            ret=planningutils.SmoothActiveDOFTrajectory(traj,robot)
+            assert(ret.statusCode==PlannerStatusCode.HasSolution)
+            # the smoother swaps its result into traj, so the first pass samples the swapped segment coefficients
+            jointspec = robot.GetActiveConfigurationSpecification()
+            for iter in range(2):
+                duration = traj.GetDuration()
+                times = r_[linspace(0,duration,101),duration*random.rand(20)]
+                data = traj.SamplePoints2D(times)
+                assert(data.shape == (len(times),traj.GetConfigurationSpecification().GetDOF()))
+                assert(transdist(data,[traj.Sample(t) for t in times]) <= len(times)*g_epsilon)
+                jointdata = traj.SamplePoints2D(times,jointspec)
+                assert(transdist(jointdata,[traj.Sample(t,jointspec) for t in times]) <= len(times)*g_epsilon)
+
+                deltatime = 0.01
+                data = traj.SamplePointsSameDeltaTime2D(deltatime,True)
+                assert(transdist(data[:-1],[traj.Sample(i*deltatime) for i in range(len(data)-1)]) <= len(data)*g_epsilon)
+                assert(transdist(data[-1],traj.Sample(duration)) <= g_epsilon)
+                jointdata = traj.SamplePointsSameDeltaTime2D(deltatime,True,jointspec)
+                assert(transdist(jointdata[:-1],[traj.Sample(i*deltatime,jointspec) for i in range(len(jointdata)-1)]) <= len(jointdata)*g_epsilon)
+
+                # appending a waypoint has to recompute the cached segment coefficients
+                waypoint = traj.GetWaypoint(-1)
+                waypoint[traj.GetConfigurationSpecification().GetGroupFromName('deltatime').offset] = 0.1
+                traj.Insert(traj.GetNumWaypoints(),waypoint)
+
+    def test_streamingtraj(self):
+        self.log.info('check that a streaming trajectory samples the same as the trajectory it is streamed from')
+        env = self.env
+        self.LoadEnv('data/katanatable.env.xml')
+        robot=env.GetRobots()[0]
+        with env:
+            robot.SetActiveDOFs(range(5))
+            traj = RaveCreateTrajectory(env,'')
+            traj.Init(robot.GetActiveConfigurationSpecification())
+            traj.Insert(0,[-1,-0.5,-1,-1,-1,0,0.5,0.2,0,0.4,1,1,1,1,1])
+            ret=planningutils.SmoothActiveDOFTrajectory(traj,robot)
+            assert(ret.statusCode==PlannerStatusCode.HasSolution)
+            duration = traj.GetDuration()
+
+            timeoffset = traj.GetConfigurationSpecification().GetGroupFromName('deltatime').offset
+            stream = RaveCreateTrajectory(env,'StreamingTrajectory')
+            stream.Init(traj.GetConfigurationSpecification())
+            waypointtime = 0
+            for i in range(traj.GetNumWaypoints()):
+                stream.Insert(stream.GetNumWaypoints(),traj.GetWaypoint(i))
+                waypointtime += traj.GetWaypoint(i)[timeoffset]
+                assert(abs(stream.GetDuration()-waypointtime) <= g_epsilon)
+            assert(stream.GetNumWaypoints() == traj.GetNumWaypoints())
+            # can only append at the end
+            assert_raises(openrave_exception,stream.Insert,0,traj.GetWaypoint(0))
+
+            times = linspace(0,duration,51)
+            assert(transdist(stream.SamplePoints2D(times),traj.SamplePoints2D(times)) <= len(times)*g_epsilon)
+
+            # removing the consumed waypoints does not change the times of the remaining ones
+            trimtime = 0.5*duration
+            numtrimmed = int(stream.SendCommand('TrimBefore %.15e'%trimtime))
+            assert(numtrimmed > 0)
+            assert(stream.GetNumWaypoints() == traj.GetNumWaypoints()-numtrimmed)
+            assert(transdist(stream.GetWaypoint(0),traj.GetWaypoint(numtrimmed)) <= g_epsilon)
+            assert(abs(stream.GetDuration()-duration) <= g_epsilon)
+            times = linspace(trimtime,duration,51)
+            assert(transdist(stream.SamplePoints2D(times),traj.SamplePoints2D(times)) <= len(times)*g_epsilon)
+            for t in times:
+                assert(transdist(stream.Sample(t),traj.Sample(t)) <= g_epsilon)
+
+            # appending after trimming keeps the times
+            stream.Insert(stream.GetNumWaypoints(),traj.GetWaypoint(-1))
+            assert(abs(stream.GetDuration()-duration-traj.GetWaypoint(-1)[timeoffset]) <= g_epsilon)
+            assert(transdist(stream.Sample(trimtime),traj.Sample(trimtime)) <= g_epsilon)
+
     def test_extendwaypoint(self):
         env=self.env
         self.LoadEnv('data/lab1.env.xml')